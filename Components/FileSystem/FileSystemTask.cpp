@@ -8,9 +8,13 @@
 /* Includes ------------------------------------------------------------------*/
 #include "FileSystemTask.hpp"
 #include "SoarFileSystemExample.hpp"
+#include "SoarFileSystemBenchmark.hpp"
 #include "SoarFileSystem.hpp"
 #include "SystemDefines.hpp"
+#include "CycleCounter.hpp"
+#include "StaticAllocation.hpp"
 #include <stdint.h>
+#include <string.h>
 #include "stm32g4xx_hal.h"
 
 /**
@@ -19,15 +23,35 @@
 FileSystemTask::FileSystemTask() : Task(TASK_FILESYSTEM_QUEUE_DEPTH_OBJS),
                                    fileSystemInitialized(false),
                                    usbMounted(false),
-                                   lastLogTime(0),
-                                   lastCleanupTime(0),
-                                   testCounter(0)
+                                   lastOpStatsTime(0),
+                                   testCounter(0),
+                                   drainQueued(false),
+                                   drainedRecords(0),
+                                   drainBatches(0),
+                                   sensorLog(FILESYSTEM_SENSOR_LOG_ROTATION, FILESYSTEM_LOG_CHECKPOINT_MS)
 {
-    // Initialize pending log data
-    pendingLogData.hasData = false;
-    pendingLogData.temperature = 0.0f;
-    pendingLogData.humidity = 0.0f;
-    pendingLogData.timestamp = 0;
+    memset(appendGroups, 0, sizeof(appendGroups));
+    memset(&batchStats, 0, sizeof(batchStats));
+
+    if (FILESYSTEM_SENSOR_LOG_COLUMNS != SOAR_LOG_RECORD_NONE)
+    {
+        SoarFS_Result_t result = sensorLog.EnableColumns(FILESYSTEM_SENSOR_LOG_COLUMNS);
+        SOAR_ASSERT(result == SOAR_FS_OK, "Sensor log column type must have fixed length numeric fields");
+    }
+}
+
+/**
+ * @brief Power of two histogram bucket of value, bucket 0 holds everything below bucket0Limit
+ */
+static uint32_t HistogramBucket(uint32_t value, uint32_t bucket0Limit)
+{
+    uint32_t bucket = 0;
+    while (value >= bucket0Limit && bucket < FILESYSTEM_HISTOGRAM_BUCKETS - 1)
+    {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
 }
 
 /**
@@ -39,6 +63,16 @@ void FileSystemTask::InitTask()
     SOAR_ASSERT(rtTaskHandle == nullptr, "Cannot initialize FileSystem task twice");
 
     // Start the task
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    static StaticTaskStorage<TASK_FILESYSTEM_STACK_DEPTH_WORDS> taskStorage;
+    rtTaskHandle = taskStorage.Create((TaskFunction_t)FileSystemTask::RunTask,
+                                      (const char *)"FileSystemTask",
+                                      (void *)this,
+                                      (UBaseType_t)TASK_FILESYSTEM_TASK_PRIORITY);
+
+    // Ensure creation succeded
+    SOAR_ASSERT(rtTaskHandle != nullptr, "FileSystemTask::InitTask() - xTaskCreateStatic() failed");
+#else
     BaseType_t rtValue =
         xTaskCreate((TaskFunction_t)FileSystemTask::RunTask,
                     (const char *)"FileSystemTask",
@@ -49,6 +83,7 @@ void FileSystemTask::InitTask()
 
     // Ensure creation succeded
     SOAR_ASSERT(rtValue == pdPASS, "FileSystemTask::InitTask() - xTaskCreate() failed");
+#endif
 }
 
 /**
@@ -61,16 +96,130 @@ void FileSystemTask::Run(void *pvParams)
 
     // Initialize file system on startup
     InitializeFileSystem();
+    RegisterJobs();
 
+    uint32_t timeoutMs = FILESYSTEM_TASK_QUEUE_TIMEOUT_MS;
     while (1)
     {
-        /* Process commands in blocking mode */
-        Command cm;
-        bool res = qEvtQueue->ReceiveWait(cm);
-        if (res)
+        /* Wait for a command, waking up at least every queue timeout to service appender sync policies
+         * and at the next periodic job release, then take everything else already queued so it is
+         * handled in one batch */
+        Command batch[FILESYSTEM_BATCH_MAX_COMMANDS];
+        if (qEvtQueue->Receive(batch[0], timeoutMs))
         {
-            HandleCommand(cm);
+            uint32_t count = 1;
+            while (count < FILESYSTEM_BATCH_MAX_COMMANDS && qEvtQueue->Receive(batch[count], 0))
+            {
+                count++;
+            }
+            HandleBatch(batch, count);
+        }
+
+        // Notices the media coming and going even when no commands arrive
+        CheckUSBStatus();
+        SoarFS_Poll();
+        sensorLog.Poll(HAL_GetTick());
+
+        // Producers stop waking the task while the log is closed, drain what the ring held as soon as it is open again
+        if (drainQueued.load() && sensorLog.IsOpen())
+        {
+            DrainTelemetry();
         }
+
+        uint32_t untilReleaseMs = jobs.Service();
+        timeoutMs = (untilReleaseMs < FILESYSTEM_TASK_QUEUE_TIMEOUT_MS) ? untilReleaseMs : FILESYSTEM_TASK_QUEUE_TIMEOUT_MS;
+    }
+}
+
+/**
+ * @brief Register the fixed rate jobs, released from the first loop iteration on
+ */
+void FileSystemTask::RegisterJobs()
+{
+    bool registered = jobs.Register("telemetry", FILESYSTEM_LOG_INTERVAL_MS, 0, DrainTelemetryJob, this) &&
+                      jobs.Register("free_space", FILESYSTEM_CLEANUP_INTERVAL_MS, FILESYSTEM_CLEANUP_PHASE_MS,
+                                    CheckFreeSpaceJob, this) &&
+                      jobs.Register("op_stats", FILESYSTEM_OP_STATS_INTERVAL_MS, FILESYSTEM_OP_STATS_PHASE_MS,
+                                    LogOpStatsJob, this);
+    SOAR_ASSERT(registered, "FileSystemTask::RegisterJobs() - Too many periodic jobs");
+}
+
+/**
+ * @brief Drain records a producer pushed without managing to queue a drain
+ */
+void FileSystemTask::DrainTelemetryJob(void *context)
+{
+    ((FileSystemTask *)context)->DrainTelemetry();
+}
+
+/**
+ * @brief Periodic free space check
+ */
+void FileSystemTask::CheckFreeSpaceJob(void *context)
+{
+    ((FileSystemTask *)context)->CheckFreeSpace();
+}
+
+/**
+ * @brief Periodic file system operation counters
+ */
+void FileSystemTask::LogOpStatsJob(void *context)
+{
+    ((FileSystemTask *)context)->LogOpStats();
+}
+
+/**
+ * @brief Warn once free space is below where the sensor log rotation starts deleting old logs
+ */
+void FileSystemTask::CheckFreeSpace()
+{
+    uint64_t freeBytes;
+    if (!IsFileSystemReady() || SoarFS_GetFreeSpace(&freeBytes) != SOAR_FS_OK)
+    {
+        return;
+    }
+
+    if (freeBytes < FILESYSTEM_SENSOR_LOG_ROTATION.lowWaterBytes)
+    {
+        SOAR_PRINT("FileSystemTask::CheckFreeSpace() - %lu KB free, old logs are being deleted\n",
+                   (uint32_t)(freeBytes / 1024));
+    }
+}
+
+/**
+ * @brief Handle a batch of commands in order, appends to the same file are combined into one write
+ * @param batch Commands received in one wakeup
+ * @param count Number of commands in batch
+ */
+void FileSystemTask::HandleBatch(Command *batch, uint32_t count)
+{
+    uint32_t start = CycleCounter::Now();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        Command &cm = batch[i];
+        if (cm.GetCommand() == TASK_SPECIFIC_COMMAND && cm.GetTaskCommand() == EVENT_FILESYSTEM_ASYNC_REQUEST &&
+            ((SoarFS_AsyncRequest_t *)cm.GetDataPointer())->op == SOARFS_ASYNC_APPEND)
+        {
+            CoalesceAppend((SoarFS_AsyncRequest_t *)cm.GetDataPointer());
+            cm.Reset();
+            continue;
+        }
+
+        // Anything else may read, flush or close a file with appends held, so write them first
+        FlushAppendGroups();
+        HandleCommand(cm);
+    }
+    FlushAppendGroups();
+
+    uint32_t latencyUs = CycleCounter::ToMicros(CycleCounter::Now() - start);
+    batchStats.batches++;
+    batchStats.commands += count;
+    batchStats.batchSizeHistogram[HistogramBucket(count, 2)]++;
+    batchStats.batchLatencyHistogram[HistogramBucket(latencyUs, FILESYSTEM_LATENCY_BUCKET0_US)]++;
+    if (latencyUs > batchStats.maxBatchLatencyUs)
+    {
+        batchStats.maxBatchLatencyUs = latencyUs;
     }
 }
 
@@ -92,15 +241,26 @@ void FileSystemTask::HandleCommand(Command &cm)
             RunFileSystemTests();
             break;
         case EVENT_FILESYSTEM_LOG_DATA:
-            if (pendingLogData.hasData)
-            {
-                LogSensorData(pendingLogData.temperature, pendingLogData.humidity, pendingLogData.timestamp);
-                pendingLogData.hasData = false;
-            }
+            DrainTelemetry();
             break;
         case EVENT_FILESYSTEM_CLEANUP:
             PerformCleanup();
             break;
+        case EVENT_FILESYSTEM_BENCHMARK:
+            RunBenchmarks();
+            break;
+        case EVENT_FILESYSTEM_ASYNC_REQUEST:
+            ExecuteRequest((SoarFS_AsyncRequest_t *)cm.GetDataPointer());
+            break;
+        case EVENT_FILESYSTEM_LOG_OP_STATS:
+            LogOpStats();
+            break;
+        case EVENT_FILESYSTEM_SWEEP:
+            RunSweep(false);
+            break;
+        case EVENT_FILESYSTEM_SWEEP_FORMAT:
+            RunSweep(true);
+            break;
         default:
             SOAR_PRINT("FileSystemTask - Received Unsupported Task Command {%d}\n", cm.GetTaskCommand());
             break;
@@ -172,9 +332,49 @@ void FileSystemTask::LogSensorData(float temperature, float humidity, uint32_t t
         return;
     }
 
-    SOAR_PRINT("FileSystemTask::LogSensorData() - Logging sensor data: T=%.2f, H=%.2f\n", temperature, humidity);
-    SoarFS_Example_LogSensorData(temperature, humidity, timestamp);
-    lastLogTime = HAL_GetTick();
+    // Opened at mount, if that failed the session retries from Poll and counts the records dropped meanwhile
+    SoarLog_Environment_t sample;
+    sample.temperature = temperature;
+    sample.humidity = humidity;
+    sensorLog.Append(SOAR_LOG_RECORD_ENVIRONMENT, timestamp, &sample, sizeof(sample));
+}
+
+/**
+ * @brief Drain the telemetry ring in batches until it is empty
+ */
+void FileSystemTask::DrainTelemetry()
+{
+    // Keep the records in the ring while the media is out, drainQueued stays set so producers
+    // stop waking the task and Run() drains them once the log is open again
+    if (!sensorLog.IsOpen())
+    {
+        return;
+    }
+
+    // Clear first, a record pushed while draining queues another drain instead of being stranded
+    drainQueued.store(false);
+
+    TelemetryRecord batch[FILESYSTEM_TELEMETRY_DRAIN_BATCH];
+    uint32_t count;
+    while ((count = telemetryRing.PopBatch(batch, FILESYSTEM_TELEMETRY_DRAIN_BATCH)) > 0)
+    {
+        drainBatches++;
+        drainedRecords += count;
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            switch (batch[i].type)
+            {
+            case TELEMETRY_RECORD_ENVIRONMENT:
+                LogSensorData(batch[i].environment.temperature, batch[i].environment.humidity, batch[i].timestamp);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    // Blocks go out as they fill, the session commits them every checkpoint interval
 }
 
 /**
@@ -191,6 +391,274 @@ void FileSystemTask::PerformCleanup()
     SoarFS_Example_FileManagement();
 }
 
+/**
+ * @brief Run the file system benchmarks
+ */
+void FileSystemTask::RunBenchmarks()
+{
+    if (!IsFileSystemReady())
+    {
+        SOAR_PRINT("FileSystemTask::RunBenchmarks() - File system not ready\n");
+        return;
+    }
+
+    SOAR_PRINT("FileSystemTask::RunBenchmarks() - Running file system benchmarks\n");
+    PauseSensorLog();
+    SoarFS_Bench_RunAll();
+    ResumeSensorLog();
+}
+
+/**
+ * @brief Run the file system parameter sweep with the sensor log closed
+ */
+void FileSystemTask::RunSweep(bool formatVolume)
+{
+    if (!IsFileSystemReady())
+    {
+        SOAR_PRINT("FileSystemTask::RunSweep() - File system not ready\n");
+        return;
+    }
+
+    PauseSensorLog();
+    SoarFS_Bench_Sweep(formatVolume);
+    ResumeSensorLog();
+}
+
+/**
+ * @brief Close the sensor log before a benchmark. The sweep opens SOAR_FS_MAX_FILES_OPEN
+ * files at once and a reformat closes every file, so the log may not hold a handle or staged data.
+ */
+void FileSystemTask::PauseSensorLog()
+{
+    FlushAppendGroups();
+    sensorLog.Stop();
+}
+
+/**
+ * @brief Open the next sensor log after PauseSensorLog()
+ */
+void FileSystemTask::ResumeSensorLog()
+{
+    if (sensorLog.Start() != SOAR_FS_OK)
+    {
+        SOAR_PRINT("FileSystemTask::ResumeSensorLog() - Could not reopen the sensor log\n");
+    }
+}
+
+/**
+ * @brief Run a submitted request and signal its completion
+ */
+void FileSystemTask::ExecuteRequest(SoarFS_AsyncRequest_t *request)
+{
+    SoarFS_Result_t result = SOAR_FS_OK;
+    uint32_t bytes = 0;
+
+    // Requests run in submission order, so the referenced OPEN has already completed
+    if (request->handleFrom != nullptr)
+    {
+        request->handle = request->handleFrom->handle;
+    }
+
+    if (!IsFileSystemReady())
+    {
+        result = SOAR_FS_NOT_MOUNTED;
+    }
+    else
+    {
+        switch (request->op)
+        {
+        case SOARFS_ASYNC_OPEN:
+            if (request->createIfMissing && !SoarFS_FileExists(request->filename))
+            {
+                static const uint8_t empty = 0;
+                result = SoarFS_CreateFile(request->filename, &empty, 0);
+            }
+            if (result == SOAR_FS_OK)
+            {
+                result = request->policy ? SoarFS_OpenAppender(request->filename, request->policy, &request->handle)
+                                         : SoarFS_Open(request->filename, &request->handle);
+            }
+            break;
+        case SOARFS_ASYNC_APPEND:
+            // Appenders always write at the end, a plain handle has to be moved there
+            if (!SoarFS_IsAppender(request->handle))
+            {
+                result = SoarFS_Seek(request->handle, SOAR_FS_SEEK_END);
+            }
+            if (result == SOAR_FS_OK)
+            {
+                result = SoarFS_Write(request->handle, request->buffer, request->size);
+            }
+            bytes = (result == SOAR_FS_OK) ? request->size : 0;
+            break;
+        case SOARFS_ASYNC_READ:
+            result = SoarFS_Seek(request->handle, request->offset);
+            if (result == SOAR_FS_OK)
+            {
+                result = SoarFS_Read(request->handle, request->buffer, request->size, &bytes);
+            }
+            break;
+        case SOARFS_ASYNC_FLUSH:
+            result = SoarFS_Flush(request->handle);
+            break;
+        case SOARFS_ASYNC_CLOSE:
+            result = SoarFS_Close(request->handle);
+            break;
+        case SOARFS_ASYNC_DELETE:
+            result = SoarFS_DeleteFile(request->filename);
+            break;
+        default:
+            result = SOAR_FS_INVALID_PARAMETER;
+            break;
+        }
+    }
+
+    CompleteRequest(request, result, bytes);
+}
+
+/**
+ * @brief Store the outcome of a request and signal its completion
+ */
+void FileSystemTask::CompleteRequest(SoarFS_AsyncRequest_t *request, SoarFS_Result_t result, uint32_t bytes)
+{
+    request->result = result;
+    request->bytes = bytes;
+
+    // The submitter may reuse the descriptor as soon as it sees DONE, so read the notify target first
+    TaskHandle_t notifyTask = request->notifyTask;
+    uint32_t notifyBits = request->notifyBits;
+    bool release = request->releaseWhenDone;
+    if (request->callback != nullptr)
+    {
+        request->callback(request);
+    }
+    request->state.store(SOARFS_ASYNC_DONE, std::memory_order_release);
+
+    if (notifyTask != nullptr)
+    {
+        xTaskNotify(notifyTask, notifyBits, eSetBits);
+    }
+    if (release)
+    {
+        ReleaseRequest(request);
+    }
+}
+
+/**
+ * @brief Hold an append in its file's group until the group is flushed
+ */
+void FileSystemTask::CoalesceAppend(SoarFS_AsyncRequest_t *request)
+{
+    batchStats.appendRequests++;
+
+    // Resolved now, while the batch is still in submission order
+    if (request->handleFrom != nullptr)
+    {
+        request->handle = request->handleFrom->handle;
+    }
+
+    uint32_t group = SOAR_FS_MAX_FILES_OPEN;
+    uint32_t freeGroup = SOAR_FS_MAX_FILES_OPEN;
+    for (uint32_t i = 0; i < SOAR_FS_MAX_FILES_OPEN; i++)
+    {
+        if (appendGroups[i].count > 0 && appendGroups[i].handle == request->handle)
+        {
+            group = i;
+        }
+        else if (appendGroups[i].count == 0 && freeGroup == SOAR_FS_MAX_FILES_OPEN)
+        {
+            freeGroup = i;
+        }
+    }
+
+    // Too large to hold, write it on its own after what is already held for the file
+    if (request->buffer == nullptr || request->size == 0 || request->size > FILESYSTEM_COALESCE_BYTES)
+    {
+        if (group < SOAR_FS_MAX_FILES_OPEN)
+        {
+            FlushAppendGroup(group);
+        }
+        batchStats.appendWrites++;
+        ExecuteRequest(request);
+        return;
+    }
+
+    if (group == SOAR_FS_MAX_FILES_OPEN)
+    {
+        // More files than groups, an invalid handle can only match stale handles anyway
+        if (freeGroup == SOAR_FS_MAX_FILES_OPEN)
+        {
+            FlushAppendGroups();
+            freeGroup = 0;
+        }
+        group = freeGroup;
+        appendGroups[group].handle = request->handle;
+    }
+
+    AppendGroup &g = appendGroups[group];
+    if (g.used + request->size > FILESYSTEM_COALESCE_BYTES || g.count == FILESYSTEM_BATCH_MAX_COMMANDS)
+    {
+        FlushAppendGroup(group);
+        g.handle = request->handle;
+    }
+
+    memcpy(g.data + g.used, request->buffer, request->size);
+    g.used += request->size;
+    g.requests[g.count++] = request;
+}
+
+/**
+ * @brief Write a group's appends as one write and complete every request in it
+ */
+void FileSystemTask::FlushAppendGroup(uint32_t group)
+{
+    AppendGroup &g = appendGroups[group];
+    if (g.count == 0)
+    {
+        return;
+    }
+
+    SoarFS_Result_t result = SOAR_FS_OK;
+    if (!IsFileSystemReady())
+    {
+        result = SOAR_FS_NOT_MOUNTED;
+    }
+    else
+    {
+        // Appenders always write at the end, a plain handle has to be moved there
+        if (!SoarFS_IsAppender(g.handle))
+        {
+            result = SoarFS_Seek(g.handle, SOAR_FS_SEEK_END);
+        }
+        if (result == SOAR_FS_OK)
+        {
+            result = SoarFS_Write(g.handle, g.data, g.used);
+        }
+        batchStats.appendWrites++;
+    }
+
+    // All or nothing, a failed write leaves no way to tell which records made it
+    for (uint32_t i = 0; i < g.count; i++)
+    {
+        CompleteRequest(g.requests[i], result, (result == SOAR_FS_OK) ? g.requests[i]->size : 0);
+    }
+
+    g.handle = SOAR_FS_NULL_HANDLE;
+    g.used = 0;
+    g.count = 0;
+}
+
+/**
+ * @brief Flush every append group
+ */
+void FileSystemTask::FlushAppendGroups()
+{
+    for (uint32_t i = 0; i < SOAR_FS_MAX_FILES_OPEN; i++)
+    {
+        FlushAppendGroup(i);
+    }
+}
+
 /**
  * @brief Check USB connection status
  */
@@ -204,18 +672,33 @@ void FileSystemTask::CheckUSBStatus()
         {
             SOAR_PRINT("FileSystemTask::CheckUSBStatus() - USB storage connected\n");
 
+            // Open the next log, the records the session and the ring kept while the media was out go into it
+            if (sensorLog.Start() != SOAR_FS_OK)
+            {
+                SOAR_PRINT("FileSystemTask::CheckUSBStatus() - Could not open the sensor log\n");
+            }
+
             // Get and display free space
-            uint32_t freeBytes;
+            uint64_t freeBytes;
             if (SoarFS_GetFreeSpace(&freeBytes) == SOAR_FS_OK)
             {
-                SOAR_PRINT("FileSystemTask::CheckUSBStatus() - Available space: %lu bytes\n", freeBytes);
+                SOAR_PRINT("FileSystemTask::CheckUSBStatus() - Available space: %lu KB\n", (uint32_t)(freeBytes / 1024));
             }
         }
         else
         {
             SOAR_PRINT("FileSystemTask::CheckUSBStatus() - USB storage disconnected\n");
+
+            // The open file went with the media, keep the buffered records for the resume
+            sensorLog.Suspend();
         }
         usbMounted = currentStatus;
+
+        // After the update, logging a record checks the status again
+        if (usbMounted)
+        {
+            DrainTelemetry();
+        }
     }
 }
 
@@ -247,6 +730,12 @@ void FileSystemTask::WaitForUSBMount(uint32_t maxWaitMs)
     {
         usbMounted = true;
         SOAR_PRINT("FileSystemTask::WaitForUSBMount() - USB storage mounted successfully\n");
+
+        // Open the log once here instead of on every sample
+        if (sensorLog.Start() != SOAR_FS_OK)
+        {
+            SOAR_PRINT("FileSystemTask::WaitForUSBMount() - Could not open the sensor log\n");
+        }
     }
     else
     {
@@ -278,13 +767,256 @@ void FileSystemTask::TriggerTest()
  */
 void FileSystemTask::TriggerLogData(float temperature, float humidity, uint32_t timestamp)
 {
-    pendingLogData.temperature = temperature;
-    pendingLogData.humidity = humidity;
-    pendingLogData.timestamp = timestamp;
-    pendingLogData.hasData = true;
+    TelemetryRecord record = {};
+    record.timestamp = timestamp;
+    record.type = TELEMETRY_RECORD_ENVIRONMENT;
+    record.environment.temperature = temperature;
+    record.environment.humidity = humidity;
 
-    Command cm(TASK_SPECIFIC_COMMAND, EVENT_FILESYSTEM_LOG_DATA);
-    qEvtQueue->Send(cm);
+    PushTelemetry(record, false);
+}
+
+/**
+ * @brief Trigger sensor data logging from an interrupt
+ */
+void FileSystemTask::TriggerLogDataFromISR(float temperature, float humidity, uint32_t timestamp)
+{
+    TelemetryRecord record = {};
+    record.timestamp = timestamp;
+    record.type = TELEMETRY_RECORD_ENVIRONMENT;
+    record.environment.temperature = temperature;
+    record.environment.humidity = humidity;
+
+    PushTelemetry(record, true);
+}
+
+/**
+ * @brief Push a record into the telemetry ring and make sure a drain is queued, never blocks
+ * @return False if the ring was full and the record was dropped
+ */
+bool FileSystemTask::PushTelemetry(const TelemetryRecord &record, bool fromISR)
+{
+    if (!telemetryRing.Push(record))
+    {
+        return false;
+    }
+
+    // Only the first producer since the last drain needs to wake the task
+    if (!drainQueued.exchange(true))
+    {
+        Command cm(TASK_SPECIFIC_COMMAND, EVENT_FILESYSTEM_LOG_DATA);
+        bool res = fromISR ? qEvtQueue->SendFromISR(cm) : qEvtQueue->Send(cm);
+
+        // Let the next producer retry the wakeup, the record itself is already queued
+        if (!res)
+        {
+            drainQueued.store(false);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Print telemetry ring counters
+ */
+void FileSystemTask::PrintTelemetryStats()
+{
+    SOAR_PRINT("\n-- TELEMETRY RING --\n");
+    SOAR_PRINT("Fill Level   : %lu / %lu records\n", telemetryRing.Size(), telemetryRing.Capacity());
+    SOAR_PRINT("High Water   : %lu records\n", telemetryRing.HighWater());
+    SOAR_PRINT("Pushed       : %lu records\n", telemetryRing.Pushed());
+    SOAR_PRINT("Overflows    : %lu records\n", telemetryRing.Overflows());
+    SOAR_PRINT("Drained      : %lu records in %lu batches\n", drainedRecords, drainBatches);
+    sensorLog.PrintStats();
+}
+
+/**
+ * @brief Queue an asynchronous request, returns as soon as it is queued
+ * @param request Descriptor to run, owned by this task until it is done
+ * @return False if the queue was full, the request is left idle and not run
+ */
+bool FileSystemTask::Submit(SoarFS_AsyncRequest_t *request)
+{
+    if (request == nullptr)
+    {
+        return false;
+    }
+
+    request->state.store(SOARFS_ASYNC_PENDING, std::memory_order_relaxed);
+
+    // Only the pointer travels through the queue, the descriptor stays with the caller
+    Command cm(TASK_SPECIFIC_COMMAND, EVENT_FILESYSTEM_ASYNC_REQUEST);
+    cm.SetCommandToStaticExternalBuffer((uint8_t *)request, sizeof(SoarFS_AsyncRequest_t));
+    if (!qEvtQueue->Send(cm))
+    {
+        request->state.store(SOARFS_ASYNC_IDLE, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Take a descriptor, and a buffer of bufferBytes if asked for, from the pools
+ * @param op Operation the descriptor is initialized for, see SoarFS_AsyncInit
+ * @param bufferBytes Bytes for request->buffer, request->size is set to it, 0 for none
+ * @return nullptr if a pool is exhausted or bufferBytes is over FILESYSTEM_REQUEST_BUFFER_BYTES
+ */
+SoarFS_AsyncRequest_t *FileSystemTask::AllocateRequest(SOARFS_ASYNC_OP op, uint32_t bufferBytes)
+{
+    if (bufferBytes > FILESYSTEM_REQUEST_BUFFER_BYTES)
+    {
+        return nullptr;
+    }
+
+    SoarFS_AsyncRequest_t *request = requestPool.Allocate();
+    if (request == nullptr)
+    {
+        return nullptr;
+    }
+    SoarFS_AsyncInit(request, op);
+
+    if (bufferBytes > 0)
+    {
+        FileSystemRequestBuffer *buffer = bufferPool.Allocate();
+        if (buffer == nullptr)
+        {
+            requestPool.Free(request);
+            return nullptr;
+        }
+        request->buffer = buffer->bytes;
+        request->size = bufferBytes;
+    }
+    return request;
+}
+
+/**
+ * @brief Give a descriptor from AllocateRequest() and its pooled buffer back, not while it is pending
+ */
+void FileSystemTask::ReleaseRequest(SoarFS_AsyncRequest_t *request)
+{
+    if (request == nullptr)
+    {
+        return;
+    }
+
+    // Checked before the buffer goes back, a stray descriptor must not free a pooled buffer
+    SOAR_ASSERT(requestPool.Owns(request), "FileSystemTask::ReleaseRequest() - Descriptor is not pooled");
+    if (bufferPool.Owns(request->buffer))
+    {
+        bufferPool.Free((FileSystemRequestBuffer *)(void *)request->buffer);
+    }
+    requestPool.Free(request);
+}
+
+/**
+ * @brief Print the request descriptor and buffer pool counters
+ */
+void FileSystemTask::PrintPoolStats()
+{
+    ObjectPool_PrintStats("FsRequest", requestPool.Stats());
+    ObjectPool_PrintStats("FsBuffer", bufferPool.Stats());
+}
+
+/**
+ * @brief Print a power of two histogram as "<bound:count" pairs on one line
+ */
+static void PrintHistogram(const char *label, const uint32_t *histogram, uint32_t bucket0Limit,
+                           uint32_t buckets = FILESYSTEM_HISTOGRAM_BUCKETS)
+{
+    SOAR_PRINT("%s", label);
+    for (uint32_t i = 0; i < buckets - 1; i++)
+    {
+        SOAR_PRINT("<%lu:%lu ", bucket0Limit << i, histogram[i]);
+    }
+    SOAR_PRINT(">=%lu:%lu\n", bucket0Limit << (buckets - 2), histogram[buckets - 1]);
+}
+
+/**
+ * @brief Print batching and coalescing counters with their histograms
+ */
+void FileSystemTask::PrintBatchStats()
+{
+    FileSystemBatchStats stats = batchStats;
+
+    SOAR_PRINT("\n-- FILESYSTEM BATCHES --\n");
+    SOAR_PRINT("Batches      : %lu, %lu commands\n", stats.batches, stats.commands);
+    SOAR_PRINT("Appends      : %lu requests in %lu writes", stats.appendRequests, stats.appendWrites);
+    if (stats.appendRequests > 0)
+    {
+        SOAR_PRINT(", %lu%% fewer", 100 - (stats.appendWrites * 100) / stats.appendRequests);
+    }
+    SOAR_PRINT("\nMax Latency  : %lu us\n", stats.maxBatchLatencyUs);
+
+    PrintHistogram("Size         : ", stats.batchSizeHistogram, 2);
+    PrintHistogram("Latency (us) : ", stats.batchLatencyHistogram, FILESYSTEM_LATENCY_BUCKET0_US);
+    SOAR_PRINT("\n");
+}
+
+/**
+ * @brief Zero the batching counters
+ */
+void FileSystemTask::ResetBatchStats()
+{
+    memset(&batchStats, 0, sizeof(batchStats));
+}
+
+/**
+ * @brief Print the counters and latency histogram of every file system operation called so far
+ */
+void FileSystemTask::PrintOpStats()
+{
+    const SoarFS_Stats_t *stats = SoarFS_GetStats();
+
+    SOAR_PRINT("\n-- FILESYSTEM OPERATIONS --\n");
+    SOAR_PRINT("Media        : %lu removals\n", stats->mediaRemovals);
+    for (uint32_t op = 0; op < SOAR_FS_OP_COUNT; op++)
+    {
+        SoarFS_OpStats_t entry = stats->ops[op];
+        if (entry.calls == 0)
+        {
+            continue;
+        }
+
+        SOAR_PRINT("%-13s: %lu calls, %lu errors, %lu bytes, avg %lu us, max %lu us\n", SoarFS_OpName((SoarFS_Op_t)op),
+                   entry.calls, entry.errors, entry.bytes, entry.totalUs / entry.calls, entry.maxUs);
+        PrintHistogram("  Latency us : ", entry.histogram, SOAR_FS_LATENCY_BUCKET0_US, SOAR_FS_LATENCY_BUCKETS);
+    }
+    SOAR_PRINT("\n");
+}
+
+/**
+ * @brief Write one fs_op record per file system operation called so far to the sensor log
+ */
+void FileSystemTask::LogOpStats()
+{
+    static_assert(SOAR_LOG_FS_OP_BUCKETS == SOAR_FS_LATENCY_BUCKETS, "fs_op records must match the histograms");
+
+    lastOpStatsTime = HAL_GetTick();
+    if (!sensorLog.IsOpen())
+    {
+        return;
+    }
+
+    const SoarFS_Stats_t *stats = SoarFS_GetStats();
+    for (uint32_t op = 0; op < SOAR_FS_OP_COUNT; op++)
+    {
+        const SoarFS_OpStats_t *entry = &stats->ops[op];
+        if (entry->calls == 0)
+        {
+            continue;
+        }
+
+        SoarLog_FsOp_t record;
+        record.op = (uint8_t)op;
+        record.calls = entry->calls;
+        record.errors = entry->errors;
+        record.bytes = entry->bytes;
+        record.totalUs = entry->totalUs;
+        record.maxUs = entry->maxUs;
+        memcpy(record.histogram, entry->histogram, sizeof(record.histogram));
+        sensorLog.Append(SOAR_LOG_RECORD_FS_OP, lastOpStatsTime, &record, sizeof(record));
+    }
 }
 
 /**
@@ -295,3 +1027,40 @@ void FileSystemTask::TriggerCleanup()
     Command cm(TASK_SPECIFIC_COMMAND, EVENT_FILESYSTEM_CLEANUP);
     qEvtQueue->Send(cm);
 }
+
+/**
+ * @brief Trigger file system benchmarks from external task
+ */
+void FileSystemTask::TriggerBenchmark()
+{
+    Command cm(TASK_SPECIFIC_COMMAND, EVENT_FILESYSTEM_BENCHMARK);
+    qEvtQueue->Send(cm);
+}
+
+/**
+ * @brief Write the file system operation counters to the sensor log from external task
+ */
+void FileSystemTask::TriggerOpStatsLog()
+{
+    Command cm(TASK_SPECIFIC_COMMAND, EVENT_FILESYSTEM_LOG_OP_STATS);
+    qEvtQueue->Send(cm);
+}
+
+/**
+ * @brief Trigger the file system parameter sweep from external task
+ * @param formatVolume Also sweep cluster sizes by reformatting, erases the volume
+ */
+void FileSystemTask::TriggerSweep(bool formatVolume)
+{
+    Command cm(TASK_SPECIFIC_COMMAND, formatVolume ? EVENT_FILESYSTEM_SWEEP_FORMAT : EVENT_FILESYSTEM_SWEEP);
+    qEvtQueue->Send(cm);
+}
+
+/**
+ * @brief Print the periodic job timing, racy against the task but only ever off by a run
+ */
+void FileSystemTask::PrintJobStats()
+{
+    SOAR_PRINT("\n-- FILESYSTEM PERIODIC JOBS --\n");
+    jobs.PrintStats();
+}
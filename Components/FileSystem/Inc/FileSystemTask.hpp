@@ -11,7 +11,13 @@
 #include "Task.hpp"
 #include "SystemDefines.hpp"
 #include "SoarFileSystem.hpp"
+#include "TelemetryRing.hpp"
+#include "LogSession.hpp"
+#include "SoarFileSystemAsync.hpp"
+#include "PeriodicScheduler.hpp"
+#include "ObjectPool.hpp"
 #include <stdint.h>
+#include <atomic>
 
 /* Enums ------------------------------------------------------------------*/
 enum FILESYSTEM_TASK_COMMANDS
@@ -20,12 +26,57 @@ enum FILESYSTEM_TASK_COMMANDS
     EVENT_FILESYSTEM_INIT,
     EVENT_FILESYSTEM_TEST,
     EVENT_FILESYSTEM_LOG_DATA,
-    EVENT_FILESYSTEM_CLEANUP
+    EVENT_FILESYSTEM_CLEANUP,
+    EVENT_FILESYSTEM_BENCHMARK,
+    EVENT_FILESYSTEM_ASYNC_REQUEST, // Data is the submitted SoarFS_AsyncRequest_t
+    EVENT_FILESYSTEM_LOG_OP_STATS,
+    EVENT_FILESYSTEM_SWEEP,
+    EVENT_FILESYSTEM_SWEEP_FORMAT // Sweep cluster sizes too, erases the RAM disk or image
 };
 
 /* Macros ------------------------------------------------------------------*/
-constexpr uint32_t FILESYSTEM_LOG_INTERVAL_MS = 10000;     // Log every 10 seconds
-constexpr uint32_t FILESYSTEM_CLEANUP_INTERVAL_MS = 60000; // Cleanup every minute
+constexpr uint32_t FILESYSTEM_LOG_INTERVAL_MS = 10000;     // Drain the telemetry ring every 10 seconds, besides the drains producers queue
+constexpr uint32_t FILESYSTEM_CLEANUP_INTERVAL_MS = 60000; // Check free space every minute
+constexpr uint32_t FILESYSTEM_CLEANUP_PHASE_MS = 2500;     // Offsets keep the periodic jobs from being released together
+constexpr uint32_t FILESYSTEM_TELEMETRY_RING_DEPTH = 64;   // Records buffered between producers and the task, power of two
+constexpr uint32_t FILESYSTEM_TELEMETRY_DRAIN_BATCH = 16;  // Records popped per batch while draining
+constexpr LogRotationConfig FILESYSTEM_SENSOR_LOG_ROTATION = { // Sized for the USB media
+    "SNS",             // Logs are SNS00001.SLG, SNS00002.SLG, ...
+    "SLG",
+    1024 * 1024,       // Reserved per log, rolls over once full
+    30 * 60 * 1000,    // or after 30 minutes
+    2,                 // Spares kept ready
+    4 * 1024 * 1024,   // Delete the oldest logs below 4 MB free
+    8 * 1024 * 1024,   // until 8 MB is free
+};
+constexpr uint32_t FILESYSTEM_LOG_CHECKPOINT_MS = 5000; // Longest time logged records wait before being committed
+constexpr uint8_t FILESYSTEM_SENSOR_LOG_COLUMNS = SOAR_LOG_RECORD_ENVIRONMENT; // Column encoded in the sensor log, or SOAR_LOG_RECORD_NONE
+constexpr uint32_t FILESYSTEM_BATCH_MAX_COMMANDS = TASK_FILESYSTEM_QUEUE_DEPTH_OBJS; // Commands handled per wakeup
+constexpr uint32_t FILESYSTEM_COALESCE_BYTES = 512;   // Appends combined per file per batch, larger ones go straight through
+constexpr uint32_t FILESYSTEM_HISTOGRAM_BUCKETS = 8;  // Power of two buckets, the last one is open ended
+constexpr uint32_t FILESYSTEM_LATENCY_BUCKET0_US = 128; // Upper bound of the first batch latency bucket
+constexpr uint32_t FILESYSTEM_OP_STATS_INTERVAL_MS = 60000; // File system operation counters written to the sensor log every minute
+constexpr uint32_t FILESYSTEM_OP_STATS_PHASE_MS = 5000;
+constexpr uint16_t FILESYSTEM_REQUEST_POOL_DEPTH = TASK_FILESYSTEM_QUEUE_DEPTH_OBJS; // Pooled descriptors, one per queue slot
+constexpr uint16_t FILESYSTEM_BUFFER_POOL_DEPTH = 8;      // Pooled request buffers
+constexpr uint32_t FILESYSTEM_REQUEST_BUFFER_BYTES = 256; // Largest pooled request buffer
+
+/* Structs ------------------------------------------------------------------*/
+struct FileSystemBatchStats
+{
+    uint32_t batches;
+    uint32_t commands;
+    uint32_t appendRequests; // Async appends received
+    uint32_t appendWrites;   // Writes issued for them after coalescing
+    uint32_t batchSizeHistogram[FILESYSTEM_HISTOGRAM_BUCKETS];    // Commands per wakeup: 1, 2-3, 4-7, ...
+    uint32_t batchLatencyHistogram[FILESYSTEM_HISTOGRAM_BUCKETS]; // Time per wakeup: <128us, <256us, ...
+    uint32_t maxBatchLatencyUs;
+};
+
+struct FileSystemRequestBuffer
+{
+    uint8_t bytes[FILESYSTEM_REQUEST_BUFFER_BYTES];
+};
 
 /* Class ------------------------------------------------------------------*/
 class FileSystemTask : public Task
@@ -42,7 +93,26 @@ public:
     // Public interface for other tasks to trigger operations
     void TriggerTest();
     void TriggerLogData(float temperature, float humidity, uint32_t timestamp);
+    void TriggerLogDataFromISR(float temperature, float humidity, uint32_t timestamp);
     void TriggerCleanup();
+    void TriggerBenchmark();
+    void TriggerOpStatsLog(); // Write the file system operation counters to the sensor log now
+    void TriggerSweep(bool formatVolume);
+
+    // Queue a request without waiting on the disk, false if the queue is full
+    bool Submit(SoarFS_AsyncRequest_t *request);
+
+    // Pooled descriptors and buffers for Submit(), safe to call from any task
+    SoarFS_AsyncRequest_t *AllocateRequest(SOARFS_ASYNC_OP op, uint32_t bufferBytes = 0);
+    void ReleaseRequest(SoarFS_AsyncRequest_t *request);
+
+    // Telemetry ring diagnostics, safe to call from any task
+    void PrintTelemetryStats();
+    void PrintBatchStats();
+    void ResetBatchStats();
+    void PrintOpStats();
+    void PrintJobStats(); // Periodic job release latency, jitter and deadline misses
+    void PrintPoolStats(); // One ObjectPool_PrintStats() line per pool
 
 protected:
     static void RunTask(void *pvParams)
@@ -63,28 +133,64 @@ private:
     void InitializeFileSystem();
     void RunFileSystemTests();
     void LogSensorData(float temperature, float humidity, uint32_t timestamp);
+    void DrainTelemetry();
     void PerformCleanup();
+    void RunBenchmarks();
+    void RunSweep(bool formatVolume);
+    void PauseSensorLog();
+    void ResumeSensorLog();
     void CheckUSBStatus();
+    void HandleBatch(Command *batch, uint32_t count);
+    void ExecuteRequest(SoarFS_AsyncRequest_t *request);
+    void CompleteRequest(SoarFS_AsyncRequest_t *request, SoarFS_Result_t result, uint32_t bytes);
+    void CoalesceAppend(SoarFS_AsyncRequest_t *request);
+    void FlushAppendGroup(uint32_t group);
+    void FlushAppendGroups();
+    void LogOpStats();
+    void CheckFreeSpace();
+    void RegisterJobs();
+    static void DrainTelemetryJob(void *context);
+    static void CheckFreeSpaceJob(void *context);
+    static void LogOpStatsJob(void *context);
 
     // Helper functions
     void WaitForUSBMount(uint32_t maxWaitMs = 30000);
     bool IsFileSystemReady();
+    bool PushTelemetry(const TelemetryRecord &record, bool fromISR);
 
     // Member variables
     bool fileSystemInitialized;
     bool usbMounted;
-    uint32_t lastLogTime;
-    uint32_t lastCleanupTime;
+    uint32_t lastOpStatsTime;
     uint32_t testCounter;
 
-    // Data for logging
-    struct
+    // Data for logging, filled by producers and drained by this task
+    TelemetryRing<TelemetryRecord, FILESYSTEM_TELEMETRY_RING_DEPTH> telemetryRing;
+    std::atomic<bool> drainQueued; // A drain command is already in the queue
+    uint32_t drainedRecords;
+    uint32_t drainBatches;
+
+    // Fixed rate housekeeping, serviced between commands
+    PeriodicScheduler jobs;
+
+    // Framed binary log the drained records are written to, open while the media is mounted
+    LogSession sensorLog;
+
+    // Async appends held until the end of the batch, one group per file
+    struct AppendGroup
     {
-        float temperature;
-        float humidity;
-        uint32_t timestamp;
-        bool hasData;
-    } pendingLogData;
+        SoarFS_Handle_t handle; // SOAR_FS_NULL_HANDLE while unused
+        uint32_t used;
+        uint32_t count;
+        SoarFS_AsyncRequest_t *requests[FILESYSTEM_BATCH_MAX_COMMANDS];
+        uint8_t data[FILESYSTEM_COALESCE_BYTES];
+    };
+    AppendGroup appendGroups[SOAR_FS_MAX_FILES_OPEN];
+    FileSystemBatchStats batchStats;
+
+    // Handed out by AllocateRequest(), exhaustion is reported like a full queue
+    ObjectPool<SoarFS_AsyncRequest_t, FILESYSTEM_REQUEST_POOL_DEPTH> requestPool;
+    ObjectPool<FileSystemRequestBuffer, FILESYSTEM_BUFFER_POOL_DEPTH> bufferPool;
 };
 
 #endif // CUBE_SYSTEM_FILESYSTEM_TASK_HPP_
\ No newline at end of file
@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * File Name          : LogRotator.hpp
+ * Description        : Sequence numbered log files with a pool of preallocated spares
+ ******************************************************************************
+ *
+ * Logs are named <prefix><5 digit sequence>.<extension>, e.g. SNS00042.SLG,
+ * and the sequence grows as long as any log is left on the media, so the
+ * oldest file is the one with the lowest number. Spares for the next sequences are reserved ahead of time as
+ * <prefix><sequence>.PRE, so a rollover is a rename and an open and never
+ * waits on cluster allocation. Service() tops the pool up and deletes the
+ * oldest logs while free space is below the low watermark, one file per call,
+ * so that work is spread over the owning task's idle wakeups.
+ *
+ * Owned and used by a single task.
+ ******************************************************************************
+ */
+#ifndef CUBE_SYSTEM_LOG_ROTATOR_HPP_
+#define CUBE_SYSTEM_LOG_ROTATOR_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarFileSystem.hpp"
+#include <stdint.h>
+
+/* Macros ------------------------------------------------------------------*/
+constexpr uint32_t LOG_ROTATOR_MAX_SPARES = 4;           // Upper bound of LogRotationConfig::spares
+constexpr uint32_t LOG_ROTATOR_MAX_SEQUENCE = 99999;     // Five digits, keeps names within 8.3
+constexpr const char *LOG_ROTATOR_SPARE_EXTENSION = "PRE";
+
+/* Structs ------------------------------------------------------------------*/
+struct LogRotationConfig
+{
+    const char *prefix;      // Up to 3 upper case characters
+    const char *extension;   // Up to 3 upper case characters, not LOG_ROTATOR_SPARE_EXTENSION
+    uint32_t fileBytes;      // Reservation of each file, also the size a file rolls over at
+    uint32_t maxAgeMs;       // Roll over once a file has been open this long, 0 for size only
+    uint32_t spares;         // Preallocated next files kept ready, at most LOG_ROTATOR_MAX_SPARES
+    uint32_t lowWaterBytes;  // Start deleting the oldest logs once free space drops below this
+    uint32_t highWaterBytes; // and stop once this much is free again
+};
+
+/* Class ------------------------------------------------------------------*/
+class LogRotator
+{
+public:
+    LogRotator(const LogRotationConfig &config);
+
+    SoarFS_Result_t Scan();  // Call once the media is mounted, finds existing logs and spares
+    void Suspend();          // Call once the media is gone, forgets everything Scan found
+    SoarFS_Result_t OpenNext(const SoarFS_SyncPolicy_t *policy, char *filename, SoarFS_Handle_t *handle);
+    void Service();          // Refill the pool or delete one old log, call when the task is otherwise idle
+
+    bool NewestLog(char *filename); // Name of the highest numbered log Scan found, false if none
+    const LogRotationConfig &Config() const { return config; }
+    void PrintStats();
+
+private:
+    void MakeName(char *filename, uint32_t sequence, const char *extension);
+    bool ParseName(const char *filename, uint32_t *sequence, bool *spare);
+    static void ScanFile(const char *filename, uint32_t fileSize, void *context);
+
+    LogRotationConfig config;
+    bool scanned;                          // Sequences below are valid for the mounted media
+    bool reclaiming;                       // Between crossing the low and the high watermark
+    bool reserveBlocked;                   // A spare found no contiguous run, delete a log before retrying
+    uint32_t activeSequence;               // Sequence of the open log, 0 before the first OpenNext
+    uint32_t oldestSequence;               // Lowest sequence that may still exist as a log
+    uint32_t lastSequence;                 // Highest sequence used by a log or a spare
+    uint32_t newestLogSequence;            // Highest log found by Scan
+    uint32_t spareSequences[LOG_ROTATOR_MAX_SPARES]; // Ascending
+    uint32_t spareCount;
+
+    // Counters
+    uint32_t filesOpened;
+    uint32_t poolMisses;     // Opens that had to reserve their file on the spot
+    uint32_t sparesReserved;
+    uint32_t logsDeleted;
+    uint32_t reserveFailures;
+};
+
+#endif // CUBE_SYSTEM_LOG_ROTATOR_HPP_
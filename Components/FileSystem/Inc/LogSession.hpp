@@ -0,0 +1,86 @@
+/**
+ ******************************************************************************
+ * File Name          : LogSession.hpp
+ * Description        : Framed log kept open across samples, rollovers and media swaps
+ ******************************************************************************
+ *
+ * A LogSession opens a log once when the media mounts and streams records
+ * into it through a write-behind appender. Nothing touches the directory
+ * entry until the log is closed: every checkpoint interval the partial block
+ * and a commit block are written and the data sectors flushed, see
+ * SoarLogJournalFormat.hpp. Start trims the newest log on the media back to
+ * its last commit point, which bounds the data lost on a power cut to one
+ * interval.
+ *
+ * Logs come from a LogRotator. The session rolls over to the next one when
+ * the reservation of the current file is full or it reaches its maximum age,
+ * and keeps the rotator's spare pool and free space watermark serviced from
+ * Poll. When the media is pulled the session is suspended without I/O,
+ * keeping the records of the block being filled, and continues in a new log
+ * when the media comes back.
+ *
+ * One record type may be column encoded: its records are batched and
+ * written as column blocks, at checkpoints or when a block's worth is ready,
+ * instead of going into the data blocks.
+ *
+ * Owned and used by a single task.
+ ******************************************************************************
+ */
+#ifndef CUBE_SYSTEM_LOG_SESSION_HPP_
+#define CUBE_SYSTEM_LOG_SESSION_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLogWriter.hpp"
+#include "SoarLogColumns.hpp"
+#include "SoarLogRecovery.hpp"
+#include "LogRotator.hpp"
+#include <stdint.h>
+
+/* Class ------------------------------------------------------------------*/
+class LogSession
+{
+public:
+    LogSession(const LogRotationConfig &rotation, uint32_t checkpointIntervalMs);
+
+    SoarFS_Result_t Start();  // Call once the media is mounted, opens the next log
+    void Suspend();           // Call once the media is gone, no I/O
+    SoarFS_Result_t Stop();   // Checkpoint and close
+    void Poll(uint32_t now);  // Checkpoints, rolls over by age, retries a failed Start and services the rotator
+
+    SoarFS_Result_t EnableColumns(uint8_t type); // Column encode the records of this type from now on
+    SoarFS_Result_t Append(uint8_t type, uint32_t timestamp, const void *payload, uint8_t length);
+    SoarFS_Result_t Checkpoint();
+    SoarFS_Result_t Rotate(); // Close the current log and continue in the next one
+
+    bool IsOpen() const { return writer.isOpen; }
+    void PrintStats();
+
+private:
+    SoarFS_Result_t OpenNextLog();
+    void RecoverNewestLog();
+    SoarFS_Result_t FlushColumns();
+    bool ColumnsFit() const;
+
+    SoarLog_Writer_t writer;
+    SoarLog_ColumnBatch_t columns; // Kept across rollovers and media swaps like the writer's block
+    SoarFS_SyncPolicy_t policy;
+    LogRotator rotator;
+    uint32_t checkpointIntervalMs;
+    uint32_t lastCheckpointTick;
+    uint32_t logOpenedTick;
+    bool started;      // Writer holds records from before a media swap to carry into the next log
+    bool retryStart;   // No log could be opened on mounted media, Poll tries again every checkpoint interval
+    SoarLog_Recovery_t recovery; // Of the newest log at the last Start
+    char recoveredLog[SOAR_FS_MAX_FILENAME_LEN];
+    uint32_t recoveryUs;
+
+    // Counters
+    uint32_t opens;
+    uint32_t resumes;
+    uint32_t rollovers;
+    uint32_t checkpoints;
+    uint32_t recoveries;     // Logs trimmed back to a commit point
+    uint32_t droppedRecords; // Appended while suspended or on a write error
+};
+
+#endif // CUBE_SYSTEM_LOG_SESSION_HPP_
@@ -34,13 +34,117 @@ extern "C"
         SOAR_FS_FILE_ALREADY_OPEN = -7,
         SOAR_FS_FILE_NOT_OPEN = -8,
         SOAR_FS_WRITE_PROTECTED = -9,
-        SOAR_FS_TIMEOUT = -10
+        SOAR_FS_TIMEOUT = -10,
+        SOAR_FS_INVALID_HANDLE = -11,
+        SOAR_FS_END_OF_FILE = -12
     } SoarFS_Result_t;
 
+    /**
+     * @brief Opaque handle to an open file
+     *
+     * Encodes the slot index and a generation count, so a handle that outlives
+     * its file (closed and the slot reused) is rejected instead of aliasing.
+     * A value of SOAR_FS_NULL_HANDLE is never returned for an open file.
+     */
+    typedef uint32_t SoarFS_Handle_t;
+
+    /**
+     * @brief When an appender commits its data to the storage with f_sync
+     *
+     * Durability window, i.e. data lost if power is cut, per mode:
+     *  - EVERY_N_BYTES : at most syncBytes + the size of the record being written
+     *  - EVERY_T_MS    : at most syncIntervalMs of data, plus the SoarFS_Poll period
+     *                    when no writes arrive to trigger the check
+     *  - ON_FLUSH      : everything since the last SoarFS_Flush or close
+     *  - ON_CLOSE      : everything since open, SoarFS_Flush only drains the
+     *                    staging buffer into FatFS without updating the directory
+     * Until a commit, the directory entry still holds the old file size, so
+     * uncommitted data is not visible after a reset even if its sectors were written.
+     */
+    typedef enum
+    {
+        SOAR_FS_SYNC_EVERY_N_BYTES = 0,
+        SOAR_FS_SYNC_EVERY_T_MS,
+        SOAR_FS_SYNC_ON_FLUSH,
+        SOAR_FS_SYNC_ON_CLOSE
+    } SoarFS_SyncMode_t;
+
+    typedef struct
+    {
+        SoarFS_SyncMode_t mode;
+        uint32_t syncBytes;      // Used by SOAR_FS_SYNC_EVERY_N_BYTES
+        uint32_t syncIntervalMs; // Used by SOAR_FS_SYNC_EVERY_T_MS
+    } SoarFS_SyncPolicy_t;
+
+    /**
+     * @brief Called by SoarFS_ListFiles for each file, must not create or delete files
+     */
+    typedef void (*SoarFS_ListCallback_t)(const char *filename, uint32_t fileSize, void *context);
+
+    /**
+     * @brief Operations timed by the instrumentation, one per API function unless noted.
+     * Nested calls are counted by each operation, SoarFS_WriteFile includes its Seek,
+     * Write and Sync.
+     */
+    typedef enum
+    {
+        SOAR_FS_OP_MOUNT = 0,   // Every mount attempt, at init and on remount
+        SOAR_FS_OP_FREE_SPACE,
+        SOAR_FS_OP_CREATE_FILE,
+        SOAR_FS_OP_OPEN_FILE,
+        SOAR_FS_OP_CLOSE_FILE,
+        SOAR_FS_OP_READ_FILE,
+        SOAR_FS_OP_WRITE_FILE,
+        SOAR_FS_OP_DELETE_FILE,
+        SOAR_FS_OP_STAT,        // SoarFS_FileExists and SoarFS_GetFileSize
+        SOAR_FS_OP_OPEN,        // SoarFS_Open, SoarFS_OpenReader and SoarFS_OpenAppender
+        SOAR_FS_OP_CLOSE,
+        SOAR_FS_OP_READ,
+        SOAR_FS_OP_WRITE,
+        SOAR_FS_OP_SEEK,
+        SOAR_FS_OP_FLUSH,
+        SOAR_FS_OP_FLUSH_DATA,
+        SOAR_FS_OP_SYNC,        // Every f_sync, from SoarFS_Sync, SoarFS_Flush or a sync policy
+        SOAR_FS_OP_TRUNCATE,
+        SOAR_FS_OP_CREATE_PREALLOCATED,
+        SOAR_FS_OP_RESERVE,
+        SOAR_FS_OP_OPEN_PREALLOCATED,
+        SOAR_FS_OP_RENAME,
+        SOAR_FS_OP_LIST,
+        SOAR_FS_OP_COUNT
+    } SoarFS_Op_t;
+
 /* Exported constants --------------------------------------------------------*/
 #define SOAR_FS_MAX_FILENAME_LEN 32
 #define SOAR_FS_MAX_FILES_OPEN 4
 #define SOAR_FS_BUFFER_SIZE 512
+#define SOAR_FS_NULL_HANDLE ((SoarFS_Handle_t)0)
+#define SOAR_FS_SEEK_END 0xFFFFFFFFu // Pass to SoarFS_Seek to move to the end of the file
+#define SOAR_FS_REMOUNT_INTERVAL_MS 1000 // Minimum time between remount attempts while unmounted
+#define SOAR_FS_CLMT_ENTRIES 16          // Fast-seek map: size, a length and start per fragment, terminator
+#define SOAR_FS_LATENCY_BUCKETS 16       // Power of two latency buckets per operation, the last one is open ended
+#define SOAR_FS_LATENCY_BUCKET0_US 4     // Upper bound of the first bucket, bucket i holds < (4 << i) us
+
+/* Time every operation, override with -DSOAR_FS_OP_STATS=0 to compile the instrumentation out */
+#ifndef SOAR_FS_OP_STATS
+#define SOAR_FS_OP_STATS 1
+#endif
+
+    typedef struct
+    {
+        uint32_t calls;
+        uint32_t errors;  // Calls that returned anything but SOAR_FS_OK
+        uint32_t bytes;   // Transferred by successful reads and writes
+        uint32_t totalUs; // Wraps after ~71 minutes spent in the operation
+        uint32_t maxUs;
+        uint32_t histogram[SOAR_FS_LATENCY_BUCKETS];
+    } SoarFS_OpStats_t;
+
+    typedef struct
+    {
+        SoarFS_OpStats_t ops[SOAR_FS_OP_COUNT];
+        uint32_t mediaRemovals; // Times the media was found gone and every handle dropped
+    } SoarFS_Stats_t;
 
     /* Exported function prototypes ----------------------------------------------*/
 
@@ -57,17 +161,24 @@ extern "C"
     SoarFS_Result_t SoarFS_DeInit(void);
 
     /**
-     * @brief Check if the file system is mounted and ready
+     * @brief Check if the file system is mounted and ready, retrying the mount at
+     * most every SOAR_FS_REMOUNT_INTERVAL_MS while it is not
+     *
+     * When the disk driver reports the media gone, every open handle is released
+     * without I/O and becomes stale; reopen files once this returns true again.
      * @retval bool True if mounted, false otherwise
      */
     bool SoarFS_IsMounted(void);
 
     /**
      * @brief Get available free space on the storage device
+     *
+     * O(1): the free cluster count is seeded once at mount and FatFS keeps it
+     * current on every cluster allocation and release.
      * @param freeBytes Pointer to store free bytes available
      * @retval SoarFS_Result_t Status of operation
      */
-    SoarFS_Result_t SoarFS_GetFreeSpace(uint32_t *freeBytes);
+    SoarFS_Result_t SoarFS_GetFreeSpace(uint64_t *freeBytes);
 
     /**
      * @brief Create a new file with specified content
@@ -133,12 +244,234 @@ extern "C"
      */
     SoarFS_Result_t SoarFS_GetFileSize(const char *filename, uint32_t *fileSize);
 
+    /* Handle-based API -------------------------------------------------------------
+     * Resolving a handle is O(1) and does no string work, use these on hot paths.
+     * The filename-based functions above are a compatibility layer over these.
+     */
+
+    /**
+     * @brief Open an existing file and return a handle to it
+     * @param filename Name of the file to open
+     * @param handle Pointer to store the handle of the opened file
+     * @retval SoarFS_Result_t Status of file opening
+     */
+    SoarFS_Result_t SoarFS_Open(const char *filename, SoarFS_Handle_t *handle);
+
+    /**
+     * @brief Close a file, the handle is invalid after this call
+     * @param handle Handle of the file to close
+     * @retval SoarFS_Result_t Status of file closing
+     */
+    SoarFS_Result_t SoarFS_Close(SoarFS_Handle_t handle);
+
+    /**
+     * @brief Read data from the current position of a file
+     * @param handle Handle of the file to read from
+     * @param buffer Pointer to buffer to store read data
+     * @param bufferSize Size of the buffer
+     * @param bytesRead Pointer to store actual bytes read
+     * @retval SoarFS_Result_t Status of read operation
+     */
+    SoarFS_Result_t SoarFS_Read(SoarFS_Handle_t handle, uint8_t *buffer, uint32_t bufferSize, uint32_t *bytesRead);
+
+    /**
+     * @brief Write data at the current position of a file, does not sync
+     * @param handle Handle of the file to write to
+     * @param data Pointer to data to write
+     * @param dataSize Size of data in bytes
+     * @retval SoarFS_Result_t Status of write operation
+     */
+    SoarFS_Result_t SoarFS_Write(SoarFS_Handle_t handle, const uint8_t *data, uint32_t dataSize);
+
+    /**
+     * @brief Flush cached data and the directory entry of a file to the storage
+     * @param handle Handle of the file to sync
+     * @retval SoarFS_Result_t Status of sync operation
+     */
+    SoarFS_Result_t SoarFS_Sync(SoarFS_Handle_t handle);
+
+    /**
+     * @brief Move the read/write position of a file
+     * @param handle Handle of the file
+     * @param offset Byte offset from the start of the file, or SOAR_FS_SEEK_END
+     * @retval SoarFS_Result_t Status of seek operation
+     */
+    SoarFS_Result_t SoarFS_Seek(SoarFS_Handle_t handle, uint32_t offset);
+
+    /**
+     * @brief Get the read/write position of a file
+     * @param handle Handle of the file
+     * @param offset Pointer to store the byte offset from the start of the file
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarFS_Tell(SoarFS_Handle_t handle, uint32_t *offset);
+
+    /**
+     * @brief Open an existing file read-only with a fast-seek map, so seeking anywhere
+     * in it reads no FAT sectors
+     * @param filename Name of the file to open
+     * @param handle Pointer to store the handle of the opened file
+     * @retval SoarFS_Result_t Status of open operation, a file too fragmented for the map
+     * still opens and seeks by walking its cluster chain
+     */
+    SoarFS_Result_t SoarFS_OpenReader(const char *filename, SoarFS_Handle_t *handle);
+
+    /* Write-behind appender ---------------------------------------------------------
+     * An appender stages writes in a sector-aligned buffer and hands FatFS whole
+     * sectors, committing to the storage per its SoarFS_SyncPolicy_t instead of
+     * on every write. SoarFS_Write on an appender handle always appends.
+     */
+
+    /**
+     * @brief Open an existing file as a write-behind appender positioned at its end
+     * @param filename Name of the file to open
+     * @param policy Sync policy of the file, copied
+     * @param handle Pointer to store the handle of the opened file
+     * @retval SoarFS_Result_t Status of file opening
+     */
+    SoarFS_Result_t SoarFS_OpenAppender(const char *filename, const SoarFS_SyncPolicy_t *policy, SoarFS_Handle_t *handle);
+
+    /**
+     * @brief Drain staged data to FatFS and sync it, unless the policy is SOAR_FS_SYNC_ON_CLOSE
+     * @param handle Handle of the file, behaves as SoarFS_Sync for non-appender handles
+     * @retval SoarFS_Result_t Status of flush operation
+     */
+    SoarFS_Result_t SoarFS_Flush(SoarFS_Handle_t handle);
+
+    /**
+     * @brief Drain staged data and write the data sectors through to the storage, without
+     * updating the directory entry. Only writes inside the reservation of a preallocated
+     * file need no FAT or directory update, anything else falls back to SoarFS_Sync.
+     * @param handle Handle of the file
+     * @retval SoarFS_Result_t Status of flush operation
+     */
+    SoarFS_Result_t SoarFS_FlushData(SoarFS_Handle_t handle);
+
+    /**
+     * @brief Cut a file at its read/write position. A preallocated file keeps its
+     * reservation until it is closed, then is truncated here.
+     * @param handle Handle of the file, opened for writing
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarFS_Truncate(SoarFS_Handle_t handle);
+
+    /**
+     * @brief Check if a handle was opened as a write-behind appender
+     * @param handle Handle of the file
+     * @retval bool False for plain handles and invalid handles
+     */
+    bool SoarFS_IsAppender(SoarFS_Handle_t handle);
+
+    /**
+     * @brief Service time based sync policies, call periodically from the owning task
+     */
+    void SoarFS_Poll(void);
+
+    /* Preallocated files -------------------------------------------------------------
+     * The whole cluster chain is reserved contiguously at creation, so writes
+     * inside it never allocate clusters or touch the FAT, and a fast-seek map
+     * makes seeks and reads O(1). Writes past the last reserved cluster fail with
+     * SOAR_FS_DISK_FULL. On close the file is truncated to the furthest byte
+     * written; if power is lost first it keeps its reserved size, so readers
+     * must find the end of valid data from the content itself.
+     */
+
+    /**
+     * @brief Create a new file with a contiguous reservation and open it at offset 0
+     * @param filename Name of the file to create, must not exist
+     * @param bytes Size to reserve
+     * @param policy Sync policy to open it as a write-behind appender, or NULL for a plain handle
+     * @param handle Pointer to store the handle of the created file
+     * @retval SoarFS_Result_t SOAR_FS_DISK_FULL if no contiguous free run is large enough
+     */
+    SoarFS_Result_t SoarFS_CreatePreallocated(const char *filename, uint32_t bytes, const SoarFS_SyncPolicy_t *policy,
+                                              SoarFS_Handle_t *handle);
+
+    /**
+     * @brief Create a new file with a contiguous reservation and close it at its full size,
+     * so it can be opened later with SoarFS_OpenPreallocated without allocating anything.
+     * Until then the file holds whatever the reserved clusters held before.
+     * @param filename Name of the file to create, must not exist
+     * @param bytes Size to reserve
+     * @retval SoarFS_Result_t SOAR_FS_DISK_FULL if no contiguous free run is large enough
+     */
+    SoarFS_Result_t SoarFS_Reserve(const char *filename, uint32_t bytes);
+
+    /**
+     * @brief Open a file made by SoarFS_Reserve at offset 0, treating its whole size as the reservation
+     * @param filename Name of the reserved file
+     * @param policy Sync policy to open it as a write-behind appender, or NULL for a plain handle
+     * @param handle Pointer to store the handle of the opened file
+     * @retval SoarFS_Result_t Status of file opening
+     */
+    SoarFS_Result_t SoarFS_OpenPreallocated(const char *filename, const SoarFS_SyncPolicy_t *policy,
+                                            SoarFS_Handle_t *handle);
+
+    /**
+     * @brief Rename a file, only its directory entry is rewritten
+     * @param oldName Name of the file, must not be open
+     * @param newName New name, must not exist
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarFS_Rename(const char *oldName, const char *newName);
+
+    /**
+     * @brief Call a function for every file in the root directory, in directory order
+     * @param callback Called with each file's 8.3 name and size
+     * @param context Passed through to callback
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarFS_ListFiles(SoarFS_ListCallback_t callback, void *context);
+
     /**
      * @brief Close all open files
      * @retval SoarFS_Result_t Status of operation
      */
     SoarFS_Result_t SoarFS_CloseAllFiles(void);
 
+    /**
+     * @brief Erase the volume and make a new FAT volume on it, only on the RAM disk and
+     * disk image backends. Every open file is closed and its handle goes stale.
+     * @param clusterBytes Cluster size, a power of two multiple of the sector size, or 0 for the FatFS default
+     * @retval SoarFS_Result_t SOAR_FS_WRITE_PROTECTED on real media, SOAR_FS_ERROR if the
+     * volume cannot hold a FAT volume with that cluster size, it is then left as it was
+     */
+    SoarFS_Result_t SoarFS_Format(uint32_t clusterBytes);
+
+    /**
+     * @brief Get the cluster size of the mounted volume
+     * @param clusterBytes Pointer to store the cluster size in bytes
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarFS_GetClusterSize(uint32_t *clusterBytes);
+
+    /* Instrumentation ----------------------------------------------------------------
+     * Every operation is timed with the cycle counter, or a monotonic clock on the
+     * host, into a log2 latency histogram with call, error and byte counters. An
+     * interval is taken with two counter reads and a few adds, the counter wraps
+     * after ~25 s on target so a longer call is misreported. Updated by the task
+     * using the file system without locking, readers from another task may see a
+     * call half counted.
+     */
+
+    /**
+     * @brief Live counters of every operation, copy an entry for a consistent view
+     * @retval const SoarFS_Stats_t* Never NULL
+     */
+    const SoarFS_Stats_t *SoarFS_GetStats(void);
+
+    /**
+     * @brief Zero the counters of every operation
+     */
+    void SoarFS_ResetStats(void);
+
+    /**
+     * @brief Short lowercase name of an operation, e.g. "write_file"
+     * @param op Operation
+     * @retval const char* "?" for an unknown operation
+     */
+    const char *SoarFS_OpName(SoarFS_Op_t op);
+
 #ifdef __cplusplus
 }
 #endif
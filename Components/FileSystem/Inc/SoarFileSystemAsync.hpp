@@ -0,0 +1,116 @@
+/**
+ * File Name          : SoarFileSystemAsync.hpp
+ * Description        : Request descriptors for asynchronous SOAR File System access
+ * Author             : SOAR Team
+ *
+ * A task fills in a SoarFS_AsyncRequest_t and submits it with
+ * FileSystemTask::Submit(), which only queues a pointer to it and returns.
+ * FileSystemTask runs the operation and signals completion through the
+ * request's callback and/or a task notification. Requests complete in the
+ * order they were submitted, so several may be outstanding at once.
+ *
+ * The descriptor and every buffer it points to belong to FileSystemTask from
+ * Submit() until the request is complete, they must not be on a stack frame
+ * that returns before then. FileSystemTask::AllocateRequest() takes both from
+ * fixed pools instead, for submitters that do not keep descriptors of their own.
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_FILE_SYSTEM_ASYNC_HPP
+#define __SOAR_FILE_SYSTEM_ASYNC_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarFileSystem.hpp"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <atomic>
+
+/* Enums ------------------------------------------------------------------*/
+enum SOARFS_ASYNC_OP : uint8_t
+{
+    SOARFS_ASYNC_OPEN = 0, // filename, policy, createIfMissing -> handle
+    SOARFS_ASYNC_APPEND,   // handle, data, size -> bytes written, always at the end of the file
+    SOARFS_ASYNC_READ,     // handle, buffer, size, offset -> bytes read
+    SOARFS_ASYNC_FLUSH,    // handle, see SoarFS_Flush
+    SOARFS_ASYNC_CLOSE,    // handle
+    SOARFS_ASYNC_DELETE,   // filename
+};
+
+enum SOARFS_ASYNC_STATE : uint8_t
+{
+    SOARFS_ASYNC_IDLE = 0, // Never submitted, or rejected by Submit()
+    SOARFS_ASYNC_PENDING,  // Owned by FileSystemTask
+    SOARFS_ASYNC_DONE,     // result and bytes are valid, the descriptor may be reused
+};
+
+/* Structs ------------------------------------------------------------------*/
+struct SoarFS_AsyncRequest_t;
+
+/**
+ * @brief Completion callback, runs on FileSystemTask so it must not block
+ * or submit and wait on another request
+ */
+typedef void (*SoarFS_AsyncCallback_t)(SoarFS_AsyncRequest_t *request);
+
+struct SoarFS_AsyncRequest_t
+{
+    // Operation and its arguments
+    SOARFS_ASYNC_OP op;
+    bool createIfMissing;                    // OPEN: create an empty file first if it does not exist
+    const char *filename;                    // OPEN, DELETE
+    const SoarFS_SyncPolicy_t *policy;       // OPEN: open as a write-behind appender, or NULL for a plain handle
+    SoarFS_Handle_t handle;                  // Set by OPEN, used by every other operation
+    const SoarFS_AsyncRequest_t *handleFrom; // If set, take handle from this earlier OPEN when run, so an open
+                                             // and its writes can be submitted together
+    uint8_t *buffer;                         // APPEND source, READ destination
+    uint32_t size;                           // Bytes to append or read
+    uint32_t offset;                         // READ: file offset to read from
+
+    // Completion, either or both may be set
+    SoarFS_AsyncCallback_t callback;
+    void *context;           // Free for the callback's use
+    TaskHandle_t notifyTask; // Task whose notification value gets notifyBits set, eSetBits
+    uint32_t notifyBits;
+    bool releaseWhenDone; // From AllocateRequest(): give it back once signalled, outputs are only valid in the callback
+
+    // Outputs, valid once state is SOARFS_ASYNC_DONE
+    SoarFS_Result_t result;
+    uint32_t bytes; // Bytes appended or read
+    std::atomic<uint8_t> state;
+};
+
+/* Inline Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Reset a descriptor to an idle request for op with no completion signal
+ */
+inline void SoarFS_AsyncInit(SoarFS_AsyncRequest_t *request, SOARFS_ASYNC_OP op)
+{
+    request->op = op;
+    request->createIfMissing = false;
+    request->filename = nullptr;
+    request->policy = nullptr;
+    request->handle = SOAR_FS_NULL_HANDLE;
+    request->handleFrom = nullptr;
+    request->buffer = nullptr;
+    request->size = 0;
+    request->offset = 0;
+    request->callback = nullptr;
+    request->context = nullptr;
+    request->notifyTask = nullptr;
+    request->notifyBits = 0;
+    request->releaseWhenDone = false;
+    request->result = SOAR_FS_OK;
+    request->bytes = 0;
+    request->state.store(SOARFS_ASYNC_IDLE);
+}
+
+/**
+ * @brief Check if FileSystemTask is finished with a request
+ */
+inline bool SoarFS_AsyncIsDone(const SoarFS_AsyncRequest_t *request)
+{
+    return request->state.load(std::memory_order_acquire) == SOARFS_ASYNC_DONE;
+}
+
+#endif /* __SOAR_FILE_SYSTEM_ASYNC_HPP */
@@ -0,0 +1,104 @@
+/**
+ * File Name          : SoarFileSystemBenchmark.hpp
+ * Description        : Microbenchmarks for the SOAR File System wrapper
+ * Author             : SOAR Team
+ *
+ * Each benchmark runs against whichever diskio backend FatFS is linked to and
+ * prints its results over the debug UART.
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_FILE_SYSTEM_BENCHMARK_HPP
+#define __SOAR_FILE_SYSTEM_BENCHMARK_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarFileSystem.hpp"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* Exported function prototypes ----------------------------------------------*/
+
+    /**
+     * @brief Compare the per-call cost of the filename API against the handle API
+     */
+    void SoarFS_Bench_HandleLookup(void);
+
+    /**
+     * @brief Compare append throughput and disk writes per record of SoarFS_WriteFile
+     * against the write-behind appender under each sync policy
+     */
+    void SoarFS_Bench_AppendThroughput(void);
+
+    /**
+     * @brief Compare backend traffic of round-robin appends to several files with
+     * the sector cache bypassed and enabled
+     */
+    void SoarFS_Bench_MultiFileAppend(void);
+
+    /**
+     * @brief Compare per-record write latency and random seek cost of a growing
+     * file against a preallocated one
+     */
+    void SoarFS_Bench_Preallocated(void);
+
+    /**
+     * @brief Report the SoarLZ compression ratio and cycles per byte to encode and
+     * decode synthetic telemetry at the current core clock
+     */
+    void SoarFS_Bench_Compression(void);
+
+    /**
+     * @brief Report bytes per record and encode cycles per record of column encoded
+     * env and flight records against plain data blocks
+     */
+    void SoarFS_Bench_ColumnEncoding(void);
+
+    /**
+     * @brief Report blocks read and time taken to extract the last seconds of a log
+     * through its time index against a scan from the start
+     */
+    void SoarFS_Bench_TimeSeek(void);
+
+    /**
+     * @brief Compare the cost of a log checkpoint that syncs the directory entry
+     * against a commit block and a data flush
+     */
+    void SoarFS_Bench_CommitCost(void);
+
+    /**
+     * @brief Cut power at random sector writes while a log is written, recover it and
+     * check it holds every committed record and nothing else, reporting recovery time.
+     * Needs the fault injector, USER_DISKIO_FAULT=1.
+     */
+    void SoarFS_Bench_PowerLoss(void);
+
+    /**
+     * @brief Pull the RAM disk, check several remounts fail while it is out and that the
+     * volume mounts again with its files once it is reinserted. RAM disk backend only,
+     * waits a few remount intervals.
+     */
+    void SoarFS_Bench_MediaRemoval(void);
+
+    /**
+     * @brief Sweep record size, open files, sync policy and cluster size, printing one
+     * "BENCH,sweep,..." CSV line per run with write and read throughput, p50/p99/max
+     * append latency and sectors written per record
+     * @param formatVolume Reformat the volume for each cluster size, erasing it. Only on
+     * the RAM disk and disk image backends, real media is swept at its own cluster size.
+     * Runs use up to SOAR_FS_MAX_FILES_OPEN files, so nothing else may hold a file open.
+     */
+    void SoarFS_Bench_Sweep(bool formatVolume);
+
+    /**
+     * @brief Run every benchmark in sequence, nothing else may hold a file open
+     */
+    void SoarFS_Bench_RunAll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SOAR_FILE_SYSTEM_BENCHMARK_HPP */
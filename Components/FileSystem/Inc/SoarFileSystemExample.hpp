@@ -49,11 +49,22 @@ extern "C"
      */
     void SoarFS_Example_StoreBinaryData(void);
 
+    /**
+     * @brief Example function demonstrating a compressed text log
+     */
+    void SoarFS_Example_CompressedLog(void);
+
     /**
      * @brief Example function demonstrating file management
      */
     void SoarFS_Example_FileManagement(void);
 
+    /**
+     * @brief Example function demonstrating pipelined asynchronous requests,
+     * call from any task other than FileSystemTask
+     */
+    void SoarFS_Example_AsyncPipeline(void);
+
     /**
      * @brief Example error handling function
      * @param result The result code to handle
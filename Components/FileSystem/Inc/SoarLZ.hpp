@@ -0,0 +1,104 @@
+/**
+ * File Name          : SoarLZ.hpp
+ * Description        : Streaming compressor for files written through SOAR File System
+ * Author             : SOAR Team
+ *
+ * Compresses a byte stream into independently decodable, sector sized blocks,
+ * see SoarLZFormat.hpp. All state, including the match window and the block
+ * being built, lives in the caller-owned writer, so there is no heap use.
+ * Bytes are held until a full block's worth has been compressed or until
+ * SoarLZ_Flush, which writes the partial block out padded to a whole sector.
+ * Not thread safe, use each writer from a single task.
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_LZ_HPP
+#define __SOAR_LZ_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarFileSystem.hpp"
+#include "SoarLZFormat.hpp"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define SOAR_LZ_HASH_BITS 10 // Match finder table of 2^n most recent positions
+
+    /* Exported types ------------------------------------------------------------*/
+
+    /**
+     * @brief Receives each sealed SOAR_LOG_BLOCK_SIZE byte block
+     */
+    typedef SoarFS_Result_t (*SoarLZ_Sink_t)(const uint8_t *block, void *context);
+
+    typedef struct
+    {
+        SoarLZ_Sink_t sink;
+        void *context;
+        SoarFS_Handle_t handle; // File of SoarLZ_Open, closed by SoarLZ_Close
+        bool isOpen;
+        uint32_t sequence;   // Sequence number of the block being built
+        uint16_t rawLength;  // Bytes in the window
+        uint16_t encoded;    // Window bytes already encoded into the block
+        uint16_t packed;     // Payload bytes used in the block
+        uint16_t flagOffset; // Payload offset of the flags byte being filled
+        uint8_t flagBit;     // Next bit of it, 8 when the next item needs a new flags byte
+        uint32_t rawBytes;   // Bytes written by the caller
+        uint32_t blocksWritten;
+        uint32_t blocksDropped; // Sealed blocks the sink failed to take
+        uint16_t head[1 << SOAR_LZ_HASH_BITS];
+        uint8_t window[SOAR_LZ_WINDOW];
+        uint8_t block[SOAR_LOG_BLOCK_SIZE] __attribute__((aligned(4)));
+    } SoarLZ_Writer_t;
+
+    /* Exported function prototypes ----------------------------------------------*/
+
+    /**
+     * @brief Start a compressed stream into a custom sink, e.g. memory or a benchmark
+     * @param writer Writer state, owned by the caller
+     * @param sink Called with every sealed block
+     * @param context Passed through to sink
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLZ_Init(SoarLZ_Writer_t *writer, SoarLZ_Sink_t sink, void *context);
+
+    /**
+     * @brief Open a compressed file for appending, creating it if it does not exist
+     * @param writer Writer state, owned by the caller
+     * @param filename 8.3 name of the file
+     * @param policy Sync policy to open it as a write-behind appender, or NULL to sync every block
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLZ_Open(SoarLZ_Writer_t *writer, const char *filename, const SoarFS_SyncPolicy_t *policy);
+
+    /**
+     * @brief Compress bytes into the stream, writing out every block that fills
+     * @param writer Open writer
+     * @param data Bytes to compress
+     * @param dataSize Bytes in data
+     * @retval SoarFS_Result_t Status of operation, the bytes are taken even if a block failed to write
+     */
+    SoarFS_Result_t SoarLZ_Write(SoarLZ_Writer_t *writer, const uint8_t *data, uint32_t dataSize);
+
+    /**
+     * @brief Compress everything held and write the partial block out, later bytes start a new block
+     * @param writer Open writer
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLZ_Flush(SoarLZ_Writer_t *writer);
+
+    /**
+     * @brief Flush, and close the file if the writer was opened with SoarLZ_Open
+     * @param writer Open writer
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLZ_Close(SoarLZ_Writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SOAR_LZ_HPP */
@@ -0,0 +1,111 @@
+/**
+ * File Name          : SoarLZFormat.hpp
+ * Description        : On-media layout and decoder of SOAR compressed streams
+ * Author             : SOAR Team
+ *
+ * Shared by the firmware compressor and the host tools, so it only depends on
+ * SoarLogFormat.hpp. All multi-byte fields are little endian.
+ *
+ * A compressed file is a sequence of SOAR_LOG_BLOCK_SIZE byte blocks framed
+ * exactly like a log block (SoarLog_BlockHeader_t, payload, CRC-32) but with
+ * SOAR_LZ_MAGIC, so the same resynchronization applies. The match window
+ * restarts at every block, so each block decodes on its own and a corrupt
+ * block costs only the bytes it held. Payload:
+ *
+ *   [raw length, uint16][flags][item] x8 [flags][item] x8 ...
+ *
+ * Bit n (LSB first) of a flags byte describes the n-th item after it:
+ *   0 -> literal, one byte
+ *   1 -> match, uint16 ((offset - 1) << SOAR_LZ_LENGTH_BITS | (length - SOAR_LZ_MIN_MATCH)),
+ *        copy length bytes starting offset bytes back in this block's output
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_LZ_FORMAT_HPP
+#define __SOAR_LZ_FORMAT_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLogFormat.hpp"
+
+/* Exported constants --------------------------------------------------------*/
+#define SOAR_LZ_MAGIC 0x305A4C53u // "SLZ0"
+#define SOAR_LZ_VERSION 1
+#define SOAR_LZ_BLOCK_PACKED 1    // blockType of every compressed block
+#define SOAR_LZ_RAW_LENGTH_SIZE 2 // Leading payload field
+#define SOAR_LZ_LENGTH_BITS 5
+#define SOAR_LZ_MIN_MATCH 3
+#define SOAR_LZ_MAX_MATCH (SOAR_LZ_MIN_MATCH + (1 << SOAR_LZ_LENGTH_BITS) - 1)
+#define SOAR_LZ_WINDOW (1 << (16 - SOAR_LZ_LENGTH_BITS)) // Also the most raw bytes one block holds
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Decode the payload of a compressed block, its header and CRC already checked
+ * @param payload Block payload, header.payloadLength bytes
+ * @param length Bytes in payload
+ * @param out Receives the raw bytes, SOAR_LZ_WINDOW bytes is always enough
+ * @param outCapacity Bytes available in out
+ * @retval int32_t Raw bytes decoded, or -1 if the payload is malformed
+ */
+static inline int32_t SoarLZ_Unpack(const uint8_t *payload, uint32_t length, uint8_t *out, uint32_t outCapacity)
+{
+    if (length < SOAR_LZ_RAW_LENGTH_SIZE)
+    {
+        return -1;
+    }
+
+    const uint32_t rawLength = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8);
+    if (rawLength > outCapacity)
+    {
+        return -1;
+    }
+
+    uint32_t in = SOAR_LZ_RAW_LENGTH_SIZE;
+    uint32_t produced = 0;
+    while (produced < rawLength)
+    {
+        if (in >= length)
+        {
+            return -1;
+        }
+        const uint8_t flags = payload[in++];
+
+        for (uint32_t bit = 0; bit < 8 && produced < rawLength; bit++)
+        {
+            if ((flags & (1u << bit)) == 0)
+            {
+                if (in >= length)
+                {
+                    return -1;
+                }
+                out[produced++] = payload[in++];
+                continue;
+            }
+
+            if (in + 2 > length)
+            {
+                return -1;
+            }
+            const uint32_t token = (uint32_t)payload[in] | ((uint32_t)payload[in + 1] << 8);
+            in += 2;
+
+            const uint32_t offset = (token >> SOAR_LZ_LENGTH_BITS) + 1;
+            const uint32_t count = (token & ((1u << SOAR_LZ_LENGTH_BITS) - 1)) + SOAR_LZ_MIN_MATCH;
+            if (offset > produced || count > rawLength - produced)
+            {
+                return -1;
+            }
+
+            // Byte by byte, a match may overlap the bytes it produces
+            for (uint32_t i = 0; i < count; i++)
+            {
+                out[produced + i] = out[produced + i - offset];
+            }
+            produced += count;
+        }
+    }
+
+    return (int32_t)produced;
+}
+
+#endif /* __SOAR_LZ_FORMAT_HPP */
@@ -0,0 +1,341 @@
+/**
+ * File Name          : SoarLogColumnFormat.hpp
+ * Description        : Layout and codec of column encoded SOAR log blocks
+ * Author             : SOAR Team
+ *
+ * Shared by the firmware encoder and the host tools, so it only depends on
+ * SoarLogFormat.hpp. All multi-byte fields are little endian.
+ *
+ * A SOAR_LOG_BLOCK_COLUMNS block holds a batch of records of one fixed length
+ * type, stored field by field instead of record by record. Payload:
+ *
+ *   [record type][count][first timestamp, uint32]
+ *   [timestamp deltas, count - 1 varints]
+ *   [field 0 of every record][field 1 of every record] ...
+ *
+ * Each field is coded against the same field of the previous record, starting
+ * from 0 in every block so each block decodes on its own:
+ *   - integers: zigzag varint of the difference
+ *   - floats with a scale ("name:f*100"): quantized to round(value * scale),
+ *     then zigzag varint of the difference, lossy below 1 / scale
+ *   - floats without a scale: varint of the XOR with the previous bit pattern
+ *
+ * Varints hold 7 bits per byte, low bits first, the top bit set on every byte
+ * but the last. Slowly changing fields cost a byte or two per record instead
+ * of their full width.
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_LOG_COLUMN_FORMAT_HPP
+#define __SOAR_LOG_COLUMN_FORMAT_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLogFormat.hpp"
+#include <string.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define SOAR_LOG_COLUMN_HEADER_SIZE 6    // Type, count and first timestamp
+#define SOAR_LOG_COLUMN_MAX_FIELDS 8     // Per record type
+#define SOAR_LOG_COLUMN_MAX_RECORDS 128  // Per block
+#define SOAR_LOG_COLUMN_MAX_VARINT 5     // Bytes of the longest 32 bit varint
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+    char code;      // SOAR_LOG_FIELD_*, never SOAR_LOG_FIELD_TEXT
+    uint8_t offset; // Within the record payload
+    uint8_t size;
+    uint32_t scale; // Floats only, 0 for XOR coding
+} SoarLog_ColumnField_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Byte size of a field type code, 0 for variable length text or an unknown code
+ */
+static inline uint32_t SoarLog_FieldSize(char code)
+{
+    switch (code)
+    {
+    case SOAR_LOG_FIELD_U8:
+    case SOAR_LOG_FIELD_I8:
+        return 1;
+    case SOAR_LOG_FIELD_U16:
+    case SOAR_LOG_FIELD_I16:
+        return 2;
+    case SOAR_LOG_FIELD_U32:
+    case SOAR_LOG_FIELD_I32:
+    case SOAR_LOG_FIELD_F32:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Parse a schema field list into column descriptors
+ * @param fields "name:code[*scale],..." as in SoarLog_SchemaEntry_t
+ * @param out Receives up to SOAR_LOG_COLUMN_MAX_FIELDS descriptors
+ * @retval int32_t Fields parsed, or -1 if the type has text or too many fields to be column encoded
+ */
+static inline int32_t SoarLog_ParseColumnFields(const char *fields, SoarLog_ColumnField_t *out)
+{
+    int32_t count = 0;
+    uint32_t offset = 0;
+    const char *p = fields;
+
+    while (*p != '\0')
+    {
+        while (*p != ':' && *p != ',' && *p != '\0')
+        {
+            p++;
+        }
+        if (*p != ':')
+        {
+            return -1;
+        }
+        p++;
+
+        const uint32_t size = SoarLog_FieldSize(*p);
+        if (size == 0 || count == SOAR_LOG_COLUMN_MAX_FIELDS || offset + size > SOAR_LOG_MAX_RECORD_PAYLOAD)
+        {
+            return -1;
+        }
+        SoarLog_ColumnField_t *field = &out[count++];
+        field->code = *p++;
+        field->offset = (uint8_t)offset;
+        field->size = (uint8_t)size;
+        field->scale = 0;
+        offset += size;
+
+        if (*p == '*')
+        {
+            for (p++; *p >= '0' && *p <= '9'; p++)
+            {
+                field->scale = field->scale * 10 + (uint32_t)(*p - '0');
+            }
+        }
+        if (*p == ',')
+        {
+            p++;
+        }
+        else if (*p != '\0')
+        {
+            return -1;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Map a signed value onto an unsigned one with small magnitudes near zero
+ */
+static inline uint32_t SoarLog_ZigZag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t SoarLog_UnZigZag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/**
+ * @brief Bytes the varint of value takes
+ */
+static inline uint32_t SoarLog_VarintSize(uint32_t value)
+{
+    uint32_t size = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+/**
+ * @brief Write the varint of value at p
+ * @retval uint32_t Bytes written
+ */
+static inline uint32_t SoarLog_PutVarint(uint8_t *p, uint32_t value)
+{
+    uint32_t n = 0;
+    while (value >= 0x80)
+    {
+        p[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = (uint8_t)value;
+    return n;
+}
+
+/**
+ * @brief Read a varint at *pos, advancing it
+ * @retval bool false if the varint runs past length or is longer than 32 bits
+ */
+static inline bool SoarLog_GetVarint(const uint8_t *p, uint32_t length, uint32_t *pos, uint32_t *value)
+{
+    uint32_t result = 0;
+    for (uint32_t shift = 0; shift < 7 * SOAR_LOG_COLUMN_MAX_VARINT; shift += 7)
+    {
+        if (*pos >= length)
+        {
+            return false;
+        }
+        const uint8_t byte = p[(*pos)++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief The 32 bit word a field is coded as: the integer, the quantized float or the float bits
+ */
+static inline uint32_t SoarLog_ColumnWord(const SoarLog_ColumnField_t *field, const uint8_t *record)
+{
+    const uint8_t *p = record + field->offset;
+    switch (field->code)
+    {
+    case SOAR_LOG_FIELD_U8:
+        return p[0];
+    case SOAR_LOG_FIELD_I8:
+        return (uint32_t)(int32_t)(int8_t)p[0];
+    case SOAR_LOG_FIELD_U16:
+    {
+        uint16_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    case SOAR_LOG_FIELD_I16:
+    {
+        int16_t v;
+        memcpy(&v, p, sizeof(v));
+        return (uint32_t)(int32_t)v;
+    }
+    case SOAR_LOG_FIELD_F32:
+        if (field->scale != 0)
+        {
+            float v;
+            memcpy(&v, p, sizeof(v));
+            float q = v * (float)field->scale;
+            if (!(q == q))
+            {
+                return 0; // NaN
+            }
+            q = (q < -2147483520.0f) ? -2147483520.0f : (q > 2147483520.0f) ? 2147483520.0f : q;
+            return (uint32_t)(int32_t)((q < 0.0f) ? q - 0.5f : q + 0.5f);
+        }
+        break; // The bit pattern is XOR coded
+    default:
+        break;
+    }
+
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief Store a word decoded by SoarLog_DecodeColumns back into a record
+ */
+static inline void SoarLog_ColumnStore(const SoarLog_ColumnField_t *field, uint32_t word, uint8_t *record)
+{
+    uint8_t *p = record + field->offset;
+    if (field->code == SOAR_LOG_FIELD_F32 && field->scale != 0)
+    {
+        float v = (float)(int32_t)word / (float)field->scale;
+        memcpy(p, &v, sizeof(v));
+        return;
+    }
+
+    // Little endian, the low bytes are the narrower types
+    memcpy(p, &word, field->size);
+}
+
+/**
+ * @brief Code a word against the same field of the previous record
+ */
+static inline uint32_t SoarLog_ColumnCode(const SoarLog_ColumnField_t *field, uint32_t word, uint32_t previous)
+{
+    if (field->code == SOAR_LOG_FIELD_F32 && field->scale == 0)
+    {
+        return word ^ previous;
+    }
+    return SoarLog_ZigZag((int32_t)(word - previous));
+}
+
+static inline uint32_t SoarLog_ColumnUncode(const SoarLog_ColumnField_t *field, uint32_t code, uint32_t previous)
+{
+    if (field->code == SOAR_LOG_FIELD_F32 && field->scale == 0)
+    {
+        return code ^ previous;
+    }
+    return previous + (uint32_t)SoarLog_UnZigZag(code);
+}
+
+/**
+ * @brief Decode the payload of a columns block back into records, its header and CRC already checked
+ * @param payload Block payload, after the record type was used to look up fields
+ * @param length Bytes in payload
+ * @param fields Descriptors of the record type in payload[0]
+ * @param fieldCount Descriptors in fields
+ * @param timestamps Receives the timestamp of each record
+ * @param records Receives the records, recordStride bytes apart
+ * @param recordStride At least the record length
+ * @param maxRecords Room in timestamps and records, SOAR_LOG_COLUMN_MAX_RECORDS is always enough
+ * @retval int32_t Records decoded, or -1 if the payload is malformed
+ */
+static inline int32_t SoarLog_DecodeColumns(const uint8_t *payload, uint32_t length,
+                                            const SoarLog_ColumnField_t *fields, uint32_t fieldCount,
+                                            uint32_t *timestamps, uint8_t *records, uint32_t recordStride,
+                                            uint32_t maxRecords)
+{
+    if (length < SOAR_LOG_COLUMN_HEADER_SIZE)
+    {
+        return -1;
+    }
+
+    const uint32_t count = payload[1];
+    if (count == 0 || count > maxRecords)
+    {
+        return -1;
+    }
+
+    uint32_t pos = SOAR_LOG_COLUMN_HEADER_SIZE;
+    memcpy(&timestamps[0], payload + 2, sizeof(uint32_t));
+    for (uint32_t i = 1; i < count; i++)
+    {
+        uint32_t delta;
+        if (!SoarLog_GetVarint(payload, length, &pos, &delta))
+        {
+            return -1;
+        }
+        timestamps[i] = timestamps[i - 1] + delta;
+    }
+
+    for (uint32_t f = 0; f < fieldCount; f++)
+    {
+        uint32_t word = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t code;
+            if (!SoarLog_GetVarint(payload, length, &pos, &code))
+            {
+                return -1;
+            }
+            word = SoarLog_ColumnUncode(&fields[f], code, word);
+            SoarLog_ColumnStore(&fields[f], word, records + i * recordStride);
+        }
+    }
+
+    return (int32_t)count;
+}
+
+#endif /* __SOAR_LOG_COLUMN_FORMAT_HPP */
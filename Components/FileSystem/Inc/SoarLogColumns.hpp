@@ -0,0 +1,93 @@
+/**
+ * File Name          : SoarLogColumns.hpp
+ * Description        : Column encoder for fixed length log records, see SoarLogColumnFormat.hpp
+ * Author             : SOAR Team
+ *
+ * A batch collects records of one type until their column encoding fills a
+ * block, tracking the encoded size as records are added so it never has to
+ * encode twice. The batch is caller-owned, there is no heap use. Records are
+ * kept as the 32 bit words they are coded from, so one batch holds at most
+ * SOAR_LOG_COLUMN_MAX_VALUES fields across all its records.
+ * Not thread safe, use each batch from a single task.
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_LOG_COLUMNS_HPP
+#define __SOAR_LOG_COLUMNS_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLogWriter.hpp"
+#include "SoarLogColumnFormat.hpp"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define SOAR_LOG_COLUMN_MAX_VALUES 512 // Field words a batch holds, 2 KB
+
+    /* Exported types ------------------------------------------------------------*/
+    typedef struct
+    {
+        uint8_t type;          // SoarLog_RecordType_t batched, SOAR_LOG_RECORD_NONE until initialized
+        uint8_t fieldCount;
+        uint8_t recordLength;  // Payload bytes of one record
+        uint8_t maxRecords;    // Records the batch holds for this type
+        uint8_t count;         // Records in the batch
+        uint16_t encodedSize;  // Payload bytes the batch encodes to
+        uint32_t recordsWritten;
+        uint32_t blocksWritten;
+        uint32_t payloadBytes; // Written in column blocks
+        SoarLog_ColumnField_t fields[SOAR_LOG_COLUMN_MAX_FIELDS];
+        uint32_t timestamps[SOAR_LOG_COLUMN_MAX_RECORDS];
+        uint32_t words[SOAR_LOG_COLUMN_MAX_VALUES]; // Record after record, one word per field
+    } SoarLog_ColumnBatch_t;
+
+    /* Exported function prototypes ----------------------------------------------*/
+
+    /**
+     * @brief Set a batch up for one record type of SOAR_LOG_SCHEMA
+     * @param batch Batch state, owned by the caller
+     * @param type SoarLog_RecordType_t with fixed length numeric fields
+     * @retval SoarFS_Result_t SOAR_FS_INVALID_PARAMETER if the type is unknown or cannot be column encoded
+     */
+    SoarFS_Result_t SoarLog_ColumnsInit(SoarLog_ColumnBatch_t *batch, uint8_t type);
+
+    /**
+     * @brief Add one record to the batch
+     * @param batch Initialized batch
+     * @param timestamp ms since boot
+     * @param payload Record payload, batch->recordLength bytes
+     * @retval bool false if the record would not fit in the block, write the batch and add it again
+     */
+    bool SoarLog_ColumnsAdd(SoarLog_ColumnBatch_t *batch, uint32_t timestamp, const void *payload);
+
+    /**
+     * @brief Encode the batch as a column block payload, the batch is left unchanged
+     * @param batch Batch with at least one record
+     * @param payload Receives batch->encodedSize bytes, at most SOAR_LOG_BLOCK_PAYLOAD_SIZE
+     * @retval uint16_t Bytes written
+     */
+    uint16_t SoarLog_ColumnsEncode(const SoarLog_ColumnBatch_t *batch, uint8_t *payload);
+
+    /**
+     * @brief Empty the batch, keeping its type and counters
+     * @param batch Initialized batch
+     */
+    void SoarLog_ColumnsClear(SoarLog_ColumnBatch_t *batch);
+
+    /**
+     * @brief Write the batch to a log as one column block after the records buffered in it,
+     * and empty the batch
+     * @param writer Open writer
+     * @param batch Batch to write, kept intact if the write fails
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_WriteColumns(SoarLog_Writer_t *writer, SoarLog_ColumnBatch_t *batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SOAR_LOG_COLUMNS_HPP */
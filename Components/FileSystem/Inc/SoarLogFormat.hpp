@@ -0,0 +1,171 @@
+/**
+ * File Name          : SoarLogFormat.hpp
+ * Description        : On-media layout of SOAR binary flight logs
+ * Author             : SOAR Team
+ *
+ * Shared by the firmware writer and the host tools, so it only depends on
+ * <stdint.h>/<string.h>. All multi-byte fields are little endian.
+ *
+ * A log file is a sequence of SOAR_LOG_BLOCK_SIZE byte blocks, one sector
+ * each. Every block starts with a SoarLog_BlockHeader_t and ends with a
+ * CRC-32 over everything before it, so a reader can verify and resynchronize
+ * block by block. Block 0 of a file is a schema block, the rest are data
+ * blocks holding whole records:
+ *
+ *   [SoarLog_RecordHeader_t][payload, header.length bytes] ...
+ *
+ * Schema block payload, the id of the log then one entry per record type:
+ *
+ *   [log id, uint32][type][payload length, 0 = variable][name\0][fields\0] ...
+ *
+ * where fields lists "name:code" pairs separated by ',' and code is one of
+ * SOAR_LOG_FIELD_* below, so a reader can decode records it has no struct for.
+ * A float may carry a scale, "name:f*100", its precision in column blocks.
+ *
+ * Fixed length records may instead be batched into column blocks, see
+ * SoarLogColumnFormat.hpp. Index blocks map timestamps to blocks so readers
+ * can seek by time, see SoarLogIndexFormat.hpp. Commit blocks mark what a
+ * power loss cannot take back, see SoarLogJournalFormat.hpp.
+ *
+ * Version 1 logs have no log id in the schema block and no commit blocks.
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_LOG_FORMAT_HPP
+#define __SOAR_LOG_FORMAT_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define SOAR_LOG_MAGIC 0x474F4C53u // "SLOG"
+#define SOAR_LOG_VERSION 2
+#define SOAR_LOG_BLOCK_SIZE 512
+#define SOAR_LOG_BLOCK_HEADER_SIZE 12
+#define SOAR_LOG_BLOCK_CRC_SIZE 4
+#define SOAR_LOG_BLOCK_PAYLOAD_SIZE (SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_HEADER_SIZE - SOAR_LOG_BLOCK_CRC_SIZE)
+#define SOAR_LOG_RECORD_HEADER_SIZE 6
+#define SOAR_LOG_MAX_RECORD_PAYLOAD 255
+#define SOAR_LOG_SCHEMA_ID_SIZE 4 // Log id ahead of the schema entries, from version 2
+#define SOAR_LOG_FS_OP_BUCKETS 16 // Latency buckets of a file system operation record, < 4 us, < 8 us, ... >= 65536 us
+
+// Field type codes used in schema field lists
+#define SOAR_LOG_FIELD_U8 'B'
+#define SOAR_LOG_FIELD_I8 'b'
+#define SOAR_LOG_FIELD_U16 'H'
+#define SOAR_LOG_FIELD_I16 'h'
+#define SOAR_LOG_FIELD_U32 'I'
+#define SOAR_LOG_FIELD_I32 'i'
+#define SOAR_LOG_FIELD_F32 'f'
+#define SOAR_LOG_FIELD_TEXT 's' // Rest of the payload, not NUL terminated
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum : uint8_t
+{
+    SOAR_LOG_BLOCK_SCHEMA = 1,
+    SOAR_LOG_BLOCK_DATA = 2,
+    SOAR_LOG_BLOCK_COLUMNS = 3, // SoarLogColumnFormat.hpp
+    SOAR_LOG_BLOCK_INDEX = 4,   // SoarLogIndexFormat.hpp
+    SOAR_LOG_BLOCK_COMMIT = 5,  // SoarLogJournalFormat.hpp
+} SoarLog_BlockType_t;
+
+typedef enum : uint8_t
+{
+    SOAR_LOG_RECORD_NONE = 0,
+    SOAR_LOG_RECORD_ENVIRONMENT = 1, // SoarLog_Environment_t
+    SOAR_LOG_RECORD_FLIGHT = 2,      // FlightData_t
+    SOAR_LOG_RECORD_TEXT = 3,        // Free-form text
+    SOAR_LOG_RECORD_FS_OP = 4,       // SoarLog_FsOp_t
+} SoarLog_RecordType_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint8_t version;
+    uint8_t blockType;      // SoarLog_BlockType_t
+    uint16_t payloadLength; // Bytes of the payload in use, the rest is zero
+    uint32_t sequence;      // Block index within the file
+} SoarLog_BlockHeader_t;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t type;       // SoarLog_RecordType_t
+    uint8_t length;     // Payload bytes that follow
+    uint32_t timestamp; // ms since boot
+} SoarLog_RecordHeader_t;
+
+typedef struct __attribute__((packed))
+{
+    float temperature;
+    float humidity;
+} SoarLog_Environment_t;
+
+typedef struct __attribute__((packed))
+{
+    float altitude;
+    float velocity;
+    float acceleration[3]; // x, y, z
+    uint16_t battery_voltage; // mV
+} FlightData_t;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t op;        // SoarFS_Op_t
+    uint32_t calls;    // Counters since boot or the last reset
+    uint32_t errors;
+    uint32_t bytes;
+    uint32_t totalUs;
+    uint32_t maxUs;
+    uint32_t histogram[SOAR_LOG_FS_OP_BUCKETS];
+} SoarLog_FsOp_t;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t length; // 0 for variable length
+    const char *name;
+    const char *fields;
+} SoarLog_SchemaEntry_t;
+
+static_assert(sizeof(SoarLog_BlockHeader_t) == SOAR_LOG_BLOCK_HEADER_SIZE, "Block header size changed");
+static_assert(sizeof(SoarLog_RecordHeader_t) == SOAR_LOG_RECORD_HEADER_SIZE, "Record header size changed");
+
+/* Exported variables --------------------------------------------------------*/
+// Record types this firmware writes, serialized into every schema block
+static const SoarLog_SchemaEntry_t SOAR_LOG_SCHEMA[] = {
+    // Scales keep 0.01 C, 0.01 %RH, 1 cm and 1 cm/s in column blocks, acceleration stays lossless
+    {SOAR_LOG_RECORD_ENVIRONMENT, sizeof(SoarLog_Environment_t), "env", "temperature:f*100,humidity:f*100"},
+    {SOAR_LOG_RECORD_FLIGHT, sizeof(FlightData_t), "flight",
+     "altitude:f*100,velocity:f*100,accel_x:f,accel_y:f,accel_z:f,battery_mv:H"},
+    {SOAR_LOG_RECORD_TEXT, 0, "text", "text:s"},
+    {SOAR_LOG_RECORD_FS_OP, sizeof(SoarLog_FsOp_t), "fs_op",
+     "op:B,calls:I,errors:I,bytes:I,total_us:I,max_us:I,lt4us:I,lt8us:I,lt16us:I,lt32us:I,lt64us:I,lt128us:I,"
+     "lt256us:I,lt512us:I,lt1ms:I,lt2ms:I,lt4ms:I,lt8ms:I,lt16ms:I,lt33ms:I,lt66ms:I,ge66ms:I"},
+};
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Software CRC-32/MPEG-2 (poly 0x04C11DB7, init 0xFFFFFFFF, no reflection,
+ * no final XOR), bit identical to the CRC peripheral in its reset configuration
+ * @param crc Running value, SOAR_LOG_CRC_INIT for a new computation
+ */
+#define SOAR_LOG_CRC_INIT 0xFFFFFFFFu
+static inline uint32_t SoarLog_Crc32Software(uint32_t crc, const uint8_t *data, uint32_t length)
+{
+    // Nibble table, 64 bytes instead of the 1 KB byte table
+    static const uint32_t table[16] = {
+        0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9, 0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
+        0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61, 0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD,
+    };
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc = (crc << 4) ^ table[(crc >> 28) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ table[(crc >> 28) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+#endif /* __SOAR_LOG_FORMAT_HPP */
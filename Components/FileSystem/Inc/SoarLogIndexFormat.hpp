@@ -0,0 +1,121 @@
+/**
+ * File Name          : SoarLogIndexFormat.hpp
+ * Description        : Layout of the time index blocks of SOAR logs
+ * Author             : SOAR Team
+ *
+ * Shared by the firmware writer and reader and the host tools, so it only
+ * depends on SoarLogColumnFormat.hpp and SoarLogJournalFormat.hpp. All multi-byte fields are little endian.
+ *
+ * The writer keeps the latest timestamp of the record blocks (data and
+ * columns) written so far. The first record block in every group of
+ * SOAR_LOG_INDEX_INTERVAL sequence numbers gets an index entry with its
+ * sequence and that timestamp, so every record before the block is no newer
+ * than the entry. Unlike the first timestamp of each block this never goes
+ * backwards, although a column block holds records older than the data
+ * blocks before it.
+ *
+ * Entries are written out in SOAR_LOG_BLOCK_INDEX blocks:
+ *   - in the slot ending every SOAR_LOG_INDEX_SPAN blocks, sequence
+ *     SOAR_LOG_INDEX_SPAN - 1, 2 * SOAR_LOG_INDEX_SPAN - 1, ..., holding the
+ *     entries of that span, so a reader can binary search the slots
+ *   - as the footer, the last block of a closed log, holding the entries
+ *     since the last slot
+ *
+ * Payload:
+ *
+ *   [SoarLog_Commit_t, its latest timestamp that of the records before this block]
+ *   [SoarLog_IndexEntry_t] ...
+ *
+ * so every index block is also a commit point, and a closed log ends in one.
+ *
+ * A log cut short by a power loss has no footer, readers scan forward from its
+ * last slot. Timestamps are ms since boot, so seeking by time assumes a log was
+ * written within one boot.
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_LOG_INDEX_FORMAT_HPP
+#define __SOAR_LOG_INDEX_FORMAT_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLogColumnFormat.hpp"
+#include "SoarLogJournalFormat.hpp"
+
+/* Exported constants --------------------------------------------------------*/
+#define SOAR_LOG_INDEX_INTERVAL 16   // Blocks per index entry, at most this many are read past the target
+#define SOAR_LOG_INDEX_HEADER_SIZE SOAR_LOG_COMMIT_SIZE // SoarLog_Commit_t
+#define SOAR_LOG_INDEX_ENTRIES ((SOAR_LOG_BLOCK_PAYLOAD_SIZE - SOAR_LOG_INDEX_HEADER_SIZE) / 8)
+#define SOAR_LOG_INDEX_SPAN (SOAR_LOG_INDEX_INTERVAL * SOAR_LOG_INDEX_ENTRIES) // Blocks per slot, the slot included
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct __attribute__((packed))
+{
+    uint32_t sequence; // First record block of its interval
+    uint32_t latest;   // Latest timestamp of the records in the blocks before it
+} SoarLog_IndexEntry_t;
+
+static_assert(sizeof(SoarLog_IndexEntry_t) == 8, "Index entry size changed");
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Whether a sequence number is an index slot, no other block takes one
+ */
+static inline bool SoarLog_IsIndexSlot(uint32_t sequence)
+{
+    return sequence % SOAR_LOG_INDEX_SPAN == SOAR_LOG_INDEX_SPAN - 1;
+}
+
+/**
+ * @brief Latest timestamp of the records in a data or columns block, its header and CRC already checked
+ * @param blockType SoarLog_BlockType_t of the block
+ * @param payload Block payload
+ * @param length Bytes in payload
+ * @param latest Receives the timestamp
+ * @retval bool false if the block holds no records
+ */
+static inline bool SoarLog_BlockLatest(uint8_t blockType, const uint8_t *payload, uint32_t length, uint32_t *latest)
+{
+    bool found = false;
+
+    if (blockType == SOAR_LOG_BLOCK_DATA)
+    {
+        for (uint32_t pos = 0; pos + SOAR_LOG_RECORD_HEADER_SIZE <= length;)
+        {
+            SoarLog_RecordHeader_t header;
+            memcpy(&header, payload + pos, SOAR_LOG_RECORD_HEADER_SIZE);
+            if (pos + SOAR_LOG_RECORD_HEADER_SIZE + header.length > length)
+            {
+                break;
+            }
+            if (!found || header.timestamp > *latest)
+            {
+                *latest = header.timestamp;
+            }
+            found = true;
+            pos += SOAR_LOG_RECORD_HEADER_SIZE + header.length;
+        }
+    }
+    else if (blockType == SOAR_LOG_BLOCK_COLUMNS && length >= SOAR_LOG_COLUMN_HEADER_SIZE && payload[1] > 0)
+    {
+        // Deltas are unsigned, the last timestamp is the latest
+        uint32_t timestamp;
+        memcpy(&timestamp, payload + 2, sizeof(timestamp));
+        uint32_t pos = SOAR_LOG_COLUMN_HEADER_SIZE;
+        for (uint32_t i = 1; i < payload[1]; i++)
+        {
+            uint32_t delta;
+            if (!SoarLog_GetVarint(payload, length, &pos, &delta))
+            {
+                break;
+            }
+            timestamp += delta;
+        }
+        *latest = timestamp;
+        found = true;
+    }
+
+    return found;
+}
+
+#endif /* __SOAR_LOG_INDEX_FORMAT_HPP */
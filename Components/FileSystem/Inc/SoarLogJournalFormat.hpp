@@ -0,0 +1,80 @@
+/**
+ * File Name          : SoarLogJournalFormat.hpp
+ * Description        : Commit points that make SOAR logs recoverable after a power loss
+ * Author             : SOAR Team
+ *
+ * Shared by the firmware writer and recovery and the host tools, so it only
+ * depends on SoarLogFormat.hpp. All multi-byte fields are little endian.
+ *
+ * A log in a preallocated file keeps its reserved size until it is closed, so
+ * after a power loss the directory entry says nothing about where the written
+ * blocks end, and past them the file holds whatever its clusters held before,
+ * possibly blocks of a deleted log at the same sequence numbers.
+ *
+ * Every log gets a random id, stored ahead of its schema. The writer chains
+ * the CRCs of the blocks it writes:
+ *
+ *   chain = SoarLog_ChainSeed(log id), then SoarLog_ChainBlock(chain, block) per block
+ *
+ * and at intervals writes a commit point, a SOAR_LOG_BLOCK_COMMIT block or an
+ * index block, whose payload starts with a SoarLog_Commit_t holding the id and
+ * the chain of the blocks since the previous commit point, then restarts the
+ * chain from the seed. Only then are the data sectors flushed to the storage,
+ * without rewriting the directory entry. A commit point is valid if the id
+ * and chain match the blocks before it, so blocks of another log, torn or
+ * missing blocks all end the log at the previous valid one.
+ *
+ * Commit block payload:
+ *
+ *   [SoarLog_Commit_t]
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_LOG_JOURNAL_FORMAT_HPP
+#define __SOAR_LOG_JOURNAL_FORMAT_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLogFormat.hpp"
+#include <string.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define SOAR_LOG_COMMIT_SIZE 12
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct __attribute__((packed))
+{
+    uint32_t latest; // Latest timestamp of the records before this block
+    uint32_t logId;  // From the schema block of the log
+    uint32_t chain;  // Of the blocks since the previous commit point
+} SoarLog_Commit_t;
+
+static_assert(sizeof(SoarLog_Commit_t) == SOAR_LOG_COMMIT_SIZE, "Commit size changed");
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Whether blocks of a type start with a SoarLog_Commit_t
+ */
+static inline bool SoarLog_IsCommitPoint(uint8_t blockType)
+{
+    return blockType == SOAR_LOG_BLOCK_COMMIT || blockType == SOAR_LOG_BLOCK_INDEX;
+}
+
+/**
+ * @brief Chain value at the start of a log, before its schema block, and after every commit point
+ */
+static inline uint32_t SoarLog_ChainSeed(uint32_t logId)
+{
+    return SoarLog_Crc32Software(SOAR_LOG_CRC_INIT, (const uint8_t *)&logId, sizeof(logId));
+}
+
+/**
+ * @brief Add a sealed block to the chain, only its CRC is hashed
+ */
+static inline uint32_t SoarLog_ChainBlock(uint32_t chain, const uint8_t *block)
+{
+    return SoarLog_Crc32Software(chain, block + SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE,
+                                 SOAR_LOG_BLOCK_CRC_SIZE);
+}
+
+#endif /* __SOAR_LOG_JOURNAL_FORMAT_HPP */
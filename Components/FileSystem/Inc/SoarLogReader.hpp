@@ -0,0 +1,102 @@
+/**
+ * File Name          : SoarLogReader.hpp
+ * Description        : Reads framed binary flight logs back, seeking by timestamp
+ * Author             : SOAR Team
+ *
+ * The log is opened read-only with a fast-seek map, so moving to any block
+ * costs no FAT reads. SoarLog_SeekTime finds where a time window starts from
+ * the index blocks, see SoarLogIndexFormat.hpp: the footer of a closed log
+ * holds its newest entries, and the index slots are binary searched for
+ * older ones, so a seek reads O(log n) blocks, then at most
+ * SOAR_LOG_INDEX_INTERVAL blocks before the first record of the window.
+ * Records of column blocks are decoded back into plain records. Corrupt or
+ * torn blocks are skipped. All state is caller-owned, there is no heap use.
+ * Not thread safe, use each reader from a single task.
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_LOG_READER_HPP
+#define __SOAR_LOG_READER_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarFileSystem.hpp"
+#include "SoarLogIndexFormat.hpp"
+#include "SoarLogColumns.hpp"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define SOAR_LOG_READER_COLUMN_BYTES (SOAR_LOG_COLUMN_MAX_VALUES * 4) // Records of the largest column block
+
+    /* Exported types ------------------------------------------------------------*/
+    typedef struct
+    {
+        SoarFS_Handle_t handle;
+        bool isOpen;
+        uint32_t blockCount;   // Whole blocks in the file
+        uint32_t nextSequence; // Block loaded once the current one is used up
+        uint32_t from;         // Older records are skipped, set by SoarLog_SeekTime
+        uint16_t length;       // Payload bytes of the loaded data block, 0 if none is loaded
+        uint16_t offset;       // Next record: payload offset in a data block, index in a column block
+        uint16_t columnCount;  // Records decoded from the loaded column block
+        uint8_t columnType;    // Record type the fields below describe
+        uint8_t columnLength;
+        uint8_t fieldCount;
+        uint32_t blocksRead;
+        uint32_t blocksSkipped; // Corrupt, torn or undecodable
+        SoarLog_ColumnField_t fields[SOAR_LOG_COLUMN_MAX_FIELDS];
+        uint32_t timestamps[SOAR_LOG_COLUMN_MAX_RECORDS];
+        uint8_t records[SOAR_LOG_READER_COLUMN_BYTES] __attribute__((aligned(4)));
+        uint8_t block[SOAR_LOG_BLOCK_SIZE] __attribute__((aligned(4)));
+    } SoarLog_Reader_t;
+
+    /* Exported function prototypes ----------------------------------------------*/
+
+    /**
+     * @brief Open a log for reading, positioned at its first record
+     * @param reader Reader state, owned by the caller
+     * @param filename 8.3 name of the log file, not open elsewhere
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_ReaderOpen(SoarLog_Reader_t *reader, const char *filename);
+
+    /**
+     * @brief Latest timestamp in the log, from the footer of a closed log or else its last blocks
+     * @param reader Open reader, rewound to its first record
+     * @param timestamp Receives the timestamp
+     * @retval SoarFS_Result_t Status of operation, SOAR_FS_END_OF_FILE if the log holds no records
+     */
+    SoarFS_Result_t SoarLog_ReaderLatest(SoarLog_Reader_t *reader, uint32_t *timestamp);
+
+    /**
+     * @brief Position the reader so the next records read are those at or after a time
+     * @param reader Open reader
+     * @param timestamp Start of the window, ms since boot
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_SeekTime(SoarLog_Reader_t *reader, uint32_t timestamp);
+
+    /**
+     * @brief Read the next record in file order, skipping those before the time sought
+     * @param reader Open reader
+     * @param header Receives the type, length and timestamp of the record
+     * @param payload Receives header->length bytes, SOAR_LOG_MAX_RECORD_PAYLOAD is always enough
+     * @retval SoarFS_Result_t Status of operation, SOAR_FS_END_OF_FILE after the last record
+     */
+    SoarFS_Result_t SoarLog_ReadRecord(SoarLog_Reader_t *reader, SoarLog_RecordHeader_t *header, uint8_t *payload);
+
+    /**
+     * @brief Close the log
+     * @param reader Open reader
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_ReaderClose(SoarLog_Reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SOAR_LOG_READER_HPP */
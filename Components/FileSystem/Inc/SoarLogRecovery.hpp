@@ -0,0 +1,55 @@
+/**
+ * File Name          : SoarLogRecovery.hpp
+ * Description        : Trims a SOAR log back to its last commit point after a power loss
+ * Author             : SOAR Team
+ *
+ * A log written with SoarLog_Commit never updates its directory entry before
+ * it is closed, so after a power loss a preallocated log still has its whole
+ * reservation as its size. SoarLog_Recover finds the end of the log from its
+ * content, see SoarLogJournalFormat.hpp, and truncates the file there, after
+ * which it reads like a log that was closed without a footer. A closed log is
+ * recognized from its footer with two block reads, anything else is scanned
+ * from the start. Run it once the media is mounted, before the log is opened
+ * by anything else.
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_LOG_RECOVERY_HPP
+#define __SOAR_LOG_RECOVERY_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarFileSystem.hpp"
+#include "SoarLogJournalFormat.hpp"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* Exported types ------------------------------------------------------------*/
+    typedef struct
+    {
+        bool closed;              // Ended in a footer or the commit point of an earlier recovery, nothing to trim
+        uint32_t blocksScanned;   // Read to find the end, block 0 included
+        uint32_t blocksKept;      // Up to and including the last valid commit point
+        uint32_t blocksDiscarded; // Whole blocks past it in the file: uncommitted, torn or stale
+        uint32_t latest;          // Latest record timestamp kept, from the last commit point
+    } SoarLog_Recovery_t;
+
+    /* Exported function prototypes ----------------------------------------------*/
+
+    /**
+     * @brief Trim a log to its last valid commit point. Logs reopened with SoarLog_Open
+     * restart their chain, blocks the earlier session wrote after its last commit point
+     * end the log there.
+     * @param filename 8.3 name of the log file, not open
+     * @param recovery Receives what was found, may be NULL
+     * @retval SoarFS_Result_t Status of operation, a log without a valid schema block is emptied
+     */
+    SoarFS_Result_t SoarLog_Recover(const char *filename, SoarLog_Recovery_t *recovery);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SOAR_LOG_RECOVERY_HPP */
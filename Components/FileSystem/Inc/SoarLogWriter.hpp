@@ -0,0 +1,180 @@
+/**
+ * File Name          : SoarLogWriter.hpp
+ * Description        : Framed binary flight log writer, see SoarLogFormat.hpp
+ * Author             : SOAR Team
+ *
+ * Records are packed into a block buffer held in the caller-owned writer, so
+ * there is no heap use. A block goes to the file, one aligned sector per
+ * write, when it fills or on SoarLog_Flush. A writer opened with SoarLog_Open
+ * syncs every block; one opened with SoarLog_OpenAppender leaves commits to
+ * its sync policy and SoarLog_Checkpoint. Entries of the time index are
+ * collected as blocks are written and go out in index slots and, on
+ * SoarLog_Close, the footer, see SoarLogIndexFormat.hpp. SoarLog_Commit
+ * writes a commit point instead of syncing the directory entry, making the
+ * log recoverable up to there with SoarLog_Recover, see
+ * SoarLogJournalFormat.hpp. Not thread safe, use each writer from a single
+ * task.
+ ******************************************************************************
+ */
+
+#ifndef __SOAR_LOG_WRITER_HPP
+#define __SOAR_LOG_WRITER_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarFileSystem.hpp"
+#include "SoarLogFormat.hpp"
+#include "SoarLogIndexFormat.hpp"
+#include "SoarLogJournalFormat.hpp"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* Exported types ------------------------------------------------------------*/
+    typedef struct
+    {
+        char filename[SOAR_FS_MAX_FILENAME_LEN];
+        bool isOpen;
+        SoarFS_Handle_t handle;
+        uint32_t sequence; // Sequence number of the block being filled
+        uint16_t used;     // Payload bytes used in the block being filled
+        uint32_t recordsWritten;
+        uint32_t blocksWritten;
+        uint32_t latest;     // Latest timestamp in the record blocks written to the file
+        uint16_t indexCount; // Entries waiting for the next index block
+        uint32_t logId;      // Random, from the schema block
+        uint32_t chain;      // Of the blocks written since the last commit point
+        SoarLog_IndexEntry_t index[SOAR_LOG_INDEX_ENTRIES];
+        uint8_t block[SOAR_LOG_BLOCK_SIZE] __attribute__((aligned(4)));
+    } SoarLog_Writer_t;
+
+    /**
+     * @brief Fills the payload of a block written with SoarLog_AppendBlock
+     * @retval uint16_t Payload bytes used, at most SOAR_LOG_BLOCK_PAYLOAD_SIZE
+     */
+    typedef uint16_t (*SoarLog_PayloadBuilder_t)(uint8_t *payload, void *context);
+
+    /* Exported function prototypes ----------------------------------------------*/
+
+    /**
+     * @brief Open a log for appending, creating it with a schema block if it does not exist
+     * @param writer Writer state, owned by the caller
+     * @param filename 8.3 name of the log file
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_Open(SoarLog_Writer_t *writer, const char *filename);
+
+    /**
+     * @brief Open a log as a write-behind appender, creating it with a schema block if it does not exist
+     * @param writer Writer state, owned by the caller
+     * @param filename 8.3 name of the log file
+     * @param policy When written blocks are committed, see SoarFS_SyncPolicy_t
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_OpenAppender(SoarLog_Writer_t *writer, const char *filename,
+                                         const SoarFS_SyncPolicy_t *policy);
+
+    /**
+     * @brief Start a log in an open, empty file by writing its schema block, e.g. one opened
+     * with SoarFS_OpenPreallocated. Records already buffered in the writer are kept and
+     * continue in the new file, so a zeroed writer or one that was closed or detached may be used.
+     * @param writer Writer state, owned by the caller
+     * @param filename 8.3 name of the file
+     * @param handle Open handle positioned at offset 0, the writer takes ownership of it
+     * @retval SoarFS_Result_t Status of operation, the handle is closed on failure
+     */
+    SoarFS_Result_t SoarLog_Begin(SoarLog_Writer_t *writer, const char *filename, SoarFS_Handle_t handle);
+
+    /**
+     * @brief Forget the file of a log whose media is gone, without any I/O. Records
+     * buffered in the current block are kept for SoarLog_Reattach.
+     * @param writer Writer to detach
+     */
+    void SoarLog_Detach(SoarLog_Writer_t *writer);
+
+    /**
+     * @brief Reopen a detached log, recreating it if the media no longer has it.
+     * Buffered records continue in the next block.
+     * @param writer Detached writer
+     * @param policy Sync policy to reopen as an appender, or NULL to sync every block
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_Reattach(SoarLog_Writer_t *writer, const SoarFS_SyncPolicy_t *policy);
+
+    /**
+     * @brief Append one record, writing the current block out first if it does not fit
+     * @param writer Open writer
+     * @param type SoarLog_RecordType_t of the record
+     * @param timestamp ms since boot
+     * @param payload Record payload
+     * @param length Payload bytes, at most SOAR_LOG_MAX_RECORD_PAYLOAD
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_Append(SoarLog_Writer_t *writer, uint8_t type, uint32_t timestamp, const void *payload,
+                                   uint8_t length);
+
+    /**
+     * @brief Write the buffered records out, then a block of another type whose payload
+     * is built in place, e.g. SOAR_LOG_BLOCK_COLUMNS
+     * @param writer Open writer
+     * @param blockType SoarLog_BlockType_t of the block
+     * @param build Fills the zeroed payload
+     * @param context Passed through to build
+     * @retval SoarFS_Result_t Status of operation, build is not called if the records could not be written
+     */
+    SoarFS_Result_t SoarLog_AppendBlock(SoarLog_Writer_t *writer, uint8_t blockType, SoarLog_PayloadBuilder_t build,
+                                        void *context);
+
+    /**
+     * @brief Write the partially filled block out, later records start a new block
+     * @param writer Open writer
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_Flush(SoarLog_Writer_t *writer);
+
+    /**
+     * @brief Flush the current block and commit every written block and the file size to the storage
+     * @param writer Open writer
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_Checkpoint(SoarLog_Writer_t *writer);
+
+    /**
+     * @brief Flush the current block, write a commit point and flush the data sectors,
+     * leaving the directory entry alone. On a preallocated file this costs a block
+     * and a driver flush instead of a directory update.
+     * @param writer Open writer
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_Commit(SoarLog_Writer_t *writer);
+
+    /**
+     * @brief Flush, write the index footer and close the log
+     * @param writer Open writer
+     * @retval SoarFS_Result_t Status of operation
+     */
+    SoarFS_Result_t SoarLog_Close(SoarLog_Writer_t *writer);
+
+    /**
+     * @brief Size the log will have once more blocks and then the footer are written,
+     * counting the index slots they pass, e.g. to check they fit in a reservation
+     * @param writer Writer, open or not
+     * @param blocks Data, columns or commit blocks still to write, the buffered records included
+     * @retval uint32_t Bytes
+     */
+    uint32_t SoarLog_ClosedSize(const SoarLog_Writer_t *writer, uint32_t blocks);
+
+    /**
+     * @brief CRC-32/MPEG-2 of a buffer, on the CRC peripheral when available
+     * @param data Buffer to checksum
+     * @param length Bytes in the buffer
+     * @retval uint32_t CRC value
+     */
+    uint32_t SoarLog_Crc32(const uint8_t *data, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SOAR_LOG_WRITER_HPP */
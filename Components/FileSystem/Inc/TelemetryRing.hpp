@@ -0,0 +1,180 @@
+/**
+ ******************************************************************************
+ * File Name          : TelemetryRing.hpp
+ * Description        : Lock-free multi-producer, single-consumer ring of typed
+ *                      telemetry records
+ ******************************************************************************
+ *
+ * Producers (tasks and ISRs) claim a cell with a CAS on the enqueue index and
+ * publish it by advancing the cell's sequence number, so Push never blocks
+ * and never disables interrupts. A producer preempted between claiming and
+ * publishing only delays the consumer at that cell, it never stalls other
+ * producers. Only one task may call Pop/PopBatch.
+ *
+ ******************************************************************************
+ */
+#ifndef CUBE_SYSTEM_TELEMETRY_RING_HPP_
+#define CUBE_SYSTEM_TELEMETRY_RING_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <atomic>
+
+/* Macros ------------------------------------------------------------------*/
+constexpr uint32_t TELEMETRY_RING_INDEX_ALIGN = 32; // Keeps producer and consumer indices on separate lines
+
+/* Enums ------------------------------------------------------------------*/
+enum TELEMETRY_RECORD_TYPE : uint8_t
+{
+    TELEMETRY_RECORD_NONE = 0,
+    TELEMETRY_RECORD_ENVIRONMENT, // Temperature and humidity sample
+};
+
+/* Structs ------------------------------------------------------------------*/
+struct TelemetryRecord
+{
+    uint32_t timestamp;
+    TELEMETRY_RECORD_TYPE type;
+    uint8_t reserved[3];
+    union
+    {
+        struct
+        {
+            float temperature;
+            float humidity;
+        } environment;
+        uint8_t raw[8];
+    };
+};
+static_assert(sizeof(TelemetryRecord) == 16, "TelemetryRecord should stay 16 bytes");
+
+/* Class ------------------------------------------------------------------*/
+template <typename T, uint32_t CAPACITY>
+class TelemetryRing
+{
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "TelemetryRing capacity must be a power of two");
+
+public:
+    TelemetryRing() : enqueuePos(0), dequeuePos(0), overflowCount(0), pushCount(0), highWater(0)
+    {
+        for (uint32_t i = 0; i < CAPACITY; i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Push a record, safe from any task or ISR
+     * @return False if the ring was full, the record is dropped and counted
+     */
+    bool Push(const T &item)
+    {
+        Cell *cell;
+        uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            cell = &cells[pos & MASK];
+            uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+
+            if (diff == 0)
+            {
+                // Cell is free for this lap, claim it
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                // Consumer has not freed this cell yet, ring is full
+                overflowCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                // Another producer claimed it first
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        pushCount.fetch_add(1, std::memory_order_relaxed);
+        UpdateHighWater(pos + 1 - dequeuePos.load(std::memory_order_relaxed));
+        return true;
+    }
+
+    /**
+     * @brief Pop the oldest published record, consumer task only
+     * @return False if the ring is empty or the oldest record is still being written
+     */
+    bool Pop(T &item)
+    {
+        uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell &cell = cells[pos & MASK];
+
+        if ((int32_t)(cell.sequence.load(std::memory_order_acquire) - (pos + 1)) < 0)
+        {
+            return false;
+        }
+
+        item = cell.data;
+        cell.sequence.store(pos + CAPACITY, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Pop up to maxItems records, consumer task only
+     * @return Number of records copied to out
+     */
+    uint32_t PopBatch(T *out, uint32_t maxItems)
+    {
+        uint32_t count = 0;
+        while (count < maxItems && Pop(out[count]))
+        {
+            count++;
+        }
+        return count;
+    }
+
+    uint32_t Capacity() const { return CAPACITY; }
+    uint32_t Size() const { return enqueuePos.load(std::memory_order_relaxed) - dequeuePos.load(std::memory_order_relaxed); }
+    uint32_t HighWater() const { return highWater.load(std::memory_order_relaxed); }
+    uint32_t Overflows() const { return overflowCount.load(std::memory_order_relaxed); }
+    uint32_t Pushed() const { return pushCount.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Restart the high water mark from the current fill level
+     */
+    void ResetHighWater() { highWater.store(Size(), std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t MASK = CAPACITY - 1;
+
+    struct Cell
+    {
+        std::atomic<uint32_t> sequence;
+        T data;
+    };
+
+    void UpdateHighWater(uint32_t level)
+    {
+        uint32_t current = highWater.load(std::memory_order_relaxed);
+        while (level > current && !highWater.compare_exchange_weak(current, level, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    alignas(TELEMETRY_RING_INDEX_ALIGN) std::atomic<uint32_t> enqueuePos; // Written by producers
+    alignas(TELEMETRY_RING_INDEX_ALIGN) std::atomic<uint32_t> dequeuePos; // Written by the consumer
+    alignas(TELEMETRY_RING_INDEX_ALIGN) std::atomic<uint32_t> overflowCount;
+    std::atomic<uint32_t> pushCount;
+    std::atomic<uint32_t> highWater;
+    Cell cells[CAPACITY];
+};
+
+#endif // CUBE_SYSTEM_TELEMETRY_RING_HPP_
@@ -0,0 +1,367 @@
+/**
+ ******************************************************************************
+ * File Name          : LogRotator.cpp
+ * Description        : Sequence numbered log files with a pool of preallocated spares
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "LogRotator.hpp"
+#include "SystemDefines.hpp"
+#include <string.h>
+#include <stdio.h>
+
+/* Macros ------------------------------------------------------------------*/
+constexpr uint32_t LOG_ROTATOR_MAX_PROBES = 16; // Missing sequences skipped per Service() while looking for the oldest log
+
+/**
+ * @brief Constructor, nothing touches the media until Scan
+ * @param config Naming, size and watermark settings, copied
+ */
+LogRotator::LogRotator(const LogRotationConfig &config) : config(config),
+                                                          scanned(false),
+                                                          reclaiming(false),
+                                                          reserveBlocked(false),
+                                                          activeSequence(0),
+                                                          oldestSequence(0),
+                                                          lastSequence(0),
+                                                          newestLogSequence(0),
+                                                          spareCount(0),
+                                                          filesOpened(0),
+                                                          poolMisses(0),
+                                                          sparesReserved(0),
+                                                          logsDeleted(0),
+                                                          reserveFailures(0)
+{
+    SOAR_ASSERT(config.spares <= LOG_ROTATOR_MAX_SPARES, "LogRotator spares exceed LOG_ROTATOR_MAX_SPARES");
+    memset(spareSequences, 0, sizeof(spareSequences));
+}
+
+/**
+ * @brief Find the existing logs and spares, numbering continues after the highest of them
+ */
+SoarFS_Result_t LogRotator::Scan()
+{
+    scanned = false;
+    reclaiming = false;
+    reserveBlocked = false;
+    activeSequence = 0;
+    oldestSequence = LOG_ROTATOR_MAX_SEQUENCE + 1;
+    lastSequence = 0;
+    newestLogSequence = 0;
+    spareCount = 0;
+
+    SoarFS_Result_t result = SoarFS_ListFiles(LogRotator::ScanFile, this);
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+
+    // No logs at all, deletion has nothing to look for below the first one opened
+    if (oldestSequence > LOG_ROTATOR_MAX_SEQUENCE)
+    {
+        oldestSequence = lastSequence + 1;
+    }
+
+    // A spare numbered below a log was left behind by a reset mid-rollover, give its space back
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < spareCount; i++)
+    {
+        if (spareSequences[i] < newestLogSequence)
+        {
+            char filename[SOAR_FS_MAX_FILENAME_LEN];
+            MakeName(filename, spareSequences[i], LOG_ROTATOR_SPARE_EXTENSION);
+            SoarFS_DeleteFile(filename);
+        }
+        else
+        {
+            spareSequences[kept++] = spareSequences[i];
+        }
+    }
+    spareCount = kept;
+
+    scanned = true;
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Forget the media, its files are found again by the next Scan
+ */
+void LogRotator::Suspend()
+{
+    scanned = false;
+}
+
+/**
+ * @brief Open the next log, a preallocated spare when one is ready
+ * @param policy Sync policy to open it as a write-behind appender, or NULL for a plain handle
+ * @param filename Receives the name of the opened log, SOAR_FS_MAX_FILENAME_LEN bytes
+ * @param handle Receives the handle of the opened log, positioned at offset 0
+ */
+SoarFS_Result_t LogRotator::OpenNext(const SoarFS_SyncPolicy_t *policy, char *filename, SoarFS_Handle_t *handle)
+{
+    if (!scanned)
+    {
+        SoarFS_Result_t result = Scan();
+        if (result != SOAR_FS_OK)
+        {
+            return result;
+        }
+    }
+
+    // Take the lowest spare, renaming only rewrites its directory entry
+    while (spareCount > 0)
+    {
+        uint32_t sequence = spareSequences[0];
+        spareCount--;
+        memmove(spareSequences, spareSequences + 1, spareCount * sizeof(spareSequences[0]));
+
+        char spareName[SOAR_FS_MAX_FILENAME_LEN];
+        MakeName(spareName, sequence, LOG_ROTATOR_SPARE_EXTENSION);
+        MakeName(filename, sequence, config.extension);
+        if (SoarFS_Rename(spareName, filename) == SOAR_FS_OK &&
+            SoarFS_OpenPreallocated(filename, policy, handle) == SOAR_FS_OK)
+        {
+            activeSequence = sequence;
+            filesOpened++;
+            return SOAR_FS_OK;
+        }
+    }
+
+    // Pool is empty, reserve the file now and make the writer wait for it
+    if (lastSequence >= LOG_ROTATOR_MAX_SEQUENCE)
+    {
+        return SOAR_FS_ERROR;
+    }
+
+    uint32_t sequence = lastSequence + 1;
+    MakeName(filename, sequence, config.extension);
+    SoarFS_Result_t result = SoarFS_CreatePreallocated(filename, config.fileBytes, policy, handle);
+    poolMisses++;
+    if (result != SOAR_FS_OK)
+    {
+        reserveFailures++;
+        reclaiming = true;
+        return result;
+    }
+
+    lastSequence = sequence;
+    activeSequence = sequence;
+    filesOpened++;
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Delete one old log if free space is low, otherwise reserve one spare if the pool is short
+ */
+void LogRotator::Service()
+{
+    if (!scanned)
+    {
+        return;
+    }
+
+    uint64_t freeBytes = 0;
+    if (SoarFS_GetFreeSpace(&freeBytes) != SOAR_FS_OK)
+    {
+        return;
+    }
+
+    if (freeBytes < config.lowWaterBytes)
+    {
+        reclaiming = true;
+    }
+    else if (reclaiming && freeBytes >= config.highWaterBytes && !reserveBlocked)
+    {
+        reclaiming = false;
+    }
+
+    if (reclaiming)
+    {
+        // Never the open log, and spares are newer than it. With no log open yet, e.g. the
+        // media was too full to open one, everything Scan found may go
+        uint32_t limit = (activeSequence != 0) ? activeSequence : newestLogSequence + 1;
+        for (uint32_t probes = 0; probes < LOG_ROTATOR_MAX_PROBES && oldestSequence < limit; probes++)
+        {
+            char filename[SOAR_FS_MAX_FILENAME_LEN];
+            MakeName(filename, oldestSequence, config.extension);
+            SoarFS_Result_t result = SoarFS_DeleteFile(filename);
+            if (result == SOAR_FS_FILE_NOT_FOUND)
+            {
+                oldestSequence++;
+                continue;
+            }
+            if (result == SOAR_FS_OK)
+            {
+                oldestSequence++;
+                logsDeleted++;
+                reserveBlocked = false;
+            }
+            break;
+        }
+        return;
+    }
+
+    if (spareCount < config.spares && lastSequence < LOG_ROTATOR_MAX_SEQUENCE)
+    {
+        uint32_t sequence = lastSequence + 1;
+        char filename[SOAR_FS_MAX_FILENAME_LEN];
+        MakeName(filename, sequence, LOG_ROTATOR_SPARE_EXTENSION);
+
+        SoarFS_Result_t result = SoarFS_Reserve(filename, config.fileBytes);
+        if (result == SOAR_FS_OK)
+        {
+            spareSequences[spareCount++] = sequence;
+            lastSequence = sequence;
+            sparesReserved++;
+        }
+        else if (result == SOAR_FS_DISK_FULL)
+        {
+            // No contiguous run is long enough even though the watermark may be met, so free the
+            // oldest log before trying again rather than searching the FAT on every call
+            reserveFailures++;
+            reserveBlocked = true;
+            reclaiming = true;
+        }
+        else
+        {
+            reserveFailures++;
+        }
+    }
+}
+
+/**
+ * @brief Name of the highest numbered log Scan found, the one open at a power loss if any
+ * @param filename Receives the 8.3 name, SOAR_FS_MAX_FILENAME_LEN bytes
+ * @retval bool false before Scan or if the media holds no logs
+ */
+bool LogRotator::NewestLog(char *filename)
+{
+    if (!scanned || newestLogSequence == 0)
+    {
+        return false;
+    }
+
+    MakeName(filename, newestLogSequence, config.extension);
+    return true;
+}
+
+/**
+ * @brief Print rotation counters
+ */
+void LogRotator::PrintStats()
+{
+    char filename[SOAR_FS_MAX_FILENAME_LEN] = "-";
+    if (activeSequence != 0)
+    {
+        MakeName(filename, activeSequence, config.extension);
+    }
+
+    SOAR_PRINT("Active Log   : %s, oldest %lu, last %lu\n", filename, oldestSequence, lastSequence);
+    SOAR_PRINT("Spares       : %lu / %lu ready, %lu reserved, %lu failed\n", spareCount, config.spares,
+               sparesReserved, reserveFailures);
+    SOAR_PRINT("Rotation     : %lu files opened, %lu pool misses, %lu deleted%s\n", filesOpened, poolMisses,
+               logsDeleted, reclaiming ? ", reclaiming" : "");
+}
+
+/**
+ * @brief Build the 8.3 name of a sequence
+ */
+void LogRotator::MakeName(char *filename, uint32_t sequence, const char *extension)
+{
+    snprintf(filename, SOAR_FS_MAX_FILENAME_LEN, "%.3s%05lu.%.3s", config.prefix, (unsigned long)sequence,
+             extension);
+}
+
+/**
+ * @brief Parse a name built by MakeName
+ * @return False for names that are neither a log nor a spare of this rotator
+ */
+bool LogRotator::ParseName(const char *filename, uint32_t *sequence, bool *spare)
+{
+    size_t prefixLen = strlen(config.prefix);
+    if (strncmp(filename, config.prefix, prefixLen) != 0)
+    {
+        return false;
+    }
+
+    const char *digits = filename + prefixLen;
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        if (digits[i] < '0' || digits[i] > '9')
+        {
+            return false;
+        }
+        value = value * 10 + (uint32_t)(digits[i] - '0');
+    }
+
+    if (digits[5] != '.' || value == 0)
+    {
+        return false;
+    }
+
+    const char *extension = digits + 6;
+    if (strcmp(extension, config.extension) == 0)
+    {
+        *spare = false;
+    }
+    else if (strcmp(extension, LOG_ROTATOR_SPARE_EXTENSION) == 0)
+    {
+        *spare = true;
+    }
+    else
+    {
+        return false;
+    }
+
+    *sequence = value;
+    return true;
+}
+
+/**
+ * @brief SoarFS_ListFiles callback of Scan, records the range of logs and the spares
+ */
+void LogRotator::ScanFile(const char *filename, uint32_t fileSize, void *context)
+{
+    (void)fileSize;
+    LogRotator *rotator = (LogRotator *)context;
+
+    uint32_t sequence;
+    bool spare;
+    if (!rotator->ParseName(filename, &sequence, &spare))
+    {
+        return;
+    }
+
+    if (sequence > rotator->lastSequence)
+    {
+        rotator->lastSequence = sequence;
+    }
+
+    if (!spare)
+    {
+        if (sequence < rotator->oldestSequence)
+        {
+            rotator->oldestSequence = sequence;
+        }
+        if (sequence > rotator->newestLogSequence)
+        {
+            rotator->newestLogSequence = sequence;
+        }
+        return;
+    }
+
+    // Keep the pool sorted, spares past its capacity stay on the media unused
+    if (rotator->spareCount == LOG_ROTATOR_MAX_SPARES)
+    {
+        return;
+    }
+    uint32_t i = rotator->spareCount++;
+    while (i > 0 && rotator->spareSequences[i - 1] > sequence)
+    {
+        rotator->spareSequences[i] = rotator->spareSequences[i - 1];
+        i--;
+    }
+    rotator->spareSequences[i] = sequence;
+}
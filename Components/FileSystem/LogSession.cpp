@@ -0,0 +1,344 @@
+/**
+ ******************************************************************************
+ * File Name          : LogSession.cpp
+ * Description        : Framed log kept open across samples, rollovers and media swaps
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "LogSession.hpp"
+#include "SystemDefines.hpp"
+#include "CycleCounter.hpp"
+#include "stm32g4xx_hal.h"
+#include <string.h>
+
+/**
+ * @brief Constructor, nothing is opened until Start
+ * @param rotation Naming, size and retention of the logs, copied
+ * @param checkpointIntervalMs Longest time records wait in RAM before being committed
+ */
+LogSession::LogSession(const LogRotationConfig &rotation, uint32_t checkpointIntervalMs) : rotator(rotation),
+                                                                                          checkpointIntervalMs(checkpointIntervalMs),
+                                                                                          lastCheckpointTick(0),
+                                                                                          logOpenedTick(0),
+                                                                                          started(false),
+                                                                                          retryStart(false),
+                                                                                          recoveryUs(0),
+                                                                                          opens(0),
+                                                                                          resumes(0),
+                                                                                          rollovers(0),
+                                                                                          checkpoints(0),
+                                                                                          recoveries(0),
+                                                                                          droppedRecords(0)
+{
+    // Room for the schema block, at least one data block and the index footer per log
+    SOAR_ASSERT(rotation.fileBytes >= 3 * SOAR_LOG_BLOCK_SIZE, "LogSession logs must hold three blocks");
+
+    memset(&writer, 0, sizeof(writer));
+    memset(&columns, 0, sizeof(columns));
+    memset(&recovery, 0, sizeof(recovery));
+    recoveredLog[0] = '\0';
+
+    // Checkpoints write commit blocks instead, the directory entry is only rewritten on close
+    policy.mode = SOAR_FS_SYNC_ON_CLOSE;
+    policy.syncBytes = 0;
+    policy.syncIntervalMs = 0;
+}
+
+/**
+ * @brief Open the next log, carrying over the records buffered before a media swap
+ */
+SoarFS_Result_t LogSession::Start()
+{
+    if (writer.isOpen)
+    {
+        return SOAR_FS_OK;
+    }
+
+    // The media may have changed since the last Start, find its logs again
+    SoarFS_Result_t result = rotator.Scan();
+    if (result == SOAR_FS_OK)
+    {
+        RecoverNewestLog();
+        result = OpenNextLog();
+    }
+    else
+    {
+        lastCheckpointTick = HAL_GetTick();
+        retryStart = true;
+    }
+
+    if (result == SOAR_FS_OK)
+    {
+        if (started)
+        {
+            resumes++;
+        }
+        else
+        {
+            opens++;
+            started = true;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Drop the file without I/O, its handle died with the media
+ */
+void LogSession::Suspend()
+{
+    SoarLog_Detach(&writer);
+    rotator.Suspend();
+    retryStart = false;
+}
+
+/**
+ * @brief Checkpoint and close, the next Start begins the next log afresh
+ */
+SoarFS_Result_t LogSession::Stop()
+{
+    if (!writer.isOpen)
+    {
+        return SOAR_FS_FILE_NOT_OPEN;
+    }
+
+    FlushColumns();
+    SoarFS_Result_t result = SoarLog_Close(&writer);
+    started = false;
+    return result;
+}
+
+/**
+ * @brief Checkpoint or roll over when due, then let the rotator do one step of background work
+ * @param now HAL_GetTick() of the caller
+ */
+void LogSession::Poll(uint32_t now)
+{
+    // e.g. the media was too full to open a log, Service may have made room since
+    if (retryStart && now - lastCheckpointTick >= checkpointIntervalMs)
+    {
+        Start();
+    }
+
+    const uint32_t maxAgeMs = rotator.Config().maxAgeMs;
+    if (writer.isOpen && maxAgeMs != 0 && now - logOpenedTick >= maxAgeMs)
+    {
+        Rotate();
+    }
+    else if (writer.isOpen && now - lastCheckpointTick >= checkpointIntervalMs)
+    {
+        Checkpoint();
+    }
+
+    rotator.Service();
+}
+
+/**
+ * @brief Batch the records of a type into column blocks instead of data blocks
+ * @param type Fixed length record type of SOAR_LOG_SCHEMA
+ */
+SoarFS_Result_t LogSession::EnableColumns(uint8_t type)
+{
+    // Records still batched for another type would be lost
+    if (columns.count != 0)
+    {
+        return SOAR_FS_ERROR;
+    }
+    return SoarLog_ColumnsInit(&columns, type);
+}
+
+/**
+ * @brief Buffer one record, a full block goes to FatFS without touching the directory entry
+ */
+SoarFS_Result_t LogSession::Append(uint8_t type, uint32_t timestamp, const void *payload, uint8_t length)
+{
+    if (type == columns.type && length == columns.recordLength && type != SOAR_LOG_RECORD_NONE)
+    {
+        if (!writer.isOpen)
+        {
+            droppedRecords++;
+            return SOAR_FS_NOT_MOUNTED;
+        }
+
+        // A full batch is written, rolling over first if the log has no room for it
+        if (!SoarLog_ColumnsAdd(&columns, timestamp, payload) &&
+            (FlushColumns() != SOAR_FS_OK || !SoarLog_ColumnsAdd(&columns, timestamp, payload)))
+        {
+            droppedRecords++;
+            return SOAR_FS_ERROR;
+        }
+        return SOAR_FS_OK;
+    }
+
+    // Roll over rather than start a block the reservation has no room for, footer included
+    if (writer.isOpen && writer.used + SOAR_LOG_RECORD_HEADER_SIZE + length > SOAR_LOG_BLOCK_PAYLOAD_SIZE &&
+        SoarLog_ClosedSize(&writer, 2) > rotator.Config().fileBytes)
+    {
+        Rotate();
+    }
+
+    if (!writer.isOpen)
+    {
+        droppedRecords++;
+        return SOAR_FS_NOT_MOUNTED;
+    }
+
+    SoarFS_Result_t result = SoarLog_Append(&writer, type, timestamp, payload, length);
+    if (result != SOAR_FS_OK)
+    {
+        droppedRecords++;
+    }
+    return result;
+}
+
+/**
+ * @brief Write the partial block and a commit block, and flush the data sectors
+ */
+SoarFS_Result_t LogSession::Checkpoint()
+{
+    lastCheckpointTick = HAL_GetTick();
+    if (!writer.isOpen)
+    {
+        return SOAR_FS_FILE_NOT_OPEN;
+    }
+
+    SoarFS_Result_t result = FlushColumns();
+    if (result == SOAR_FS_OK)
+    {
+        // Closing commits as well, through the footer
+        const uint32_t blocks = (writer.used > 0) ? 2 : 1;
+        result = (SoarLog_ClosedSize(&writer, blocks) > rotator.Config().fileBytes) ? Rotate()
+                                                                                      : SoarLog_Commit(&writer);
+    }
+    if (result == SOAR_FS_OK)
+    {
+        checkpoints++;
+    }
+    return result;
+}
+
+/**
+ * @brief Close the current log, trimming it to what was written, and continue in the next one
+ */
+SoarFS_Result_t LogSession::Rotate()
+{
+    if (!writer.isOpen)
+    {
+        return SOAR_FS_FILE_NOT_OPEN;
+    }
+
+    // Batched columns that do not fit, or a block that failed to write, go to the next log instead
+    if (ColumnsFit())
+    {
+        SoarLog_WriteColumns(&writer, &columns);
+    }
+    SoarLog_Close(&writer);
+    rollovers++;
+    return OpenNextLog();
+}
+
+/**
+ * @brief Take the next log from the rotator and write its schema
+ */
+SoarFS_Result_t LogSession::OpenNextLog()
+{
+    char filename[SOAR_FS_MAX_FILENAME_LEN];
+    SoarFS_Handle_t handle;
+    SoarFS_Result_t result = rotator.OpenNext(&policy, filename, &handle);
+    if (result == SOAR_FS_OK)
+    {
+        result = SoarLog_Begin(&writer, filename, handle);
+    }
+
+    logOpenedTick = HAL_GetTick();
+    lastCheckpointTick = logOpenedTick;
+    retryStart = (result != SOAR_FS_OK);
+    return result;
+}
+
+/**
+ * @brief Trim the newest log back to its last commit point, in case power was lost while it was open
+ */
+void LogSession::RecoverNewestLog()
+{
+    if (!rotator.NewestLog(recoveredLog))
+    {
+        recoveredLog[0] = '\0';
+        return;
+    }
+
+    CycleCounter::Init();
+    const uint32_t start = CycleCounter::Now();
+    SoarFS_Result_t result = SoarLog_Recover(recoveredLog, &recovery);
+    recoveryUs = CycleCounter::ToMicros(CycleCounter::Now() - start);
+
+    if (result != SOAR_FS_OK)
+    {
+        SOAR_PRINT("LogSession: recovery of %s failed (%d)\n", recoveredLog, result);
+    }
+    else if (!recovery.closed)
+    {
+        recoveries++;
+    }
+}
+
+/**
+ * @brief Write the batched columns, in the next log if this one has no room for them
+ */
+SoarFS_Result_t LogSession::FlushColumns()
+{
+    if (columns.count == 0 || !writer.isOpen)
+    {
+        return SOAR_FS_OK;
+    }
+
+    if (!ColumnsFit())
+    {
+        SoarFS_Result_t result = Rotate();
+        if (result != SOAR_FS_OK)
+        {
+            return result;
+        }
+    }
+    return SoarLog_WriteColumns(&writer, &columns);
+}
+
+/**
+ * @brief Whether the reservation has room for the buffered records, a column block after them and the footer
+ */
+bool LogSession::ColumnsFit() const
+{
+    const uint32_t blocks = (writer.used > 0) ? 2 : 1;
+    return SoarLog_ClosedSize(&writer, blocks) <= rotator.Config().fileBytes;
+}
+
+/**
+ * @brief Print session and rotation counters
+ */
+void LogSession::PrintStats()
+{
+    SOAR_PRINT("\n-- LOG SESSION %s --\n", writer.isOpen ? writer.filename : "-");
+    SOAR_PRINT("State        : %s\n", writer.isOpen ? "open" : (started ? "suspended" : "closed"));
+    SOAR_PRINT("Records      : %lu written, %lu dropped\n", writer.recordsWritten, droppedRecords);
+    SOAR_PRINT("Blocks       : %lu, next sequence %lu\n", writer.blocksWritten, writer.sequence);
+    if (columns.type != SOAR_LOG_RECORD_NONE)
+    {
+        // Bytes per record scaled by 100, against the header and payload of a data record
+        uint32_t perRecord100 =
+            columns.recordsWritten ? (uint32_t)(((uint64_t)columns.payloadBytes * 100) / columns.recordsWritten) : 0;
+        SOAR_PRINT("Columns      : type %u, %lu records in %lu blocks, %lu.%02lu bytes/record vs %u, %u batched\n",
+                   columns.type, columns.recordsWritten, columns.blocksWritten, perRecord100 / 100,
+                   perRecord100 % 100, SOAR_LOG_RECORD_HEADER_SIZE + columns.recordLength, columns.count);
+    }
+    SOAR_PRINT("Opens        : %lu, resumes %lu, rollovers %lu, checkpoints %lu\n", opens, resumes, rollovers,
+               checkpoints);
+    if (recoveredLog[0] != '\0')
+    {
+        SOAR_PRINT("Recovery     : %s %s, kept %lu blocks, discarded %lu, scanned %lu in %lu us (%lu trims)\n",
+                   recoveredLog, recovery.closed ? "closed" : "trimmed", recovery.blocksKept,
+                   recovery.blocksDiscarded, recovery.blocksScanned, recoveryUs, recoveries);
+    }
+    rotator.PrintStats();
+    SOAR_PRINT("\n");
+}
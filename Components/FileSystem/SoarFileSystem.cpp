@@ -11,32 +11,123 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "SoarFileSystem.hpp"
-#include "app_fatfs.h"
+extern "C"
+{
+#include "app_fatfs.h" // Generated header has no C++ guards
+}
 #include "ff.h"
+#include "diskio.h"
+#include "ff_gen_drv.h"
+#include "stm32g4xx_hal.h"
+#include "CycleCounter.hpp"
 #include <string.h>
 #include <stdio.h>
 
 /* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+    bool enabled;
+    SoarFS_SyncPolicy_t policy;
+    uint16_t stagedStart;   // Offset of the file position within its sector, staged data begins here
+    uint16_t stagedEnd;     // One past the last staged byte, the buffer mirrors the sector layout
+    uint32_t unsyncedBytes; // Bytes appended since the last commit
+    uint32_t lastSyncTick;
+} SoarFS_Appender_t;
+
+typedef struct
+{
+    bool enabled;
+    uint32_t highWater; // Furthest byte written, the file is truncated here on close
+} SoarFS_Prealloc_t;
+
 typedef struct
 {
     char filename[SOAR_FS_MAX_FILENAME_LEN];
     FIL file_object;
     bool is_open;
+    uint32_t generation; // Bumped on every close, stale handles no longer match
+    SoarFS_Appender_t appender;
+    SoarFS_Prealloc_t prealloc;
+    DWORD clmt[SOAR_FS_CLMT_ENTRIES]; // Fast-seek cluster map of preallocated and reader files, FIL::cltbl points here
 } SoarFS_FileHandle_t;
 
 /* Private define ------------------------------------------------------------*/
 #define SOAR_FS_DRIVE_PATH "0:/"
+#define SOAR_FS_HANDLE_INDEX_BITS 8
+#define SOAR_FS_HANDLE_INDEX_MASK ((1u << SOAR_FS_HANDLE_INDEX_BITS) - 1)
+#define SOAR_FS_FIL_DIRTY 0x80 // FA_DIRTY of ff.c, FIL::buf holds data not yet written to the disk
+#define SOAR_FS_MKFS_OPT (FM_ANY | FM_SFD) // No partition table, its 63 sector offset leaves a 128 sector RAM disk too small
 
 /* Private variables ---------------------------------------------------------*/
 static bool g_fs_initialized = false;
 static bool g_fs_mounted = false;
+static uint32_t g_last_mount_tick = 0;
 static SoarFS_FileHandle_t g_file_handles[SOAR_FS_MAX_FILES_OPEN];
+static uint8_t g_appender_buffers[SOAR_FS_MAX_FILES_OPEN][SOAR_FS_BUFFER_SIZE] __attribute__((aligned(4)));
+static SoarFS_Stats_t g_fs_stats;
+static uint32_t g_cycles_per_us = 1; // Set at init, until then intervals are left in counter ticks
+
+static const char *const SOAR_FS_OP_NAMES[] = {
+    "mount", "free_space", "create_file", "open_file", "close_file", "read_file", "write_file", "delete_file",
+    "stat", "open", "close", "read", "write", "seek", "flush", "flush_data", "sync", "truncate",
+    "create_prealloc", "reserve", "open_prealloc", "rename", "list",
+};
+static_assert(sizeof(SOAR_FS_OP_NAMES) / sizeof(SOAR_FS_OP_NAMES[0]) == SOAR_FS_OP_COUNT, "Name every SoarFS_Op_t");
 
 /* Private function prototypes -----------------------------------------------*/
 static SoarFS_Result_t SoarFS_ConvertFresultToSoarResult(FRESULT fr);
+static void SoarFS_RecordOp(SoarFS_Op_t op, uint32_t cycles, bool failed, uint32_t bytes);
+static FRESULT SoarFS_Mount(void);
+static void SoarFS_DropAllFiles(void);
 static int SoarFS_FindFreeHandle(void);
 static int SoarFS_FindHandleByFilename(const char *filename);
 static bool SoarFS_IsValidFilename(const char *filename);
+static SoarFS_Handle_t SoarFS_MakeHandle(int handle_idx);
+static SoarFS_FileHandle_t *SoarFS_ResolveHandle(SoarFS_Handle_t handle);
+static SoarFS_Result_t SoarFS_OpenExisting(const char *filename, BYTE mode, SoarFS_Handle_t *handle, SoarFS_Op_t op);
+static FRESULT SoarFS_MapClusters(SoarFS_FileHandle_t *fh);
+static void SoarFS_ReleaseHandle(SoarFS_FileHandle_t *fh);
+static uint8_t *SoarFS_AppenderBuffer(SoarFS_FileHandle_t *fh);
+static void SoarFS_AppenderRealign(SoarFS_FileHandle_t *fh);
+static SoarFS_Result_t SoarFS_AppenderDrain(SoarFS_FileHandle_t *fh);
+static SoarFS_Result_t SoarFS_AppenderAppend(SoarFS_FileHandle_t *fh, const uint8_t *data, uint32_t dataSize);
+static SoarFS_Result_t SoarFS_AppenderCommit(SoarFS_FileHandle_t *fh, uint32_t now);
+static SoarFS_Result_t SoarFS_AppenderApplyPolicy(SoarFS_FileHandle_t *fh, uint32_t now);
+static void SoarFS_AppenderEnable(SoarFS_FileHandle_t *fh, const SoarFS_SyncPolicy_t *policy);
+static void SoarFS_PreallocOpen(SoarFS_FileHandle_t *fh, const char *filename, const SoarFS_SyncPolicy_t *policy);
+static void SoarFS_PreallocTrack(SoarFS_FileHandle_t *fh);
+static FRESULT SoarFS_PreallocRelease(SoarFS_FileHandle_t *fh);
+
+/* Private classes -----------------------------------------------------------*/
+/**
+ * @brief Times an operation from construction to destruction, which runs after the
+ * return value is computed. Results passed through Done are counted as errors.
+ */
+class SoarFS_OpTimer
+{
+public:
+#if SOAR_FS_OP_STATS
+    explicit SoarFS_OpTimer(SoarFS_Op_t op) : op(op), failed(false), bytes(0), start(CycleCounter::Now()) {}
+    ~SoarFS_OpTimer() { SoarFS_RecordOp(op, CycleCounter::Now() - start, failed, bytes); }
+
+    SoarFS_Result_t Done(SoarFS_Result_t result)
+    {
+        failed = (result != SOAR_FS_OK);
+        return result;
+    }
+    void Transferred(uint32_t count) { bytes = count; }
+
+private:
+    SoarFS_Op_t op;
+    bool failed;
+    uint32_t bytes;
+    uint32_t start;
+#else
+    explicit SoarFS_OpTimer(SoarFS_Op_t) {}
+    SoarFS_Result_t Done(SoarFS_Result_t result) { return result; }
+    void Transferred(uint32_t) {}
+#endif
+};
 
 /* Exported functions --------------------------------------------------------*/
 
@@ -55,18 +146,25 @@ SoarFS_Result_t SoarFS_Init(void)
     // Initialize all file handles
     for (int i = 0; i < SOAR_FS_MAX_FILES_OPEN; i++)
     {
+        // Generation survives a re-init so handles from before DeInit stay stale
+        uint32_t generation = g_file_handles[i].generation;
         memset(&g_file_handles[i], 0, sizeof(SoarFS_FileHandle_t));
         g_file_handles[i].is_open = false;
+        g_file_handles[i].generation = generation;
     }
 
-    // Initialize FatFS
-    if (MX_FATFS_Init() != APP_OK)
+    // Latencies are kept in us, the counter runs at the core clock on target and 1 GHz on the host
+    CycleCounter::Init();
+    g_cycles_per_us = CycleCounter::Frequency() / 1000000u;
+
+    // Initialize FatFS, main() normally links the driver already and a second link fails
+    if (USERPath[0] == '\0' && MX_FATFS_Init() != APP_OK)
     {
         return SOAR_FS_ERROR;
     }
 
     // Try to mount the file system
-    fr = f_mount(&USERFatFs, USERPath, 1);
+    fr = SoarFS_Mount();
     if (fr == FR_OK)
     {
         g_fs_mounted = true;
@@ -113,10 +211,19 @@ bool SoarFS_IsMounted(void)
         return false;
     }
 
-    // Try to remount if not mounted
-    if (!g_fs_mounted)
+    // Media pulled, the driver reports it uninitialized until it is back
+    if (g_fs_mounted && (disk_status(USERFatFs.drv) & (STA_NOINIT | STA_NODISK)))
     {
-        FRESULT fr = f_mount(&USERFatFs, USERPath, 1);
+        g_fs_mounted = false;
+        g_last_mount_tick = HAL_GetTick();
+        g_fs_stats.mediaRemovals++;
+        SoarFS_DropAllFiles();
+    }
+
+    // Try to remount if not mounted, a missing card fails slowly so don't retry on every call
+    if (!g_fs_mounted && HAL_GetTick() - g_last_mount_tick >= SOAR_FS_REMOUNT_INTERVAL_MS)
+    {
+        FRESULT fr = SoarFS_Mount();
         if (fr == FR_OK)
         {
             g_fs_mounted = true;
@@ -129,31 +236,41 @@ bool SoarFS_IsMounted(void)
 /**
  * @brief Get available free space on the storage device
  */
-SoarFS_Result_t SoarFS_GetFreeSpace(uint32_t *freeBytes)
+SoarFS_Result_t SoarFS_GetFreeSpace(uint64_t *freeBytes)
 {
+    SoarFS_OpTimer timer(SOAR_FS_OP_FREE_SPACE);
+
     if (!SoarFS_IsMounted())
     {
-        return SOAR_FS_NOT_MOUNTED;
+        return timer.Done(SOAR_FS_NOT_MOUNTED);
     }
 
     if (freeBytes == NULL)
     {
-        return SOAR_FS_INVALID_PARAMETER;
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
     }
 
-    FATFS *fs;
-    DWORD fre_clust;
-
-    FRESULT fr = f_getfree(USERPath, &fre_clust, &fs);
-    if (fr != FR_OK)
+    // FatFS updates free_clst in create_chain/remove_chain once it is valid,
+    // only fall back to a scan if the seed at mount failed
+    DWORD fre_clust = USERFatFs.free_clst;
+    if (fre_clust > USERFatFs.n_fatent - 2)
     {
-        return SoarFS_ConvertFresultToSoarResult(fr);
+        FATFS *fs;
+        FRESULT fr = f_getfree(USERPath, &fre_clust, &fs);
+        if (fr != FR_OK)
+        {
+            return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+        }
     }
 
-    // Calculate free space in bytes
-    *freeBytes = fre_clust * fs->csize * 512; // Sector size is typically 512 bytes
+#if _MAX_SS == _MIN_SS
+    const uint32_t sectorSize = _MIN_SS;
+#else
+    const uint32_t sectorSize = USERFatFs.ssize;
+#endif
+    *freeBytes = (uint64_t)fre_clust * USERFatFs.csize * sectorSize;
 
-    return SOAR_FS_OK;
+    return timer.Done(SOAR_FS_OK);
 }
 
 /**
@@ -161,29 +278,31 @@ SoarFS_Result_t SoarFS_GetFreeSpace(uint32_t *freeBytes)
  */
 SoarFS_Result_t SoarFS_CreateFile(const char *filename, const uint8_t *data, uint32_t dataSize)
 {
+    SoarFS_OpTimer timer(SOAR_FS_OP_CREATE_FILE);
+
     if (!SoarFS_IsMounted())
     {
-        return SOAR_FS_NOT_MOUNTED;
+        return timer.Done(SOAR_FS_NOT_MOUNTED);
     }
 
     if (!SoarFS_IsValidFilename(filename) || data == NULL)
     {
-        return SOAR_FS_INVALID_PARAMETER;
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
     }
 
     // Check if file already exists
     if (SoarFS_FileExists(filename))
     {
-        return SOAR_FS_FILE_EXISTS;
+        return timer.Done(SOAR_FS_FILE_EXISTS);
     }
 
     // Check available space
-    uint32_t freeSpace;
+    uint64_t freeSpace;
     if (SoarFS_GetFreeSpace(&freeSpace) == SOAR_FS_OK)
     {
         if (dataSize > freeSpace)
         {
-            return SOAR_FS_DISK_FULL;
+            return timer.Done(SOAR_FS_DISK_FULL);
         }
     }
 
@@ -195,7 +314,7 @@ SoarFS_Result_t SoarFS_CreateFile(const char *filename, const uint8_t *data, uin
     FRESULT fr = f_open(&file, fullPath, FA_CREATE_NEW | FA_WRITE);
     if (fr != FR_OK)
     {
-        return SoarFS_ConvertFresultToSoarResult(fr);
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
     }
 
     // Write data to file
@@ -205,17 +324,18 @@ SoarFS_Result_t SoarFS_CreateFile(const char *filename, const uint8_t *data, uin
     {
         f_close(&file);
         f_unlink(fullPath); // Delete partially created file
-        return (fr != FR_OK) ? SoarFS_ConvertFresultToSoarResult(fr) : SOAR_FS_ERROR;
+        return timer.Done((fr != FR_OK) ? SoarFS_ConvertFresultToSoarResult(fr) : SOAR_FS_ERROR);
     }
 
     // Close the file
     fr = f_close(&file);
     if (fr != FR_OK)
     {
-        return SoarFS_ConvertFresultToSoarResult(fr);
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
     }
 
-    return SOAR_FS_OK;
+    timer.Transferred(dataSize);
+    return timer.Done(SOAR_FS_OK);
 }
 
 /**
@@ -223,46 +343,9 @@ SoarFS_Result_t SoarFS_CreateFile(const char *filename, const uint8_t *data, uin
  */
 SoarFS_Result_t SoarFS_OpenFile(const char *filename)
 {
-    if (!SoarFS_IsMounted())
-    {
-        return SOAR_FS_NOT_MOUNTED;
-    }
-
-    if (!SoarFS_IsValidFilename(filename))
-    {
-        return SOAR_FS_INVALID_PARAMETER;
-    }
-
-    // Check if file is already open
-    if (SoarFS_FindHandleByFilename(filename) >= 0)
-    {
-        return SOAR_FS_FILE_ALREADY_OPEN;
-    }
-
-    // Find a free handle
-    int handle_idx = SoarFS_FindFreeHandle();
-    if (handle_idx < 0)
-    {
-        return SOAR_FS_ERROR; // No free handles
-    }
-
-    // Create full path
-    char fullPath[64];
-    snprintf(fullPath, sizeof(fullPath), "%s%s", SOAR_FS_DRIVE_PATH, filename);
-
-    // Open the file
-    FRESULT fr = f_open(&g_file_handles[handle_idx].file_object, fullPath, FA_READ | FA_WRITE);
-    if (fr != FR_OK)
-    {
-        return SoarFS_ConvertFresultToSoarResult(fr);
-    }
-
-    // Store filename and mark as open
-    strncpy(g_file_handles[handle_idx].filename, filename, SOAR_FS_MAX_FILENAME_LEN - 1);
-    g_file_handles[handle_idx].filename[SOAR_FS_MAX_FILENAME_LEN - 1] = '\0';
-    g_file_handles[handle_idx].is_open = true;
-
-    return SOAR_FS_OK;
+    // Timed as OPEN_FILE only, going through SoarFS_Open would count the call under OPEN as well
+    SoarFS_Handle_t handle;
+    return SoarFS_OpenExisting(filename, FA_READ | FA_WRITE, &handle, SOAR_FS_OP_OPEN_FILE);
 }
 
 /**
@@ -270,31 +353,21 @@ SoarFS_Result_t SoarFS_OpenFile(const char *filename)
  */
 SoarFS_Result_t SoarFS_CloseFile(const char *filename)
 {
+    SoarFS_OpTimer timer(SOAR_FS_OP_CLOSE_FILE);
+
     if (!SoarFS_IsValidFilename(filename))
     {
-        return SOAR_FS_INVALID_PARAMETER;
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
     }
 
     // Find the file handle
     int handle_idx = SoarFS_FindHandleByFilename(filename);
     if (handle_idx < 0)
     {
-        return SOAR_FS_FILE_NOT_OPEN;
-    }
-
-    // Close the file
-    FRESULT fr = f_close(&g_file_handles[handle_idx].file_object);
-
-    // Mark handle as free
-    g_file_handles[handle_idx].is_open = false;
-    memset(g_file_handles[handle_idx].filename, 0, SOAR_FS_MAX_FILENAME_LEN);
-
-    if (fr != FR_OK)
-    {
-        return SoarFS_ConvertFresultToSoarResult(fr);
+        return timer.Done(SOAR_FS_FILE_NOT_OPEN);
     }
 
-    return SOAR_FS_OK;
+    return timer.Done(SoarFS_Close(SoarFS_MakeHandle(handle_idx)));
 }
 
 /**
@@ -302,30 +375,26 @@ SoarFS_Result_t SoarFS_CloseFile(const char *filename)
  */
 SoarFS_Result_t SoarFS_ReadFile(const char *filename, uint8_t *buffer, uint32_t bufferSize, uint32_t *bytesRead)
 {
-    if (!SoarFS_IsValidFilename(filename) || buffer == NULL || bytesRead == NULL)
+    SoarFS_OpTimer timer(SOAR_FS_OP_READ_FILE);
+
+    if (!SoarFS_IsValidFilename(filename))
     {
-        return SOAR_FS_INVALID_PARAMETER;
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
     }
 
     // Find the file handle
     int handle_idx = SoarFS_FindHandleByFilename(filename);
     if (handle_idx < 0)
     {
-        return SOAR_FS_FILE_NOT_OPEN;
+        return timer.Done(SOAR_FS_FILE_NOT_OPEN);
     }
 
-    // Read from file
-    UINT bytes_read;
-    FRESULT fr = f_read(&g_file_handles[handle_idx].file_object, buffer, bufferSize, &bytes_read);
-
-    *bytesRead = bytes_read;
-
-    if (fr != FR_OK)
+    SoarFS_Result_t result = SoarFS_Read(SoarFS_MakeHandle(handle_idx), buffer, bufferSize, bytesRead);
+    if (result == SOAR_FS_OK)
     {
-        return SoarFS_ConvertFresultToSoarResult(fr);
+        timer.Transferred(*bytesRead);
     }
-
-    return SOAR_FS_OK;
+    return timer.Done(result);
 }
 
 /**
@@ -333,46 +402,38 @@ SoarFS_Result_t SoarFS_ReadFile(const char *filename, uint8_t *buffer, uint32_t
  */
 SoarFS_Result_t SoarFS_WriteFile(const char *filename, const uint8_t *data, uint32_t dataSize)
 {
-    if (!SoarFS_IsValidFilename(filename) || data == NULL || dataSize == 0)
+    SoarFS_OpTimer timer(SOAR_FS_OP_WRITE_FILE);
+
+    if (!SoarFS_IsValidFilename(filename))
     {
-        return SOAR_FS_INVALID_PARAMETER;
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
     }
 
     // Find the file handle
     int handle_idx = SoarFS_FindHandleByFilename(filename);
     if (handle_idx < 0)
     {
-        return SOAR_FS_FILE_NOT_OPEN;
+        return timer.Done(SOAR_FS_FILE_NOT_OPEN);
     }
 
-    // Move to end of file for appending
-    FRESULT fr = f_lseek(&g_file_handles[handle_idx].file_object, f_size(&g_file_handles[handle_idx].file_object));
-    if (fr != FR_OK)
-    {
-        return SoarFS_ConvertFresultToSoarResult(fr);
-    }
+    SoarFS_Handle_t handle = SoarFS_MakeHandle(handle_idx);
 
-    // Write data to file
-    UINT bytesWritten;
-    fr = f_write(&g_file_handles[handle_idx].file_object, data, dataSize, &bytesWritten);
-    if (fr != FR_OK)
+    // Move to end of file for appending
+    SoarFS_Result_t result = SoarFS_Seek(handle, SOAR_FS_SEEK_END);
+    if (result != SOAR_FS_OK)
     {
-        return SoarFS_ConvertFresultToSoarResult(fr);
+        return timer.Done(result);
     }
 
-    if (bytesWritten != dataSize)
+    result = SoarFS_Write(handle, data, dataSize);
+    if (result != SOAR_FS_OK)
     {
-        return SOAR_FS_DISK_FULL;
+        return timer.Done(result);
     }
 
     // Sync file to ensure data is written
-    fr = f_sync(&g_file_handles[handle_idx].file_object);
-    if (fr != FR_OK)
-    {
-        return SoarFS_ConvertFresultToSoarResult(fr);
-    }
-
-    return SOAR_FS_OK;
+    timer.Transferred(dataSize);
+    return timer.Done(SoarFS_Sync(handle));
 }
 
 /**
@@ -380,14 +441,16 @@ SoarFS_Result_t SoarFS_WriteFile(const char *filename, const uint8_t *data, uint
  */
 SoarFS_Result_t SoarFS_DeleteFile(const char *filename)
 {
+    SoarFS_OpTimer timer(SOAR_FS_OP_DELETE_FILE);
+
     if (!SoarFS_IsMounted())
     {
-        return SOAR_FS_NOT_MOUNTED;
+        return timer.Done(SOAR_FS_NOT_MOUNTED);
     }
 
     if (!SoarFS_IsValidFilename(filename))
     {
-        return SOAR_FS_INVALID_PARAMETER;
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
     }
 
     // Close file if it's open
@@ -405,10 +468,10 @@ SoarFS_Result_t SoarFS_DeleteFile(const char *filename)
     FRESULT fr = f_unlink(fullPath);
     if (fr != FR_OK)
     {
-        return SoarFS_ConvertFresultToSoarResult(fr);
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
     }
 
-    return SOAR_FS_OK;
+    return timer.Done(SOAR_FS_OK);
 }
 
 /**
@@ -416,8 +479,17 @@ SoarFS_Result_t SoarFS_DeleteFile(const char *filename)
  */
 bool SoarFS_FileExists(const char *filename)
 {
-    if (!SoarFS_IsMounted() || !SoarFS_IsValidFilename(filename))
+    SoarFS_OpTimer timer(SOAR_FS_OP_STAT);
+
+    if (!SoarFS_IsMounted())
+    {
+        timer.Done(SOAR_FS_NOT_MOUNTED);
+        return false;
+    }
+
+    if (!SoarFS_IsValidFilename(filename))
     {
+        timer.Done(SOAR_FS_INVALID_PARAMETER);
         return false;
     }
 
@@ -436,14 +508,16 @@ bool SoarFS_FileExists(const char *filename)
  */
 SoarFS_Result_t SoarFS_GetFileSize(const char *filename, uint32_t *fileSize)
 {
+    SoarFS_OpTimer timer(SOAR_FS_OP_STAT);
+
     if (!SoarFS_IsMounted())
     {
-        return SOAR_FS_NOT_MOUNTED;
+        return timer.Done(SOAR_FS_NOT_MOUNTED);
     }
 
     if (!SoarFS_IsValidFilename(filename) || fileSize == NULL)
     {
-        return SOAR_FS_INVALID_PARAMETER;
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
     }
 
     // Create full path
@@ -454,11 +528,11 @@ SoarFS_Result_t SoarFS_GetFileSize(const char *filename, uint32_t *fileSize)
     FRESULT fr = f_stat(fullPath, &fno);
     if (fr != FR_OK)
     {
-        return SoarFS_ConvertFresultToSoarResult(fr);
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
     }
 
     *fileSize = fno.fsize;
-    return SOAR_FS_OK;
+    return timer.Done(SOAR_FS_OK);
 }
 
 /**
@@ -472,9 +546,9 @@ SoarFS_Result_t SoarFS_CloseAllFiles(void)
     {
         if (g_file_handles[i].is_open)
         {
+            SoarFS_AppenderDrain(&g_file_handles[i]);
             FRESULT fr = f_close(&g_file_handles[i].file_object);
-            g_file_handles[i].is_open = false;
-            memset(g_file_handles[i].filename, 0, SOAR_FS_MAX_FILENAME_LEN);
+            SoarFS_ReleaseHandle(&g_file_handles[i]);
 
             if (fr != FR_OK && result == SOAR_FS_OK)
             {
@@ -486,86 +560,1154 @@ SoarFS_Result_t SoarFS_CloseAllFiles(void)
     return result;
 }
 
-/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Erase the volume and make a new FAT volume on it, test backends only
+ */
+SoarFS_Result_t SoarFS_Format(uint32_t clusterBytes)
+{
+#if USER_DISKIO_BACKEND == USER_DISKIO_BACKEND_MEDIA
+    // Never format real media, it may hold the only copy of a flight
+    (void)clusterBytes;
+    return SOAR_FS_WRITE_PROTECTED;
+#else
+    if (!g_fs_initialized)
+    {
+        return SOAR_FS_NOT_MOUNTED;
+    }
+
+    SoarFS_CloseAllFiles();
+    f_mount(NULL, USERPath, 0);
+    g_fs_mounted = false;
+
+    // f_mkfs checks the cluster count against the volume size before it writes anything
+    BYTE work[_MAX_SS];
+    FRESULT fr = f_mkfs(USERPath, SOAR_FS_MKFS_OPT, clusterBytes, work, sizeof(work));
+
+    FRESULT mountFr = SoarFS_Mount();
+    g_fs_mounted = (mountFr == FR_OK);
+
+    return SoarFS_ConvertFresultToSoarResult(fr != FR_OK ? fr : mountFr);
+#endif
+}
 
 /**
- * @brief Convert FatFS FRESULT to SoarFS_Result_t
+ * @brief Get the cluster size of the mounted volume
  */
-static SoarFS_Result_t SoarFS_ConvertFresultToSoarResult(FRESULT fr)
+SoarFS_Result_t SoarFS_GetClusterSize(uint32_t *clusterBytes)
 {
-    switch (fr)
+    if (!SoarFS_IsMounted())
     {
-    case FR_OK:
-        return SOAR_FS_OK;
-    case FR_NO_FILE:
-    case FR_NO_PATH:
-        return SOAR_FS_FILE_NOT_FOUND;
-    case FR_EXIST:
-        return SOAR_FS_FILE_EXISTS;
-    case FR_DISK_ERR:
-    case FR_NOT_READY:
         return SOAR_FS_NOT_MOUNTED;
-    case FR_WRITE_PROTECTED:
-        return SOAR_FS_WRITE_PROTECTED;
-    case FR_TIMEOUT:
-        return SOAR_FS_TIMEOUT;
-    case FR_INVALID_PARAMETER:
-    case FR_INVALID_NAME:
+    }
+
+    if (clusterBytes == NULL)
+    {
         return SOAR_FS_INVALID_PARAMETER;
-    default:
-        return SOAR_FS_ERROR;
     }
+
+#if _MAX_SS == _MIN_SS
+    *clusterBytes = (uint32_t)USERFatFs.csize * _MIN_SS;
+#else
+    *clusterBytes = (uint32_t)USERFatFs.csize * USERFatFs.ssize;
+#endif
+    return SOAR_FS_OK;
 }
 
+/* Handle-based API ----------------------------------------------------------*/
+
 /**
- * @brief Find a free file handle
+ * @brief Open an existing file and return a handle to it
  */
-static int SoarFS_FindFreeHandle(void)
+SoarFS_Result_t SoarFS_Open(const char *filename, SoarFS_Handle_t *handle)
 {
-    for (int i = 0; i < SOAR_FS_MAX_FILES_OPEN; i++)
+    return SoarFS_OpenExisting(filename, FA_READ | FA_WRITE, handle, SOAR_FS_OP_OPEN);
+}
+
+/**
+ * @brief Open an existing file read-only with a fast-seek map
+ */
+SoarFS_Result_t SoarFS_OpenReader(const char *filename, SoarFS_Handle_t *handle)
+{
+    SoarFS_Result_t result = SoarFS_OpenExisting(filename, FA_READ, handle, SOAR_FS_OP_OPEN);
+    if (result != SOAR_FS_OK)
     {
-        if (!g_file_handles[i].is_open)
-        {
-            return i;
-        }
+        return result;
     }
-    return -1; // No free handles
+
+    // Seeks then look clusters up in RAM instead of walking the FAT chain from the start
+    SoarFS_FileHandle_t *fh = SoarFS_ResolveHandle(*handle);
+    if (SoarFS_MapClusters(fh) != FR_OK)
+    {
+        fh->file_object.cltbl = NULL;
+    }
+    return SOAR_FS_OK;
 }
 
 /**
- * @brief Find file handle by filename
+ * @brief Close a file, the handle is invalid after this call
  */
-static int SoarFS_FindHandleByFilename(const char *filename)
+SoarFS_Result_t SoarFS_Close(SoarFS_Handle_t handle)
 {
-    for (int i = 0; i < SOAR_FS_MAX_FILES_OPEN; i++)
+    SoarFS_OpTimer timer(SOAR_FS_OP_CLOSE);
+
+    SoarFS_FileHandle_t *fh = SoarFS_ResolveHandle(handle);
+    if (fh == NULL)
     {
-        if (g_file_handles[i].is_open && strcmp(g_file_handles[i].filename, filename) == 0)
-        {
-            return i;
-        }
+        return timer.Done(SOAR_FS_INVALID_HANDLE);
     }
-    return -1; // Not found
+
+    // Staged data goes out before the close syncs the file
+    SoarFS_Result_t result = SoarFS_AppenderDrain(fh);
+
+    // Give back the unwritten part of a reservation
+    FRESULT fr = SoarFS_PreallocRelease(fh);
+    if (result == SOAR_FS_OK)
+    {
+        result = SoarFS_ConvertFresultToSoarResult(fr);
+    }
+
+    // Close the file
+    fr = f_close(&fh->file_object);
+
+    // Mark handle as free
+    SoarFS_ReleaseHandle(fh);
+
+    if (fr != FR_OK)
+    {
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+    }
+
+    return timer.Done(result);
 }
 
 /**
- * @brief Check if filename is valid
+ * @brief Read data from the current position of a file
  */
-static bool SoarFS_IsValidFilename(const char *filename)
+SoarFS_Result_t SoarFS_Read(SoarFS_Handle_t handle, uint8_t *buffer, uint32_t bufferSize, uint32_t *bytesRead)
 {
-    if (filename == NULL || strlen(filename) == 0 || strlen(filename) >= SOAR_FS_MAX_FILENAME_LEN)
+    SoarFS_OpTimer timer(SOAR_FS_OP_READ);
+
+    if (buffer == NULL || bytesRead == NULL)
     {
-        return false;
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
     }
 
-    // Check for invalid characters
-    const char *invalid_chars = "\\/:*?\"<>|";
-    for (int i = 0; invalid_chars[i] != '\0'; i++)
+    SoarFS_FileHandle_t *fh = SoarFS_ResolveHandle(handle);
+    if (fh == NULL)
     {
-        if (strchr(filename, invalid_chars[i]) != NULL)
+        return timer.Done(SOAR_FS_INVALID_HANDLE);
+    }
+
+    SoarFS_Result_t result = SoarFS_AppenderDrain(fh);
+    if (result != SOAR_FS_OK)
+    {
+        return timer.Done(result);
+    }
+
+    // Read from file
+    UINT bytes_read;
+    FRESULT fr = f_read(&fh->file_object, buffer, bufferSize, &bytes_read);
+
+    *bytesRead = bytes_read;
+    timer.Transferred(bytes_read);
+
+    if (fr != FR_OK)
+    {
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+    }
+
+    return timer.Done(SOAR_FS_OK);
+}
+
+/**
+ * @brief Write data at the current position of a file, does not sync
+ */
+SoarFS_Result_t SoarFS_Write(SoarFS_Handle_t handle, const uint8_t *data, uint32_t dataSize)
+{
+    SoarFS_OpTimer timer(SOAR_FS_OP_WRITE);
+
+    if (data == NULL || dataSize == 0)
+    {
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
+    }
+
+    SoarFS_FileHandle_t *fh = SoarFS_ResolveHandle(handle);
+    if (fh == NULL)
+    {
+        return timer.Done(SOAR_FS_INVALID_HANDLE);
+    }
+
+    if (fh->appender.enabled)
+    {
+        SoarFS_Result_t result = SoarFS_AppenderAppend(fh, data, dataSize);
+        if (result != SOAR_FS_OK)
         {
-            return false;
+            return timer.Done(result);
         }
+        timer.Transferred(dataSize);
+        return timer.Done(SoarFS_AppenderApplyPolicy(fh, HAL_GetTick()));
     }
 
-    return true;
+    // Write data to file
+    UINT bytesWritten;
+    FRESULT fr = f_write(&fh->file_object, data, dataSize, &bytesWritten);
+    SoarFS_PreallocTrack(fh);
+    if (fr != FR_OK)
+    {
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+    }
+
+    if (bytesWritten != dataSize)
+    {
+        return timer.Done(SOAR_FS_DISK_FULL);
+    }
+
+    timer.Transferred(dataSize);
+    return timer.Done(SOAR_FS_OK);
+}
+
+/**
+ * @brief Flush cached data and the directory entry of a file to the storage
+ */
+SoarFS_Result_t SoarFS_Sync(SoarFS_Handle_t handle)
+{
+    SoarFS_FileHandle_t *fh = SoarFS_ResolveHandle(handle);
+    if (fh == NULL)
+    {
+        return SOAR_FS_INVALID_HANDLE;
+    }
+
+    return SoarFS_AppenderCommit(fh, HAL_GetTick());
+}
+
+/**
+ * @brief Move the read/write position of a file
+ */
+SoarFS_Result_t SoarFS_Seek(SoarFS_Handle_t handle, uint32_t offset)
+{
+    SoarFS_OpTimer timer(SOAR_FS_OP_SEEK);
+
+    SoarFS_FileHandle_t *fh = SoarFS_ResolveHandle(handle);
+    if (fh == NULL)
+    {
+        return timer.Done(SOAR_FS_INVALID_HANDLE);
+    }
+
+    SoarFS_Result_t result = SoarFS_AppenderDrain(fh);
+    if (result != SOAR_FS_OK)
+    {
+        return timer.Done(result);
+    }
+
+    // The end of a preallocated file is its furthest written byte, not the reservation
+    SoarFS_PreallocTrack(fh);
+    if (offset == SOAR_FS_SEEK_END)
+    {
+        offset = fh->prealloc.enabled ? fh->prealloc.highWater : f_size(&fh->file_object);
+    }
+
+    result = SoarFS_ConvertFresultToSoarResult(f_lseek(&fh->file_object, offset));
+    SoarFS_AppenderRealign(fh);
+    return timer.Done(result);
+}
+
+/**
+ * @brief Get the read/write position of a file
+ */
+SoarFS_Result_t SoarFS_Tell(SoarFS_Handle_t handle, uint32_t *offset)
+{
+    if (offset == NULL)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    SoarFS_FileHandle_t *fh = SoarFS_ResolveHandle(handle);
+    if (fh == NULL)
+    {
+        return SOAR_FS_INVALID_HANDLE;
+    }
+
+    // Staged bytes are logically part of the file already
+    *offset = f_tell(&fh->file_object) + (fh->appender.stagedEnd - fh->appender.stagedStart);
+    return SOAR_FS_OK;
+}
+
+/* Write-behind appender -----------------------------------------------------*/
+
+/**
+ * @brief Open an existing file as a write-behind appender positioned at its end
+ */
+SoarFS_Result_t SoarFS_OpenAppender(const char *filename, const SoarFS_SyncPolicy_t *policy, SoarFS_Handle_t *handle)
+{
+    if (policy == NULL || policy->mode > SOAR_FS_SYNC_ON_CLOSE)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    SoarFS_Result_t result = SoarFS_Open(filename, handle);
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+
+    result = SoarFS_Seek(*handle, SOAR_FS_SEEK_END);
+    if (result != SOAR_FS_OK)
+    {
+        SoarFS_Close(*handle);
+        return result;
+    }
+
+    SoarFS_AppenderEnable(SoarFS_ResolveHandle(*handle), policy);
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Drain staged data to FatFS and sync it, unless the policy is SOAR_FS_SYNC_ON_CLOSE
+ */
+SoarFS_Result_t SoarFS_Flush(SoarFS_Handle_t handle)
+{
+    SoarFS_OpTimer timer(SOAR_FS_OP_FLUSH);
+
+    SoarFS_FileHandle_t *fh = SoarFS_ResolveHandle(handle);
+    if (fh == NULL)
+    {
+        return timer.Done(SOAR_FS_INVALID_HANDLE);
+    }
+
+    if (fh->appender.enabled && fh->appender.policy.mode == SOAR_FS_SYNC_ON_CLOSE)
+    {
+        return timer.Done(SoarFS_AppenderDrain(fh));
+    }
+
+    return timer.Done(SoarFS_AppenderCommit(fh, HAL_GetTick()));
+}
+
+/**
+ * @brief Drain staged data and write the data sectors through, the directory entry is left alone
+ */
+SoarFS_Result_t SoarFS_FlushData(SoarFS_Handle_t handle)
+{
+    SoarFS_OpTimer timer(SOAR_FS_OP_FLUSH_DATA);
+
+    SoarFS_FileHandle_t *fh = SoarFS_ResolveHandle(handle);
+    if (fh == NULL)
+    {
+        return timer.Done(SOAR_FS_INVALID_HANDLE);
+    }
+
+    SoarFS_Result_t result = SoarFS_AppenderDrain(fh);
+    if (result != SOAR_FS_OK)
+    {
+        return timer.Done(result);
+    }
+
+    // Clusters outside a reservation are linked in the FAT by f_sync, and a partial
+    // sector is still in FatFS's buffer when the position is not sector aligned
+    if (!fh->prealloc.enabled || (fh->file_object.flag & SOAR_FS_FIL_DIRTY) != 0)
+    {
+        return timer.Done(SoarFS_AppenderCommit(fh, HAL_GetTick()));
+    }
+
+    // Writes a cached sector back, the sectors FatFS wrote are already with the driver
+    DRESULT dr = disk_ioctl(fh->file_object.obj.fs->drv, CTRL_SYNC, NULL);
+    return timer.Done((dr == RES_OK) ? SOAR_FS_OK : SOAR_FS_ERROR);
+}
+
+/**
+ * @brief Cut a file at its read/write position
+ */
+SoarFS_Result_t SoarFS_Truncate(SoarFS_Handle_t handle)
+{
+    SoarFS_OpTimer timer(SOAR_FS_OP_TRUNCATE);
+
+    SoarFS_FileHandle_t *fh = SoarFS_ResolveHandle(handle);
+    if (fh == NULL)
+    {
+        return timer.Done(SOAR_FS_INVALID_HANDLE);
+    }
+
+    SoarFS_Result_t result = SoarFS_AppenderDrain(fh);
+    if (result != SOAR_FS_OK)
+    {
+        return timer.Done(result);
+    }
+
+    // The reservation stays mapped, SoarFS_PreallocRelease truncates at the high water mark
+    if (fh->prealloc.enabled)
+    {
+        fh->prealloc.highWater = f_tell(&fh->file_object);
+        return timer.Done(SOAR_FS_OK);
+    }
+
+    return timer.Done(SoarFS_ConvertFresultToSoarResult(f_truncate(&fh->file_object)));
+}
+
+/* Preallocated files --------------------------------------------------------*/
+
+/**
+ * @brief Create a new file with a contiguous reservation and open it at offset 0
+ */
+SoarFS_Result_t SoarFS_CreatePreallocated(const char *filename, uint32_t bytes, const SoarFS_SyncPolicy_t *policy,
+                                          SoarFS_Handle_t *handle)
+{
+    SoarFS_OpTimer timer(SOAR_FS_OP_CREATE_PREALLOCATED);
+
+    if (!SoarFS_IsMounted())
+    {
+        return timer.Done(SOAR_FS_NOT_MOUNTED);
+    }
+
+    if (!SoarFS_IsValidFilename(filename) || handle == NULL || bytes == 0 ||
+        (policy != NULL && policy->mode > SOAR_FS_SYNC_ON_CLOSE))
+    {
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
+    }
+
+    int handle_idx = SoarFS_FindFreeHandle();
+    if (handle_idx < 0)
+    {
+        return timer.Done(SOAR_FS_ERROR); // No free handles
+    }
+
+    // Create full path
+    char fullPath[64];
+    snprintf(fullPath, sizeof(fullPath), "%s%s", SOAR_FS_DRIVE_PATH, filename);
+
+    SoarFS_FileHandle_t *fh = &g_file_handles[handle_idx];
+    FRESULT fr = f_open(&fh->file_object, fullPath, FA_CREATE_NEW | FA_READ | FA_WRITE);
+    if (fr != FR_OK)
+    {
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+    }
+
+    // Allocate now (opt = 1), FR_DENIED means no contiguous run of free clusters is long enough
+    fr = f_expand(&fh->file_object, bytes, 1);
+    if (fr == FR_OK)
+    {
+        fr = SoarFS_MapClusters(fh);
+    }
+
+    if (fr != FR_OK)
+    {
+        f_close(&fh->file_object);
+        f_unlink(fullPath);
+        memset(&fh->prealloc, 0, sizeof(SoarFS_Prealloc_t));
+        return timer.Done((fr == FR_DENIED) ? SOAR_FS_DISK_FULL : SoarFS_ConvertFresultToSoarResult(fr));
+    }
+
+    SoarFS_PreallocOpen(fh, filename, policy);
+    *handle = SoarFS_MakeHandle(handle_idx);
+    return timer.Done(SOAR_FS_OK);
+}
+
+/**
+ * @brief Create a new file with a contiguous reservation and close it at its full size
+ */
+SoarFS_Result_t SoarFS_Reserve(const char *filename, uint32_t bytes)
+{
+    SoarFS_OpTimer timer(SOAR_FS_OP_RESERVE);
+
+    if (!SoarFS_IsMounted())
+    {
+        return timer.Done(SOAR_FS_NOT_MOUNTED);
+    }
+
+    if (!SoarFS_IsValidFilename(filename) || bytes == 0)
+    {
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
+    }
+
+    // Borrow a free slot's FIL for the duration instead of putting one on the stack
+    int handle_idx = SoarFS_FindFreeHandle();
+    if (handle_idx < 0)
+    {
+        return timer.Done(SOAR_FS_ERROR); // No free handles
+    }
+
+    char fullPath[64];
+    snprintf(fullPath, sizeof(fullPath), "%s%s", SOAR_FS_DRIVE_PATH, filename);
+
+    FIL *fp = &g_file_handles[handle_idx].file_object;
+    FRESULT fr = f_open(fp, fullPath, FA_CREATE_NEW | FA_WRITE);
+    if (fr != FR_OK)
+    {
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+    }
+
+    FRESULT expandFr = f_expand(fp, bytes, 1);
+    fr = f_close(fp);
+    if (expandFr != FR_OK || fr != FR_OK)
+    {
+        f_unlink(fullPath);
+        if (expandFr == FR_DENIED)
+        {
+            return timer.Done(SOAR_FS_DISK_FULL);
+        }
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(expandFr != FR_OK ? expandFr : fr));
+    }
+
+    return timer.Done(SOAR_FS_OK);
+}
+
+/**
+ * @brief Open a file made by SoarFS_Reserve at offset 0, its whole size being the reservation
+ */
+SoarFS_Result_t SoarFS_OpenPreallocated(const char *filename, const SoarFS_SyncPolicy_t *policy,
+                                        SoarFS_Handle_t *handle)
+{
+    SoarFS_OpTimer timer(SOAR_FS_OP_OPEN_PREALLOCATED);
+
+    if (!SoarFS_IsMounted())
+    {
+        return timer.Done(SOAR_FS_NOT_MOUNTED);
+    }
+
+    if (!SoarFS_IsValidFilename(filename) || handle == NULL ||
+        (policy != NULL && policy->mode > SOAR_FS_SYNC_ON_CLOSE))
+    {
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
+    }
+
+    if (SoarFS_FindHandleByFilename(filename) >= 0)
+    {
+        return timer.Done(SOAR_FS_FILE_ALREADY_OPEN);
+    }
+
+    int handle_idx = SoarFS_FindFreeHandle();
+    if (handle_idx < 0)
+    {
+        return timer.Done(SOAR_FS_ERROR); // No free handles
+    }
+
+    char fullPath[64];
+    snprintf(fullPath, sizeof(fullPath), "%s%s", SOAR_FS_DRIVE_PATH, filename);
+
+    SoarFS_FileHandle_t *fh = &g_file_handles[handle_idx];
+    FRESULT fr = f_open(&fh->file_object, fullPath, FA_OPEN_EXISTING | FA_READ | FA_WRITE);
+    if (fr != FR_OK)
+    {
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+    }
+
+    // Writes stay inside the existing chain either way, a fragmented one only loses O(1) seeks
+    if (SoarFS_MapClusters(fh) != FR_OK)
+    {
+        fh->file_object.cltbl = NULL;
+    }
+
+    SoarFS_PreallocOpen(fh, filename, policy);
+    *handle = SoarFS_MakeHandle(handle_idx);
+    return timer.Done(SOAR_FS_OK);
+}
+
+/**
+ * @brief Rename a file that is not open
+ */
+SoarFS_Result_t SoarFS_Rename(const char *oldName, const char *newName)
+{
+    SoarFS_OpTimer timer(SOAR_FS_OP_RENAME);
+
+    if (!SoarFS_IsMounted())
+    {
+        return timer.Done(SOAR_FS_NOT_MOUNTED);
+    }
+
+    if (!SoarFS_IsValidFilename(oldName) || !SoarFS_IsValidFilename(newName))
+    {
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
+    }
+
+    if (SoarFS_FindHandleByFilename(oldName) >= 0)
+    {
+        return timer.Done(SOAR_FS_FILE_ALREADY_OPEN);
+    }
+
+    char oldPath[64];
+    char newPath[64];
+    snprintf(oldPath, sizeof(oldPath), "%s%s", SOAR_FS_DRIVE_PATH, oldName);
+    snprintf(newPath, sizeof(newPath), "%s%s", SOAR_FS_DRIVE_PATH, newName);
+
+    return timer.Done(SoarFS_ConvertFresultToSoarResult(f_rename(oldPath, newPath)));
+}
+
+/**
+ * @brief Call a function for every file in the root directory
+ */
+SoarFS_Result_t SoarFS_ListFiles(SoarFS_ListCallback_t callback, void *context)
+{
+    SoarFS_OpTimer timer(SOAR_FS_OP_LIST);
+
+    if (!SoarFS_IsMounted())
+    {
+        return timer.Done(SOAR_FS_NOT_MOUNTED);
+    }
+
+    if (callback == NULL)
+    {
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
+    }
+
+    DIR dir;
+    FRESULT fr = f_opendir(&dir, SOAR_FS_DRIVE_PATH);
+    if (fr != FR_OK)
+    {
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+    }
+
+    FILINFO info;
+    while ((fr = f_readdir(&dir, &info)) == FR_OK && info.fname[0] != '\0')
+    {
+        if (!(info.fattrib & AM_DIR))
+        {
+            callback(info.fname, (uint32_t)info.fsize, context);
+        }
+    }
+
+    f_closedir(&dir);
+    return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+}
+
+/**
+ * @brief Check if a handle was opened as a write-behind appender
+ */
+bool SoarFS_IsAppender(SoarFS_Handle_t handle)
+{
+    SoarFS_FileHandle_t *fh = SoarFS_ResolveHandle(handle);
+    return fh != NULL && fh->appender.enabled;
+}
+
+/**
+ * @brief Service time based sync policies, call periodically from the owning task
+ */
+void SoarFS_Poll(void)
+{
+    uint32_t now = HAL_GetTick();
+
+    for (int i = 0; i < SOAR_FS_MAX_FILES_OPEN; i++)
+    {
+        if (g_file_handles[i].is_open && g_file_handles[i].appender.enabled)
+        {
+            SoarFS_AppenderApplyPolicy(&g_file_handles[i], now);
+        }
+    }
+}
+
+/* Instrumentation -----------------------------------------------------------*/
+
+/**
+ * @brief Live counters of every operation
+ */
+const SoarFS_Stats_t *SoarFS_GetStats(void)
+{
+    return &g_fs_stats;
+}
+
+/**
+ * @brief Zero the counters of every operation
+ */
+void SoarFS_ResetStats(void)
+{
+    memset(&g_fs_stats, 0, sizeof(g_fs_stats));
+}
+
+/**
+ * @brief Short lowercase name of an operation
+ */
+const char *SoarFS_OpName(SoarFS_Op_t op)
+{
+    return ((uint32_t)op < SOAR_FS_OP_COUNT) ? SOAR_FS_OP_NAMES[op] : "?";
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Convert FatFS FRESULT to SoarFS_Result_t
+ */
+static SoarFS_Result_t SoarFS_ConvertFresultToSoarResult(FRESULT fr)
+{
+    switch (fr)
+    {
+    case FR_OK:
+        return SOAR_FS_OK;
+    case FR_NO_FILE:
+    case FR_NO_PATH:
+        return SOAR_FS_FILE_NOT_FOUND;
+    case FR_EXIST:
+        return SOAR_FS_FILE_EXISTS;
+    case FR_DISK_ERR:
+    case FR_NOT_READY:
+        return SOAR_FS_NOT_MOUNTED;
+    case FR_WRITE_PROTECTED:
+        return SOAR_FS_WRITE_PROTECTED;
+    case FR_TIMEOUT:
+        return SOAR_FS_TIMEOUT;
+    case FR_INVALID_PARAMETER:
+    case FR_INVALID_NAME:
+        return SOAR_FS_INVALID_PARAMETER;
+    default:
+        return SOAR_FS_ERROR;
+    }
+}
+
+/**
+ * @brief Count a finished operation into its latency bucket, floor(log2) of the
+ * latency in units of the first bucket with one count leading zeros instruction
+ */
+static void SoarFS_RecordOp(SoarFS_Op_t op, uint32_t cycles, bool failed, uint32_t bytes)
+{
+    SoarFS_OpStats_t *stats = &g_fs_stats.ops[op];
+    const uint32_t us = cycles / g_cycles_per_us;
+
+    uint32_t bucket = 0;
+    if (us >= SOAR_FS_LATENCY_BUCKET0_US)
+    {
+        bucket = 32 - __builtin_clz(us / SOAR_FS_LATENCY_BUCKET0_US);
+        if (bucket > SOAR_FS_LATENCY_BUCKETS - 1)
+        {
+            bucket = SOAR_FS_LATENCY_BUCKETS - 1;
+        }
+    }
+
+    stats->calls++;
+    if (failed)
+    {
+        stats->errors++;
+    }
+    else
+    {
+        stats->bytes += bytes;
+    }
+    stats->totalUs += us;
+    if (us > stats->maxUs)
+    {
+        stats->maxUs = us;
+    }
+    stats->histogram[bucket]++;
+}
+
+/**
+ * @brief Mount the volume, formatting it first if it is a blank RAM disk or disk
+ * image, and seed the free cluster count
+ */
+static FRESULT SoarFS_Mount(void)
+{
+    SoarFS_OpTimer timer(SOAR_FS_OP_MOUNT);
+    g_last_mount_tick = HAL_GetTick();
+
+    /* diskio.c calls a driver's initialize only the first time after it is linked, so a
+     * mount after the media was pulled, or a retry while it is still out, would otherwise
+     * never reach it again. Relinking restarts that on every attempt, the drive number and
+     * USERPath stay the same as this is the only linked driver. */
+    FATFS_UnLinkDriver(USERPath);
+    FATFS_LinkDriver(&USER_Driver, USERPath);
+
+    FRESULT fr = f_mount(&USERFatFs, USERPath, 1);
+
+#if USER_DISKIO_BACKEND != USER_DISKIO_BACKEND_MEDIA
+    // Never format real media, a card without a FAT volume may still hold data
+    if (fr == FR_NO_FILESYSTEM)
+    {
+        BYTE work[_MAX_SS];
+        fr = f_mkfs(USERPath, SOAR_FS_MKFS_OPT, 0, work, sizeof(work));
+        if (fr == FR_OK)
+        {
+            fr = f_mount(&USERFatFs, USERPath, 1);
+        }
+    }
+#endif
+
+    if (fr == FR_OK)
+    {
+        // Reads FSINFO on FAT32, scans the FAT once on FAT12/16
+        DWORD fre_clust;
+        FATFS *fs;
+        f_getfree(USERPath, &fre_clust, &fs);
+    }
+
+    timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+    return fr;
+}
+
+/**
+ * @brief Release every slot without touching the media, used once it is gone.
+ * Handles issued before become stale, a remount invalidates the FIL objects anyway.
+ */
+static void SoarFS_DropAllFiles(void)
+{
+    for (int i = 0; i < SOAR_FS_MAX_FILES_OPEN; i++)
+    {
+        if (g_file_handles[i].is_open)
+        {
+            SoarFS_ReleaseHandle(&g_file_handles[i]);
+        }
+    }
+}
+
+/**
+ * @brief Find a free file handle
+ */
+static int SoarFS_FindFreeHandle(void)
+{
+    for (int i = 0; i < SOAR_FS_MAX_FILES_OPEN; i++)
+    {
+        if (!g_file_handles[i].is_open)
+        {
+            return i;
+        }
+    }
+    return -1; // No free handles
+}
+
+/**
+ * @brief Find file handle by filename
+ */
+static int SoarFS_FindHandleByFilename(const char *filename)
+{
+    for (int i = 0; i < SOAR_FS_MAX_FILES_OPEN; i++)
+    {
+        if (g_file_handles[i].is_open && strcmp(g_file_handles[i].filename, filename) == 0)
+        {
+            return i;
+        }
+    }
+    return -1; // Not found
+}
+
+/**
+ * @brief Check if filename is valid
+ */
+static bool SoarFS_IsValidFilename(const char *filename)
+{
+    if (filename == NULL || strlen(filename) == 0 || strlen(filename) >= SOAR_FS_MAX_FILENAME_LEN)
+    {
+        return false;
+    }
+
+    // Check for invalid characters
+    const char *invalid_chars = "\\/:*?\"<>|";
+    for (int i = 0; invalid_chars[i] != '\0'; i++)
+    {
+        if (strchr(filename, invalid_chars[i]) != NULL)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Build the handle for a slot from its index and current generation
+ */
+static SoarFS_Handle_t SoarFS_MakeHandle(int handle_idx)
+{
+    // Index is stored off by one so a zeroed handle never resolves
+    return (g_file_handles[handle_idx].generation << SOAR_FS_HANDLE_INDEX_BITS) | (uint32_t)(handle_idx + 1);
+}
+
+/**
+ * @brief Resolve a handle to its open slot, O(1)
+ * @retval Pointer to the slot, or NULL if the handle is stale or invalid
+ */
+static SoarFS_FileHandle_t *SoarFS_ResolveHandle(SoarFS_Handle_t handle)
+{
+    uint32_t idx = (handle & SOAR_FS_HANDLE_INDEX_MASK) - 1;
+    if (idx >= SOAR_FS_MAX_FILES_OPEN)
+    {
+        return NULL;
+    }
+
+    SoarFS_FileHandle_t *fh = &g_file_handles[idx];
+    if (!fh->is_open || fh->generation != (handle >> SOAR_FS_HANDLE_INDEX_BITS))
+    {
+        return NULL;
+    }
+
+    return fh;
+}
+
+/**
+ * @brief Mark a slot as free and invalidate every handle issued for it
+ */
+static void SoarFS_ReleaseHandle(SoarFS_FileHandle_t *fh)
+{
+    memset(&fh->appender, 0, sizeof(SoarFS_Appender_t));
+    memset(&fh->prealloc, 0, sizeof(SoarFS_Prealloc_t));
+    fh->is_open = false;
+    memset(fh->filename, 0, SOAR_FS_MAX_FILENAME_LEN);
+    fh->generation = (fh->generation + 1) & (0xFFFFFFFFu >> SOAR_FS_HANDLE_INDEX_BITS);
+}
+
+/**
+ * @brief Staging buffer of a slot
+ */
+static uint8_t *SoarFS_AppenderBuffer(SoarFS_FileHandle_t *fh)
+{
+    return g_appender_buffers[fh - g_file_handles];
+}
+
+/**
+ * @brief Line the empty staging buffer up with the file position's offset in its sector
+ */
+static void SoarFS_AppenderRealign(SoarFS_FileHandle_t *fh)
+{
+    uint16_t offset = (uint16_t)(f_tell(&fh->file_object) % SOAR_FS_BUFFER_SIZE);
+    fh->appender.stagedStart = offset;
+    fh->appender.stagedEnd = offset;
+}
+
+/**
+ * @brief Hand staged data to FatFS, a full buffer lands as one aligned sector write
+ */
+static SoarFS_Result_t SoarFS_AppenderDrain(SoarFS_FileHandle_t *fh)
+{
+    SoarFS_Appender_t *app = &fh->appender;
+    if (app->stagedEnd == app->stagedStart)
+    {
+        return SOAR_FS_OK;
+    }
+
+    UINT toWrite = app->stagedEnd - app->stagedStart;
+    UINT bytesWritten;
+    FRESULT fr = f_write(&fh->file_object, SoarFS_AppenderBuffer(fh) + app->stagedStart, toWrite, &bytesWritten);
+
+    // Staged data is dropped on failure, retrying would only repeat the error
+    SoarFS_AppenderRealign(fh);
+
+    if (fr != FR_OK)
+    {
+        return SoarFS_ConvertFresultToSoarResult(fr);
+    }
+
+    return (bytesWritten == toWrite) ? SOAR_FS_OK : SOAR_FS_DISK_FULL;
+}
+
+/**
+ * @brief Stage data, writing out each sector as it fills
+ */
+static SoarFS_Result_t SoarFS_AppenderAppend(SoarFS_FileHandle_t *fh, const uint8_t *data, uint32_t dataSize)
+{
+    SoarFS_Appender_t *app = &fh->appender;
+    uint8_t *staging = SoarFS_AppenderBuffer(fh);
+
+    app->unsyncedBytes += dataSize;
+
+    while (dataSize > 0)
+    {
+        // Sector aligned and nothing staged, whole sectors can skip the copy
+        if (app->stagedEnd == 0 && dataSize >= SOAR_FS_BUFFER_SIZE)
+        {
+            UINT toWrite = dataSize - (dataSize % SOAR_FS_BUFFER_SIZE);
+            UINT bytesWritten;
+            FRESULT fr = f_write(&fh->file_object, data, toWrite, &bytesWritten);
+            if (fr != FR_OK)
+            {
+                return SoarFS_ConvertFresultToSoarResult(fr);
+            }
+            if (bytesWritten != toWrite)
+            {
+                return SOAR_FS_DISK_FULL;
+            }
+            data += toWrite;
+            dataSize -= toWrite;
+            continue;
+        }
+
+        uint32_t chunk = SOAR_FS_BUFFER_SIZE - app->stagedEnd;
+        if (chunk > dataSize)
+        {
+            chunk = dataSize;
+        }
+
+        memcpy(staging + app->stagedEnd, data, chunk);
+        app->stagedEnd += chunk;
+        data += chunk;
+        dataSize -= chunk;
+
+        if (app->stagedEnd == SOAR_FS_BUFFER_SIZE)
+        {
+            SoarFS_Result_t result = SoarFS_AppenderDrain(fh);
+            if (result != SOAR_FS_OK)
+            {
+                return result;
+            }
+        }
+    }
+
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Drain and f_sync, making everything appended so far durable
+ */
+static SoarFS_Result_t SoarFS_AppenderCommit(SoarFS_FileHandle_t *fh, uint32_t now)
+{
+    SoarFS_Result_t result = SoarFS_AppenderDrain(fh);
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+
+    SoarFS_OpTimer timer(SOAR_FS_OP_SYNC);
+    FRESULT fr = f_sync(&fh->file_object);
+    timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+    fh->appender.unsyncedBytes = 0;
+    fh->appender.lastSyncTick = now;
+
+    return SoarFS_ConvertFresultToSoarResult(fr);
+}
+
+/**
+ * @brief Commit if the appender's sync policy is due
+ */
+static SoarFS_Result_t SoarFS_AppenderApplyPolicy(SoarFS_FileHandle_t *fh, uint32_t now)
+{
+    const SoarFS_Appender_t *app = &fh->appender;
+    if (app->unsyncedBytes == 0)
+    {
+        return SOAR_FS_OK;
+    }
+
+    switch (app->policy.mode)
+    {
+    case SOAR_FS_SYNC_EVERY_N_BYTES:
+        if (app->unsyncedBytes >= app->policy.syncBytes)
+        {
+            return SoarFS_AppenderCommit(fh, now);
+        }
+        break;
+    case SOAR_FS_SYNC_EVERY_T_MS:
+        if ((now - app->lastSyncTick) >= app->policy.syncIntervalMs)
+        {
+            return SoarFS_AppenderCommit(fh, now);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Start staging writes on an open slot under a sync policy
+ */
+static void SoarFS_AppenderEnable(SoarFS_FileHandle_t *fh, const SoarFS_SyncPolicy_t *policy)
+{
+    fh->appender.policy = *policy;
+    fh->appender.unsyncedBytes = 0;
+    fh->appender.lastSyncTick = HAL_GetTick();
+    fh->appender.enabled = true;
+    SoarFS_AppenderRealign(fh);
+}
+
+/**
+ * @brief Open an existing file in a free slot, timed as op
+ */
+static SoarFS_Result_t SoarFS_OpenExisting(const char *filename, BYTE mode, SoarFS_Handle_t *handle, SoarFS_Op_t op)
+{
+    SoarFS_OpTimer timer(op);
+
+    if (!SoarFS_IsMounted())
+    {
+        return timer.Done(SOAR_FS_NOT_MOUNTED);
+    }
+
+    if (!SoarFS_IsValidFilename(filename) || handle == NULL)
+    {
+        return timer.Done(SOAR_FS_INVALID_PARAMETER);
+    }
+
+    // Check if file is already open
+    if (SoarFS_FindHandleByFilename(filename) >= 0)
+    {
+        return timer.Done(SOAR_FS_FILE_ALREADY_OPEN);
+    }
+
+    // Find a free handle
+    int handle_idx = SoarFS_FindFreeHandle();
+    if (handle_idx < 0)
+    {
+        return timer.Done(SOAR_FS_ERROR); // No free handles
+    }
+
+    // Create full path
+    char fullPath[64];
+    snprintf(fullPath, sizeof(fullPath), "%s%s", SOAR_FS_DRIVE_PATH, filename);
+
+    // Open the file
+    FRESULT fr = f_open(&g_file_handles[handle_idx].file_object, fullPath, mode);
+    if (fr != FR_OK)
+    {
+        return timer.Done(SoarFS_ConvertFresultToSoarResult(fr));
+    }
+
+    // Store filename and mark as open
+    strncpy(g_file_handles[handle_idx].filename, filename, SOAR_FS_MAX_FILENAME_LEN - 1);
+    g_file_handles[handle_idx].filename[SOAR_FS_MAX_FILENAME_LEN - 1] = '\0';
+    g_file_handles[handle_idx].is_open = true;
+
+    *handle = SoarFS_MakeHandle(handle_idx);
+    return timer.Done(SOAR_FS_OK);
+}
+
+/**
+ * @brief Build the fast-seek map of a slot's file, FR_NOT_ENOUGH_CORE if it has more fragments than the map holds
+ */
+static FRESULT SoarFS_MapClusters(SoarFS_FileHandle_t *fh)
+{
+    fh->clmt[0] = SOAR_FS_CLMT_ENTRIES;
+    fh->file_object.cltbl = fh->clmt;
+    return f_lseek(&fh->file_object, CREATE_LINKMAP);
+}
+
+/**
+ * @brief Mark a slot open on a reserved file, writes start at offset 0
+ */
+static void SoarFS_PreallocOpen(SoarFS_FileHandle_t *fh, const char *filename, const SoarFS_SyncPolicy_t *policy)
+{
+    // Store filename and mark as open
+    strncpy(fh->filename, filename, SOAR_FS_MAX_FILENAME_LEN - 1);
+    fh->filename[SOAR_FS_MAX_FILENAME_LEN - 1] = '\0';
+    fh->is_open = true;
+    fh->prealloc.enabled = true;
+    fh->prealloc.highWater = 0;
+
+    if (policy != NULL)
+    {
+        SoarFS_AppenderEnable(fh, policy);
+    }
+}
+
+/**
+ * @brief Advance the high water mark of a preallocated file to the file position
+ */
+static void SoarFS_PreallocTrack(SoarFS_FileHandle_t *fh)
+{
+    if (fh->prealloc.enabled && f_tell(&fh->file_object) > fh->prealloc.highWater)
+    {
+        fh->prealloc.highWater = f_tell(&fh->file_object);
+    }
+}
+
+/**
+ * @brief Truncate a preallocated file to its high water mark, freeing the unused clusters
+ */
+static FRESULT SoarFS_PreallocRelease(SoarFS_FileHandle_t *fh)
+{
+    if (!fh->prealloc.enabled)
+    {
+        return FR_OK;
+    }
+
+    SoarFS_PreallocTrack(fh);
+
+    // Leave fast-seek mode, f_lseek there cannot move past the cached map
+    fh->file_object.cltbl = NULL;
+    FRESULT fr = f_lseek(&fh->file_object, fh->prealloc.highWater);
+    if (fr == FR_OK)
+    {
+        fr = f_truncate(&fh->file_object);
+    }
+    return fr;
 }
@@ -0,0 +1,1456 @@
+/**
+ * File Name          : SoarFileSystemBenchmark.cpp
+ * Description        : Microbenchmarks for the SOAR File System wrapper
+ * Author             : SOAR Team
+ *
+ * Timings use the DWT cycle counter and are reported as average cycles per
+ * call, so results stay comparable across clock configurations.
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarFileSystemBenchmark.hpp"
+#include "SoarFileSystem.hpp"
+#include "SoarLZ.hpp"
+#include "SoarLogColumns.hpp"
+#include "SoarLogReader.hpp"
+#include "SoarLogRecovery.hpp"
+#include "SystemDefines.hpp"
+#include "CycleCounter.hpp"
+extern "C"
+{
+#include "app_fatfs.h" // Generated header has no C++ guards
+#if USER_DISKIO_CACHE
+#include "cache_diskio.h"
+#endif
+#if USER_DISKIO_FAULT
+#include "fault_diskio.h"
+#endif
+#if USER_DISKIO_BACKEND == USER_DISKIO_BACKEND_RAMDISK
+#include "ram_diskio.h"
+#endif
+}
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Private define ------------------------------------------------------------*/
+#define BENCH_FILENAME "bench.bin"
+#define BENCH_LOOKUP_ITERATIONS 1000
+#define BENCH_APPEND_FILENAME "append.bin"
+#define BENCH_APPEND_RECORD_SIZE 32
+#define BENCH_APPEND_RECORDS 256
+#define BENCH_MULTI_FILES 3
+#define BENCH_MULTI_RECORDS_PER_FILE 128
+#define BENCH_MULTI_SYNC_EVERY 8 // Records per file between syncs, like a 256 B appender policy
+#define BENCH_PREALLOC_FILENAME "prealloc.bin"
+#define BENCH_PREALLOC_RECORDS 512
+#define BENCH_PREALLOC_BYTES (BENCH_PREALLOC_RECORDS * BENCH_APPEND_RECORD_SIZE)
+#define BENCH_SEEK_ITERATIONS 64
+#define BENCH_LZ_INPUT_BYTES SOAR_LZ_WINDOW // Repeats are never visible to the window, so reusing it stays honest
+#define BENCH_LZ_PASSES 16
+#define BENCH_COLUMN_RECORDS 1024
+#define BENCH_COLUMN_MAX_RECORD sizeof(FlightData_t)
+#define BENCH_SEEK_LOG_FILENAME "seeklog.slg"
+#define BENCH_SEEK_LOG_BLOCKS (2 * SOAR_LOG_INDEX_SPAN + 256) // Two index slots and a footer, about 1 MB
+#define BENCH_SEEK_WINDOW_MS 10000
+#define BENCH_SEEK_ENV_EVERY 10 // Flight samples per env sample, env goes into column blocks
+#define BENCH_JOURNAL_FILENAME "journal.slg"
+#define BENCH_JOURNAL_BYTES (256 * SOAR_LOG_BLOCK_SIZE)
+#define BENCH_JOURNAL_COMMIT_EVERY 112 // Flight records per checkpoint, 8 data blocks
+#define BENCH_JOURNAL_RECORDS (12 * BENCH_JOURNAL_COMMIT_EVERY)
+#define BENCH_POWER_TRIALS 32
+#define BENCH_POWER_CUT_RANGE 128 // Sectors, a little more than a journal log takes so some trials close it
+#define BENCH_REMOVAL_FILENAME "removal.txt"
+#define BENCH_REMOVAL_ATTEMPTS 3 // Remounts left to fail while the media is out
+#define BENCH_SWEEP_FILENAME "sweep%lu.bin"
+#define BENCH_SWEEP_RECORDS 512        // Appends per run, fewer of the larger records
+#define BENCH_SWEEP_BYTES (128 * 1024) // Most written per run, less on a volume with less free
+#define BENCH_SWEEP_MAX_RECORD 1024
+
+/* Private typedef -----------------------------------------------------------*/
+typedef enum
+{
+    BENCH_LZ_FLIGHT_RECORDS = 0,
+    BENCH_LZ_CSV_LINES,
+    BENCH_LZ_RANDOM,
+    BENCH_LZ_DATASETS
+} SoarFS_Bench_LzDataset_t;
+
+typedef struct
+{
+    const char *name;
+    SoarFS_SyncPolicy_t policy;
+} SoarFS_Bench_SweepPolicy_t;
+
+typedef struct
+{
+    uint64_t writeCycles; // Appends and closes, summed per call so runs may outlast the counter
+    uint64_t readCycles;
+    uint32_t bytesRead;
+    uint32_t fsSectors;    // Written by FatFS
+    uint32_t mediaSectors; // Reaching the backend, after the sector cache
+} SoarFS_Bench_SweepResult_t;
+
+typedef struct
+{
+    uint32_t streamOffset; // Raw bytes verified so far
+    uint32_t inputLength;
+    uint32_t decodeCycles;
+    uint32_t blocks;
+    bool mismatch;
+} SoarFS_Bench_LzCheck_t;
+
+/* Private variables ---------------------------------------------------------*/
+// Too large for the task stack, benchmarks run one at a time and share it
+static union
+{
+    struct
+    {
+        SoarLZ_Writer_t writer;
+        uint8_t input[BENCH_LZ_INPUT_BYTES];
+        uint8_t output[SOAR_LZ_WINDOW];
+    } lz;
+    struct
+    {
+        SoarLog_ColumnBatch_t batch;
+        uint8_t payload[SOAR_LOG_BLOCK_PAYLOAD_SIZE];
+        uint32_t timestamps[SOAR_LOG_COLUMN_MAX_RECORDS];
+        uint8_t records[SOAR_LOG_COLUMN_MAX_RECORDS][BENCH_COLUMN_MAX_RECORD];
+    } columns;
+    struct
+    {
+        SoarLog_Writer_t writer;
+        SoarLog_ColumnBatch_t batch;
+        SoarLog_Reader_t reader;
+    } seek;
+    struct
+    {
+        SoarLog_Writer_t writer;
+        SoarLog_Reader_t reader;
+    } journal;
+    struct
+    {
+        uint32_t latency[BENCH_SWEEP_RECORDS]; // Cycles per append, sorted after the run
+        uint8_t record[BENCH_SWEEP_MAX_RECORD];
+    } sweep;
+} g_bench;
+
+// Sweep axes, every combination runs once per cluster size
+static const uint16_t BENCH_SWEEP_RECORD_SIZES[] = {16, 64, 256, BENCH_SWEEP_MAX_RECORD};
+static const uint8_t BENCH_SWEEP_FILE_COUNTS[] = {1, 2, SOAR_FS_MAX_FILES_OPEN};
+static const SoarFS_Bench_SweepPolicy_t BENCH_SWEEP_POLICIES[] = {
+    {"each", {SOAR_FS_SYNC_EVERY_N_BYTES, 1, 0}}, // Synced per record, like SoarFS_WriteFile
+    {"4k", {SOAR_FS_SYNC_EVERY_N_BYTES, 4096, 0}},
+    {"100ms", {SOAR_FS_SYNC_EVERY_T_MS, 0, 100}},
+    {"close", {SOAR_FS_SYNC_ON_CLOSE, 0, 0}},
+};
+static const uint32_t BENCH_SWEEP_CLUSTER_SIZES[] = {512, 4096, 16384};
+
+/* Private function prototypes -----------------------------------------------*/
+static bool SoarFS_Bench_PrepareFile(const char *filename);
+static bool SoarFS_Bench_ResetFile(const char *filename);
+static void SoarFS_Bench_ReportAppend(const char *label, uint32_t cycles);
+static void SoarFS_Bench_ReportLatency(const char *label, uint32_t minCycles, uint32_t maxCycles, uint32_t totalCycles,
+                                       uint32_t count);
+static uint32_t SoarFS_Bench_RandomSeeks(SoarFS_Handle_t handle);
+static uint32_t SoarFS_Bench_MakeSample(uint8_t type, uint32_t i, uint8_t *record);
+static uint32_t SoarFS_Bench_FillLzInput(SoarFS_Bench_LzDataset_t dataset);
+static bool SoarFS_Bench_CheckColumns(uint8_t type, uint32_t firstSample, uint16_t length);
+static uint32_t SoarFS_Bench_WriteSeekLog(void);
+static void SoarFS_Bench_ReadWindow(const char *label, bool indexed, uint32_t from, uint32_t expected);
+static SoarFS_Result_t SoarFS_Bench_LzCheckSink(const uint8_t *block, void *context);
+static SoarFS_Result_t SoarFS_Bench_OpenJournal(SoarFS_SyncMode_t mode);
+static uint32_t SoarFS_Bench_WriteJournal(bool commit, uint32_t *committed, uint32_t *checkpointCycles);
+#if USER_DISKIO_FAULT
+static bool SoarFS_Bench_CheckJournal(uint32_t committed, uint32_t appended, uint32_t *records);
+#endif
+#if USER_DISKIO_CACHE
+static bool SoarFS_Bench_MultiFileRun(const char *label);
+#endif
+static void SoarFS_Bench_SweepCluster(uint32_t clusterBytes);
+static bool SoarFS_Bench_SweepRun(uint32_t recordSize, uint32_t files, const SoarFS_SyncPolicy_t *policy,
+                                  uint32_t records, SoarFS_Bench_SweepResult_t *result);
+static int SoarFS_Bench_CompareCycles(const void *a, const void *b);
+
+/* Benchmark functions -------------------------------------------------------*/
+
+/**
+ * @brief Compare the per-call cost of the filename API against the handle API
+ *
+ * Both paths issue a zero length read so FatFS returns right after validating
+ * the file object, leaving the wrapper's own dispatch as the measured cost.
+ */
+void SoarFS_Bench_HandleLookup(void)
+{
+    if (!SoarFS_Bench_PrepareFile(BENCH_FILENAME))
+    {
+        SOAR_PRINT("SoarFS_Bench_HandleLookup() - Could not prepare %s\n", BENCH_FILENAME);
+        return;
+    }
+
+    SoarFS_Handle_t handle;
+    if (SoarFS_Open(BENCH_FILENAME, &handle) != SOAR_FS_OK)
+    {
+        SOAR_PRINT("SoarFS_Bench_HandleLookup() - Could not open %s\n", BENCH_FILENAME);
+        return;
+    }
+
+    uint8_t buffer[1];
+    uint32_t bytesRead;
+
+    // Filename API: validate name + linear strcmp lookup on every call
+    uint32_t start = CycleCounter::Now();
+    for (uint32_t i = 0; i < BENCH_LOOKUP_ITERATIONS; i++)
+    {
+        SoarFS_ReadFile(BENCH_FILENAME, buffer, 0, &bytesRead);
+    }
+    uint32_t filenameCycles = CycleCounter::Now() - start;
+
+    // Handle API: index + generation check
+    start = CycleCounter::Now();
+    for (uint32_t i = 0; i < BENCH_LOOKUP_ITERATIONS; i++)
+    {
+        SoarFS_Read(handle, buffer, 0, &bytesRead);
+    }
+    uint32_t handleCycles = CycleCounter::Now() - start;
+
+    SoarFS_Close(handle);
+
+    SOAR_PRINT("SoarFS_Bench_HandleLookup() - %d calls each\n", BENCH_LOOKUP_ITERATIONS);
+    SOAR_PRINT("  filename API : %lu cycles/call\n", filenameCycles / BENCH_LOOKUP_ITERATIONS);
+    SOAR_PRINT("  handle API   : %lu cycles/call\n", handleCycles / BENCH_LOOKUP_ITERATIONS);
+}
+
+/**
+ * @brief Compare append throughput and disk writes per record of SoarFS_WriteFile
+ * against the write-behind appender under each sync policy
+ */
+void SoarFS_Bench_AppendThroughput(void)
+{
+    static const struct
+    {
+        const char *label;
+        SoarFS_SyncPolicy_t policy;
+    } appenderCases[] = {
+        {"appender every 4KB ", {SOAR_FS_SYNC_EVERY_N_BYTES, 4096, 0}},
+        {"appender every 1s  ", {SOAR_FS_SYNC_EVERY_T_MS, 0, 1000}},
+        {"appender on flush  ", {SOAR_FS_SYNC_ON_FLUSH, 0, 0}},
+        {"appender on close  ", {SOAR_FS_SYNC_ON_CLOSE, 0, 0}},
+    };
+
+    uint8_t record[BENCH_APPEND_RECORD_SIZE];
+    for (uint32_t i = 0; i < sizeof(record); i++)
+    {
+        record[i] = (uint8_t)i;
+    }
+
+    SOAR_PRINT("SoarFS_Bench_AppendThroughput() - %d records of %d bytes\n",
+               BENCH_APPEND_RECORDS, BENCH_APPEND_RECORD_SIZE);
+
+    // Current behaviour: lseek + write + sync per record
+    if (!SoarFS_Bench_ResetFile(BENCH_APPEND_FILENAME) || SoarFS_OpenFile(BENCH_APPEND_FILENAME) != SOAR_FS_OK)
+    {
+        SOAR_PRINT("SoarFS_Bench_AppendThroughput() - Could not prepare %s\n", BENCH_APPEND_FILENAME);
+        return;
+    }
+    USER_ResetDiskStats();
+    uint32_t start = CycleCounter::Now();
+    for (uint32_t i = 0; i < BENCH_APPEND_RECORDS; i++)
+    {
+        SoarFS_WriteFile(BENCH_APPEND_FILENAME, record, sizeof(record));
+    }
+    SoarFS_CloseFile(BENCH_APPEND_FILENAME);
+    SoarFS_Bench_ReportAppend("SoarFS_WriteFile   ", CycleCounter::Now() - start);
+
+    for (uint32_t c = 0; c < sizeof(appenderCases) / sizeof(appenderCases[0]); c++)
+    {
+        SoarFS_Handle_t handle;
+        if (!SoarFS_Bench_ResetFile(BENCH_APPEND_FILENAME) ||
+            SoarFS_OpenAppender(BENCH_APPEND_FILENAME, &appenderCases[c].policy, &handle) != SOAR_FS_OK)
+        {
+            SOAR_PRINT("SoarFS_Bench_AppendThroughput() - Could not prepare %s\n", BENCH_APPEND_FILENAME);
+            return;
+        }
+        USER_ResetDiskStats();
+        start = CycleCounter::Now();
+        for (uint32_t i = 0; i < BENCH_APPEND_RECORDS; i++)
+        {
+            SoarFS_Write(handle, record, sizeof(record));
+        }
+        SoarFS_Flush(handle);
+        SoarFS_Close(handle);
+        SoarFS_Bench_ReportAppend(appenderCases[c].label, CycleCounter::Now() - start);
+    }
+
+    SoarFS_DeleteFile(BENCH_APPEND_FILENAME);
+}
+
+/**
+ * @brief Compare backend traffic of round-robin appends to several files with
+ * the sector cache bypassed and enabled
+ *
+ * Every periodic sync moves the FatFS window to the directory sector and every
+ * cluster allocation moves it back to the FAT, re-reading both each time
+ * without the cache.
+ */
+void SoarFS_Bench_MultiFileAppend(void)
+{
+#if USER_DISKIO_CACHE
+    SOAR_PRINT("SoarFS_Bench_MultiFileAppend() - %d files, %d records of %d bytes each\n",
+               BENCH_MULTI_FILES, BENCH_MULTI_RECORDS_PER_FILE, BENCH_APPEND_RECORD_SIZE);
+
+    CACHEDISK_SetEnabled(0, 0);
+    bool ok = SoarFS_Bench_MultiFileRun("cache bypassed");
+    CACHEDISK_SetEnabled(0, 1);
+    if (ok)
+    {
+        SoarFS_Bench_MultiFileRun("cache enabled ");
+    }
+#else
+    SOAR_PRINT("SoarFS_Bench_MultiFileAppend() - Sector cache not built (USER_DISKIO_CACHE=0)\n");
+#endif
+}
+
+/**
+ * @brief Compare per-record write latency and random seek cost of a growing
+ * file against a preallocated one
+ *
+ * Both write paths sync every record so the only difference is cluster
+ * allocation: the growing file walks and updates the FAT whenever it crosses
+ * a cluster boundary, the preallocated file never does.
+ */
+void SoarFS_Bench_Preallocated(void)
+{
+    uint8_t record[BENCH_APPEND_RECORD_SIZE];
+    memset(record, 0x5A, sizeof(record));
+
+    SOAR_PRINT("SoarFS_Bench_Preallocated() - %d synced records of %d bytes\n",
+               BENCH_PREALLOC_RECORDS, BENCH_APPEND_RECORD_SIZE);
+
+    // Growing file, SoarFS_WriteFile extends the chain as it goes
+    if (!SoarFS_Bench_ResetFile(BENCH_PREALLOC_FILENAME) || SoarFS_OpenFile(BENCH_PREALLOC_FILENAME) != SOAR_FS_OK)
+    {
+        SOAR_PRINT("SoarFS_Bench_Preallocated() - Could not prepare %s\n", BENCH_PREALLOC_FILENAME);
+        return;
+    }
+    uint32_t minCycles = 0xFFFFFFFF, maxCycles = 0, totalCycles = 0;
+    for (uint32_t i = 0; i < BENCH_PREALLOC_RECORDS; i++)
+    {
+        uint32_t start = CycleCounter::Now();
+        SoarFS_WriteFile(BENCH_PREALLOC_FILENAME, record, sizeof(record));
+        uint32_t cycles = CycleCounter::Now() - start;
+        minCycles = (cycles < minCycles) ? cycles : minCycles;
+        maxCycles = (cycles > maxCycles) ? cycles : maxCycles;
+        totalCycles += cycles;
+    }
+    SoarFS_CloseFile(BENCH_PREALLOC_FILENAME);
+    SoarFS_Bench_ReportLatency("growing file  ", minCycles, maxCycles, totalCycles, BENCH_PREALLOC_RECORDS);
+
+    SoarFS_Handle_t handle;
+    uint32_t growingSeekCycles = 0;
+    if (SoarFS_Open(BENCH_PREALLOC_FILENAME, &handle) == SOAR_FS_OK)
+    {
+        growingSeekCycles = SoarFS_Bench_RandomSeeks(handle);
+        SoarFS_Close(handle);
+    }
+    SoarFS_DeleteFile(BENCH_PREALLOC_FILENAME);
+
+    // Preallocated file, same records and syncs
+    if (SoarFS_CreatePreallocated(BENCH_PREALLOC_FILENAME, BENCH_PREALLOC_BYTES, NULL, &handle) != SOAR_FS_OK)
+    {
+        SOAR_PRINT("SoarFS_Bench_Preallocated() - Could not preallocate %s\n", BENCH_PREALLOC_FILENAME);
+        return;
+    }
+    minCycles = 0xFFFFFFFF, maxCycles = 0, totalCycles = 0;
+    for (uint32_t i = 0; i < BENCH_PREALLOC_RECORDS; i++)
+    {
+        uint32_t start = CycleCounter::Now();
+        SoarFS_Write(handle, record, sizeof(record));
+        SoarFS_Sync(handle);
+        uint32_t cycles = CycleCounter::Now() - start;
+        minCycles = (cycles < minCycles) ? cycles : minCycles;
+        maxCycles = (cycles > maxCycles) ? cycles : maxCycles;
+        totalCycles += cycles;
+    }
+    SoarFS_Bench_ReportLatency("preallocated  ", minCycles, maxCycles, totalCycles, BENCH_PREALLOC_RECORDS);
+
+    uint32_t fastSeekCycles = SoarFS_Bench_RandomSeeks(handle);
+    SoarFS_Close(handle);
+    SoarFS_DeleteFile(BENCH_PREALLOC_FILENAME);
+
+    SOAR_PRINT("  random seek+read, %d iterations: chain walk %lu cycles/op, fast-seek %lu cycles/op\n",
+               BENCH_SEEK_ITERATIONS, growingSeekCycles / BENCH_SEEK_ITERATIONS,
+               fastSeekCycles / BENCH_SEEK_ITERATIONS);
+}
+
+/**
+ * @brief Measure the compression ratio and the encode and decode cost of SoarLZ on
+ * synthetic telemetry, a text log and incompressible data
+ *
+ * Every block is decoded again and compared against the input; that work is
+ * timed separately and left out of the encode figure. The ratio counts whole
+ * sectors, padding included, so it is the reduction in bytes sent to the media.
+ */
+void SoarFS_Bench_Compression(void)
+{
+    static const char *const labels[BENCH_LZ_DATASETS] = {"flight records", "env csv lines ", "random bytes  "};
+
+    SOAR_PRINT("SoarFS_Bench_Compression() - %d bytes per dataset, core clock %lu Hz\n",
+               BENCH_LZ_INPUT_BYTES * BENCH_LZ_PASSES, CycleCounter::Frequency());
+
+    for (uint32_t set = 0; set < BENCH_LZ_DATASETS; set++)
+    {
+        SoarFS_Bench_LzCheck_t check;
+        memset(&check, 0, sizeof(check));
+        check.inputLength = SoarFS_Bench_FillLzInput((SoarFS_Bench_LzDataset_t)set);
+
+        SoarLZ_Init(&g_bench.lz.writer, SoarFS_Bench_LzCheckSink, &check);
+        uint32_t start = CycleCounter::Now();
+        for (uint32_t pass = 0; pass < BENCH_LZ_PASSES; pass++)
+        {
+            SoarLZ_Write(&g_bench.lz.writer, g_bench.lz.input, check.inputLength);
+        }
+        SoarLZ_Flush(&g_bench.lz.writer);
+        uint32_t encodeCycles = CycleCounter::Now() - start - check.decodeCycles;
+
+        const uint32_t rawBytes = check.inputLength * BENCH_LZ_PASSES;
+        const uint32_t packedBytes = check.blocks * SOAR_LOG_BLOCK_SIZE;
+        const uint32_t ratio100 = (packedBytes == 0) ? 0 : (uint32_t)(((uint64_t)rawBytes * 100) / packedBytes);
+        const uint32_t encodeKBps =
+            (encodeCycles == 0) ? 0 : (uint32_t)(((uint64_t)rawBytes * CycleCounter::Frequency()) / encodeCycles / 1024);
+
+        // Cycles per byte are scaled by 100 to stay in integer printf
+        const uint32_t encodeCpb100 = (uint32_t)(((uint64_t)encodeCycles * 100) / rawBytes);
+        const uint32_t decodeCpb100 = (uint32_t)(((uint64_t)check.decodeCycles * 100) / rawBytes);
+        SOAR_PRINT("  %s: %lu -> %lu bytes, ratio %lu.%02lu, encode %lu.%02lu cycles/B (%lu KB/s), "
+                   "decode %lu.%02lu cycles/B%s\n",
+                   labels[set], rawBytes, packedBytes, ratio100 / 100, ratio100 % 100, encodeCpb100 / 100,
+                   encodeCpb100 % 100, encodeKBps, decodeCpb100 / 100, decodeCpb100 % 100,
+                   (check.mismatch || check.streamOffset != rawBytes) ? ", ROUND TRIP FAILED" : "");
+    }
+}
+
+/**
+ * @brief Compare bytes per record and encode cost of column blocks against data blocks
+ *
+ * Each block is decoded again and every field checked against the sample it
+ * came from, at the precision of its schema scale; that is not timed.
+ */
+void SoarFS_Bench_ColumnEncoding(void)
+{
+    static const uint8_t types[] = {SOAR_LOG_RECORD_ENVIRONMENT, SOAR_LOG_RECORD_FLIGHT};
+    static const char *const labels[] = {"env   ", "flight"};
+    SoarLog_ColumnBatch_t *batch = &g_bench.columns.batch;
+
+    SOAR_PRINT("SoarFS_Bench_ColumnEncoding() - %d records per type\n", BENCH_COLUMN_RECORDS);
+
+    for (uint32_t t = 0; t < sizeof(types); t++)
+    {
+        if (SoarLog_ColumnsInit(batch, types[t]) != SOAR_FS_OK)
+        {
+            SOAR_PRINT("  %s: cannot be column encoded\n", labels[t]);
+            continue;
+        }
+
+        uint32_t blocks = 0;
+        uint32_t payloadBytes = 0;
+        uint32_t cycles = 0;
+        uint32_t blockStart = 0;
+        bool mismatch = false;
+        uint8_t record[BENCH_COLUMN_MAX_RECORD];
+
+        for (uint32_t i = 0; i <= BENCH_COLUMN_RECORDS; i++)
+        {
+            const bool last = (i == BENCH_COLUMN_RECORDS);
+            uint32_t timestamp = last ? 0 : SoarFS_Bench_MakeSample(types[t], i, record);
+
+            uint32_t start = CycleCounter::Now();
+            bool added = !last && SoarLog_ColumnsAdd(batch, timestamp, record);
+            uint16_t length = 0;
+            if (!added)
+            {
+                length = SoarLog_ColumnsEncode(batch, g_bench.columns.payload);
+            }
+            cycles += CycleCounter::Now() - start;
+
+            if (added)
+            {
+                continue;
+            }
+            mismatch = mismatch || !SoarFS_Bench_CheckColumns(types[t], blockStart, length);
+            blocks++;
+            payloadBytes += length;
+            blockStart += batch->count;
+            SoarLog_ColumnsClear(batch);
+
+            if (!last)
+            {
+                start = CycleCounter::Now();
+                SoarLog_ColumnsAdd(batch, timestamp, record);
+                cycles += CycleCounter::Now() - start;
+            }
+        }
+
+        // Data blocks hold whole records, the rest of each sector is padding. Sizes scaled by 100.
+        const uint32_t rowsPerBlock = SOAR_LOG_BLOCK_PAYLOAD_SIZE / (SOAR_LOG_RECORD_HEADER_SIZE + batch->recordLength);
+        const uint32_t rowBytes100 = (SOAR_LOG_BLOCK_SIZE * 100) / rowsPerBlock;
+        const uint32_t columnBytes100 = (blocks * SOAR_LOG_BLOCK_SIZE * 100) / BENCH_COLUMN_RECORDS;
+        const uint32_t payloadBytes100 = (payloadBytes * 100) / BENCH_COLUMN_RECORDS;
+        const uint32_t gain100 = (columnBytes100 == 0) ? 0 : (rowBytes100 * 100) / columnBytes100;
+        SOAR_PRINT("  %s: data blocks %lu.%02lu B/record, column blocks %lu.%02lu B/record (%lu.%02lu encoded), "
+                   "%lu.%02lux smaller, encode %lu cycles/record%s\n",
+                   labels[t], rowBytes100 / 100, rowBytes100 % 100, columnBytes100 / 100, columnBytes100 % 100,
+                   payloadBytes100 / 100, payloadBytes100 % 100, gain100 / 100, gain100 % 100,
+                   cycles / BENCH_COLUMN_RECORDS,
+                   (mismatch || blockStart != BENCH_COLUMN_RECORDS) ? ", ROUND TRIP FAILED" : "");
+    }
+}
+
+/**
+ * @brief Compare extracting the last seconds of a log through its time index against a scan
+ *
+ * The log interleaves flight data blocks with env column blocks, whose
+ * records are older than the data blocks around them, so the window is
+ * checked to hold exactly the records at or after its start.
+ */
+void SoarFS_Bench_TimeSeek(void)
+{
+    SOAR_PRINT("SoarFS_Bench_TimeSeek() - last %d ms of a %d block log\n", BENCH_SEEK_WINDOW_MS,
+               BENCH_SEEK_LOG_BLOCKS);
+
+    uint32_t flightSamples = SoarFS_Bench_WriteSeekLog();
+    if (flightSamples == 0)
+    {
+        SOAR_PRINT("SoarFS_Bench_TimeSeek() - Could not write %s\n", BENCH_SEEK_LOG_FILENAME);
+        SoarFS_DeleteFile(BENCH_SEEK_LOG_FILENAME);
+        return;
+    }
+
+    // Timestamps of SoarFS_Bench_MakeSample, flight every 10 ms and env every 100 ms from 100000
+    uint8_t record[BENCH_COLUMN_MAX_RECORD];
+    const uint32_t latest = SoarFS_Bench_MakeSample(SOAR_LOG_RECORD_FLIGHT, flightSamples - 1, record);
+    const uint32_t from = latest - BENCH_SEEK_WINDOW_MS;
+    const uint32_t envSamples = (flightSamples + BENCH_SEEK_ENV_EVERY - 1) / BENCH_SEEK_ENV_EVERY;
+    const uint32_t envFrom = (from - 100000 + 99) / 100;
+    const uint32_t expected = (latest - from) / 10 + 1 + ((envSamples > envFrom) ? envSamples - envFrom : 0);
+
+    SoarFS_Bench_ReadWindow("indexed", true, from, expected);
+    SoarFS_Bench_ReadWindow("scan   ", false, from, expected);
+    SoarFS_DeleteFile(BENCH_SEEK_LOG_FILENAME);
+}
+
+/**
+ * @brief Compare a checkpoint that syncs the directory entry against a commit block and a data flush
+ *
+ * Both write the same flight records into a reserved log with a checkpoint
+ * every BENCH_JOURNAL_COMMIT_EVERY records. f_sync rewrites the directory
+ * sector, away from the data, while the commit block is one more sequential
+ * sector.
+ */
+void SoarFS_Bench_CommitCost(void)
+{
+    SOAR_PRINT("SoarFS_Bench_CommitCost() - %d flight records, a checkpoint every %d\n", BENCH_JOURNAL_RECORDS,
+               BENCH_JOURNAL_COMMIT_EVERY);
+
+    for (uint32_t journal = 0; journal < 2; journal++)
+    {
+        const char *label = journal ? "SoarLog_Commit    " : "SoarLog_Checkpoint";
+        if (SoarFS_Bench_OpenJournal(journal ? SOAR_FS_SYNC_ON_CLOSE : SOAR_FS_SYNC_ON_FLUSH) != SOAR_FS_OK)
+        {
+            SOAR_PRINT("SoarFS_Bench_CommitCost() - Could not open %s\n", BENCH_JOURNAL_FILENAME);
+            return;
+        }
+
+        USER_ResetDiskStats();
+        uint32_t committed = 0;
+        uint32_t checkpointCycles = 0;
+        uint32_t appended = SoarFS_Bench_WriteJournal(journal != 0, &committed, &checkpointCycles);
+        USER_DiskStats_t stats;
+        USER_GetDiskStats(&stats);
+        SoarLog_Close(&g_bench.journal.writer);
+
+        const uint32_t checkpoints = BENCH_JOURNAL_RECORDS / BENCH_JOURNAL_COMMIT_EVERY;
+        SOAR_PRINT("  %s: %lu us/checkpoint, %lu disk writes, %lu syncs%s\n", label,
+                   CycleCounter::ToMicros(checkpointCycles / checkpoints), stats.writeCalls, stats.syncCalls,
+                   (appended != BENCH_JOURNAL_RECORDS || committed != appended) ? ", WRITE FAILED" : "");
+    }
+
+    SoarFS_DeleteFile(BENCH_JOURNAL_FILENAME);
+}
+
+/**
+ * @brief Cut power at random sector writes while a log is written, then recover and check it
+ *
+ * Power is cut at a random sector among roughly those one log takes, so most
+ * trials lose it mid-log and some during or after the close. After each cut
+ * the file system is dropped without I/O and remounted, which also empties
+ * the sector cache, as a reset would. The recovered log must hold a prefix of
+ * the records written that covers every one before the last successful
+ * commit. Successive trials reuse the same clusters, so the tail of each
+ * reservation holds the previous trial's blocks at the same sequence numbers.
+ */
+void SoarFS_Bench_PowerLoss(void)
+{
+#if USER_DISKIO_FAULT
+    SOAR_PRINT("SoarFS_Bench_PowerLoss() - %d trials of %d flight records, a commit every %d\n", BENCH_POWER_TRIALS,
+               BENCH_JOURNAL_RECORDS, BENCH_JOURNAL_COMMIT_EVERY);
+
+    uint32_t lcg = 0x2545F491;
+    uint32_t cuts = 0, closed = 0, wrong = 0;
+    uint32_t minCycles = 0xFFFFFFFF, maxCycles = 0, totalCycles = 0;
+    uint32_t scanned = 0, lost = 0, maxLost = 0;
+
+    for (uint32_t trial = 0; trial < BENCH_POWER_TRIALS; trial++)
+    {
+        if (SoarFS_Bench_OpenJournal(SOAR_FS_SYNC_ON_CLOSE) != SOAR_FS_OK)
+        {
+            SOAR_PRINT("SoarFS_Bench_PowerLoss() - Could not open %s\n", BENCH_JOURNAL_FILENAME);
+            return;
+        }
+
+        lcg = lcg * 1664525u + 1013904223u;
+        FAULTDISK_Arm((lcg >> 8) % BENCH_POWER_CUT_RANGE, lcg);
+
+        uint32_t committed = 0;
+        uint32_t appended = SoarFS_Bench_WriteJournal(true, &committed, NULL);
+        if (!FAULTDISK_PowerLost() && SoarLog_Close(&g_bench.journal.writer) == SOAR_FS_OK)
+        {
+            committed = appended;
+        }
+
+        if (FAULTDISK_PowerLost())
+        {
+            // The drive reports itself gone, open files are dropped without I/O
+            cuts++;
+            SoarFS_IsMounted();
+            FAULTDISK_Disarm();
+            SoarFS_DeInit();
+            SoarFS_Init();
+        }
+        FAULTDISK_Disarm();
+
+        SoarLog_Recovery_t recovery;
+        uint32_t start = CycleCounter::Now();
+        SoarFS_Result_t result = SoarLog_Recover(BENCH_JOURNAL_FILENAME, &recovery);
+        uint32_t cycles = CycleCounter::Now() - start;
+
+        uint32_t records = 0;
+        if (result != SOAR_FS_OK || !SoarFS_Bench_CheckJournal(committed, appended, &records))
+        {
+            wrong++;
+            SOAR_PRINT("  trial %lu: %lu committed, %lu appended, %lu recovered, recover %d, WRONG\n", trial,
+                       committed, appended, records, result);
+        }
+
+        closed += recovery.closed ? 1 : 0;
+        scanned += recovery.blocksScanned;
+        lost += appended - records;
+        maxLost = (appended - records > maxLost) ? appended - records : maxLost;
+        minCycles = (cycles < minCycles) ? cycles : minCycles;
+        maxCycles = (cycles > maxCycles) ? cycles : maxCycles;
+        totalCycles += cycles;
+    }
+
+    SoarFS_DeleteFile(BENCH_JOURNAL_FILENAME);
+    SOAR_PRINT("  %lu power cuts, %lu logs found closed, %lu recovered wrong\n", cuts, closed, wrong);
+    SoarFS_Bench_ReportLatency("recovery      ", minCycles, maxCycles, totalCycles, BENCH_POWER_TRIALS);
+    SOAR_PRINT("  %lu blocks scanned per recovery, records lost past the last commit: avg %lu, max %lu\n",
+               scanned / BENCH_POWER_TRIALS, lost / BENCH_POWER_TRIALS, maxLost);
+#else
+    SOAR_PRINT("SoarFS_Bench_PowerLoss() - Fault injector not built (USER_DISKIO_FAULT=0)\n");
+#endif
+}
+
+/**
+ * @brief Pull the RAM disk, let several remounts fail, reinsert it and check the volume
+ * comes back with its files
+ *
+ * Every attempt has to reach the driver's initialize again, a volume whose remount
+ * failed while the media was out must still mount once it is back.
+ */
+void SoarFS_Bench_MediaRemoval(void)
+{
+#if USER_DISKIO_BACKEND == USER_DISKIO_BACKEND_RAMDISK
+    static const uint8_t marker[] = "remount";
+    SoarFS_DeleteFile(BENCH_REMOVAL_FILENAME);
+    if (SoarFS_CreateFile(BENCH_REMOVAL_FILENAME, marker, sizeof(marker)) != SOAR_FS_OK)
+    {
+        SOAR_PRINT("SoarFS_Bench_MediaRemoval() - Could not write %s\n", BENCH_REMOVAL_FILENAME);
+        return;
+    }
+
+    const SoarFS_OpStats_t *mounts = &SoarFS_GetStats()->ops[SOAR_FS_OP_MOUNT];
+    RAMDISK_SetPresent(0);
+    bool unmounted = !SoarFS_IsMounted();
+    uint32_t errorsBefore = mounts->errors;
+    for (uint32_t i = 0; i < BENCH_REMOVAL_ATTEMPTS; i++)
+    {
+        osDelay(SOAR_FS_REMOUNT_INTERVAL_MS + 10);
+        unmounted = unmounted && !SoarFS_IsMounted();
+    }
+    uint32_t failed = mounts->errors - errorsBefore;
+
+    RAMDISK_SetPresent(1);
+    osDelay(SOAR_FS_REMOUNT_INTERVAL_MS + 10);
+    bool remounted = SoarFS_IsMounted();
+
+    uint8_t readBack[sizeof(marker)] = {0};
+    uint32_t bytesRead = 0;
+    SoarFS_Handle_t handle;
+    bool intact = false;
+    if (remounted && SoarFS_OpenReader(BENCH_REMOVAL_FILENAME, &handle) == SOAR_FS_OK)
+    {
+        intact = SoarFS_Read(handle, readBack, sizeof(readBack), &bytesRead) == SOAR_FS_OK &&
+                 bytesRead == sizeof(marker) && memcmp(readBack, marker, sizeof(marker)) == 0;
+        SoarFS_Close(handle);
+    }
+    SoarFS_DeleteFile(BENCH_REMOVAL_FILENAME);
+
+    bool pass = unmounted && failed == BENCH_REMOVAL_ATTEMPTS && remounted && intact;
+    SOAR_PRINT("SoarFS_Bench_MediaRemoval() - %lu of %d remounts failed while removed, %s after reinsertion, "
+               "file %s: %s\n",
+               failed, BENCH_REMOVAL_ATTEMPTS, remounted ? "mounted" : "NOT MOUNTED", intact ? "intact" : "LOST",
+               pass ? "PASS" : "FAIL");
+#else
+    SOAR_PRINT("SoarFS_Bench_MediaRemoval() - Needs the RAM disk backend (USER_DISKIO_BACKEND=1)\n");
+#endif
+}
+
+/**
+ * @brief Sweep record size, open files, sync policy and cluster size, one BENCH line per run
+ *
+ * Each run appends through write-behind appenders, round robin over the files,
+ * then closes them and reads them back sequentially in records. Append latency
+ * is the time of each SoarFS_Write, so it includes any sync the policy
+ * triggers; closes count towards the write throughput as they flush what the
+ * policy held back. The lines are CSV after the "BENCH," prefix, with a header
+ * line first, so the output of two builds can be filtered and diffed.
+ */
+void SoarFS_Bench_Sweep(bool formatVolume)
+{
+    uint32_t originalCluster = 0;
+    if (SoarFS_GetClusterSize(&originalCluster) != SOAR_FS_OK)
+    {
+        SOAR_PRINT("SoarFS_Bench_Sweep() - File system not mounted\n");
+        return;
+    }
+
+    SOAR_PRINT("SoarFS_Bench_Sweep() - up to %d records or %d KB per run, less if the volume has less free\n",
+               BENCH_SWEEP_RECORDS, BENCH_SWEEP_BYTES / 1024);
+    SOAR_PRINT("BENCH,sweep,backend,cluster_bytes,record_bytes,files,policy,records,write_kBps,read_kBps,"
+               "p50_us,p99_us,max_us,fs_sectors_per_100,media_sectors_per_100\n");
+
+#if USER_DISKIO_BACKEND != USER_DISKIO_BACKEND_MEDIA
+    if (formatVolume)
+    {
+        for (uint32_t c = 0; c < sizeof(BENCH_SWEEP_CLUSTER_SIZES) / sizeof(BENCH_SWEEP_CLUSTER_SIZES[0]); c++)
+        {
+            if (SoarFS_Format(BENCH_SWEEP_CLUSTER_SIZES[c]) != SOAR_FS_OK)
+            {
+                SOAR_PRINT("  %lu B clusters do not fit this volume, skipped\n", BENCH_SWEEP_CLUSTER_SIZES[c]);
+                continue;
+            }
+            SoarFS_Bench_SweepCluster(BENCH_SWEEP_CLUSTER_SIZES[c]);
+        }
+        SoarFS_Format(originalCluster);
+        return;
+    }
+#else
+    (void)formatVolume;
+#endif
+
+    // Real media is never formatted, its own cluster size is the only one
+    SoarFS_Bench_SweepCluster(originalCluster);
+}
+
+/**
+ * @brief Run every benchmark in sequence
+ */
+void SoarFS_Bench_RunAll(void)
+{
+    CycleCounter::Init();
+
+    SoarFS_Bench_HandleLookup();
+    SoarFS_Bench_AppendThroughput();
+    SoarFS_Bench_MultiFileAppend();
+    SoarFS_Bench_Preallocated();
+    SoarFS_Bench_Compression();
+    SoarFS_Bench_ColumnEncoding();
+    SoarFS_Bench_TimeSeek();
+    SoarFS_Bench_CommitCost();
+    SoarFS_Bench_PowerLoss();
+    SoarFS_Bench_MediaRemoval();
+    SoarFS_Bench_Sweep(false);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Make sure a benchmark file exists
+ * @retval bool True if the file exists or was created
+ */
+static bool SoarFS_Bench_PrepareFile(const char *filename)
+{
+    if (SoarFS_FileExists(filename))
+    {
+        return true;
+    }
+
+    const uint8_t seed[] = {0};
+    return SoarFS_CreateFile(filename, seed, sizeof(seed)) == SOAR_FS_OK;
+}
+
+/**
+ * @brief Delete a benchmark file if present and recreate it empty
+ * @retval bool True if the empty file was created
+ */
+static bool SoarFS_Bench_ResetFile(const char *filename)
+{
+    if (SoarFS_FileExists(filename))
+    {
+        SoarFS_DeleteFile(filename);
+    }
+
+    const uint8_t empty[1] = {0};
+    return SoarFS_CreateFile(filename, empty, 0) == SOAR_FS_OK;
+}
+
+/**
+ * @brief Print throughput and disk writes per record of one append run
+ */
+static void SoarFS_Bench_ReportAppend(const char *label, uint32_t cycles)
+{
+    USER_DiskStats_t stats;
+    USER_GetDiskStats(&stats);
+
+    const uint32_t totalBytes = BENCH_APPEND_RECORDS * BENCH_APPEND_RECORD_SIZE;
+    uint32_t bytesPerSec = (cycles == 0) ? 0 : (uint32_t)(((uint64_t)totalBytes * CycleCounter::Frequency()) / cycles);
+
+    // Per-record figures are scaled by 100 to stay in integer printf
+    SOAR_PRINT("  %s: %lu B/s, %lu disk writes/100 records, %lu syncs\n", label, bytesPerSec,
+               (stats.writeCalls * 100) / BENCH_APPEND_RECORDS, stats.syncCalls);
+}
+
+/**
+ * @brief Print min/avg/max latency of one run, jitter is max - min
+ */
+static void SoarFS_Bench_ReportLatency(const char *label, uint32_t minCycles, uint32_t maxCycles, uint32_t totalCycles,
+                                       uint32_t count)
+{
+    SOAR_PRINT("  %s: min %lu us, avg %lu us, max %lu us, jitter %lu us\n", label, CycleCounter::ToMicros(minCycles),
+               CycleCounter::ToMicros(totalCycles / count), CycleCounter::ToMicros(maxCycles),
+               CycleCounter::ToMicros(maxCycles - minCycles));
+}
+
+/**
+ * @brief Sample i of a synthetic sensor stream, slowly changing values with a little noise
+ * @param type SOAR_LOG_RECORD_FLIGHT at 100 Hz or SOAR_LOG_RECORD_ENVIRONMENT at 10 Hz
+ * @param record Receives the record payload
+ * @retval uint32_t Timestamp of the sample
+ */
+static uint32_t SoarFS_Bench_MakeSample(uint8_t type, uint32_t i, uint8_t *record)
+{
+    const uint32_t noise = (i * 2654435761u) >> 16;
+
+    if (type == SOAR_LOG_RECORD_FLIGHT)
+    {
+        FlightData_t data;
+        data.altitude = 1000.0f + (float)i * 0.5f;
+        data.velocity = 25.0f + (float)(noise & 7) * 0.01f;
+        data.acceleration[0] = 0.1f;
+        data.acceleration[1] = 0.2f;
+        data.acceleration[2] = 9.81f + (float)((noise >> 4) & 3) * 0.01f;
+        data.battery_voltage = (uint16_t)(3700 - i / 64);
+        memcpy(record, &data, sizeof(data));
+        return 100000 + i * 10;
+    }
+
+    SoarLog_Environment_t data;
+    data.temperature = 21.5f + (float)(noise % 20) * 0.01f;
+    data.humidity = 45.0f + (float)((noise >> 8) % 10) * 0.01f;
+    memcpy(record, &data, sizeof(data));
+    return 100000 + i * 100;
+}
+
+/**
+ * @brief Fill the compression input with one dataset
+ * @retval uint32_t Bytes of input, whole records or lines only
+ */
+static uint32_t SoarFS_Bench_FillLzInput(SoarFS_Bench_LzDataset_t dataset)
+{
+    uint32_t length = 0;
+    uint32_t lcg = 12345;
+
+    for (uint32_t i = 0;; i++)
+    {
+        lcg = lcg * 1103515245u + 12345u;
+
+        if (dataset == BENCH_LZ_FLIGHT_RECORDS)
+        {
+            // Framed records as SoarLog_Append lays them out
+            if (length + SOAR_LOG_RECORD_HEADER_SIZE + sizeof(FlightData_t) > BENCH_LZ_INPUT_BYTES)
+            {
+                break;
+            }
+            uint8_t *record = g_bench.lz.input + length + SOAR_LOG_RECORD_HEADER_SIZE;
+            SoarLog_RecordHeader_t header = {SOAR_LOG_RECORD_FLIGHT, sizeof(FlightData_t),
+                                             SoarFS_Bench_MakeSample(SOAR_LOG_RECORD_FLIGHT, i, record)};
+            memcpy(g_bench.lz.input + length, &header, sizeof(header));
+            length += SOAR_LOG_RECORD_HEADER_SIZE + sizeof(FlightData_t);
+        }
+        else if (dataset == BENCH_LZ_CSV_LINES)
+        {
+            // Lines as SoarFS_Example_LogSensorData formats them
+            char line[48];
+            int32_t tempCenti = 2150 + (int32_t)((lcg >> 16) % 20);
+            int32_t humCenti = 4500 + (int32_t)((lcg >> 24) % 10);
+            int n = snprintf(line, sizeof(line), "%lu,%ld.%02ld,%ld.%02ld\n", (unsigned long)(100000 + i * 100),
+                             (long)(tempCenti / 100), (long)(tempCenti % 100), (long)(humCenti / 100),
+                             (long)(humCenti % 100));
+
+            if (length + (uint32_t)n > BENCH_LZ_INPUT_BYTES)
+            {
+                break;
+            }
+            memcpy(g_bench.lz.input + length, line, (uint32_t)n);
+            length += (uint32_t)n;
+        }
+        else
+        {
+            if (length == BENCH_LZ_INPUT_BYTES)
+            {
+                break;
+            }
+            g_bench.lz.input[length++] = (uint8_t)(lcg >> 24);
+        }
+    }
+
+    return length;
+}
+
+/**
+ * @brief Decode a column block payload and compare every field with the samples it was built from
+ * @param firstSample Index of the first sample in the block
+ */
+static bool SoarFS_Bench_CheckColumns(uint8_t type, uint32_t firstSample, uint16_t length)
+{
+    const SoarLog_ColumnBatch_t *batch = &g_bench.columns.batch;
+    int32_t count = SoarLog_DecodeColumns(g_bench.columns.payload, length, batch->fields, batch->fieldCount,
+                                          g_bench.columns.timestamps, &g_bench.columns.records[0][0],
+                                          BENCH_COLUMN_MAX_RECORD, SOAR_LOG_COLUMN_MAX_RECORDS);
+    if (count != batch->count || g_bench.columns.payload[0] != type)
+    {
+        return false;
+    }
+
+    for (int32_t i = 0; i < count; i++)
+    {
+        uint8_t expected[BENCH_COLUMN_MAX_RECORD];
+        if (SoarFS_Bench_MakeSample(type, firstSample + i, expected) != g_bench.columns.timestamps[i])
+        {
+            return false;
+        }
+
+        // Quantized fields compare at their scale, the rest bit for bit
+        for (uint32_t f = 0; f < batch->fieldCount; f++)
+        {
+            if (SoarLog_ColumnWord(&batch->fields[f], expected) !=
+                SoarLog_ColumnWord(&batch->fields[f], g_bench.columns.records[i]))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Compression benchmark sink, decodes each block and compares it against the input
+ */
+static SoarFS_Result_t SoarFS_Bench_LzCheckSink(const uint8_t *block, void *context)
+{
+    SoarFS_Bench_LzCheck_t *check = (SoarFS_Bench_LzCheck_t *)context;
+
+    uint32_t start = CycleCounter::Now();
+    SoarLog_BlockHeader_t header;
+    memcpy(&header, block, SOAR_LOG_BLOCK_HEADER_SIZE);
+    int32_t rawLength = SoarLZ_Unpack(block + SOAR_LOG_BLOCK_HEADER_SIZE, header.payloadLength, g_bench.lz.output,
+                                      sizeof(g_bench.lz.output));
+    check->decodeCycles += CycleCounter::Now() - start;
+
+    check->blocks++;
+    if (header.magic != SOAR_LZ_MAGIC || rawLength < 0)
+    {
+        check->mismatch = true;
+        return SOAR_FS_OK;
+    }
+
+    for (int32_t i = 0; i < rawLength; i++)
+    {
+        if (g_bench.lz.output[i] != g_bench.lz.input[(check->streamOffset + i) % check->inputLength])
+        {
+            check->mismatch = true;
+            break;
+        }
+    }
+    check->streamOffset += (uint32_t)rawLength;
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Seek to pseudo-random offsets of a file and read a byte at each
+ * @retval uint32_t Total cycles spent
+ */
+static uint32_t SoarFS_Bench_RandomSeeks(SoarFS_Handle_t handle)
+{
+    uint32_t lcg = 12345;
+    uint32_t total = 0;
+    uint8_t byte;
+    uint32_t bytesRead;
+
+    for (uint32_t i = 0; i < BENCH_SEEK_ITERATIONS; i++)
+    {
+        lcg = lcg * 1664525u + 1013904223u;
+        uint32_t offset = (lcg >> 8) % BENCH_PREALLOC_BYTES;
+
+        uint32_t start = CycleCounter::Now();
+        SoarFS_Seek(handle, offset);
+        SoarFS_Read(handle, &byte, 1, &bytesRead);
+        total += CycleCounter::Now() - start;
+    }
+
+    return total;
+}
+
+#if USER_DISKIO_CACHE
+/**
+ * @brief One round-robin append pass over fresh files, prints backend traffic
+ * @retval bool False if the files could not be prepared
+ */
+static bool SoarFS_Bench_MultiFileRun(const char *label)
+{
+    static const char *const filenames[BENCH_MULTI_FILES] = {"multi0.bin", "multi1.bin", "multi2.bin"};
+    SoarFS_Handle_t handles[BENCH_MULTI_FILES];
+
+    uint8_t record[BENCH_APPEND_RECORD_SIZE];
+    memset(record, 0xA5, sizeof(record));
+
+    for (uint32_t f = 0; f < BENCH_MULTI_FILES; f++)
+    {
+        if (!SoarFS_Bench_ResetFile(filenames[f]) || SoarFS_Open(filenames[f], &handles[f]) != SOAR_FS_OK)
+        {
+            SOAR_PRINT("SoarFS_Bench_MultiFileAppend() - Could not prepare %s\n", filenames[f]);
+            for (uint32_t g = 0; g < f; g++)
+            {
+                SoarFS_Close(handles[g]);
+            }
+            return false;
+        }
+    }
+
+    CACHEDISK_ResetStats();
+    uint32_t start = CycleCounter::Now();
+    for (uint32_t i = 0; i < BENCH_MULTI_RECORDS_PER_FILE; i++)
+    {
+        for (uint32_t f = 0; f < BENCH_MULTI_FILES; f++)
+        {
+            SoarFS_Write(handles[f], record, sizeof(record));
+            if ((i + 1) % BENCH_MULTI_SYNC_EVERY == 0)
+            {
+                SoarFS_Sync(handles[f]);
+            }
+        }
+    }
+    for (uint32_t f = 0; f < BENCH_MULTI_FILES; f++)
+    {
+        SoarFS_Sync(handles[f]);
+        SoarFS_Close(handles[f]);
+    }
+    uint32_t cycles = CycleCounter::Now() - start;
+
+    CACHEDISK_Stats_t stats;
+    CACHEDISK_GetStats(&stats);
+    SOAR_PRINT("  %s: %lu us, backend %lu reads %lu writes (%lu sectors), %lu hits %lu misses\n", label,
+               CycleCounter::ToMicros(cycles), stats.backendReadCalls, stats.backendWriteCalls,
+               stats.backendWriteSectors, stats.hits, stats.misses);
+
+    for (uint32_t f = 0; f < BENCH_MULTI_FILES; f++)
+    {
+        SoarFS_DeleteFile(filenames[f]);
+    }
+    return true;
+}
+#endif
+
+/**
+ * @brief Write the time seek log, flight records in data blocks and env records in column blocks
+ * @retval uint32_t Flight samples written, 0 on failure
+ */
+static uint32_t SoarFS_Bench_WriteSeekLog(void)
+{
+    SoarLog_Writer_t *writer = &g_bench.seek.writer;
+    SoarLog_ColumnBatch_t *batch = &g_bench.seek.batch;
+    SoarFS_SyncPolicy_t policy = {SOAR_FS_SYNC_ON_FLUSH, 0, 0};
+    uint8_t record[BENCH_COLUMN_MAX_RECORD];
+
+    if (SoarFS_FileExists(BENCH_SEEK_LOG_FILENAME))
+    {
+        SoarFS_DeleteFile(BENCH_SEEK_LOG_FILENAME);
+    }
+    if (SoarLog_ColumnsInit(batch, SOAR_LOG_RECORD_ENVIRONMENT) != SOAR_FS_OK ||
+        SoarLog_OpenAppender(writer, BENCH_SEEK_LOG_FILENAME, &policy) != SOAR_FS_OK)
+    {
+        return 0;
+    }
+
+    uint32_t i = 0;
+    SoarFS_Result_t result = SOAR_FS_OK;
+    for (; result == SOAR_FS_OK && writer->sequence < BENCH_SEEK_LOG_BLOCKS; i++)
+    {
+        if (i % BENCH_SEEK_ENV_EVERY == 0)
+        {
+            uint32_t timestamp = SoarFS_Bench_MakeSample(SOAR_LOG_RECORD_ENVIRONMENT, i / BENCH_SEEK_ENV_EVERY, record);
+            if (!SoarLog_ColumnsAdd(batch, timestamp, record))
+            {
+                result = SoarLog_WriteColumns(writer, batch);
+                SoarLog_ColumnsAdd(batch, timestamp, record);
+            }
+        }
+
+        uint32_t timestamp = SoarFS_Bench_MakeSample(SOAR_LOG_RECORD_FLIGHT, i, record);
+        if (result == SOAR_FS_OK)
+        {
+            result = SoarLog_Append(writer, SOAR_LOG_RECORD_FLIGHT, timestamp, record, sizeof(FlightData_t));
+        }
+    }
+
+    if (result == SOAR_FS_OK)
+    {
+        result = SoarLog_WriteColumns(writer, batch);
+    }
+    SoarFS_Result_t closeResult = SoarLog_Close(writer);
+    return (result == SOAR_FS_OK && closeResult == SOAR_FS_OK) ? i : 0;
+}
+
+/**
+ * @brief Read the last BENCH_SEEK_WINDOW_MS of the seek log and report the cost
+ * @param indexed Seek to the window, else read from the start and count the records in it
+ * @param from Expected start of the window
+ * @param expected Records expected in the window
+ */
+static void SoarFS_Bench_ReadWindow(const char *label, bool indexed, uint32_t from, uint32_t expected)
+{
+    SoarLog_Reader_t *reader = &g_bench.seek.reader;
+    SoarLog_RecordHeader_t header;
+    uint8_t payload[SOAR_LOG_MAX_RECORD_PAYLOAD];
+
+    if (SoarLog_ReaderOpen(reader, BENCH_SEEK_LOG_FILENAME) != SOAR_FS_OK)
+    {
+        SOAR_PRINT("  %s: could not open %s\n", label, BENCH_SEEK_LOG_FILENAME);
+        return;
+    }
+
+    // Both find the window from the footer, only the indexed read seeks to it
+    uint32_t start = CycleCounter::Now();
+    uint32_t latest = 0;
+    SoarFS_Result_t result = SoarLog_ReaderLatest(reader, &latest);
+    const uint32_t windowStart = latest - BENCH_SEEK_WINDOW_MS;
+    if (result == SOAR_FS_OK && indexed)
+    {
+        result = SoarLog_SeekTime(reader, windowStart);
+    }
+
+    uint32_t records = 0;
+    while (result == SOAR_FS_OK)
+    {
+        result = SoarLog_ReadRecord(reader, &header, payload);
+        if (result == SOAR_FS_OK && header.timestamp >= windowStart)
+        {
+            records++;
+        }
+    }
+    uint32_t cycles = CycleCounter::Now() - start;
+
+    SOAR_PRINT("  %s: %lu blocks read of %lu, %lu us, %lu records%s\n", label, reader->blocksRead,
+               reader->blockCount, CycleCounter::ToMicros(cycles), records,
+               (result != SOAR_FS_END_OF_FILE || windowStart != from || records != expected) ? ", WINDOW MISMATCH"
+                                                                                         : "");
+    SoarLog_ReaderClose(reader);
+}
+
+/**
+ * @brief Start a journal log the way LogSession does, in a reserved file opened as an appender
+ * @param mode SOAR_FS_SYNC_ON_FLUSH for SoarLog_Checkpoint to sync, SOAR_FS_SYNC_ON_CLOSE for SoarLog_Commit
+ */
+static SoarFS_Result_t SoarFS_Bench_OpenJournal(SoarFS_SyncMode_t mode)
+{
+    SoarFS_SyncPolicy_t policy = {mode, 0, 0};
+    SoarFS_Handle_t handle;
+
+    if (SoarFS_FileExists(BENCH_JOURNAL_FILENAME))
+    {
+        SoarFS_DeleteFile(BENCH_JOURNAL_FILENAME);
+    }
+
+    // Reserved and closed first, so the reservation is on the media before anything is written
+    SoarFS_Result_t result = SoarFS_Reserve(BENCH_JOURNAL_FILENAME, BENCH_JOURNAL_BYTES);
+    if (result == SOAR_FS_OK)
+    {
+        result = SoarFS_OpenPreallocated(BENCH_JOURNAL_FILENAME, &policy, &handle);
+    }
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+
+    memset(&g_bench.journal.writer, 0, sizeof(g_bench.journal.writer));
+    return SoarLog_Begin(&g_bench.journal.writer, BENCH_JOURNAL_FILENAME, handle);
+}
+
+/**
+ * @brief Write BENCH_JOURNAL_RECORDS flight samples to the journal log, stopping at the first failure
+ * @param commit Checkpoint with SoarLog_Commit, else SoarLog_Checkpoint
+ * @param committed Receives the records written before the last successful checkpoint
+ * @param checkpointCycles Receives the cycles spent in checkpoints, may be NULL
+ * @retval uint32_t Records appended
+ */
+static uint32_t SoarFS_Bench_WriteJournal(bool commit, uint32_t *committed, uint32_t *checkpointCycles)
+{
+    SoarLog_Writer_t *writer = &g_bench.journal.writer;
+    uint8_t record[BENCH_COLUMN_MAX_RECORD];
+    uint32_t cycles = 0;
+
+    *committed = 0;
+    uint32_t i = 0;
+    for (; i < BENCH_JOURNAL_RECORDS; i++)
+    {
+        uint32_t timestamp = SoarFS_Bench_MakeSample(SOAR_LOG_RECORD_FLIGHT, i, record);
+        if (SoarLog_Append(writer, SOAR_LOG_RECORD_FLIGHT, timestamp, record, sizeof(FlightData_t)) != SOAR_FS_OK)
+        {
+            break;
+        }
+
+        if ((i + 1) % BENCH_JOURNAL_COMMIT_EVERY == 0)
+        {
+            uint32_t start = CycleCounter::Now();
+            SoarFS_Result_t result = commit ? SoarLog_Commit(writer) : SoarLog_Checkpoint(writer);
+            cycles += CycleCounter::Now() - start;
+            if (result != SOAR_FS_OK)
+            {
+                i++;
+                break;
+            }
+            *committed = i + 1;
+        }
+    }
+
+    if (checkpointCycles != NULL)
+    {
+        *checkpointCycles = cycles;
+    }
+    return i;
+}
+
+#if USER_DISKIO_FAULT
+/**
+ * @brief Check the recovered journal log holds flight samples 0.. in order, at least every committed one
+ * @param committed Records before the last successful commit
+ * @param appended Records handed to the writer
+ * @param records Receives the records found
+ * @retval bool True if the log is a valid prefix of what was appended, covering what was committed
+ */
+static bool SoarFS_Bench_CheckJournal(uint32_t committed, uint32_t appended, uint32_t *records)
+{
+    SoarLog_Reader_t *reader = &g_bench.journal.reader;
+    SoarLog_RecordHeader_t header;
+    uint8_t payload[SOAR_LOG_MAX_RECORD_PAYLOAD];
+    uint8_t expected[BENCH_COLUMN_MAX_RECORD];
+
+    *records = 0;
+    if (SoarLog_ReaderOpen(reader, BENCH_JOURNAL_FILENAME) != SOAR_FS_OK)
+    {
+        return false;
+    }
+
+    bool match = true;
+    SoarFS_Result_t result = SOAR_FS_OK;
+    while (match && (result = SoarLog_ReadRecord(reader, &header, payload)) == SOAR_FS_OK)
+    {
+        uint32_t timestamp = SoarFS_Bench_MakeSample(SOAR_LOG_RECORD_FLIGHT, *records, expected);
+        match = (header.type == SOAR_LOG_RECORD_FLIGHT && header.length == sizeof(FlightData_t) &&
+                 header.timestamp == timestamp && memcmp(payload, expected, sizeof(FlightData_t)) == 0);
+        *records += match ? 1 : 0;
+    }
+
+    // Anything the recovery kept must be whole, a skipped block means it kept too much
+    match = match && result == SOAR_FS_END_OF_FILE && reader->blocksSkipped == 0;
+    SoarLog_ReaderClose(reader);
+    return match && *records >= committed && *records <= appended;
+}
+#endif
+
+/**
+ * @brief Run and print every record size, file count and sync policy combination on the mounted volume
+ */
+static void SoarFS_Bench_SweepCluster(uint32_t clusterBytes)
+{
+#if USER_DISKIO_BACKEND == USER_DISKIO_BACKEND_RAMDISK
+    const char *backend = USER_DISKIO_CACHE ? "ramdisk+cache" : "ramdisk";
+#elif USER_DISKIO_BACKEND == USER_DISKIO_BACKEND_IMAGE
+    const char *backend = USER_DISKIO_CACHE ? "image+cache" : "image";
+#else
+    const char *backend = USER_DISKIO_CACHE ? "media+cache" : "media";
+#endif
+
+    // Every run must fit what is free now, less the partly filled last cluster of each file
+    uint64_t freeBytes = 0;
+    SoarFS_GetFreeSpace(&freeBytes);
+    const uint64_t slack = (uint64_t)SOAR_FS_MAX_FILES_OPEN * clusterBytes;
+    const uint32_t maxBytes = (freeBytes <= slack)                   ? 0
+                              : (freeBytes - slack < BENCH_SWEEP_BYTES) ? (uint32_t)(freeBytes - slack)
+                                                                      : BENCH_SWEEP_BYTES;
+    SOAR_PRINT("  %lu B clusters: %lu KB free, up to %lu KB per run\n", clusterBytes, (uint32_t)(freeBytes / 1024),
+               maxBytes / 1024);
+
+    for (uint32_t r = 0; r < sizeof(BENCH_SWEEP_RECORD_SIZES) / sizeof(BENCH_SWEEP_RECORD_SIZES[0]); r++)
+    {
+        const uint32_t recordSize = BENCH_SWEEP_RECORD_SIZES[r];
+        const uint32_t records = (maxBytes / recordSize < BENCH_SWEEP_RECORDS) ? maxBytes / recordSize : BENCH_SWEEP_RECORDS;
+        if (records == 0)
+        {
+            SOAR_PRINT("  %lu B records do not fit the free space, skipped\n", recordSize);
+            continue;
+        }
+
+        for (uint32_t f = 0; f < sizeof(BENCH_SWEEP_FILE_COUNTS) / sizeof(BENCH_SWEEP_FILE_COUNTS[0]); f++)
+        {
+            for (uint32_t p = 0; p < sizeof(BENCH_SWEEP_POLICIES) / sizeof(BENCH_SWEEP_POLICIES[0]); p++)
+            {
+                const SoarFS_Bench_SweepPolicy_t *policy = &BENCH_SWEEP_POLICIES[p];
+                SoarFS_Bench_SweepResult_t result;
+                if (!SoarFS_Bench_SweepRun(recordSize, BENCH_SWEEP_FILE_COUNTS[f], &policy->policy, records, &result))
+                {
+                    SOAR_PRINT("  %lu B records, %u files, sync %s: run failed\n", recordSize,
+                               BENCH_SWEEP_FILE_COUNTS[f], policy->name);
+                    continue;
+                }
+
+                // Nearest rank percentiles of the sorted samples
+                const uint32_t *latency = g_bench.sweep.latency;
+                const uint64_t bytes = (uint64_t)records * recordSize;
+                const uint64_t hz = CycleCounter::Frequency();
+                SOAR_PRINT("BENCH,sweep,%s,%lu,%lu,%u,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", backend, clusterBytes,
+                           recordSize, BENCH_SWEEP_FILE_COUNTS[f], policy->name, records,
+                           (uint32_t)(result.writeCycles ? (bytes * hz) / result.writeCycles / 1024 : 0),
+                           (uint32_t)(result.readCycles ? ((uint64_t)result.bytesRead * hz) / result.readCycles / 1024 : 0),
+                           CycleCounter::ToMicros(latency[(records - 1) * 50 / 100]),
+                           CycleCounter::ToMicros(latency[(records - 1) * 99 / 100]),
+                           CycleCounter::ToMicros(latency[records - 1]), (result.fsSectors * 100) / records,
+                           (result.mediaSectors * 100) / records);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Append records round robin to fresh appenders, close them and read them back
+ * @retval bool False if a file could not be made or did not read back whole
+ */
+static bool SoarFS_Bench_SweepRun(uint32_t recordSize, uint32_t files, const SoarFS_SyncPolicy_t *policy,
+                                  uint32_t records, SoarFS_Bench_SweepResult_t *result)
+{
+    memset(result, 0, sizeof(*result));
+
+    SoarFS_Handle_t handles[SOAR_FS_MAX_FILES_OPEN];
+    char filename[SOAR_FS_MAX_FILENAME_LEN];
+    bool ok = true;
+    uint32_t opened = 0;
+    for (; opened < files; opened++)
+    {
+        snprintf(filename, sizeof(filename), BENCH_SWEEP_FILENAME, opened);
+        if (!SoarFS_Bench_ResetFile(filename) || SoarFS_OpenAppender(filename, policy, &handles[opened]) != SOAR_FS_OK)
+        {
+            ok = false;
+            break;
+        }
+    }
+
+    USER_ResetDiskStats();
+#if USER_DISKIO_CACHE
+    CACHEDISK_ResetStats();
+#endif
+
+    for (uint32_t i = 0; ok && i < records; i++)
+    {
+        memset(g_bench.sweep.record, (uint8_t)i, recordSize);
+        uint32_t start = CycleCounter::Now();
+        ok = (SoarFS_Write(handles[i % files], g_bench.sweep.record, recordSize) == SOAR_FS_OK);
+        g_bench.sweep.latency[i] = CycleCounter::Now() - start;
+        result->writeCycles += g_bench.sweep.latency[i];
+    }
+
+    for (uint32_t f = 0; f < opened; f++)
+    {
+        uint32_t start = CycleCounter::Now();
+        ok = (SoarFS_Close(handles[f]) == SOAR_FS_OK) && ok;
+        result->writeCycles += CycleCounter::Now() - start;
+    }
+
+    USER_DiskStats_t diskStats;
+    USER_GetDiskStats(&diskStats);
+    result->fsSectors = diskStats.writeSectors;
+#if USER_DISKIO_CACHE
+    CACHEDISK_Stats_t cacheStats;
+    CACHEDISK_GetStats(&cacheStats);
+    result->mediaSectors = cacheStats.backendWriteSectors;
+#else
+    result->mediaSectors = diskStats.writeSectors;
+#endif
+
+    // Sequential read back in records, through the fast-seek reader the log tools use
+    for (uint32_t f = 0; ok && f < files; f++)
+    {
+        SoarFS_Handle_t handle;
+        snprintf(filename, sizeof(filename), BENCH_SWEEP_FILENAME, f);
+        if (SoarFS_OpenReader(filename, &handle) != SOAR_FS_OK)
+        {
+            ok = false;
+            break;
+        }
+
+        uint32_t bytesRead;
+        do
+        {
+            uint32_t start = CycleCounter::Now();
+            ok = (SoarFS_Read(handle, g_bench.sweep.record, recordSize, &bytesRead) == SOAR_FS_OK);
+            result->readCycles += CycleCounter::Now() - start;
+            result->bytesRead += bytesRead;
+        } while (ok && bytesRead == recordSize);
+        SoarFS_Close(handle);
+    }
+
+    for (uint32_t f = 0; f < files; f++)
+    {
+        snprintf(filename, sizeof(filename), BENCH_SWEEP_FILENAME, f);
+        SoarFS_DeleteFile(filename);
+    }
+
+    if (!ok || result->bytesRead != records * recordSize)
+    {
+        return false;
+    }
+
+    qsort(g_bench.sweep.latency, records, sizeof(g_bench.sweep.latency[0]), SoarFS_Bench_CompareCycles);
+    return true;
+}
+
+/**
+ * @brief qsort order of cycle counts, ascending
+ */
+static int SoarFS_Bench_CompareCycles(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
@@ -11,8 +11,14 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "SoarFileSystem.hpp"
+#include "SoarFileSystemExample.hpp"
+#include "SoarLogWriter.hpp"
+#include "SoarLZ.hpp"
+#include "SoarFileSystemAsync.hpp"
+#include "FileSystemTask.hpp"
 #include <string.h>
 #include <cstdio>
+#include <cstdlib>
 /* Example usage functions ---------------------------------------------------*/
 
 /**
@@ -28,7 +34,7 @@ void SoarFS_Example_Init(void)
         if (SoarFS_IsMounted())
         {
             // USB storage is connected and ready
-            uint32_t freeSpace;
+            uint64_t freeSpace;
             if (SoarFS_GetFreeSpace(&freeSpace) == SOAR_FS_OK)
             {
                 // Display available space (freeSpace contains bytes available)
@@ -128,16 +134,20 @@ void SoarFS_Example_LogSensorData(float temperature, float humidity, uint32_t ti
     // Create CSV header if file doesn't exist
     if (!SoarFS_FileExists(logFile))
     {
-        const char *header = "Timestamp,Temperature,Humidity\\n";
+        const char *header = "Timestamp,Temperature,Humidity\n";
         SoarFS_CreateFile(logFile, (const uint8_t *)header, strlen(header));
     }
 
     // Open file for appending
     if (SoarFS_OpenFile(logFile) == SOAR_FS_OK)
     {
-        // Format data as CSV
-        char dataLine[128];
-        //snprintf(dataLine, sizeof(dataLine), "%lu,%.2f,%.2f\\n", timestamp, temperature, humidity);
+        // Format data as CSV, in fixed point since nano printf has no %f
+        int32_t tempCenti = (int32_t)(temperature * 100.0f);
+        int32_t humCenti = (int32_t)(humidity * 100.0f);
+        char dataLine[64];
+        snprintf(dataLine, sizeof(dataLine), "%lu,%s%ld.%02ld,%s%ld.%02ld\n", (unsigned long)timestamp,
+                 (tempCenti < 0) ? "-" : "", (long)(abs(tempCenti) / 100), (long)(abs(tempCenti) % 100),
+                 (humCenti < 0) ? "-" : "", (long)(abs(humCenti) / 100), (long)(abs(humCenti) % 100));
 
         // Write data
         SoarFS_WriteFile(logFile, (const uint8_t *)dataLine, strlen(dataLine));
@@ -152,54 +162,61 @@ void SoarFS_Example_LogSensorData(float temperature, float humidity, uint32_t ti
  */
 void SoarFS_Example_StoreBinaryData(void)
 {
-    // Example: Store flight data structure
-    typedef struct
-    {
-        uint32_t timestamp;
-        float altitude;
-        float velocity;
-        float acceleration[3]; // x, y, z
-        uint16_t battery_voltage;
-    } FlightData_t;
-
+    // Framed, CRC-checked records, see SoarLogFormat.hpp
     FlightData_t flightData = {
-        .timestamp = 12345678,
         .altitude = 1000.5f,
         .velocity = 25.8f,
         .acceleration = {0.1f, 0.2f, 9.8f},
         .battery_voltage = 3700 // mV
     };
 
-    const char *filename = "flight_data.bin";
+    // Writer state holds a whole block, keep it off the task stack
+    static SoarLog_Writer_t writer;
 
-    // Create binary file
-    SoarFS_Result_t result = SoarFS_CreateFile(filename, (const uint8_t *)&flightData, sizeof(FlightData_t));
-
-    if (result == SOAR_FS_OK)
+    if (SoarLog_Open(&writer, "flight.slg") == SOAR_FS_OK)
     {
-        // Binary data stored successfully
+        SoarLog_Append(&writer, SOAR_LOG_RECORD_FLIGHT, 12345678, &flightData, sizeof(flightData));
 
-        // Later, read it back
-        if (SoarFS_OpenFile(filename) == SOAR_FS_OK)
-        {
-            FlightData_t readData;
-            uint32_t bytesRead;
+        const char note[] = "example";
+        SoarLog_Append(&writer, SOAR_LOG_RECORD_TEXT, 12345679, note, sizeof(note) - 1);
 
-            SoarFS_ReadFile(filename, (uint8_t *)&readData, sizeof(FlightData_t), &bytesRead);
+        // Close writes the partial block, sealed with its CRC
+        SoarLog_Close(&writer);
+    }
+}
 
-            if (bytesRead == sizeof(FlightData_t))
-            {
-                // Data read successfully, verify integrity
-                if (readData.timestamp == flightData.timestamp &&
-                    readData.altitude == flightData.altitude)
-                {
-                    // Data integrity verified
-                }
-            }
+/**
+ * @brief Example function demonstrating a compressed text log
+ */
+void SoarFS_Example_CompressedLog(void)
+{
+    // Window and block are several KB, keep them off the task stack
+    static SoarLZ_Writer_t lz;
 
-            SoarFS_CloseFile(filename);
-        }
+    // The file stays open; only whole compressed sectors reach the media
+    bool isNew = !SoarFS_FileExists("sensors.slz");
+    if (SoarLZ_Open(&lz, "sensors.slz", NULL) != SOAR_FS_OK)
+    {
+        return;
     }
+
+    if (isNew)
+    {
+        const char *header = "Timestamp,Temperature,Humidity\n";
+        SoarLZ_Write(&lz, (const uint8_t *)header, strlen(header));
+    }
+
+    char dataLine[32];
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        int len = snprintf(dataLine, sizeof(dataLine), "%lu,21.%02lu,45.00\n", (unsigned long)(i * 100),
+                           (unsigned long)(i % 7));
+        SoarLZ_Write(&lz, (const uint8_t *)dataLine, (uint32_t)len);
+    }
+
+    // Close compresses the partial block and pads it to a sector,
+    // soarlogtool unpack restores the original text
+    SoarLZ_Close(&lz);
 }
 
 /**
@@ -229,7 +246,7 @@ void SoarFS_Example_FileManagement(void)
     SoarFS_CloseAllFiles();
 
     // Get available space
-    uint32_t freeBytes;
+    uint64_t freeBytes;
     if (SoarFS_GetFreeSpace(&freeBytes) == SOAR_FS_OK)
     {
         // Check if we have enough space for critical operations
@@ -240,6 +257,90 @@ void SoarFS_Example_FileManagement(void)
     }
 }
 
+/**
+ * @brief Count completed appends, runs on FileSystemTask
+ */
+static void SoarFS_Example_AsyncAppendDone(SoarFS_AsyncRequest_t *request)
+{
+    if (request->result == SOAR_FS_OK)
+    {
+        (*(uint32_t *)request->context) += request->bytes;
+    }
+}
+
+/**
+ * @brief Example function demonstrating pipelined asynchronous requests
+ */
+void SoarFS_Example_AsyncPipeline(void)
+{
+    const uint32_t APPENDS = 4;
+    const uint32_t DONE_BIT = 1u << 0;
+
+    // Descriptors and buffers stay with FileSystemTask until completion, keep them off the stack
+    static SoarFS_AsyncRequest_t open, close;
+    static SoarFS_SyncPolicy_t policy = {SOAR_FS_SYNC_ON_FLUSH, 0, 0};
+    static uint32_t bytesWritten;
+
+    // Requests run in order, so the close still being pending means the previous run is in flight
+    if (close.state.load() == SOARFS_ASYNC_PENDING)
+    {
+        return;
+    }
+    bytesWritten = 0;
+
+    SoarFS_AsyncInit(&open, SOARFS_ASYNC_OPEN);
+    open.filename = "async.txt";
+    open.createIfMissing = true;
+    open.policy = &policy;
+
+    // Close flushes the appender, only it wakes this task
+    SoarFS_AsyncInit(&close, SOARFS_ASYNC_CLOSE);
+    close.handleFrom = &open;
+    close.notifyTask = xTaskGetCurrentTaskHandle();
+    close.notifyBits = DONE_BIT;
+
+    FileSystemTask &fs = FileSystemTask::Inst();
+    bool queued = fs.Submit(&open);
+
+    // Appends and close take their handle from the open, so all of them can be queued right away.
+    // The appends come from the pools and go back on their own, their results are only seen by the callback.
+    for (uint32_t i = 0; queued && i < APPENDS; i++)
+    {
+        SoarFS_AsyncRequest_t *append = fs.AllocateRequest(SOARFS_ASYNC_APPEND, 16);
+        if (append == nullptr)
+        {
+            break; // Pools exhausted, write fewer lines this time
+        }
+        append->size = (uint32_t)snprintf((char *)append->buffer, append->size, "line %lu\n", (unsigned long)i);
+        append->handleFrom = &open;
+        append->callback = SoarFS_Example_AsyncAppendDone;
+        append->context = &bytesWritten;
+        append->releaseWhenDone = true;
+
+        queued = fs.Submit(append);
+        if (!queued)
+        {
+            fs.ReleaseRequest(append); // Rejected, so still ours
+        }
+    }
+    queued = queued && fs.Submit(&close);
+    if (!queued)
+    {
+        // Queue full, whatever was queued still runs; retry later
+        return;
+    }
+
+    // This task is free to do other work here, nothing above touched the disk
+
+    uint32_t bits = 0;
+    if (xTaskNotifyWait(0, DONE_BIT, &bits, pdMS_TO_TICKS(1000)) == pdTRUE && (bits & DONE_BIT))
+    {
+        SoarFS_Example_ErrorHandling(open.result);
+        SoarFS_Example_ErrorHandling(close.result);
+        // bytesWritten holds the bytes appended
+    }
+}
+
 /**
  * @brief Example error handling function
  */
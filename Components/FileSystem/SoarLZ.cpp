@@ -0,0 +1,357 @@
+/**
+ * File Name          : SoarLZ.cpp
+ * Description        : Streaming compressor for files written through SOAR File System
+ * Author             : SOAR Team
+ *
+ * LZSS with a single-candidate hash match finder: each position looks up the
+ * most recent earlier position with the same next three bytes. Telemetry
+ * repeats with the period of its record, so that candidate is usually the
+ * same field of the previous record.
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLZ.hpp"
+#include "SoarLogWriter.hpp"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define SOAR_LZ_PAYLOAD(writer) ((writer)->block + SOAR_LOG_BLOCK_HEADER_SIZE)
+
+/* Private function prototypes -----------------------------------------------*/
+static SoarFS_Result_t SoarLZ_FileSink(const uint8_t *block, void *context);
+static void SoarLZ_BeginBlock(SoarLZ_Writer_t *writer);
+static SoarFS_Result_t SoarLZ_Encode(SoarLZ_Writer_t *writer, bool final);
+static SoarFS_Result_t SoarLZ_Seal(SoarLZ_Writer_t *writer);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Start a compressed stream into a custom sink
+ */
+SoarFS_Result_t SoarLZ_Init(SoarLZ_Writer_t *writer, SoarLZ_Sink_t sink, void *context)
+{
+    if (writer == NULL || sink == NULL)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    memset(writer, 0, sizeof(SoarLZ_Writer_t));
+    writer->sink = sink;
+    writer->context = context;
+    writer->isOpen = true;
+    SoarLZ_BeginBlock(writer);
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Open a compressed file for appending, creating it if it does not exist
+ */
+SoarFS_Result_t SoarLZ_Open(SoarLZ_Writer_t *writer, const char *filename, const SoarFS_SyncPolicy_t *policy)
+{
+    if (writer == NULL || filename == NULL)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    if (!SoarFS_FileExists(filename))
+    {
+        const uint8_t empty[1] = {0};
+        SoarFS_Result_t result = SoarFS_CreateFile(filename, empty, 0);
+        if (result != SOAR_FS_OK)
+        {
+            return result;
+        }
+    }
+
+    SoarLZ_Init(writer, SoarLZ_FileSink, writer);
+    writer->isOpen = false;
+
+    SoarFS_Result_t result = (policy != NULL) ? SoarFS_OpenAppender(filename, policy, &writer->handle)
+                                              : SoarFS_Open(filename, &writer->handle);
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+
+    // Continue the block numbering, a torn tail block is skipped by readers
+    uint32_t fileSize = 0;
+    SoarFS_GetFileSize(filename, &fileSize);
+    writer->sequence = (fileSize + SOAR_LOG_BLOCK_SIZE - 1) / SOAR_LOG_BLOCK_SIZE;
+    writer->isOpen = true;
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Compress bytes into the stream, writing out every block that fills
+ */
+SoarFS_Result_t SoarLZ_Write(SoarLZ_Writer_t *writer, const uint8_t *data, uint32_t dataSize)
+{
+    if (writer == NULL || !writer->isOpen || (data == NULL && dataSize > 0))
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    SoarFS_Result_t status = SOAR_FS_OK;
+    writer->rawBytes += dataSize;
+
+    while (dataSize > 0)
+    {
+        uint32_t chunk = SOAR_LZ_WINDOW - writer->rawLength;
+        if (chunk > dataSize)
+        {
+            chunk = dataSize;
+        }
+        memcpy(writer->window + writer->rawLength, data, chunk);
+        writer->rawLength += chunk;
+        data += chunk;
+        dataSize -= chunk;
+
+        // A full window has no more lookahead coming, it all goes into this block
+        bool windowFull = (writer->rawLength == SOAR_LZ_WINDOW);
+        SoarFS_Result_t result = SoarLZ_Encode(writer, windowFull);
+        if (result == SOAR_FS_OK && windowFull && writer->encoded == writer->rawLength)
+        {
+            result = SoarLZ_Seal(writer);
+        }
+        if (result != SOAR_FS_OK)
+        {
+            status = result;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * @brief Compress everything held and write the partial block out
+ */
+SoarFS_Result_t SoarLZ_Flush(SoarLZ_Writer_t *writer)
+{
+    if (writer == NULL || !writer->isOpen)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    SoarFS_Result_t result = SoarLZ_Encode(writer, true);
+    SoarFS_Result_t sealResult = SoarLZ_Seal(writer);
+    return (result != SOAR_FS_OK) ? result : sealResult;
+}
+
+/**
+ * @brief Flush, and close the file if the writer was opened with SoarLZ_Open
+ */
+SoarFS_Result_t SoarLZ_Close(SoarLZ_Writer_t *writer)
+{
+    if (writer == NULL || !writer->isOpen)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    SoarFS_Result_t result = SoarLZ_Flush(writer);
+    if (writer->sink == SoarLZ_FileSink)
+    {
+        SoarFS_Result_t closeResult = SoarFS_Close(writer->handle);
+        if (result == SOAR_FS_OK)
+        {
+            result = closeResult;
+        }
+    }
+
+    writer->isOpen = false;
+    writer->handle = SOAR_FS_NULL_HANDLE;
+    return result;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Sink of SoarLZ_Open, appends the block like SoarLog_WriteBlock does
+ */
+static SoarFS_Result_t SoarLZ_FileSink(const uint8_t *block, void *context)
+{
+    SoarLZ_Writer_t *writer = (SoarLZ_Writer_t *)context;
+
+    // Appenders always append and commit per their policy, plain handles are moved to the end and synced
+    SoarFS_Result_t result = SOAR_FS_OK;
+    bool appender = SoarFS_IsAppender(writer->handle);
+    if (!appender)
+    {
+        result = SoarFS_Seek(writer->handle, SOAR_FS_SEEK_END);
+    }
+    if (result == SOAR_FS_OK)
+    {
+        result = SoarFS_Write(writer->handle, block, SOAR_LOG_BLOCK_SIZE);
+    }
+    if (result == SOAR_FS_OK && !appender)
+    {
+        result = SoarFS_Sync(writer->handle);
+    }
+    return result;
+}
+
+/**
+ * @brief Hash of the three bytes at p, an index into head
+ */
+static inline uint32_t SoarLZ_Hash(const uint8_t *p)
+{
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (v * 2654435761u) >> (32 - SOAR_LZ_HASH_BITS);
+}
+
+/**
+ * @brief Clear the block and the match finder, matches never reach into an earlier block
+ */
+static void SoarLZ_BeginBlock(SoarLZ_Writer_t *writer)
+{
+    memset(writer->block, 0, SOAR_LOG_BLOCK_SIZE);
+    memset(writer->head, 0, sizeof(writer->head));
+    writer->packed = SOAR_LZ_RAW_LENGTH_SIZE;
+    writer->flagBit = 8;
+}
+
+/**
+ * @brief Append one item to the block, starting a new flags byte every eight items
+ */
+static inline void SoarLZ_Emit(SoarLZ_Writer_t *writer, bool match, uint32_t value)
+{
+    uint8_t *payload = SOAR_LZ_PAYLOAD(writer);
+    if (writer->flagBit == 8)
+    {
+        writer->flagOffset = writer->packed++;
+        writer->flagBit = 0;
+    }
+
+    if (match)
+    {
+        payload[writer->flagOffset] |= (uint8_t)(1u << writer->flagBit);
+        payload[writer->packed++] = (uint8_t)value;
+        payload[writer->packed++] = (uint8_t)(value >> 8);
+    }
+    else
+    {
+        payload[writer->packed++] = (uint8_t)value;
+    }
+    writer->flagBit++;
+}
+
+/**
+ * @brief Encode the window into the block, sealing the block whenever it fills
+ * @param final Encode up to the last byte, otherwise stop SOAR_LZ_MAX_MATCH short of it
+ * so every match can be as long as the data allows
+ */
+static SoarFS_Result_t SoarLZ_Encode(SoarLZ_Writer_t *writer, bool final)
+{
+    SoarFS_Result_t status = SOAR_FS_OK;
+
+    while (true)
+    {
+        const uint32_t available = writer->rawLength - writer->encoded;
+        if (available == 0 || (!final && available < SOAR_LZ_MAX_MATCH))
+        {
+            break;
+        }
+
+        // Worst case item is a match plus a new flags byte
+        if (writer->packed + 2u + (writer->flagBit == 8 ? 1u : 0u) > SOAR_LOG_BLOCK_PAYLOAD_SIZE)
+        {
+            SoarFS_Result_t result = SoarLZ_Seal(writer);
+            if (result != SOAR_FS_OK)
+            {
+                status = result;
+            }
+            continue;
+        }
+
+        const uint32_t pos = writer->encoded;
+        const uint8_t *cur = writer->window + pos;
+        uint32_t bestLength = 0;
+        uint32_t bestOffset = 0;
+
+        if (available >= SOAR_LZ_MIN_MATCH)
+        {
+            const uint32_t h = SoarLZ_Hash(cur);
+            const uint32_t candidate = writer->head[h];
+            writer->head[h] = (uint16_t)(pos + 1);
+
+            if (candidate != 0)
+            {
+                const uint8_t *ref = writer->window + candidate - 1;
+                const uint32_t limit = (available < SOAR_LZ_MAX_MATCH) ? available : SOAR_LZ_MAX_MATCH;
+                uint32_t length = 0;
+                while (length < limit && ref[length] == cur[length])
+                {
+                    length++;
+                }
+                if (length >= SOAR_LZ_MIN_MATCH)
+                {
+                    bestLength = length;
+                    bestOffset = pos + 1 - candidate;
+                }
+            }
+        }
+
+        if (bestLength == 0)
+        {
+            SoarLZ_Emit(writer, false, *cur);
+            writer->encoded++;
+            continue;
+        }
+
+        SoarLZ_Emit(writer, true, ((bestOffset - 1) << SOAR_LZ_LENGTH_BITS) | (bestLength - SOAR_LZ_MIN_MATCH));
+
+        // Index the positions the match covers so later data can refer back into it
+        for (uint32_t p = pos + 1; p < pos + bestLength && p + SOAR_LZ_MIN_MATCH <= writer->rawLength; p++)
+        {
+            writer->head[SoarLZ_Hash(writer->window + p)] = (uint16_t)(p + 1);
+        }
+        writer->encoded += bestLength;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Frame the block, hand it to the sink and carry the unencoded bytes over to the next one
+ */
+static SoarFS_Result_t SoarLZ_Seal(SoarLZ_Writer_t *writer)
+{
+    if (writer->encoded == 0)
+    {
+        return SOAR_FS_OK;
+    }
+
+    uint8_t *payload = SOAR_LZ_PAYLOAD(writer);
+    payload[0] = (uint8_t)writer->encoded;
+    payload[1] = (uint8_t)(writer->encoded >> 8);
+
+    SoarLog_BlockHeader_t header;
+    header.magic = SOAR_LZ_MAGIC;
+    header.version = SOAR_LZ_VERSION;
+    header.blockType = SOAR_LZ_BLOCK_PACKED;
+    header.payloadLength = writer->packed;
+    header.sequence = writer->sequence;
+    memcpy(writer->block, &header, SOAR_LOG_BLOCK_HEADER_SIZE);
+
+    uint32_t crc = SoarLog_Crc32(writer->block, SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE);
+    memcpy(writer->block + SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE, &crc, SOAR_LOG_BLOCK_CRC_SIZE);
+
+    // Unlike log records, the bytes are already folded into the window, so a failed block is
+    // dropped; its sequence number is still used up so readers see the gap
+    SoarFS_Result_t result = writer->sink(writer->block, writer->context);
+    writer->sequence++;
+    if (result == SOAR_FS_OK)
+    {
+        writer->blocksWritten++;
+    }
+    else
+    {
+        writer->blocksDropped++;
+    }
+
+    writer->rawLength -= writer->encoded;
+    memmove(writer->window, writer->window + writer->encoded, writer->rawLength);
+    writer->encoded = 0;
+    SoarLZ_BeginBlock(writer);
+    return result;
+}
@@ -0,0 +1,163 @@
+/**
+ * File Name          : SoarLogColumns.cpp
+ * Description        : Column encoder for fixed length log records, see SoarLogColumnFormat.hpp
+ * Author             : SOAR Team
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLogColumns.hpp"
+#include <string.h>
+
+/* Private function prototypes -----------------------------------------------*/
+static uint16_t SoarLog_ColumnsBuild(uint8_t *payload, void *context);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Set a batch up for one record type of SOAR_LOG_SCHEMA
+ */
+SoarFS_Result_t SoarLog_ColumnsInit(SoarLog_ColumnBatch_t *batch, uint8_t type)
+{
+    if (batch == NULL)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    memset(batch, 0, sizeof(SoarLog_ColumnBatch_t));
+    for (uint32_t i = 0; i < sizeof(SOAR_LOG_SCHEMA) / sizeof(SOAR_LOG_SCHEMA[0]); i++)
+    {
+        const SoarLog_SchemaEntry_t *entry = &SOAR_LOG_SCHEMA[i];
+        if (entry->type != type)
+        {
+            continue;
+        }
+
+        int32_t fieldCount = SoarLog_ParseColumnFields(entry->fields, batch->fields);
+        if (fieldCount <= 0)
+        {
+            return SOAR_FS_INVALID_PARAMETER;
+        }
+
+        const SoarLog_ColumnField_t *last = &batch->fields[fieldCount - 1];
+        if (last->offset + last->size != entry->length)
+        {
+            return SOAR_FS_INVALID_PARAMETER;
+        }
+
+        uint32_t maxRecords = SOAR_LOG_COLUMN_MAX_VALUES / (uint32_t)fieldCount;
+        batch->type = type;
+        batch->fieldCount = (uint8_t)fieldCount;
+        batch->recordLength = entry->length;
+        batch->maxRecords = (uint8_t)((maxRecords < SOAR_LOG_COLUMN_MAX_RECORDS) ? maxRecords : SOAR_LOG_COLUMN_MAX_RECORDS);
+        return SOAR_FS_OK;
+    }
+
+    return SOAR_FS_INVALID_PARAMETER;
+}
+
+/**
+ * @brief Add one record to the batch
+ */
+bool SoarLog_ColumnsAdd(SoarLog_ColumnBatch_t *batch, uint32_t timestamp, const void *payload)
+{
+    if (batch->count == batch->maxRecords)
+    {
+        return false;
+    }
+
+    // Price the record against the previous one before committing it, coding from 0 in a new block
+    const uint32_t fieldCount = batch->fieldCount;
+    uint32_t *words = batch->words + batch->count * fieldCount;
+    const uint32_t *previousWords = (batch->count == 0) ? NULL : words - fieldCount;
+    uint32_t size = (batch->count == 0) ? SOAR_LOG_COLUMN_HEADER_SIZE
+                                        : SoarLog_VarintSize(timestamp - batch->timestamps[batch->count - 1]);
+    for (uint32_t f = 0; f < fieldCount; f++)
+    {
+        words[f] = SoarLog_ColumnWord(&batch->fields[f], (const uint8_t *)payload);
+        uint32_t previous = (previousWords == NULL) ? 0 : previousWords[f];
+        size += SoarLog_VarintSize(SoarLog_ColumnCode(&batch->fields[f], words[f], previous));
+    }
+
+    if (batch->encodedSize + size > SOAR_LOG_BLOCK_PAYLOAD_SIZE)
+    {
+        return false;
+    }
+
+    batch->timestamps[batch->count++] = timestamp;
+    batch->encodedSize += size;
+    return true;
+}
+
+/**
+ * @brief Encode the batch as a column block payload
+ */
+uint16_t SoarLog_ColumnsEncode(const SoarLog_ColumnBatch_t *batch, uint8_t *payload)
+{
+    const uint32_t count = batch->count;
+    const uint32_t fieldCount = batch->fieldCount;
+
+    payload[0] = batch->type;
+    payload[1] = (uint8_t)count;
+    memcpy(payload + 2, &batch->timestamps[0], sizeof(uint32_t));
+
+    uint32_t pos = SOAR_LOG_COLUMN_HEADER_SIZE;
+    for (uint32_t i = 1; i < count; i++)
+    {
+        pos += SoarLog_PutVarint(payload + pos, batch->timestamps[i] - batch->timestamps[i - 1]);
+    }
+
+    for (uint32_t f = 0; f < fieldCount; f++)
+    {
+        const SoarLog_ColumnField_t *field = &batch->fields[f];
+        uint32_t previous = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint32_t word = batch->words[i * fieldCount + f];
+            pos += SoarLog_PutVarint(payload + pos, SoarLog_ColumnCode(field, word, previous));
+            previous = word;
+        }
+    }
+
+    return (uint16_t)pos;
+}
+
+/**
+ * @brief Empty the batch, keeping its type and counters
+ */
+void SoarLog_ColumnsClear(SoarLog_ColumnBatch_t *batch)
+{
+    batch->count = 0;
+    batch->encodedSize = 0;
+}
+
+/**
+ * @brief Write the batch to a log as one column block and empty the batch
+ */
+SoarFS_Result_t SoarLog_WriteColumns(SoarLog_Writer_t *writer, SoarLog_ColumnBatch_t *batch)
+{
+    if (batch == NULL || batch->count == 0)
+    {
+        return SOAR_FS_OK;
+    }
+
+    SoarFS_Result_t result = SoarLog_AppendBlock(writer, SOAR_LOG_BLOCK_COLUMNS, SoarLog_ColumnsBuild, batch);
+    if (result == SOAR_FS_OK)
+    {
+        batch->recordsWritten += batch->count;
+        batch->blocksWritten++;
+        batch->payloadBytes += batch->encodedSize;
+        SoarLog_ColumnsClear(batch);
+    }
+    return result;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief SoarLog_AppendBlock builder, encodes the batch in context
+ */
+static uint16_t SoarLog_ColumnsBuild(uint8_t *payload, void *context)
+{
+    return SoarLog_ColumnsEncode((const SoarLog_ColumnBatch_t *)context, payload);
+}
@@ -0,0 +1,412 @@
+/**
+ * File Name          : SoarLogReader.cpp
+ * Description        : Reads framed binary flight logs back, seeking by timestamp
+ * Author             : SOAR Team
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLogReader.hpp"
+#include <string.h>
+
+/* Private function prototypes -----------------------------------------------*/
+static void SoarLog_ReaderRewind(SoarLog_Reader_t *reader, uint32_t sequence, uint32_t from);
+static SoarFS_Result_t SoarLog_ReaderLoad(SoarLog_Reader_t *reader, uint32_t sequence, SoarLog_BlockHeader_t *header,
+                                          bool *valid);
+static SoarFS_Result_t SoarLog_ReaderIndexStart(SoarLog_Reader_t *reader, uint32_t sequence, uint32_t timestamp,
+                                                uint32_t *start, bool *found);
+static SoarFS_Result_t SoarLog_ReaderNext(SoarLog_Reader_t *reader);
+static bool SoarLog_ReaderDecodeColumns(SoarLog_Reader_t *reader, uint16_t length);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Open a log for reading, positioned at its first record
+ */
+SoarFS_Result_t SoarLog_ReaderOpen(SoarLog_Reader_t *reader, const char *filename)
+{
+    if (reader == NULL || filename == NULL)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    memset(reader, 0, sizeof(SoarLog_Reader_t));
+    SoarFS_Result_t result = SoarFS_OpenReader(filename, &reader->handle);
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+
+    // The handle knows the size, no directory lookup
+    uint32_t fileSize = 0;
+    result = SoarFS_Seek(reader->handle, SOAR_FS_SEEK_END);
+    if (result == SOAR_FS_OK)
+    {
+        result = SoarFS_Tell(reader->handle, &fileSize);
+    }
+    if (result != SOAR_FS_OK)
+    {
+        SoarFS_Close(reader->handle);
+        return result;
+    }
+
+    // A torn tail block is never read
+    reader->isOpen = true;
+    reader->blockCount = fileSize / SOAR_LOG_BLOCK_SIZE;
+    SoarLog_ReaderRewind(reader, 1, 0);
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Latest timestamp in the log, from the footer of a closed log or else its last blocks
+ */
+SoarFS_Result_t SoarLog_ReaderLatest(SoarLog_Reader_t *reader, uint32_t *timestamp)
+{
+    if (reader == NULL || !reader->isOpen || timestamp == NULL)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    // A commit point knows the latest record before it, so the walk back ends at the footer or last commit
+    bool found = false;
+    SoarFS_Result_t result = SOAR_FS_OK;
+    for (uint32_t sequence = reader->blockCount;
+         sequence-- > 1 && reader->blockCount - sequence <= SOAR_LOG_INDEX_INTERVAL;)
+    {
+        SoarLog_BlockHeader_t header;
+        bool valid;
+        result = SoarLog_ReaderLoad(reader, sequence, &header, &valid);
+        if (result != SOAR_FS_OK)
+        {
+            break;
+        }
+        if (!valid)
+        {
+            continue;
+        }
+
+        const uint8_t *payload = reader->block + SOAR_LOG_BLOCK_HEADER_SIZE;
+        uint32_t latest;
+        bool commit = (SoarLog_IsCommitPoint(header.blockType) && header.payloadLength >= SOAR_LOG_COMMIT_SIZE);
+        if (commit)
+        {
+            memcpy(&latest, payload, sizeof(latest));
+        }
+
+        // Only blocks after the schema put a timestamp into a commit point
+        if ((commit && sequence > 1) || SoarLog_BlockLatest(header.blockType, payload, header.payloadLength, &latest))
+        {
+            *timestamp = (found && *timestamp > latest) ? *timestamp : latest;
+            found = true;
+        }
+        if (commit)
+        {
+            break;
+        }
+    }
+
+    // The loaded block was overwritten
+    SoarLog_ReaderRewind(reader, 1, 0);
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+    return found ? SOAR_FS_OK : SOAR_FS_END_OF_FILE;
+}
+
+/**
+ * @brief Position the reader so the next records read are those at or after a time
+ */
+SoarFS_Result_t SoarLog_SeekTime(SoarLog_Reader_t *reader, uint32_t timestamp)
+{
+    if (reader == NULL || !reader->isOpen)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    // The footer holds the newest entries, a recent window is found there in one read
+    uint32_t start = 1;
+    bool found = false;
+    SoarFS_Result_t result = SOAR_FS_OK;
+    if (reader->blockCount > 1)
+    {
+        result = SoarLog_ReaderIndexStart(reader, reader->blockCount - 1, timestamp, &start, &found);
+    }
+
+    // The slots' first entries only get newer, search for the last one older than the window
+    uint32_t low = 0;
+    uint32_t high = reader->blockCount / SOAR_LOG_INDEX_SPAN;
+    while (!found && result == SOAR_FS_OK && low < high)
+    {
+        const uint32_t mid = low + (high - low) / 2;
+        uint32_t slotStart;
+        bool slotFound;
+        result = SoarLog_ReaderIndexStart(reader, mid * SOAR_LOG_INDEX_SPAN + SOAR_LOG_INDEX_SPAN - 1, timestamp,
+                                          &slotStart, &slotFound);
+        if (slotFound)
+        {
+            start = slotStart;
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    SoarLog_ReaderRewind(reader, start, timestamp);
+    return result;
+}
+
+/**
+ * @brief Read the next record in file order, skipping those before the time sought
+ */
+SoarFS_Result_t SoarLog_ReadRecord(SoarLog_Reader_t *reader, SoarLog_RecordHeader_t *header, uint8_t *payload)
+{
+    if (reader == NULL || !reader->isOpen || header == NULL || payload == NULL)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    for (;;)
+    {
+        if (reader->offset < reader->columnCount)
+        {
+            const uint32_t i = reader->offset++;
+            if (reader->timestamps[i] < reader->from)
+            {
+                continue;
+            }
+
+            header->type = reader->columnType;
+            header->length = reader->columnLength;
+            header->timestamp = reader->timestamps[i];
+            memcpy(payload, reader->records + i * reader->columnLength, reader->columnLength);
+            return SOAR_FS_OK;
+        }
+
+        if (reader->offset + SOAR_LOG_RECORD_HEADER_SIZE <= reader->length)
+        {
+            const uint8_t *src = reader->block + SOAR_LOG_BLOCK_HEADER_SIZE + reader->offset;
+            memcpy(header, src, SOAR_LOG_RECORD_HEADER_SIZE);
+            if (reader->offset + SOAR_LOG_RECORD_HEADER_SIZE + header->length > reader->length)
+            {
+                reader->length = 0;
+                continue;
+            }
+
+            reader->offset += SOAR_LOG_RECORD_HEADER_SIZE + header->length;
+            if (header->timestamp < reader->from)
+            {
+                continue;
+            }
+
+            memcpy(payload, src + SOAR_LOG_RECORD_HEADER_SIZE, header->length);
+            return SOAR_FS_OK;
+        }
+
+        SoarFS_Result_t result = SoarLog_ReaderNext(reader);
+        if (result != SOAR_FS_OK)
+        {
+            return result;
+        }
+    }
+}
+
+/**
+ * @brief Close the log
+ */
+SoarFS_Result_t SoarLog_ReaderClose(SoarLog_Reader_t *reader)
+{
+    if (reader == NULL || !reader->isOpen)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    reader->isOpen = false;
+    return SoarFS_Close(reader->handle);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Drop the loaded block and continue reading at a block
+ */
+static void SoarLog_ReaderRewind(SoarLog_Reader_t *reader, uint32_t sequence, uint32_t from)
+{
+    reader->nextSequence = sequence;
+    reader->from = from;
+    reader->length = 0;
+    reader->offset = 0;
+    reader->columnCount = 0;
+}
+
+/**
+ * @brief Read a block into reader->block and check its framing
+ * @param valid Set if the block is intact and holds the expected sequence number
+ * @retval SoarFS_Result_t Status of the read, a bad block is not an error
+ */
+static SoarFS_Result_t SoarLog_ReaderLoad(SoarLog_Reader_t *reader, uint32_t sequence, SoarLog_BlockHeader_t *header,
+                                          bool *valid)
+{
+    *valid = false;
+
+    // Fast-seek makes the seek free, the aligned read goes straight into the buffer
+    uint32_t bytesRead = 0;
+    SoarFS_Result_t result = SoarFS_Seek(reader->handle, sequence * SOAR_LOG_BLOCK_SIZE);
+    if (result == SOAR_FS_OK)
+    {
+        result = SoarFS_Read(reader->handle, reader->block, SOAR_LOG_BLOCK_SIZE, &bytesRead);
+    }
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+    reader->blocksRead++;
+
+    memcpy(header, reader->block, SOAR_LOG_BLOCK_HEADER_SIZE);
+    if (bytesRead != SOAR_LOG_BLOCK_SIZE || header->magic != SOAR_LOG_MAGIC ||
+        header->payloadLength > SOAR_LOG_BLOCK_PAYLOAD_SIZE || header->sequence != sequence)
+    {
+        return SOAR_FS_OK;
+    }
+
+    uint32_t crc;
+    memcpy(&crc, reader->block + SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE, sizeof(crc));
+    *valid = (crc == SoarLog_Crc32(reader->block, SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE));
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Find in an index block where reading for a window must start
+ * @param sequence Block expected to be an index block
+ * @param start Receives the block of the last entry whose earlier records are all older than timestamp
+ * @param found Cleared if the block is no index block or has no such entry
+ */
+static SoarFS_Result_t SoarLog_ReaderIndexStart(SoarLog_Reader_t *reader, uint32_t sequence, uint32_t timestamp,
+                                                uint32_t *start, bool *found)
+{
+    *found = false;
+
+    SoarLog_BlockHeader_t header;
+    bool valid;
+    SoarFS_Result_t result = SoarLog_ReaderLoad(reader, sequence, &header, &valid);
+    if (result != SOAR_FS_OK || !valid || header.blockType != SOAR_LOG_BLOCK_INDEX ||
+        header.payloadLength < SOAR_LOG_INDEX_HEADER_SIZE)
+    {
+        return result;
+    }
+
+    // Entries are in block order and their timestamps never go backwards
+    const uint8_t *entries = reader->block + SOAR_LOG_BLOCK_HEADER_SIZE + SOAR_LOG_INDEX_HEADER_SIZE;
+    uint32_t low = 0;
+    uint32_t high = (header.payloadLength - SOAR_LOG_INDEX_HEADER_SIZE) / sizeof(SoarLog_IndexEntry_t);
+    while (low < high)
+    {
+        const uint32_t mid = low + (high - low) / 2;
+        SoarLog_IndexEntry_t entry;
+        memcpy(&entry, entries + mid * sizeof(entry), sizeof(entry));
+        if (entry.latest < timestamp)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    if (low > 0)
+    {
+        SoarLog_IndexEntry_t entry;
+        memcpy(&entry, entries + (low - 1) * sizeof(entry), sizeof(entry));
+        *start = entry.sequence;
+        *found = true;
+    }
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Load the next data or column block, skipping every other block
+ * @retval SoarFS_Result_t Status of operation, SOAR_FS_END_OF_FILE after the last block
+ */
+static SoarFS_Result_t SoarLog_ReaderNext(SoarLog_Reader_t *reader)
+{
+    SoarLog_ReaderRewind(reader, reader->nextSequence, reader->from);
+
+    while (reader->nextSequence < reader->blockCount)
+    {
+        SoarLog_BlockHeader_t header;
+        bool valid;
+        SoarFS_Result_t result = SoarLog_ReaderLoad(reader, reader->nextSequence++, &header, &valid);
+        if (result != SOAR_FS_OK)
+        {
+            return result;
+        }
+
+        if (valid && header.blockType == SOAR_LOG_BLOCK_DATA)
+        {
+            reader->length = header.payloadLength;
+            return SOAR_FS_OK;
+        }
+        if (valid && header.blockType == SOAR_LOG_BLOCK_COLUMNS &&
+            SoarLog_ReaderDecodeColumns(reader, header.payloadLength))
+        {
+            return SOAR_FS_OK;
+        }
+        if (!valid || header.blockType == SOAR_LOG_BLOCK_COLUMNS)
+        {
+            reader->blocksSkipped++;
+        }
+    }
+
+    return SOAR_FS_END_OF_FILE;
+}
+
+/**
+ * @brief Decode the loaded column block with the fields of SOAR_LOG_SCHEMA
+ */
+static bool SoarLog_ReaderDecodeColumns(SoarLog_Reader_t *reader, uint16_t length)
+{
+    const uint8_t *payload = reader->block + SOAR_LOG_BLOCK_HEADER_SIZE;
+    if (length < SOAR_LOG_COLUMN_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    // Fields are parsed again only when the type changes
+    if (payload[0] != reader->columnType || reader->columnType == SOAR_LOG_RECORD_NONE)
+    {
+        reader->columnType = SOAR_LOG_RECORD_NONE;
+        for (uint32_t i = 0; i < sizeof(SOAR_LOG_SCHEMA) / sizeof(SOAR_LOG_SCHEMA[0]); i++)
+        {
+            const SoarLog_SchemaEntry_t *entry = &SOAR_LOG_SCHEMA[i];
+            int32_t fieldCount = (entry->type == payload[0] && entry->length != 0)
+                                     ? SoarLog_ParseColumnFields(entry->fields, reader->fields)
+                                     : -1;
+            if (fieldCount > 0)
+            {
+                reader->columnType = entry->type;
+                reader->columnLength = entry->length;
+                reader->fieldCount = (uint8_t)fieldCount;
+                break;
+            }
+        }
+        if (reader->columnType == SOAR_LOG_RECORD_NONE)
+        {
+            return false;
+        }
+    }
+
+    uint32_t maxRecords = SOAR_LOG_READER_COLUMN_BYTES / reader->columnLength;
+    maxRecords = (maxRecords < SOAR_LOG_COLUMN_MAX_RECORDS) ? maxRecords : SOAR_LOG_COLUMN_MAX_RECORDS;
+    int32_t count = SoarLog_DecodeColumns(payload, length, reader->fields, reader->fieldCount, reader->timestamps,
+                                          reader->records, reader->columnLength, maxRecords);
+    if (count < 0)
+    {
+        return false;
+    }
+
+    reader->columnCount = (uint16_t)count;
+    return true;
+}
@@ -0,0 +1,208 @@
+/**
+ * File Name          : SoarLogRecovery.cpp
+ * Description        : Trims a SOAR log back to its last commit point after a power loss
+ * Author             : SOAR Team
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLogRecovery.hpp"
+#include "SoarLogWriter.hpp"
+#include <string.h>
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t g_recover_block[SOAR_LOG_BLOCK_SIZE] __attribute__((aligned(4)));
+
+/* Private function prototypes -----------------------------------------------*/
+static SoarFS_Result_t SoarLog_RecoverLoad(SoarFS_Handle_t handle, uint32_t sequence, SoarLog_BlockHeader_t *header,
+                                           bool *valid);
+static bool SoarLog_RecoverCommit(const SoarLog_BlockHeader_t *header, uint32_t logId, SoarLog_Commit_t *commit);
+static SoarFS_Result_t SoarLog_RecoverScan(SoarFS_Handle_t handle, uint32_t blockCount, uint32_t logId,
+                                           SoarLog_Recovery_t *stats);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Trim a log to its last valid commit point
+ */
+SoarFS_Result_t SoarLog_Recover(const char *filename, SoarLog_Recovery_t *recovery)
+{
+    SoarLog_Recovery_t stats;
+    memset(&stats, 0, sizeof(stats));
+
+    SoarFS_Handle_t handle;
+    SoarFS_Result_t result = SoarFS_Open(filename, &handle);
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+
+    uint32_t fileSize = 0;
+    result = SoarFS_Seek(handle, SOAR_FS_SEEK_END);
+    if (result == SOAR_FS_OK)
+    {
+        result = SoarFS_Tell(handle, &fileSize);
+    }
+    const uint32_t blockCount = fileSize / SOAR_LOG_BLOCK_SIZE;
+
+    // The id in the schema block tells this log's blocks from those the clusters held before
+    SoarLog_BlockHeader_t header;
+    bool valid = false;
+    if (result == SOAR_FS_OK && blockCount > 0)
+    {
+        result = SoarLog_RecoverLoad(handle, 0, &header, &valid);
+        stats.blocksScanned++;
+    }
+
+    if (result == SOAR_FS_OK && valid && header.blockType == SOAR_LOG_BLOCK_SCHEMA)
+    {
+        if (header.version < 2)
+        {
+            // No commit points to go by, the size f_sync left is all there is
+            stats.blocksKept = blockCount;
+        }
+        else
+        {
+            uint32_t logId;
+            memcpy(&logId, g_recover_block + SOAR_LOG_BLOCK_HEADER_SIZE, sizeof(logId));
+            result = SoarLog_RecoverScan(handle, blockCount, logId, &stats);
+        }
+    }
+
+    // A partial tail block goes too
+    if (result == SOAR_FS_OK && stats.blocksKept * SOAR_LOG_BLOCK_SIZE < fileSize)
+    {
+        stats.blocksDiscarded = blockCount - stats.blocksKept;
+        result = SoarFS_Seek(handle, stats.blocksKept * SOAR_LOG_BLOCK_SIZE);
+        if (result == SOAR_FS_OK)
+        {
+            result = SoarFS_Truncate(handle);
+        }
+    }
+
+    SoarFS_Result_t closeResult = SoarFS_Close(handle);
+    if (result == SOAR_FS_OK)
+    {
+        result = closeResult;
+    }
+
+    if (recovery != NULL)
+    {
+        *recovery = stats;
+    }
+    return result;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Read one block into g_recover_block and check its framing, sequence and CRC
+ */
+static SoarFS_Result_t SoarLog_RecoverLoad(SoarFS_Handle_t handle, uint32_t sequence, SoarLog_BlockHeader_t *header,
+                                           bool *valid)
+{
+    *valid = false;
+
+    uint32_t bytesRead = 0;
+    SoarFS_Result_t result = SoarFS_Seek(handle, sequence * SOAR_LOG_BLOCK_SIZE);
+    if (result == SOAR_FS_OK)
+    {
+        result = SoarFS_Read(handle, g_recover_block, SOAR_LOG_BLOCK_SIZE, &bytesRead);
+    }
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+
+    memcpy(header, g_recover_block, SOAR_LOG_BLOCK_HEADER_SIZE);
+    if (bytesRead != SOAR_LOG_BLOCK_SIZE || header->magic != SOAR_LOG_MAGIC ||
+        header->payloadLength > SOAR_LOG_BLOCK_PAYLOAD_SIZE || header->sequence != sequence)
+    {
+        return SOAR_FS_OK;
+    }
+
+    uint32_t crc;
+    memcpy(&crc, g_recover_block + SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE, sizeof(crc));
+    *valid = (crc == SoarLog_Crc32(g_recover_block, SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE));
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Whether the valid block in g_recover_block is a commit point of the log
+ */
+static bool SoarLog_RecoverCommit(const SoarLog_BlockHeader_t *header, uint32_t logId, SoarLog_Commit_t *commit)
+{
+    if (!SoarLog_IsCommitPoint(header->blockType) || header->payloadLength < SOAR_LOG_COMMIT_SIZE)
+    {
+        return false;
+    }
+
+    memcpy(commit, g_recover_block + SOAR_LOG_BLOCK_HEADER_SIZE, SOAR_LOG_COMMIT_SIZE);
+    return commit->logId == logId;
+}
+
+/**
+ * @brief Find the last valid commit point after the schema block, from the footer or by chaining every block
+ */
+static SoarFS_Result_t SoarLog_RecoverScan(SoarFS_Handle_t handle, uint32_t blockCount, uint32_t logId,
+                                           SoarLog_Recovery_t *stats)
+{
+    uint32_t chain = SoarLog_ChainBlock(SoarLog_ChainSeed(logId), g_recover_block);
+    SoarLog_BlockHeader_t header;
+    SoarLog_Commit_t commit;
+    bool valid;
+
+    // Nothing after the schema block is committed yet, the log is kept empty
+    stats->blocksKept = 1;
+
+    // A closed log ends in its footer, a recovered one in a commit block. The tail of an
+    // open reservation holds stale data, a commit point there is never this log's.
+    if (blockCount > 1)
+    {
+        SoarFS_Result_t result = SoarLog_RecoverLoad(handle, blockCount - 1, &header, &valid);
+        stats->blocksScanned++;
+        if (result != SOAR_FS_OK)
+        {
+            return result;
+        }
+        if (valid && SoarLog_RecoverCommit(&header, logId, &commit))
+        {
+            stats->closed = true;
+            stats->blocksKept = blockCount;
+            stats->latest = commit.latest;
+            return SOAR_FS_OK;
+        }
+    }
+
+    for (uint32_t sequence = 1; sequence < blockCount; sequence++)
+    {
+        SoarFS_Result_t result = SoarLog_RecoverLoad(handle, sequence, &header, &valid);
+        stats->blocksScanned++;
+        if (result != SOAR_FS_OK)
+        {
+            return result;
+        }
+        if (!valid)
+        {
+            break;
+        }
+
+        if (SoarLog_IsCommitPoint(header.blockType))
+        {
+            // Another log's commit point, or one written before all blocks it covers made it
+            if (!SoarLog_RecoverCommit(&header, logId, &commit) || commit.chain != chain)
+            {
+                break;
+            }
+            stats->blocksKept = sequence + 1;
+            stats->latest = commit.latest;
+            chain = SoarLog_ChainSeed(logId);
+        }
+        else
+        {
+            chain = SoarLog_ChainBlock(chain, g_recover_block);
+        }
+    }
+
+    return SOAR_FS_OK;
+}
@@ -0,0 +1,542 @@
+/**
+ * File Name          : SoarLogWriter.cpp
+ * Description        : Framed binary flight log writer, see SoarLogFormat.hpp
+ * Author             : SOAR Team
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLogWriter.hpp"
+#include "SystemDefines.hpp"
+#include "stm32g4xx_hal.h"
+#include <string.h>
+
+/* Private variables ---------------------------------------------------------*/
+// Schema, index and commit blocks are built here, keeping a writer's buffered records intact
+static uint8_t g_side_block[SOAR_LOG_BLOCK_SIZE] __attribute__((aligned(4)));
+static uint32_t g_logs_started = 0; // Mixed into log ids, two logs begun in the same tick still differ
+
+/* Private function prototypes -----------------------------------------------*/
+static SoarFS_Result_t SoarLog_Attach(SoarLog_Writer_t *writer, const SoarFS_SyncPolicy_t *policy);
+static void SoarLog_BeginBlock(SoarLog_Writer_t *writer);
+static SoarFS_Result_t SoarLog_WriteBlock(SoarLog_Writer_t *writer, uint8_t *block, uint8_t blockType, uint16_t used);
+static SoarFS_Result_t SoarLog_WriteSchema(SoarLog_Writer_t *writer);
+static SoarFS_Result_t SoarLog_WriteIndex(SoarLog_Writer_t *writer);
+static SoarFS_Result_t SoarLog_WriteCommit(SoarLog_Writer_t *writer);
+static void SoarLog_ResetIndex(SoarLog_Writer_t *writer);
+static void SoarLog_NewId(SoarLog_Writer_t *writer);
+static void SoarLog_ReadId(SoarLog_Writer_t *writer);
+static void SoarLog_IndexBlock(SoarLog_Writer_t *writer, const uint8_t *block, uint8_t blockType, uint16_t used);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief Open a log for appending, creating it with a schema block if it does not exist
+ */
+SoarFS_Result_t SoarLog_Open(SoarLog_Writer_t *writer, const char *filename)
+{
+    return SoarLog_OpenAppender(writer, filename, NULL);
+}
+
+/**
+ * @brief Open a log as a write-behind appender, creating it with a schema block if it does not exist
+ */
+SoarFS_Result_t SoarLog_OpenAppender(SoarLog_Writer_t *writer, const char *filename, const SoarFS_SyncPolicy_t *policy)
+{
+    if (writer == NULL || filename == NULL || strlen(filename) >= SOAR_FS_MAX_FILENAME_LEN)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    memset(writer, 0, sizeof(SoarLog_Writer_t));
+    strcpy(writer->filename, filename);
+    SoarLog_BeginBlock(writer);
+
+    return SoarLog_Attach(writer, policy);
+}
+
+/**
+ * @brief Start a log in an open, empty file, records buffered in the writer continue in it
+ */
+SoarFS_Result_t SoarLog_Begin(SoarLog_Writer_t *writer, const char *filename, SoarFS_Handle_t handle)
+{
+    if (writer == NULL || writer->isOpen || filename == NULL || strlen(filename) >= SOAR_FS_MAX_FILENAME_LEN)
+    {
+        SoarFS_Close(handle);
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    strcpy(writer->filename, filename);
+    writer->handle = handle;
+    writer->isOpen = true;
+    writer->sequence = 0;
+    SoarLog_ResetIndex(writer);
+    SoarLog_NewId(writer);
+
+    SoarFS_Result_t result = SoarLog_WriteSchema(writer);
+    if (result != SOAR_FS_OK)
+    {
+        SoarFS_Close(writer->handle);
+        SoarLog_Detach(writer);
+    }
+    return result;
+}
+
+/**
+ * @brief Forget the file of a log whose media is gone, keeping buffered records
+ */
+void SoarLog_Detach(SoarLog_Writer_t *writer)
+{
+    if (writer != NULL)
+    {
+        writer->isOpen = false;
+        writer->handle = SOAR_FS_NULL_HANDLE;
+    }
+}
+
+/**
+ * @brief Reopen a detached log, buffered records continue in the next block
+ */
+SoarFS_Result_t SoarLog_Reattach(SoarLog_Writer_t *writer, const SoarFS_SyncPolicy_t *policy)
+{
+    if (writer == NULL || writer->isOpen || writer->filename[0] == '\0')
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    return SoarLog_Attach(writer, policy);
+}
+
+/**
+ * @brief Append one record, writing the current block out first if it does not fit
+ */
+SoarFS_Result_t SoarLog_Append(SoarLog_Writer_t *writer, uint8_t type, uint32_t timestamp, const void *payload,
+                               uint8_t length)
+{
+    if (writer == NULL || !writer->isOpen || (payload == NULL && length > 0))
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    const uint32_t recordSize = SOAR_LOG_RECORD_HEADER_SIZE + length;
+    if (writer->used + recordSize > SOAR_LOG_BLOCK_PAYLOAD_SIZE)
+    {
+        SoarFS_Result_t result = SoarLog_Flush(writer);
+        if (result != SOAR_FS_OK)
+        {
+            return result;
+        }
+    }
+
+    SoarLog_RecordHeader_t header;
+    header.type = type;
+    header.length = length;
+    header.timestamp = timestamp;
+
+    uint8_t *dst = writer->block + SOAR_LOG_BLOCK_HEADER_SIZE + writer->used;
+    memcpy(dst, &header, SOAR_LOG_RECORD_HEADER_SIZE);
+    memcpy(dst + SOAR_LOG_RECORD_HEADER_SIZE, payload, length);
+    writer->used += recordSize;
+    writer->recordsWritten++;
+
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Write the buffered records out, then a block of another type built in place
+ */
+SoarFS_Result_t SoarLog_AppendBlock(SoarLog_Writer_t *writer, uint8_t blockType, SoarLog_PayloadBuilder_t build,
+                                    void *context)
+{
+    if (build == NULL)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    SoarFS_Result_t result = SoarLog_Flush(writer);
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+
+    // The flushed block buffer is empty and zeroed, the payload is built straight into it
+    uint16_t used = build(writer->block + SOAR_LOG_BLOCK_HEADER_SIZE, context);
+    result = SoarLog_WriteBlock(writer, writer->block, blockType, used);
+
+    // Never leave it buffered as if it held records, the builder's owner keeps what failed
+    SoarLog_BeginBlock(writer);
+    return result;
+}
+
+/**
+ * @brief Write the partially filled block out, later records start a new block
+ */
+SoarFS_Result_t SoarLog_Flush(SoarLog_Writer_t *writer)
+{
+    if (writer == NULL || !writer->isOpen)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    if (writer->used == 0)
+    {
+        return SOAR_FS_OK;
+    }
+
+    // On failure the records stay buffered, so a retry after SoarLog_Reattach still writes them
+    SoarFS_Result_t result = SoarLog_WriteBlock(writer, writer->block, SOAR_LOG_BLOCK_DATA, writer->used);
+    if (result == SOAR_FS_OK)
+    {
+        SoarLog_BeginBlock(writer);
+    }
+    return result;
+}
+
+/**
+ * @brief Flush the current block and commit every written block and the file size to the storage
+ */
+SoarFS_Result_t SoarLog_Checkpoint(SoarLog_Writer_t *writer)
+{
+    SoarFS_Result_t result = SoarLog_Flush(writer);
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+
+    return SoarFS_Flush(writer->handle);
+}
+
+/**
+ * @brief Flush the current block, write a commit point and flush the data sectors
+ */
+SoarFS_Result_t SoarLog_Commit(SoarLog_Writer_t *writer)
+{
+    SoarFS_Result_t result = SoarLog_Flush(writer);
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+
+    // Nothing written since the last commit point, e.g. the index slot just went out
+    if (writer->chain != SoarLog_ChainSeed(writer->logId))
+    {
+        result = SoarLog_IsIndexSlot(writer->sequence) ? SoarLog_WriteIndex(writer) : SoarLog_WriteCommit(writer);
+        if (result != SOAR_FS_OK)
+        {
+            return result;
+        }
+    }
+
+    return SoarFS_FlushData(writer->handle);
+}
+
+/**
+ * @brief Flush, write the index footer and close the log
+ */
+SoarFS_Result_t SoarLog_Close(SoarLog_Writer_t *writer)
+{
+    if (writer == NULL || !writer->isOpen)
+    {
+        return SOAR_FS_INVALID_PARAMETER;
+    }
+
+    // The footer is always the last block, readers find the newest entries without a search
+    SoarFS_Result_t result = SoarLog_Flush(writer);
+    if (result == SOAR_FS_OK)
+    {
+        result = SoarLog_WriteIndex(writer);
+    }
+    SoarFS_Close(writer->handle);
+    SoarLog_Detach(writer);
+    return result;
+}
+
+/**
+ * @brief Size of the log once more record blocks and the footer are written
+ */
+uint32_t SoarLog_ClosedSize(const SoarLog_Writer_t *writer, uint32_t blocks)
+{
+    uint32_t sequence = writer->sequence;
+    for (uint32_t i = 0; i < blocks; i++)
+    {
+        sequence += SoarLog_IsIndexSlot(sequence) ? 2 : 1;
+    }
+    return (sequence + 1) * SOAR_LOG_BLOCK_SIZE;
+}
+
+/**
+ * @brief CRC-32/MPEG-2 of a buffer, on the CRC peripheral when available
+ */
+uint32_t SoarLog_Crc32(const uint8_t *data, uint32_t length)
+{
+#ifdef COMPUTER_ENVIRONMENT
+    return SoarLog_Crc32Software(SOAR_LOG_CRC_INIT, data, length);
+#else
+    // hcrc is configured for byte input with the default polynomial and init value,
+    // which is bit identical to SoarLog_Crc32Software. Only the file system task uses it.
+    return HAL_CRC_Calculate(SystemHandles::CRC_Handle, (uint32_t *)data, length);
+#endif
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Open the writer's file, creating it with a schema block if it does not
+ * exist, and continue the block numbering after its last block
+ */
+static SoarFS_Result_t SoarLog_Attach(SoarLog_Writer_t *writer, const SoarFS_SyncPolicy_t *policy)
+{
+    bool created = false;
+    if (!SoarFS_FileExists(writer->filename))
+    {
+        const uint8_t empty[1] = {0};
+        SoarFS_Result_t result = SoarFS_CreateFile(writer->filename, empty, 0);
+        if (result != SOAR_FS_OK)
+        {
+            return result;
+        }
+        created = true;
+    }
+    else
+    {
+        // Before the file is opened for writing, a file is only open once
+        SoarLog_ReadId(writer);
+    }
+
+    SoarFS_Result_t result = (policy != NULL) ? SoarFS_OpenAppender(writer->filename, policy, &writer->handle)
+                                              : SoarFS_Open(writer->filename, &writer->handle);
+    if (result != SOAR_FS_OK)
+    {
+        return result;
+    }
+    writer->isOpen = true;
+
+    if (created)
+    {
+        writer->sequence = 0;
+        SoarLog_ResetIndex(writer);
+        SoarLog_NewId(writer);
+        result = SoarLog_WriteSchema(writer);
+        if (result != SOAR_FS_OK)
+        {
+            SoarFS_Close(writer->handle);
+            SoarLog_Detach(writer);
+            return result;
+        }
+    }
+    else
+    {
+        // Continue the block numbering, a torn tail block is skipped by readers
+        uint32_t fileSize = 0;
+        SoarFS_GetFileSize(writer->filename, &fileSize);
+        writer->sequence = (fileSize + SOAR_LOG_BLOCK_SIZE - 1) / SOAR_LOG_BLOCK_SIZE;
+    }
+
+    return SOAR_FS_OK;
+}
+
+/**
+ * @brief Clear the block buffer for the next data block
+ */
+static void SoarLog_BeginBlock(SoarLog_Writer_t *writer)
+{
+    memset(writer->block, 0, SOAR_LOG_BLOCK_SIZE);
+    writer->used = 0;
+}
+
+/**
+ * @brief Seal a block with its header and CRC and append it to the file
+ */
+static SoarFS_Result_t SoarLog_WriteBlock(SoarLog_Writer_t *writer, uint8_t *block, uint8_t blockType, uint16_t used)
+{
+    // Any other block due in an index slot goes after the slot's index block
+    const bool records = (blockType == SOAR_LOG_BLOCK_DATA || blockType == SOAR_LOG_BLOCK_COLUMNS);
+    if (blockType != SOAR_LOG_BLOCK_INDEX && SoarLog_IsIndexSlot(writer->sequence))
+    {
+        SoarFS_Result_t result = SoarLog_WriteIndex(writer);
+        if (result != SOAR_FS_OK)
+        {
+            return result;
+        }
+    }
+
+    // Header is filled in last, so the sequence is right even if the file was reopened meanwhile
+    SoarLog_BlockHeader_t header;
+    header.magic = SOAR_LOG_MAGIC;
+    header.version = SOAR_LOG_VERSION;
+    header.blockType = blockType;
+    header.payloadLength = used;
+    header.sequence = writer->sequence;
+    memcpy(block, &header, SOAR_LOG_BLOCK_HEADER_SIZE);
+
+    // Likewise the chain, an index slot written just above restarted it
+    if (SoarLog_IsCommitPoint(blockType))
+    {
+        SoarLog_Commit_t commit;
+        commit.latest = writer->latest;
+        commit.logId = writer->logId;
+        commit.chain = writer->chain;
+        memcpy(block + SOAR_LOG_BLOCK_HEADER_SIZE, &commit, SOAR_LOG_COMMIT_SIZE);
+    }
+
+    uint32_t crc = SoarLog_Crc32(block, SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE);
+    memcpy(block + SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE, &crc, SOAR_LOG_BLOCK_CRC_SIZE);
+
+    // Appenders always append and commit per their policy, plain handles are moved to the end and synced
+    SoarFS_Result_t result = SOAR_FS_OK;
+    bool appender = SoarFS_IsAppender(writer->handle);
+    if (!appender)
+    {
+        result = SoarFS_Seek(writer->handle, SOAR_FS_SEEK_END);
+    }
+    if (result == SOAR_FS_OK)
+    {
+        result = SoarFS_Write(writer->handle, block, SOAR_LOG_BLOCK_SIZE);
+    }
+    if (result == SOAR_FS_OK && !appender)
+    {
+        result = SoarFS_Sync(writer->handle);
+    }
+
+    if (result == SOAR_FS_OK)
+    {
+        if (records)
+        {
+            SoarLog_IndexBlock(writer, block, blockType, used);
+        }
+        writer->chain = SoarLog_IsCommitPoint(blockType) ? SoarLog_ChainSeed(writer->logId)
+                                                         : SoarLog_ChainBlock(writer->chain, block);
+        writer->sequence++;
+        writer->blocksWritten++;
+    }
+    return result;
+}
+
+/**
+ * @brief Write the schema block describing every record type in SOAR_LOG_SCHEMA
+ */
+static SoarFS_Result_t SoarLog_WriteSchema(SoarLog_Writer_t *writer)
+{
+    memset(g_side_block, 0, sizeof(g_side_block));
+
+    uint8_t *payload = g_side_block + SOAR_LOG_BLOCK_HEADER_SIZE;
+    memcpy(payload, &writer->logId, SOAR_LOG_SCHEMA_ID_SIZE);
+    uint16_t used = SOAR_LOG_SCHEMA_ID_SIZE;
+    for (uint32_t i = 0; i < sizeof(SOAR_LOG_SCHEMA) / sizeof(SOAR_LOG_SCHEMA[0]); i++)
+    {
+        const SoarLog_SchemaEntry_t *entry = &SOAR_LOG_SCHEMA[i];
+        uint32_t nameLen = strlen(entry->name) + 1;
+        uint32_t fieldsLen = strlen(entry->fields) + 1;
+
+        SOAR_ASSERT(used + 2 + nameLen + fieldsLen <= SOAR_LOG_BLOCK_PAYLOAD_SIZE,
+                    "SoarLog schema does not fit in one block");
+
+        payload[used++] = entry->type;
+        payload[used++] = entry->length;
+        memcpy(payload + used, entry->name, nameLen);
+        used += nameLen;
+        memcpy(payload + used, entry->fields, fieldsLen);
+        used += fieldsLen;
+    }
+
+    return SoarLog_WriteBlock(writer, g_side_block, SOAR_LOG_BLOCK_SCHEMA, used);
+}
+
+/**
+ * @brief Write the pending index entries as an index block, in a slot or as the footer
+ */
+static SoarFS_Result_t SoarLog_WriteIndex(SoarLog_Writer_t *writer)
+{
+    memset(g_side_block, 0, sizeof(g_side_block));
+
+    // SoarLog_WriteBlock fills in the commit header
+    uint8_t *payload = g_side_block + SOAR_LOG_BLOCK_HEADER_SIZE;
+    memcpy(payload + SOAR_LOG_INDEX_HEADER_SIZE, writer->index, writer->indexCount * sizeof(SoarLog_IndexEntry_t));
+    uint16_t used = SOAR_LOG_INDEX_HEADER_SIZE + writer->indexCount * sizeof(SoarLog_IndexEntry_t);
+
+    SoarFS_Result_t result = SoarLog_WriteBlock(writer, g_side_block, SOAR_LOG_BLOCK_INDEX, used);
+    if (result == SOAR_FS_OK)
+    {
+        writer->indexCount = 0;
+    }
+    return result;
+}
+
+/**
+ * @brief Write a commit block, its payload is only the commit header SoarLog_WriteBlock fills in
+ */
+static SoarFS_Result_t SoarLog_WriteCommit(SoarLog_Writer_t *writer)
+{
+    memset(g_side_block, 0, sizeof(g_side_block));
+    return SoarLog_WriteBlock(writer, g_side_block, SOAR_LOG_BLOCK_COMMIT, SOAR_LOG_COMMIT_SIZE);
+}
+
+/**
+ * @brief Forget the index of the previous file, block numbering starts over
+ */
+static void SoarLog_ResetIndex(SoarLog_Writer_t *writer)
+{
+    writer->latest = 0;
+    writer->indexCount = 0;
+}
+
+/**
+ * @brief Account a record block just written at writer->sequence in the time index
+ */
+static void SoarLog_IndexBlock(SoarLog_Writer_t *writer, const uint8_t *block, uint8_t blockType, uint16_t used)
+{
+    // One entry per interval, for the first record block in it
+    const SoarLog_IndexEntry_t *last = (writer->indexCount > 0) ? &writer->index[writer->indexCount - 1] : NULL;
+    if ((last == NULL || last->sequence / SOAR_LOG_INDEX_INTERVAL != writer->sequence / SOAR_LOG_INDEX_INTERVAL) &&
+        writer->indexCount < SOAR_LOG_INDEX_ENTRIES)
+    {
+        writer->index[writer->indexCount].sequence = writer->sequence;
+        writer->index[writer->indexCount].latest = writer->latest;
+        writer->indexCount++;
+    }
+
+    uint32_t latest;
+    if (SoarLog_BlockLatest(blockType, block + SOAR_LOG_BLOCK_HEADER_SIZE, used, &latest) && latest > writer->latest)
+    {
+        writer->latest = latest;
+    }
+}
+
+/**
+ * @brief Give a log about to be started a new id, so no block of an earlier log passes for one of it
+ */
+static void SoarLog_NewId(SoarLog_Writer_t *writer)
+{
+    const uint32_t salt[2] = {HAL_GetTick(), ++g_logs_started};
+    uint32_t id = SoarLog_Crc32Software(SOAR_LOG_CRC_INIT, (const uint8_t *)writer->filename, strlen(writer->filename));
+    writer->logId = SoarLog_Crc32Software(id, (const uint8_t *)salt, sizeof(salt));
+    writer->chain = SoarLog_ChainSeed(writer->logId);
+}
+
+/**
+ * @brief Take the id of an existing log from its schema block, 0 for a version 1 log
+ */
+static void SoarLog_ReadId(SoarLog_Writer_t *writer)
+{
+    writer->logId = 0;
+
+    SoarFS_Handle_t handle;
+    if (SoarFS_OpenReader(writer->filename, &handle) == SOAR_FS_OK)
+    {
+        uint32_t bytesRead = 0;
+        SoarLog_BlockHeader_t header;
+        if (SoarFS_Read(handle, g_side_block, SOAR_LOG_BLOCK_SIZE, &bytesRead) == SOAR_FS_OK &&
+            bytesRead == SOAR_LOG_BLOCK_SIZE)
+        {
+            memcpy(&header, g_side_block, SOAR_LOG_BLOCK_HEADER_SIZE);
+            if (header.magic == SOAR_LOG_MAGIC && header.version >= 2 && header.blockType == SOAR_LOG_BLOCK_SCHEMA)
+            {
+                memcpy(&writer->logId, g_side_block + SOAR_LOG_BLOCK_HEADER_SIZE, SOAR_LOG_SCHEMA_ID_SIZE);
+            }
+        }
+        SoarFS_Close(handle);
+    }
+
+    // Blocks after the last commit point of the earlier session are not in the chain, see SoarLog_Recover
+    writer->chain = SoarLog_ChainSeed(writer->logId);
+}
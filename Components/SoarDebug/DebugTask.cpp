@@ -9,12 +9,19 @@
 #include <SoarDebug/Inc/DebugTask.hpp>
 #include "Command.hpp"
 #include "CubeUtils.hpp"
+#include "StaticAllocation.hpp"
+#include "RunTimeStats.hpp"
+#include "CommandPayloadPool.hpp"
 #include <cstring>
 
 #include "stm32g4xx_hal.h"
+#ifdef COMPUTER_ENVIRONMENT
+#include "HostConsole.hpp"
+#endif
 
 // External Tasks (to send debug commands to)
 #include "FileSystemTask.hpp"
+#include "SoarFileSystemExample.hpp"
 
 /* Macros --------------------------------------------------------------------*/
 
@@ -38,6 +45,7 @@ DebugTask::DebugTask()
   memset(debugBuffer, 0, sizeof(debugBuffer));
   debugMsgIdx = 0;
   isDebugMsgReady = false;
+  topActive = false;
 }
 
 /**
@@ -49,6 +57,16 @@ void DebugTask::InitTask()
   SOAR_ASSERT(rtTaskHandle == nullptr, "Cannot initialize Debug task twice");
 
   // Start the task
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+  static StaticTaskStorage<TASK_DEBUG_STACK_DEPTH_WORDS> taskStorage;
+  rtTaskHandle = taskStorage.Create((TaskFunction_t)DebugTask::RunTask,
+                                    (const char *)"DebugTask", (void *)this,
+                                    (UBaseType_t)TASK_DEBUG_PRIORITY);
+
+  // Ensure creation succeded
+  SOAR_ASSERT(rtTaskHandle != nullptr,
+              "DebugTask::InitTask - xTaskCreateStatic() failed");
+#else
   BaseType_t rtValue = xTaskCreate(
       (TaskFunction_t)DebugTask::RunTask, (const char *)"DebugTask",
       (uint16_t)TASK_DEBUG_STACK_DEPTH_WORDS, (void *)this,
@@ -56,6 +74,7 @@ void DebugTask::InitTask()
 
   // Ensure creation succeded
   SOAR_ASSERT(rtValue == pdPASS, "DebugTask::InitTask - xTaskCreate() failed");
+#endif
 }
 
 // TODO: Only run thread when appropriate GPIO pin pulled HIGH (or by define)
@@ -71,8 +90,20 @@ void DebugTask::Run(void *pvParams)
   {
     Command cm;
 
-    // Wait forever for a command
-    qEvtQueue->ReceiveWait(cm);
+    if (topActive)
+    {
+      // Refresh top whenever no command arrives in time
+      if (!qEvtQueue->Receive(cm, DEBUG_TOP_REFRESH_MS))
+      {
+        RunTimeStats::PrintTop();
+        continue;
+      }
+    }
+    else
+    {
+      // Wait forever for a command
+      qEvtQueue->ReceiveWait(cm);
+    }
 
     // Process the command
     if (cm.GetCommand() == DATA_COMMAND &&
@@ -110,7 +141,83 @@ void DebugTask::HandleDebugMessage(const char *msg)
     SOAR_PRINT("Debug: Triggering file system cleanup\n");
     FileSystemTask::Inst().TriggerCleanup();
   }
+  else if (strcmp(msg, "fs_ring") == 0)
+  {
+    FileSystemTask::Inst().PrintTelemetryStats();
+  }
+  else if (strcmp(msg, "fs_batch") == 0)
+  {
+    FileSystemTask::Inst().PrintBatchStats();
+  }
+  else if (strcmp(msg, "fs_ops") == 0)
+  {
+    FileSystemTask::Inst().PrintOpStats();
+  }
+  else if (strcmp(msg, "fs_ops_log") == 0)
+  {
+    SOAR_PRINT("Debug: Writing file system operation counters to the sensor log\n");
+    FileSystemTask::Inst().TriggerOpStatsLog();
+  }
+  else if (strcmp(msg, "fs_ops_reset") == 0)
+  {
+    SoarFS_ResetStats();
+  }
+  else if (strcmp(msg, "fs_jobs") == 0)
+  {
+    FileSystemTask::Inst().PrintJobStats();
+  }
+  else if (strcmp(msg, "fs_bench") == 0)
+  {
+    SOAR_PRINT("Debug: Triggering file system benchmarks\n");
+    FileSystemTask::Inst().TriggerBenchmark();
+  }
+  else if (strcmp(msg, "fs_sweep") == 0)
+  {
+    SOAR_PRINT("Debug: Triggering file system parameter sweep\n");
+    FileSystemTask::Inst().TriggerSweep(false);
+  }
+  else if (strcmp(msg, "fs_sweep_format") == 0)
+  {
+    SOAR_PRINT("Debug: Triggering file system parameter sweep with reformats\n");
+    FileSystemTask::Inst().TriggerSweep(true);
+  }
+  else if (strcmp(msg, "fs_async") == 0)
+  {
+    SOAR_PRINT("Debug: Running pipelined async file requests\n");
+    SoarFS_Example_AsyncPipeline();
+  }
   //-- SYSTEM / CHAR COMMANDS -- (Must be last)
+  else if (strcmp(msg, "top") == 0)
+  {
+    // The first refresh covers the time since the last one, or since boot
+    topActive = !topActive;
+    if (topActive)
+    {
+      RunTimeStats::PrintTop();
+    }
+    else
+    {
+      SOAR_PRINT("Debug: top stopped\n");
+    }
+  }
+  else if (strcmp(msg, "stack") == 0)
+  {
+    if (RunTimeStats::CheckStackBudgets() == 0)
+    {
+      SOAR_PRINT("Debug: every task within its stack budget\n");
+    }
+  }
+  else if (strcmp(msg, "pools") == 0)
+  {
+    ObjectPool_PrintHeader();
+    ObjectPool_PrintStats("CommandPayload", CommandPayloadPool::Stats());
+    FileSystemTask::Inst().PrintPoolStats();
+  }
+  else if (strcmp(msg, "pool_bench") == 0)
+  {
+    // Runs on this task, the queue round trips never block
+    CommandPayloadPool::Benchmark();
+  }
   else if (strcmp(msg, "sysreset") == 0)
   {
     // Reset the system
@@ -123,6 +230,9 @@ void DebugTask::HandleDebugMessage(const char *msg)
     SOAR_PRINT("Current System Free Heap: %d Bytes\n", xPortGetFreeHeapSize());
     SOAR_PRINT("Lowest Ever Free Heap: %d Bytes\n",
                xPortGetMinimumEverFreeHeapSize());
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    SOAR_PRINT("Static RTOS Storage: %lu Bytes\n", StaticAllocation::Bytes());
+#endif
     SOAR_PRINT("Debug Task Runtime  \t: %d ms\n\n",
                TICKS_TO_MS(xTaskGetTickCount()));
   }
@@ -135,9 +245,23 @@ void DebugTask::HandleDebugMessage(const char *msg)
       SOAR_PRINT("\n-- DEBUG COMMANDS --\n");
       SOAR_PRINT("sysinfo  - System information\n");
       SOAR_PRINT("sysreset - System reset\n");
+      SOAR_PRINT("top      - Task CPU, state, priority, free stack bytes and switches, 'top' again stops\n");
+      SOAR_PRINT("stack    - Deepest stack use against the Tools/StackBudget budgets\n");
+      SOAR_PRINT("pools    - Object pool usage, high water marks and exhaustion\n");
+      SOAR_PRINT("pool_bench - Command round trip latency with heap and pooled payloads\n");
       SOAR_PRINT("fs_test  - Run file system tests\n");
       SOAR_PRINT("fs_log   - Log sample sensor data\n");
       SOAR_PRINT("fs_cleanup - Run file system cleanup\n");
+      SOAR_PRINT("fs_ring  - Telemetry ring statistics\n");
+      SOAR_PRINT("fs_batch - Command batching statistics\n");
+      SOAR_PRINT("fs_ops   - File system operation latencies\n");
+      SOAR_PRINT("fs_ops_log - Write them to the sensor log\n");
+      SOAR_PRINT("fs_ops_reset - Zero them\n");
+      SOAR_PRINT("fs_jobs  - Periodic job latency, jitter and deadline misses\n");
+      SOAR_PRINT("fs_bench - Run file system benchmarks\n");
+      SOAR_PRINT("fs_sweep - Sweep record size, files and sync policy, CSV BENCH lines\n");
+      SOAR_PRINT("fs_sweep_format - Also sweep cluster sizes, erases the RAM disk or image\n");
+      SOAR_PRINT("fs_async - Run pipelined async file requests\n");
       SOAR_PRINT("h        - Show this help\n\n");
       break;
     default:
@@ -154,7 +278,14 @@ void DebugTask::HandleDebugMessage(const char *msg)
 /**
  * @brief Receive data, currently receives by arming interrupt
  */
-bool DebugTask::ReceiveData() { return kUart_->ReceiveIT(&debugRxChar, this); }
+bool DebugTask::ReceiveData() {
+#ifdef COMPUTER_ENVIRONMENT
+  // The host build has no UART peripheral, stdin stands in for it
+  return HostConsole::Inst().ReceiveIT(&debugRxChar, this);
+#else
+  return kUart_->ReceiveIT(&debugRxChar, this);
+#endif
+}
 
 /**
  * @brief Receive data to the buffer
@@ -19,6 +19,7 @@ enum DEBUG_TASK_COMMANDS {
 
 /* Macros ------------------------------------------------------------------*/
 constexpr uint16_t DEBUG_RX_BUFFER_SZ_BYTES = 16;
+constexpr uint32_t DEBUG_TOP_REFRESH_MS = 2000;  // Under the ~4.3 s host run time stats wrap, see RunTimeStats.hpp
 
 /* Class ------------------------------------------------------------------*/
 class DebugTask : public Task, public UARTReceiverBase {
@@ -56,6 +57,8 @@ class DebugTask : public Task, public UARTReceiverBase {
 
   uint8_t debugRxChar;  // Character received from UART Interrupt
 
+  bool topActive;  // Printing task statistics every DEBUG_TOP_REFRESH_MS
+
   UARTDriver* const kUart_;  // UART Driver
 
  private:
@@ -0,0 +1,144 @@
+/**
+ ******************************************************************************
+ * File Name          : CommandPayloadPool.cpp
+ * Description        : Pooled Command payloads in place of Command's heap copies
+ * Author             : SOAR Team
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "CommandPayloadPool.hpp"
+#include "CycleCounter.hpp"
+#include "StaticAllocation.hpp"
+#include "SystemDefines.hpp"
+#include "queue.h"
+#include <string.h>
+
+/* Private Types -------------------------------------------------------------*/
+struct CommandPayloadBlock
+{
+    uint8_t bytes[COMMAND_PAYLOAD_BLOCK_BYTES];
+};
+
+/* Private Variables ---------------------------------------------------------*/
+static ObjectPool<CommandPayloadBlock, COMMAND_PAYLOAD_POOL_DEPTH, OBJECT_POOL_HEAP> g_payloads;
+
+static const uint16_t COMMAND_PAYLOAD_BENCH_SIZES[] = {8, 32, COMMAND_PAYLOAD_BLOCK_BYTES};
+
+/* Private Function Prototypes -----------------------------------------------*/
+static bool CommandPayloadPool_BenchRun(QueueHandle_t queue, bool pooled, uint16_t size);
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief Copy a payload into a pool block and attach it to the command
+ */
+bool CommandPayloadPool::Attach(Command &cm, const uint8_t *data, uint16_t size)
+{
+    if (size > COMMAND_PAYLOAD_BLOCK_BYTES)
+    {
+        return false;
+    }
+
+    CommandPayloadBlock *block = g_payloads.Allocate();
+    if (block == nullptr)
+    {
+        return false;
+    }
+
+    memcpy(block->bytes, data, size);
+    cm.SetCommandToStaticExternalBuffer(block->bytes, size);
+    return true;
+}
+
+/**
+ * @brief Give the payload of a command filled by Attach() back, call before cm.Reset()
+ */
+void CommandPayloadPool::Release(Command &cm)
+{
+    g_payloads.Free((CommandPayloadBlock *)(void *)cm.GetDataPointer());
+}
+
+ObjectPoolStats CommandPayloadPool::Stats()
+{
+    return g_payloads.Stats();
+}
+
+void CommandPayloadPool::ResetStats()
+{
+    g_payloads.ResetStats();
+}
+
+/**
+ * @brief Time Commands through a queue and back with heap copied and pooled payloads
+ */
+void CommandPayloadPool::Benchmark()
+{
+    // One slot, every Command is taken back out before the next goes in
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    static StaticQueueStorage<Command, 1> storage;
+    static QueueHandle_t queue = storage.Create();
+#else
+    static QueueHandle_t queue = xQueueCreate(1, sizeof(Command));
+#endif
+    if (queue == nullptr)
+    {
+        SOAR_PRINT("CommandPayloadPool::Benchmark() - Could not create the queue\n");
+        return;
+    }
+
+    SOAR_PRINT("BENCH,msgpool,path,payload_bytes,iterations,avg_ns,max_ns\n");
+    for (uint16_t size : COMMAND_PAYLOAD_BENCH_SIZES)
+    {
+        if (!CommandPayloadPool_BenchRun(queue, false, size) || !CommandPayloadPool_BenchRun(queue, true, size))
+        {
+            SOAR_PRINT("CommandPayloadPool::Benchmark() - Out of memory at %u bytes\n", size);
+            return;
+        }
+    }
+    SOAR_PRINT("Free Heap: %lu Bytes, pool counters include the pooled runs\n", (uint32_t)xPortGetFreeHeapSize());
+}
+
+/**
+ * @brief Round trips of one payload size on one path, printed as a BENCH,msgpool line
+ * @param pooled Attach()/Release() if true, Command::CopyDataToCommand()/Reset() if false
+ */
+static bool CommandPayloadPool_BenchRun(QueueHandle_t queue, bool pooled, uint16_t size)
+{
+    uint8_t payload[COMMAND_PAYLOAD_BLOCK_BYTES];
+    memset(payload, 0x5A, sizeof(payload));
+
+    uint64_t totalCycles = 0;
+    uint32_t maxCycles = 0;
+    volatile uint8_t sink = 0;
+    for (uint32_t i = 0; i < COMMAND_PAYLOAD_BENCH_ITERATIONS; i++)
+    {
+        uint32_t start = CycleCounter::Now();
+
+        Command tx(TASK_SPECIFIC_COMMAND, 0);
+        bool attached = pooled ? CommandPayloadPool::Attach(tx, payload, size) : tx.CopyDataToCommand(payload, size);
+        if (!attached)
+        {
+            return false;
+        }
+        xQueueSend(queue, &tx, 0);
+
+        Command rx;
+        xQueueReceive(queue, &rx, 0);
+        sink = sink + rx.GetDataPointer()[size - 1];
+        if (pooled)
+        {
+            CommandPayloadPool::Release(rx);
+        }
+        rx.Reset();
+
+        uint32_t cycles = CycleCounter::Now() - start;
+        totalCycles += cycles;
+        maxCycles = (cycles > maxCycles) ? cycles : maxCycles;
+    }
+
+    const uint64_t hz = CycleCounter::Frequency();
+    SOAR_PRINT("BENCH,msgpool,%s,%u,%lu,%lu,%lu\n", pooled ? "pool" : "heap", size, COMMAND_PAYLOAD_BENCH_ITERATIONS,
+               (uint32_t)((totalCycles * 1000000000u) / hz / COMMAND_PAYLOAD_BENCH_ITERATIONS),
+               (uint32_t)(((uint64_t)maxCycles * 1000000000u) / hz));
+    return true;
+}
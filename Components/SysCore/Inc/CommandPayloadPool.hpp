@@ -0,0 +1,58 @@
+/**
+ ******************************************************************************
+ * File Name          : CommandPayloadPool.hpp
+ * Description        : Pooled Command payloads in place of Command's heap copies
+ ******************************************************************************
+ *
+ * Command::CopyDataToCommand() takes its copy from pvPortMalloc and
+ * Command::Reset() gives it back, two heap_4 calls per message. Attach()
+ * instead copies the payload into a block of a fixed-size pool and points
+ * the Command at it as a static external buffer, so Reset() leaves it alone
+ * and the receiver hands it back with Release() before Reset().
+ *
+ * The receiver must know the payload came from Attach(), in practice from
+ * the task command, as the block is told apart from other static buffers by
+ * that alone. The pool falls back to the heap once exhausted, so a burst
+ * larger than the pool still gets through and shows up in the counters.
+ *
+ ******************************************************************************
+ */
+#ifndef CUBE_SYSCORE_COMMAND_PAYLOAD_POOL_HPP_
+#define CUBE_SYSCORE_COMMAND_PAYLOAD_POOL_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include "ObjectPool.hpp"
+#include "Command.hpp"
+#include <stdint.h>
+
+/* Macros --------------------------------------------------------------------*/
+constexpr uint16_t COMMAND_PAYLOAD_BLOCK_BYTES = 64; // Largest payload Attach() takes
+constexpr uint16_t COMMAND_PAYLOAD_POOL_DEPTH = 16;  // Payloads in flight at once before the heap fallback
+constexpr uint32_t COMMAND_PAYLOAD_BENCH_ITERATIONS = 1000; // Round trips per benchmark line
+
+/* Functions -----------------------------------------------------------------*/
+namespace CommandPayloadPool
+{
+    /**
+     * @brief Copy a payload into a pool block and attach it to the command
+     * @retval bool False if size is over COMMAND_PAYLOAD_BLOCK_BYTES or no memory was left, cm is unchanged
+     */
+    bool Attach(Command &cm, const uint8_t *data, uint16_t size);
+
+    /**
+     * @brief Give the payload of a command filled by Attach() back, call before cm.Reset()
+     */
+    void Release(Command &cm);
+
+    ObjectPoolStats Stats();
+    void ResetStats();
+
+    /**
+     * @brief Time a Command carrying a payload through a queue and back out on the calling task,
+     * once with Command's heap copy and once with Attach()/Release(), for a few payload sizes.
+     * Prints a "BENCH,msgpool,<path>,<bytes>,<iterations>,<avg ns>,<max ns>" line per run.
+     */
+    void Benchmark();
+}
+
+#endif // CUBE_SYSCORE_COMMAND_PAYLOAD_POOL_HPP_
@@ -0,0 +1,87 @@
+/**
+ ******************************************************************************
+ * File Name          : CycleCounter.hpp
+ * Description        : High resolution timestamps for profiling and benchmarks
+ ******************************************************************************
+ *
+ * Wraps the Cortex-M4 DWT cycle counter. The counter is 32 bits and wraps
+ * every ~25 s at 170 MHz, so only use it for intervals shorter than that and
+ * always subtract as unsigned.
+ *
+ * On the host build (COMPUTER_ENVIRONMENT) the counter is CLOCK_MONOTONIC in
+ * nanoseconds truncated to 32 bits, so it wraps every ~4.3 s but keeps the
+ * same unsigned subtraction semantics.
+ *
+ ******************************************************************************
+ */
+#ifndef CUBE_SYSCORE_CYCLE_COUNTER_HPP_
+#define CUBE_SYSCORE_CYCLE_COUNTER_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#ifdef COMPUTER_ENVIRONMENT
+#include <time.h>
+#else
+#include "stm32g4xx_hal.h"
+#endif
+
+/* Functions -----------------------------------------------------------------*/
+namespace CycleCounter
+{
+#ifdef COMPUTER_ENVIRONMENT
+    inline void Init()
+    {
+    }
+
+    inline uint32_t Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+    }
+
+    inline uint32_t Frequency()
+    {
+        return 1000000000u;
+    }
+#else
+    /**
+     * @brief Enable the DWT cycle counter, safe to call more than once
+     */
+    inline void Init()
+    {
+        if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0)
+        {
+            CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+            DWT->CYCCNT = 0;
+            DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        }
+    }
+
+    /**
+     * @brief Current cycle count
+     */
+    inline uint32_t Now()
+    {
+        return DWT->CYCCNT;
+    }
+
+    /**
+     * @brief Cycles per second of the counter
+     */
+    inline uint32_t Frequency()
+    {
+        return SystemCoreClock;
+    }
+#endif
+
+    /**
+     * @brief Convert a cycle interval to microseconds
+     */
+    inline uint32_t ToMicros(uint32_t cycles)
+    {
+        return (uint32_t)(((uint64_t)cycles * 1000000u) / Frequency());
+    }
+}
+
+#endif // CUBE_SYSCORE_CYCLE_COUNTER_HPP_
@@ -0,0 +1,198 @@
+/**
+ ******************************************************************************
+ * File Name          : ObjectPool.hpp
+ * Description        : Fixed-block pools of a single type for hot path allocations
+ ******************************************************************************
+ *
+ * An ObjectPool holds Count blocks big enough for a T in the object itself, so
+ * a file scope or member instance lands in .bss like StaticAllocation.hpp
+ * storage. Free blocks are chained through their own storage, which makes
+ * Allocate() and Free() O(1) with no search and no fragmentation.
+ *
+ * Both take a short critical section instead of heap_4's scheduler suspend,
+ * so they may be called from any task but not from an interrupt.
+ *
+ * What happens once every block is out is fixed per pool by Exhaustion:
+ * OBJECT_POOL_FAIL returns nullptr for the caller to drop or retry,
+ * OBJECT_POOL_ASSERT treats it as a sizing bug, and OBJECT_POOL_HEAP falls
+ * back to pvPortMalloc so nothing is dropped while the counters show the
+ * pool needs to grow.
+ *
+ ******************************************************************************
+ */
+#ifndef CUBE_SYSCORE_OBJECT_POOL_HPP_
+#define CUBE_SYSCORE_OBJECT_POOL_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include "FreeRTOS.h"
+#include "task.h"
+#include "SystemDefines.hpp"
+#include <stdint.h>
+#include <new>
+
+/* Enums ---------------------------------------------------------------------*/
+enum OBJECT_POOL_EXHAUSTION : uint8_t
+{
+    OBJECT_POOL_FAIL = 0, // Allocate() returns nullptr
+    OBJECT_POOL_ASSERT,   // SOAR_ASSERT, the pool was sized too small
+    OBJECT_POOL_HEAP,     // Take the block from pvPortMalloc instead, Free() tells the two apart
+};
+
+/* Types ---------------------------------------------------------------------*/
+struct ObjectPoolStats
+{
+    uint32_t capacity;
+    uint32_t inUse;         // Pool blocks currently allocated, heap fallbacks not included
+    uint32_t highWater;     // Most pool blocks ever allocated at once
+    uint32_t allocations;   // Successful Allocate() calls, heap fallbacks included
+    uint32_t exhausted;     // Allocate() calls that found no free block
+    uint32_t heapFallbacks; // Of those, blocks taken from the heap with OBJECT_POOL_HEAP
+};
+
+/* Functions -----------------------------------------------------------------*/
+void ObjectPool_PrintHeader();                                              // Column titles for the lines below
+void ObjectPool_PrintStats(const char *name, const ObjectPoolStats &stats); // One line of pool counters
+
+/* Classes -------------------------------------------------------------------*/
+/**
+ * @brief Count blocks of type T, constructed by Allocate() and destroyed by Free()
+ */
+template <typename T, uint16_t Count, OBJECT_POOL_EXHAUSTION Exhaustion = OBJECT_POOL_FAIL>
+class ObjectPool
+{
+public:
+    ObjectPool() : freeList(nullptr), inUse(0), highWater(0), allocations(0), exhausted(0), heapFallbacks(0)
+    {
+        for (uint16_t i = 0; i < Count; i++)
+        {
+            blocks[i].next = freeList;
+            freeList = &blocks[i];
+        }
+    }
+
+    /**
+     * @brief Take a block and default construct a T in it
+     * @retval T* nullptr if the pool is exhausted and Exhaustion is OBJECT_POOL_FAIL
+     */
+    T *Allocate()
+    {
+        taskENTER_CRITICAL();
+        Block *block = freeList;
+        if (block != nullptr)
+        {
+            freeList = block->next;
+            inUse++;
+            highWater = (inUse > highWater) ? inUse : highWater;
+            allocations++;
+        }
+        else
+        {
+            exhausted++;
+        }
+        taskEXIT_CRITICAL();
+
+        if (block == nullptr)
+        {
+            return Exhausted();
+        }
+        return new (block->storage) T();
+    }
+
+    /**
+     * @brief Destroy the T and give its block back, nullptr is ignored
+     */
+    void Free(T *object)
+    {
+        if (object == nullptr)
+        {
+            return;
+        }
+
+        object->~T();
+        if (Exhaustion == OBJECT_POOL_HEAP && !Owns(object))
+        {
+            vPortFree(object);
+            return;
+        }
+
+        Block *block = (Block *)(void *)object;
+        taskENTER_CRITICAL();
+        block->next = freeList;
+        freeList = block;
+        inUse--;
+        taskEXIT_CRITICAL();
+    }
+
+    /**
+     * @brief Check if an object lives in one of this pool's blocks
+     */
+    bool Owns(const void *object) const
+    {
+        const uint8_t *address = (const uint8_t *)object;
+        return address >= (const uint8_t *)&blocks[0] && address < (const uint8_t *)&blocks[Count] &&
+               (address - (const uint8_t *)&blocks[0]) % sizeof(Block) == 0;
+    }
+
+    ObjectPoolStats Stats()
+    {
+        taskENTER_CRITICAL();
+        ObjectPoolStats stats = {Count, inUse, highWater, allocations, exhausted, heapFallbacks};
+        taskEXIT_CRITICAL();
+        return stats;
+    }
+
+    /**
+     * @brief Zero the counters and restart the high water mark from the blocks in use now
+     */
+    void ResetStats()
+    {
+        taskENTER_CRITICAL();
+        highWater = inUse;
+        allocations = 0;
+        exhausted = 0;
+        heapFallbacks = 0;
+        taskEXIT_CRITICAL();
+    }
+
+    static constexpr uint16_t Capacity() { return Count; }
+
+private:
+    union Block
+    {
+        Block *next; // While free
+        alignas(T) uint8_t storage[sizeof(T)];
+    };
+
+    T *Exhausted()
+    {
+        if (Exhaustion == OBJECT_POOL_ASSERT)
+        {
+            SOAR_ASSERT(false, "ObjectPool - Exhausted, raise its Count");
+        }
+        if (Exhaustion != OBJECT_POOL_HEAP)
+        {
+            return nullptr;
+        }
+
+        void *memory = pvPortMalloc(sizeof(T));
+        if (memory == nullptr)
+        {
+            return nullptr;
+        }
+        taskENTER_CRITICAL();
+        allocations++;
+        heapFallbacks++;
+        taskEXIT_CRITICAL();
+        return new (memory) T();
+    }
+
+    Block blocks[Count];
+    Block *freeList;
+    uint32_t inUse;
+    uint32_t highWater;
+    uint32_t allocations;
+    uint32_t exhausted;
+    uint32_t heapFallbacks;
+};
+
+#endif // CUBE_SYSCORE_OBJECT_POOL_HPP_
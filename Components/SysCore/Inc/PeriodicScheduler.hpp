@@ -0,0 +1,89 @@
+/**
+ ******************************************************************************
+ * File Name          : PeriodicScheduler.hpp
+ * Description        : Fixed rate jobs run by the task that owns the scheduler
+ ******************************************************************************
+ *
+ * Each job is released at start + phase + k * period, counted in RTOS ticks
+ * from the previous release rather than from when the job last ran, so a late
+ * run does not push the later ones back. A job that falls a whole period
+ * behind skips the releases it missed instead of running back to back.
+ *
+ * The owning task calls Service() whenever it is awake and uses the returned
+ * time as the timeout of whatever it blocks on, usually its queue receive.
+ * Jobs run on that task, so they may block it but should stay well under the
+ * shortest period.
+ *
+ * Release latency is in ticks (1 ms), as releases can only be noticed on a
+ * tick. Run time is measured with CycleCounter.
+ *
+ ******************************************************************************
+ */
+#ifndef CUBE_SYSCORE_PERIODIC_SCHEDULER_HPP_
+#define CUBE_SYSCORE_PERIODIC_SCHEDULER_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdint.h>
+
+/* Macros --------------------------------------------------------------------*/
+constexpr uint32_t PERIODIC_SCHEDULER_MAX_JOBS = 8;
+
+/* Types ---------------------------------------------------------------------*/
+typedef void (*PeriodicJobFunction)(void *context);
+
+struct PeriodicJobStats
+{
+    uint32_t runs;
+    uint32_t skipped;        // Releases dropped as they had passed before the previous run finished
+    uint32_t deadlineMisses; // Runs finishing after release + deadline
+    uint32_t minLatencyMs;   // Release to start, max - min is the start jitter
+    uint32_t maxLatencyMs;
+    uint32_t totalLatencyMs;
+    uint32_t maxRunUs;
+    uint64_t totalRunUs;
+};
+
+/* Class ---------------------------------------------------------------------*/
+class PeriodicScheduler
+{
+public:
+    PeriodicScheduler();
+
+    /**
+     * @brief Add a job, first released phaseMs after Start() (or after now, once started)
+     * @param deadlineMs Longest release to finish time that is not a miss, 0 for the period
+     * @retval bool False if PERIODIC_SCHEDULER_MAX_JOBS are already registered or the period is 0
+     */
+    bool Register(const char *name, uint32_t periodMs, uint32_t phaseMs, PeriodicJobFunction job, void *context,
+                  uint32_t deadlineMs = 0);
+
+    void Start();                // Count releases from now, call from the owning task
+    uint32_t Service();          // Run every job that is due, returns ms until the next release
+
+    void PrintStats();
+    void ResetStats();
+
+private:
+    struct Job
+    {
+        const char *name;
+        PeriodicJobFunction function;
+        void *context;
+        TickType_t period;
+        TickType_t phase;
+        TickType_t deadline;
+        TickType_t release; // Next release, valid once started
+        PeriodicJobStats stats;
+    };
+
+    TickType_t NextRelease();
+    void Run(Job &job);
+
+    Job jobs[PERIODIC_SCHEDULER_MAX_JOBS];
+    uint32_t jobCount;
+    bool started;
+};
+
+#endif // CUBE_SYSCORE_PERIODIC_SCHEDULER_HPP_
@@ -0,0 +1,58 @@
+/**
+ ******************************************************************************
+ * File Name          : RunTimeStats.hpp
+ * Description        : Per-task CPU time and context switch counts for the top command
+ ******************************************************************************
+ *
+ * FreeRTOSConfig.h points the kernel run time stats clock at CycleCounter and
+ * traceTASK_SWITCHED_IN at RunTimeStats_TaskSwitchedIn, so each task's time in
+ * the Running state is measured in counter ticks and each time it is scheduled
+ * in is counted.
+ *
+ * The kernel keeps run time in 32 bits that wrap with the counter (~25 s on
+ * target, ~4.3 s on host). PrintTop() only reports the change since its last
+ * call, which stays right as long as calls are closer together than that.
+ *
+ ******************************************************************************
+ */
+#ifndef CUBE_SYSCORE_RUN_TIME_STATS_HPP_
+#define CUBE_SYSCORE_RUN_TIME_STATS_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include "FreeRTOS.h"
+#include <stdint.h>
+
+/* Macros --------------------------------------------------------------------*/
+#define RUN_TIME_STATS_MAX_TASKS 16 // Tasks listed by top, also the task numbers switches are counted for
+
+/* Functions -----------------------------------------------------------------*/
+extern "C"
+{
+    // Kernel hooks, named as STM32CubeMX generates them, see FreeRTOSConfig.h
+    void configureTimerForRunTimeStats(void);
+    unsigned long getRunTimeCounterValue(void);
+    void RunTimeStats_TaskSwitchedIn(unsigned long taskNumber);
+}
+
+namespace RunTimeStats
+{
+    /**
+     * @brief Times a task has been scheduled in, by the xTaskNumber of its TaskStatus_t
+     */
+    uint32_t ContextSwitches(UBaseType_t taskNumber);
+
+    /**
+     * @brief Print a line per task with CPU share, state, priority, stack high water
+     * mark and switches since the last call. Only call from one task at a time.
+     */
+    void PrintTop();
+
+    /**
+     * @brief Print every task whose deepest stack use so far exceeds its StackBudgets.hpp
+     * budget, which means the static analysis missed a path
+     * @retval uint32_t Number of tasks over budget
+     */
+    uint32_t CheckStackBudgets();
+}
+
+#endif // CUBE_SYSCORE_RUN_TIME_STATS_HPP_
@@ -0,0 +1,34 @@
+/**
+ ******************************************************************************
+ * File Name          : StackBudgets.hpp
+ * Description        : Task stack budgets, hand-picked until Tools/StackBudget has run
+ ******************************************************************************
+ *
+ * Not generated yet, the checked in Debug build predates the tasks. Run
+ * `make budgets` in Tools/StackBudget after a Debug build to replace this file.
+ * RunTimeStats checks the budgets against the stack watermarks at run time.
+ *
+ ******************************************************************************
+ */
+#ifndef CUBE_SYSCORE_STACK_BUDGETS_HPP_
+#define CUBE_SYSCORE_STACK_BUDGETS_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Macros --------------------------------------------------------------------*/
+constexpr uint32_t STACK_BUDGET_MARGIN_BYTES = 256; // Exception frame and switch context on top of the budget
+
+constexpr uint32_t TASK_DEBUG_STACK_BUDGET_BYTES = 1792; // Estimate, the former 512 word stack
+constexpr uint32_t TASK_FILESYSTEM_STACK_BUDGET_BYTES = 4864; // Estimate, the former 1024 word stack plus the command and telemetry batches and the f_mkfs work sector
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief Stack depth in words for a task with the given budget
+ */
+constexpr uint16_t StackBudgetWords(uint32_t budgetBytes)
+{
+    return (uint16_t)((budgetBytes + STACK_BUDGET_MARGIN_BYTES + 3) / 4);
+}
+
+#endif // CUBE_SYSCORE_STACK_BUDGETS_HPP_
@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * File Name          : StaticAllocation.hpp
+ * Description        : Compile-time sized storage for RTOS tasks and queues
+ ******************************************************************************
+ *
+ * Each storage object holds the control block and buffers FreeRTOS would
+ * otherwise take from the heap_4 region, so the object decides where they
+ * live: a file scope or member instance lands in .bss and shows up in the map
+ * file at a fixed address. Create() hands the storage to the matching
+ * xCreateStatic call and may only be called once per object.
+ *
+ * Needs configSUPPORT_STATIC_ALLOCATION. Callers keep an xTaskCreate path
+ * under #else so a config regenerated without it still builds.
+ *
+ ******************************************************************************
+ */
+#ifndef CUBE_SYSCORE_STATIC_ALLOCATION_HPP_
+#define CUBE_SYSCORE_STATIC_ALLOCATION_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include <stdint.h>
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+
+/* Functions -----------------------------------------------------------------*/
+namespace StaticAllocation
+{
+    /**
+     * @brief Bytes of RTOS storage created statically so far, printed at boot next to the heap
+     */
+    inline uint32_t &Bytes()
+    {
+        static uint32_t bytes = 0;
+        return bytes;
+    }
+}
+
+/* Classes -------------------------------------------------------------------*/
+/**
+ * @brief Stack and TCB for one task
+ */
+template <uint16_t StackWords>
+class StaticTaskStorage
+{
+public:
+    TaskHandle_t Create(TaskFunction_t function, const char *name, void *params, UBaseType_t priority)
+    {
+        StaticAllocation::Bytes() += sizeof(*this);
+        return xTaskCreateStatic(function, name, StackWords, params, priority, stack, &tcb);
+    }
+
+private:
+    StackType_t stack[StackWords];
+    StaticTask_t tcb;
+};
+
+/**
+ * @brief Item buffer and control block for a queue of Depth items of type T
+ */
+template <typename T, uint16_t Depth>
+class StaticQueueStorage
+{
+public:
+    QueueHandle_t Create()
+    {
+        StaticAllocation::Bytes() += sizeof(*this);
+        return xQueueCreateStatic(Depth, sizeof(T), items, &control);
+    }
+
+private:
+    uint8_t items[Depth * sizeof(T)];
+    StaticQueue_t control;
+};
+
+#endif
+
+#endif // CUBE_SYSCORE_STATIC_ALLOCATION_HPP_
@@ -0,0 +1,30 @@
+/**
+ ******************************************************************************
+ * File Name          : ObjectPool.cpp
+ * Description        : Fixed-block pools of a single type for hot path allocations
+ * Author             : SOAR Team
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ObjectPool.hpp"
+#include "SystemDefines.hpp"
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief Print the column titles for ObjectPool_PrintStats()
+ */
+void ObjectPool_PrintHeader()
+{
+    SOAR_PRINT("%-16s %6s %6s %6s %10s %9s %8s\n", "Pool", "Blocks", "InUse", "High", "Allocs", "Exhausted", "HeapUsed");
+}
+
+/**
+ * @brief Print one line of pool counters
+ */
+void ObjectPool_PrintStats(const char *name, const ObjectPoolStats &stats)
+{
+    SOAR_PRINT("%-16s %6lu %6lu %6lu %10lu %9lu %8lu%s\n", name, stats.capacity, stats.inUse, stats.highWater,
+               stats.allocations, stats.exhausted, stats.heapFallbacks,
+               stats.exhausted ? "  exhausted, raise its Count" : "");
+}
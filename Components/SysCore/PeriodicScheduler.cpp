@@ -0,0 +1,166 @@
+/**
+ ******************************************************************************
+ * File Name          : PeriodicScheduler.cpp
+ * Description        : Fixed rate jobs run by the task that owns the scheduler
+ * Author             : SOAR Team
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "PeriodicScheduler.hpp"
+#include "CycleCounter.hpp"
+#include "SystemDefines.hpp"
+#include <string.h>
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief Constructor, no jobs
+ */
+PeriodicScheduler::PeriodicScheduler() : jobCount(0), started(false)
+{
+    memset(jobs, 0, sizeof(jobs));
+}
+
+/**
+ * @brief Add a job, first released phaseMs after Start() (or after now, once started)
+ */
+bool PeriodicScheduler::Register(const char *name, uint32_t periodMs, uint32_t phaseMs, PeriodicJobFunction job,
+                                 void *context, uint32_t deadlineMs)
+{
+    if (jobCount >= PERIODIC_SCHEDULER_MAX_JOBS || pdMS_TO_TICKS(periodMs) == 0 || job == nullptr)
+    {
+        return false;
+    }
+
+    Job &added = jobs[jobCount];
+    memset(&added, 0, sizeof(added));
+    added.name = name;
+    added.function = job;
+    added.context = context;
+    added.period = pdMS_TO_TICKS(periodMs);
+    added.phase = pdMS_TO_TICKS(phaseMs);
+    added.deadline = deadlineMs ? pdMS_TO_TICKS(deadlineMs) : added.period;
+    added.release = xTaskGetTickCount() + added.phase;
+    jobCount++;
+    return true;
+}
+
+/**
+ * @brief Count releases from now, call from the owning task
+ */
+void PeriodicScheduler::Start()
+{
+    TickType_t now = xTaskGetTickCount();
+    for (uint32_t i = 0; i < jobCount; i++)
+    {
+        jobs[i].release = now + jobs[i].phase;
+    }
+    started = true;
+}
+
+/**
+ * @brief Run every job that is due
+ * @retval uint32_t Milliseconds until the next release, 0 if one is already due
+ */
+uint32_t PeriodicScheduler::Service()
+{
+    if (!started)
+    {
+        Start();
+    }
+
+    for (uint32_t i = 0; i < jobCount; i++)
+    {
+        // Signed difference keeps the comparison right across the tick counter wrapping
+        if ((int32_t)(xTaskGetTickCount() - jobs[i].release) >= 0)
+        {
+            Run(jobs[i]);
+        }
+    }
+
+    int32_t wait = (int32_t)(NextRelease() - xTaskGetTickCount());
+    return wait > 0 ? (uint32_t)wait * 1000u / configTICK_RATE_HZ : 0;
+}
+
+/**
+ * @brief Earliest pending release, or a second from now with no jobs
+ */
+TickType_t PeriodicScheduler::NextRelease()
+{
+    TickType_t now = xTaskGetTickCount();
+    TickType_t next = now + pdMS_TO_TICKS(1000);
+    for (uint32_t i = 0; i < jobCount; i++)
+    {
+        if ((int32_t)(jobs[i].release - next) < 0)
+        {
+            next = jobs[i].release;
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Run a due job, record its timing and move it to its next release
+ */
+void PeriodicScheduler::Run(Job &job)
+{
+    TickType_t start = xTaskGetTickCount();
+    uint32_t startCycles = CycleCounter::Now();
+    job.function(job.context);
+    uint32_t runUs = CycleCounter::ToMicros(CycleCounter::Now() - startCycles);
+    TickType_t finish = xTaskGetTickCount();
+
+    PeriodicJobStats &stats = job.stats;
+    uint32_t latencyMs = (start - job.release) * 1000u / configTICK_RATE_HZ;
+    stats.runs++;
+    stats.totalLatencyMs += latencyMs;
+    stats.minLatencyMs = (stats.runs == 1 || latencyMs < stats.minLatencyMs) ? latencyMs : stats.minLatencyMs;
+    stats.maxLatencyMs = (latencyMs > stats.maxLatencyMs) ? latencyMs : stats.maxLatencyMs;
+    stats.totalRunUs += runUs;
+    stats.maxRunUs = (runUs > stats.maxRunUs) ? runUs : stats.maxRunUs;
+    if (finish - job.release > job.deadline)
+    {
+        stats.deadlineMisses++;
+    }
+
+    // Next release from the last one, not from now, so lateness does not turn into drift
+    job.release += job.period;
+    int32_t behind = (int32_t)(finish - job.release);
+    if (behind > 0)
+    {
+        // A release that falls due on the finish tick still runs, only those already past are skipped
+        uint32_t missed = ((uint32_t)behind - 1) / job.period + 1;
+        stats.skipped += missed;
+        job.release += missed * job.period;
+    }
+}
+
+/**
+ * @brief Print the timing of every job
+ */
+void PeriodicScheduler::PrintStats()
+{
+    SOAR_PRINT("%-12s %8s %6s %6s %6s %8s %8s %8s %8s %8s\n", "Job", "PeriodMs", "Runs", "Skip", "Miss", "AvgLatMs",
+               "MaxLatMs", "JitterMs", "AvgRunUs", "MaxRunUs");
+    for (uint32_t i = 0; i < jobCount; i++)
+    {
+        const Job &job = jobs[i];
+        const PeriodicJobStats &stats = job.stats;
+        SOAR_PRINT("%-12s %8lu %6lu %6lu %6lu %8lu %8lu %8lu %8lu %8lu\n", job.name,
+                   (uint32_t)(job.period * 1000u / configTICK_RATE_HZ), stats.runs, stats.skipped,
+                   stats.deadlineMisses, stats.runs ? stats.totalLatencyMs / stats.runs : 0, stats.maxLatencyMs,
+                   stats.maxLatencyMs - stats.minLatencyMs, stats.runs ? (uint32_t)(stats.totalRunUs / stats.runs) : 0,
+                   stats.maxRunUs);
+    }
+}
+
+/**
+ * @brief Zero the timing of every job, releases are unchanged
+ */
+void PeriodicScheduler::ResetStats()
+{
+    for (uint32_t i = 0; i < jobCount; i++)
+    {
+        memset(&jobs[i].stats, 0, sizeof(jobs[i].stats));
+    }
+}
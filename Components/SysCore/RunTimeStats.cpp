@@ -0,0 +1,204 @@
+/**
+ ******************************************************************************
+ * File Name          : RunTimeStats.cpp
+ * Description        : Per-task CPU time and context switch counts for the top command
+ * Author             : SOAR Team
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "RunTimeStats.hpp"
+#include "CycleCounter.hpp"
+#include "SystemDefines.hpp"
+#include "task.h"
+#include <string.h>
+
+/* Private Types -------------------------------------------------------------*/
+typedef struct
+{
+    const char *taskName;
+    uint16_t stackWords;
+    uint32_t budgetBytes;
+} RunTimeStats_StackBudget_t;
+
+typedef struct
+{
+    UBaseType_t taskNumber; // 0 while unused, the kernel numbers tasks from 1
+    uint32_t runTime;
+    uint32_t switches;
+} RunTimeStats_Sample_t;
+
+/* Private Variables ---------------------------------------------------------*/
+static volatile uint32_t g_switches[RUN_TIME_STATS_MAX_TASKS];
+
+// Snapshot buffers kept out of the caller's stack, PrintTop() is not reentrant
+static TaskStatus_t g_tasks[RUN_TIME_STATS_MAX_TASKS];
+static RunTimeStats_Sample_t g_current[RUN_TIME_STATS_MAX_TASKS];
+static RunTimeStats_Sample_t g_previous[RUN_TIME_STATS_MAX_TASKS];
+static uint32_t g_previousTotal;
+
+static const char RUN_TIME_STATS_STATE_CHARS[] = {'X', 'R', 'B', 'S', 'D', '?'}; // Indexed by eTaskState
+
+// Tasks sized from StackBudgets.hpp, by their FreeRTOS task name
+static const RunTimeStats_StackBudget_t RUN_TIME_STATS_STACK_BUDGETS[] = {
+    {"DebugTask", TASK_DEBUG_STACK_DEPTH_WORDS, TASK_DEBUG_STACK_BUDGET_BYTES},
+    {"FileSystemTask", TASK_FILESYSTEM_STACK_DEPTH_WORDS, TASK_FILESYSTEM_STACK_BUDGET_BYTES},
+};
+
+/* Private Function Prototypes -----------------------------------------------*/
+static const RunTimeStats_StackBudget_t *RunTimeStats_FindBudget(const char *taskName);
+static uint32_t RunTimeStats_StackUsed(const TaskStatus_t *task, const RunTimeStats_StackBudget_t *budget);
+
+/* Kernel Hooks --------------------------------------------------------------*/
+/**
+ * @brief Start the run time stats clock, called by vTaskStartScheduler
+ */
+void configureTimerForRunTimeStats(void)
+{
+    CycleCounter::Init();
+}
+
+/**
+ * @brief Run time stats clock, read on every context switch
+ */
+unsigned long getRunTimeCounterValue(void)
+{
+    return CycleCounter::Now();
+}
+
+/**
+ * @brief Count a task being scheduled in, runs inside the kernel's context switch
+ */
+void RunTimeStats_TaskSwitchedIn(unsigned long taskNumber)
+{
+    if (taskNumber < RUN_TIME_STATS_MAX_TASKS)
+    {
+        g_switches[taskNumber]++;
+    }
+}
+
+/* Functions -----------------------------------------------------------------*/
+/**
+ * @brief Times a task has been scheduled in, by the xTaskNumber of its TaskStatus_t
+ */
+uint32_t RunTimeStats::ContextSwitches(UBaseType_t taskNumber)
+{
+    return (taskNumber < RUN_TIME_STATS_MAX_TASKS) ? g_switches[taskNumber] : 0;
+}
+
+/**
+ * @brief Print a line per task with CPU share, state, priority, stack high water mark and switches since the last call
+ */
+void RunTimeStats::PrintTop()
+{
+    // Copies the task list with the scheduler suspended, interrupts and the tick keep running
+    uint32_t total;
+    UBaseType_t count = uxTaskGetSystemState(g_tasks, RUN_TIME_STATS_MAX_TASKS, &total);
+    if (count == 0)
+    {
+        SOAR_PRINT("top - More than %d tasks, raise RUN_TIME_STATS_MAX_TASKS\n", RUN_TIME_STATS_MAX_TASKS);
+        return;
+    }
+
+    const uint32_t elapsed = total - g_previousTotal;
+    SOAR_PRINT("\ntop - %lu ms, %lu tasks\n", CycleCounter::ToMicros(elapsed) / 1000, (uint32_t)count);
+    SOAR_PRINT("%-16s %6s %5s %4s %10s %9s %10s\n", "Task", "CPU%", "State", "Prio", "StackFree", "Switches", "Total");
+
+    uint32_t overBudget = 0;
+
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        const TaskStatus_t *task = &g_tasks[i];
+        g_current[i].taskNumber = task->xTaskNumber;
+        g_current[i].runTime = task->ulRunTimeCounter;
+        g_current[i].switches = ContextSwitches(task->xTaskNumber);
+
+        // A task first seen now is measured from zero
+        uint32_t runTime = g_current[i].runTime;
+        uint32_t switches = g_current[i].switches;
+        for (uint32_t p = 0; p < RUN_TIME_STATS_MAX_TASKS; p++)
+        {
+            if (g_previous[p].taskNumber == task->xTaskNumber)
+            {
+                runTime -= g_previous[p].runTime;
+                switches -= g_previous[p].switches;
+                break;
+            }
+        }
+
+        // Tenths of a percent, as the kernel's own stats round whole percents down to 0
+        uint32_t permille = elapsed ? (uint32_t)(((uint64_t)runTime * 1000u) / elapsed) : 0;
+        uint32_t state = (task->eCurrentState <= eDeleted) ? task->eCurrentState : eDeleted + 1;
+        const RunTimeStats_StackBudget_t *budget = RunTimeStats_FindBudget(task->pcTaskName);
+        bool over = budget && RunTimeStats_StackUsed(task, budget) > budget->budgetBytes;
+        overBudget += over ? 1 : 0;
+        SOAR_PRINT("%-16s %4lu.%lu %5c %4lu %10lu %9lu %10lu%s\n", task->pcTaskName, permille / 10, permille % 10,
+                   RUN_TIME_STATS_STATE_CHARS[state], (uint32_t)task->uxCurrentPriority,
+                   (uint32_t)(task->usStackHighWaterMark * sizeof(StackType_t)), switches, g_current[i].switches,
+                   over ? " !stack" : "");
+    }
+    if (overBudget)
+    {
+        SOAR_PRINT("!stack: over the StackBudgets.hpp budget, run 'stack'\n");
+    }
+
+    // Deleted tasks drop out of the snapshot here
+    memset(g_previous, 0, sizeof(g_previous));
+    memcpy(g_previous, g_current, count * sizeof(g_current[0]));
+    g_previousTotal = total;
+}
+
+/**
+ * @brief Print every task whose deepest stack use so far exceeds its StackBudgets.hpp budget
+ * @retval uint32_t Number of tasks over budget
+ */
+uint32_t RunTimeStats::CheckStackBudgets()
+{
+    uint32_t total;
+    UBaseType_t count = uxTaskGetSystemState(g_tasks, RUN_TIME_STATS_MAX_TASKS, &total);
+
+    uint32_t overBudget = 0;
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        const RunTimeStats_StackBudget_t *budget = RunTimeStats_FindBudget(g_tasks[i].pcTaskName);
+        if (budget == nullptr)
+        {
+            continue;
+        }
+
+        uint32_t used = RunTimeStats_StackUsed(&g_tasks[i], budget);
+        // The stack is sized budget + margin, so using the whole margin is an overflow and over budget has to
+        // fire below it. The margin in use is shown on its own
+        bool over = used > budget->budgetBytes;
+        uint32_t marginUsed = over ? used - budget->budgetBytes : 0;
+        SOAR_PRINT("%-16s used %5lu B of %5lu B budget, %3lu of %lu B margin, %5lu B stack%s\n", budget->taskName,
+                   used, budget->budgetBytes, marginUsed, STACK_BUDGET_MARGIN_BYTES,
+                   (uint32_t)(budget->stackWords * sizeof(StackType_t)),
+                   over ? "  OVER BUDGET, the analysis missed a path" : "");
+        overBudget += over ? 1 : 0;
+    }
+    return overBudget;
+}
+
+/**
+ * @brief Budget entry for a task name, nullptr for tasks not sized from StackBudgets.hpp
+ */
+static const RunTimeStats_StackBudget_t *RunTimeStats_FindBudget(const char *taskName)
+{
+    for (const RunTimeStats_StackBudget_t &budget : RUN_TIME_STATS_STACK_BUDGETS)
+    {
+        if (strcmp(budget.taskName, taskName) == 0)
+        {
+            return &budget;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Deepest stack use of a task so far, from its high water mark
+ */
+static uint32_t RunTimeStats_StackUsed(const TaskStatus_t *task, const RunTimeStats_StackBudget_t *budget)
+{
+    return (uint32_t)((budget->stackWords - task->usStackHighWaterMark) * sizeof(StackType_t));
+}
@@ -13,6 +13,7 @@
 
 /* Environment Defines ------------------------------------------------------------------*/
 // #define COMPUTER_ENVIRONMENT        // Define this if we're in Windows, Linux or Mac (not when flashing on DMB)
+                                      // The Host/ build passes -DCOMPUTER_ENVIRONMENT so headers that skip this file see it too
 
 #ifdef COMPUTER_ENVIRONMENT
 #define __CC_ARM
@@ -21,6 +22,7 @@
 /* System Wide Includes ------------------------------------------------------------------*/
 #include "main_avionics.hpp" // C++ Main File Header
 #include "UARTDriver.hpp"
+#include "StackBudgets.hpp" // Generated by Tools/StackBudget, sizes the task stacks below
 
 /* Cube++ Required Configuration ------------------------------------------------------------------*/
 #include "CubeDefines.hpp"
@@ -45,12 +47,12 @@ constexpr uint16_t UART_TASK_STACK_DEPTH_WORDS = 512; // Size of the uart task s
 // DEBUG TASK
 constexpr uint8_t TASK_DEBUG_PRIORITY = 2;             // Priority of the debug task
 constexpr uint8_t TASK_DEBUG_QUEUE_DEPTH_OBJS = 10;    // Size of the debug task queue
-constexpr uint16_t TASK_DEBUG_STACK_DEPTH_WORDS = 512; // Size of the debug task stack
+constexpr uint16_t TASK_DEBUG_STACK_DEPTH_WORDS = StackBudgetWords(TASK_DEBUG_STACK_BUDGET_BYTES); // Size of the debug task stack
 
 // FILESYSTEM TASK
 constexpr uint8_t TASK_FILESYSTEM_TASK_PRIORITY = 3;         // Priority of the filesystem task
-constexpr uint8_t TASK_FILESYSTEM_QUEUE_DEPTH_OBJS = 8;      // Size of the filesystem task queue
-constexpr uint16_t TASK_FILESYSTEM_STACK_DEPTH_WORDS = 1024; // Size of the filesystem task stack
+constexpr uint8_t TASK_FILESYSTEM_QUEUE_DEPTH_OBJS = 16;     // Size of the filesystem task queue, bounds outstanding async requests
+constexpr uint16_t TASK_FILESYSTEM_STACK_DEPTH_WORDS = StackBudgetWords(TASK_FILESYSTEM_STACK_BUDGET_BYTES); // Size of the filesystem task stack
 constexpr uint32_t FILESYSTEM_TASK_QUEUE_TIMEOUT_MS = 100;   // Queue timeout for filesystem task
 constexpr uint32_t FILESYSTEM_TASK_LOOP_DELAY_MS = 1000;     // Main loop delay for filesystem task
 
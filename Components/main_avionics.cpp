@@ -11,6 +11,10 @@
 #include "UARTDriver.hpp"
 #include "CubeTask.hpp"
 #include "FileSystemTask.hpp"
+#include "StaticAllocation.hpp"
+#ifdef COMPUTER_ENVIRONMENT
+#include "HostConsole.hpp"
+#endif
 
 /* Drivers ------------------------------------------------------------------*/
 namespace Driver
@@ -30,6 +34,9 @@ void run_main()
   CubeTask::Inst().InitTask();
   DebugTask::Inst().InitTask();
   FileSystemTask::Inst().InitTask();
+#ifdef COMPUTER_ENVIRONMENT
+  HostConsole::Inst().InitTask();
+#endif
 
   // Print System Boot Info : Warning, don't queue more than 10 prints before
   // scheduler starts
@@ -38,8 +45,13 @@ void run_main()
       "System Reset Reason: [TODO]\n"); // TODO: System reset reason can be
                                         // implemented via. Flash storage
   SOAR_PRINT("Current System Free Heap: %d Bytes\n", xPortGetFreeHeapSize());
-  SOAR_PRINT("Lowest Ever Free Heap: %d Bytes\n\n",
+  SOAR_PRINT("Lowest Ever Free Heap: %d Bytes\n",
              xPortGetMinimumEverFreeHeapSize());
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+  SOAR_PRINT("Static RTOS Storage: %lu Bytes\n",
+             StaticAllocation::Bytes());
+#endif
+  SOAR_PRINT("\n");
 
   // Start the Scheduler
   // Guidelines:
@@ -13,9 +13,11 @@
 #include "Mutex.hpp"
 // Board specific includes
 #include "stm32g4xx_hal.h"
+#ifndef COMPUTER_ENVIRONMENT
 #include "stm32g4xx_hal_rcc.h"
 #include "stm32g4xx_ll_dma.h"
 #include "stm32g4xx_ll_usart.h"
+#endif
 
 
 /* Interface Functions
@@ -0,0 +1,488 @@
+/**
+ ******************************************************************************
+  * @file    cache_diskio.c
+  * @brief   Set-associative write-back sector cache, stacked on another
+  *          diskio driver.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "cache_diskio.h"
+
+/* Private define ------------------------------------------------------------*/
+#define CACHEDISK_LINES     (CACHEDISK_SETS * CACHEDISK_WAYS)
+
+#if (CACHEDISK_SETS & (CACHEDISK_SETS - 1)) != 0
+#error "CACHEDISK_SETS must be a power of two"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  DWORD sector;
+  uint32_t lastUse;     /* Access stamp, smallest in a set is evicted */
+  uint8_t valid;
+  uint8_t dirty;
+} CacheLine_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const Diskio_drvTypeDef *Backend = NULL;
+static CacheLine_t Lines[CACHEDISK_LINES];
+static uint8_t LineData[CACHEDISK_LINES][CACHEDISK_SECTOR_SIZE] __attribute__((aligned(4)));
+static uint8_t CoalesceBuffer[CACHEDISK_COALESCE_SECTORS][CACHEDISK_SECTOR_SIZE] __attribute__((aligned(4)));
+static uint32_t AccessStamp = 0;
+static uint8_t Enabled = 1;
+static CACHEDISK_Stats_t Stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static DSTATUS CACHEDISK_initialize (BYTE pdrv);
+static DSTATUS CACHEDISK_status (BYTE pdrv);
+static DRESULT CACHEDISK_read (BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+#if _USE_WRITE == 1
+static DRESULT CACHEDISK_write (BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+#endif /* _USE_WRITE == 1 */
+#if _USE_IOCTL == 1
+static DRESULT CACHEDISK_ioctl (BYTE pdrv, BYTE cmd, void *buff);
+#endif /* _USE_IOCTL == 1 */
+
+static CacheLine_t *CACHEDISK_Lookup(DWORD sector);
+static CacheLine_t *CACHEDISK_Allocate(BYTE pdrv, DWORD sector, DRESULT *res);
+static DRESULT CACHEDISK_FlushRange(BYTE pdrv, DWORD first, DWORD last);
+static DRESULT CACHEDISK_BackendRead(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+static DRESULT CACHEDISK_BackendWrite(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+static void CACHEDISK_Invalidate(void);
+
+Diskio_drvTypeDef  CACHEDISK_Driver =
+{
+  CACHEDISK_initialize,
+  CACHEDISK_status,
+  CACHEDISK_read,
+#if  _USE_WRITE == 1
+  CACHEDISK_write,
+#endif /* _USE_WRITE == 1 */
+#if  _USE_IOCTL == 1
+  CACHEDISK_ioctl,
+#endif /* _USE_IOCTL == 1 */
+};
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Select the driver the cache sits on, call before disk_initialize.
+  *         Attaching the driver already in use keeps the cached lines
+  * @param  backend: Driver that performs the actual transfers
+  * @retval None
+  */
+void CACHEDISK_Attach(const Diskio_drvTypeDef *backend)
+{
+  if (backend == Backend)
+  {
+    return;
+  }
+
+  Backend = backend;
+  CACHEDISK_Invalidate();
+}
+
+/**
+  * @brief  Enable or bypass the cache at run time, dirty sectors are written
+  *         back before bypassing
+  * @param  pdrv: Physical drive number (0..)
+  * @param  enabled: Non zero to cache
+  * @retval DRESULT: Result of the write back
+  */
+DRESULT CACHEDISK_SetEnabled(BYTE pdrv, uint8_t enabled)
+{
+  DRESULT res = CACHEDISK_Flush(pdrv);
+  if (res == RES_OK)
+  {
+    CACHEDISK_Invalidate();
+    Enabled = enabled;
+  }
+  return res;
+}
+
+/**
+  * @brief  Write every dirty sector back, coalescing adjacent sectors
+  * @param  pdrv: Physical drive number (0..)
+  * @retval DRESULT: Operation result
+  */
+DRESULT CACHEDISK_Flush(BYTE pdrv)
+{
+  return CACHEDISK_FlushRange(pdrv, 0, (DWORD)0xFFFFFFFF);
+}
+
+/**
+  * @brief  Copy out the counters
+  * @param  stats: Destination of the counters
+  * @retval None
+  */
+void CACHEDISK_GetStats(CACHEDISK_Stats_t *stats)
+{
+  *stats = Stats;
+}
+
+/**
+  * @brief  Zero the counters
+  * @retval None
+  */
+void CACHEDISK_ResetStats(void)
+{
+  memset(&Stats, 0, sizeof(Stats));
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Initializes the backend. Dirty sectors are written back while the
+  *         backend still reports its media, the cache only starts empty
+  *         once the media went away and may have changed
+  * @param  pdrv: Physical drive number (0..)
+  * @retval DSTATUS: Operation status
+  */
+static DSTATUS CACHEDISK_initialize(BYTE pdrv)
+{
+  if (Backend == NULL)
+  {
+    return STA_NOINIT;
+  }
+
+  if (Backend->disk_status(pdrv) & STA_NOINIT)
+  {
+    CACHEDISK_Invalidate();
+  }
+  else
+  {
+    /* Remount of the same media, a failed write back keeps the lines dirty for the next sync */
+    CACHEDISK_Flush(pdrv);
+  }
+  return Backend->disk_initialize(pdrv);
+}
+
+/**
+  * @brief  Gets Disk Status
+  * @param  pdrv: Physical drive number (0..)
+  * @retval DSTATUS: Operation status
+  */
+static DSTATUS CACHEDISK_status(BYTE pdrv)
+{
+  if (Backend == NULL)
+  {
+    return STA_NOINIT;
+  }
+
+  return Backend->disk_status(pdrv);
+}
+
+/**
+  * @brief  Reads Sector(s)
+  * @param  pdrv: Physical drive number (0..)
+  * @param  *buff: Data buffer to store read data
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to read
+  * @retval DRESULT: Operation result
+  */
+static DRESULT CACHEDISK_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+  DRESULT res;
+
+  if (Backend == NULL)
+  {
+    return RES_NOTRDY;
+  }
+
+  if (!Enabled)
+  {
+    return CACHEDISK_BackendRead(pdrv, buff, sector, count);
+  }
+
+  if (count > 1)
+  {
+    /* Make the backend current for the range, then read around the cache */
+    res = CACHEDISK_FlushRange(pdrv, sector, sector + count - 1);
+    if (res != RES_OK)
+    {
+      return res;
+    }
+    return CACHEDISK_BackendRead(pdrv, buff, sector, count);
+  }
+
+  CacheLine_t *line = CACHEDISK_Lookup(sector);
+  if (line != NULL)
+  {
+    Stats.hits++;
+  }
+  else
+  {
+    Stats.misses++;
+    line = CACHEDISK_Allocate(pdrv, sector, &res);
+    if (line == NULL)
+    {
+      return res;
+    }
+    res = CACHEDISK_BackendRead(pdrv, LineData[line - Lines], sector, 1);
+    if (res != RES_OK)
+    {
+      return res;
+    }
+    line->valid = 1;
+  }
+
+  line->lastUse = ++AccessStamp;
+  memcpy(buff, LineData[line - Lines], CACHEDISK_SECTOR_SIZE);
+  return RES_OK;
+}
+
+/**
+  * @brief  Writes Sector(s)
+  * @param  pdrv: Physical drive number (0..)
+  * @param  *buff: Data to be written
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to write
+  * @retval DRESULT: Operation result
+  */
+#if _USE_WRITE == 1
+static DRESULT CACHEDISK_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+  DRESULT res;
+
+  if (Backend == NULL)
+  {
+    return RES_NOTRDY;
+  }
+
+  if (!Enabled)
+  {
+    return CACHEDISK_BackendWrite(pdrv, buff, sector, count);
+  }
+
+  if (count > 1)
+  {
+    res = CACHEDISK_BackendWrite(pdrv, buff, sector, count);
+    if (res != RES_OK)
+    {
+      return res;
+    }
+
+    /* Cached copies in the range now match the backend */
+    for (UINT i = 0; i < CACHEDISK_LINES; i++)
+    {
+      if (Lines[i].valid && Lines[i].sector >= sector && Lines[i].sector - sector < count)
+      {
+        memcpy(LineData[i], buff + (size_t)(Lines[i].sector - sector) * CACHEDISK_SECTOR_SIZE, CACHEDISK_SECTOR_SIZE);
+        Lines[i].dirty = 0;
+      }
+    }
+    return RES_OK;
+  }
+
+  CacheLine_t *line = CACHEDISK_Lookup(sector);
+  if (line != NULL)
+  {
+    Stats.hits++;
+  }
+  else
+  {
+    /* Whole sector is overwritten, no need to read it first */
+    Stats.misses++;
+    line = CACHEDISK_Allocate(pdrv, sector, &res);
+    if (line == NULL)
+    {
+      return res;
+    }
+    line->valid = 1;
+  }
+
+  memcpy(LineData[line - Lines], buff, CACHEDISK_SECTOR_SIZE);
+  line->dirty = 1;
+  line->lastUse = ++AccessStamp;
+  return RES_OK;
+}
+#endif /* _USE_WRITE == 1 */
+
+/**
+  * @brief  I/O control operation, CTRL_SYNC writes back the cache first
+  * @param  pdrv: Physical drive number (0..)
+  * @param  cmd: Control code
+  * @param  *buff: Buffer to send/receive control data
+  * @retval DRESULT: Operation result
+  */
+#if _USE_IOCTL == 1
+static DRESULT CACHEDISK_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+  if (Backend == NULL)
+  {
+    return RES_NOTRDY;
+  }
+
+  if (cmd == CTRL_SYNC)
+  {
+    DRESULT res = CACHEDISK_Flush(pdrv);
+    if (res != RES_OK)
+    {
+      return res;
+    }
+  }
+
+  return Backend->disk_ioctl(pdrv, cmd, buff);
+}
+#endif /* _USE_IOCTL == 1 */
+
+/**
+  * @brief  Find the line holding a sector
+  * @retval CacheLine_t*: The line, NULL on a miss
+  */
+static CacheLine_t *CACHEDISK_Lookup(DWORD sector)
+{
+  CacheLine_t *set = &Lines[(sector & (CACHEDISK_SETS - 1)) * CACHEDISK_WAYS];
+
+  for (UINT way = 0; way < CACHEDISK_WAYS; way++)
+  {
+    if (set[way].valid && set[way].sector == sector)
+    {
+      return &set[way];
+    }
+  }
+  return NULL;
+}
+
+/**
+  * @brief  Claim a line for a sector, writing back the least recently used
+  *         line of the set if it is dirty
+  * @param  res: Result of the write back when NULL is returned
+  * @retval CacheLine_t*: The claimed line marked invalid, NULL on failure
+  */
+static CacheLine_t *CACHEDISK_Allocate(BYTE pdrv, DWORD sector, DRESULT *res)
+{
+  CacheLine_t *set = &Lines[(sector & (CACHEDISK_SETS - 1)) * CACHEDISK_WAYS];
+  CacheLine_t *victim = &set[0];
+
+  for (UINT way = 0; way < CACHEDISK_WAYS; way++)
+  {
+    if (!set[way].valid)
+    {
+      victim = &set[way];
+      break;
+    }
+    if (set[way].lastUse < victim->lastUse)
+    {
+      victim = &set[way];
+    }
+  }
+
+  if (victim->valid)
+  {
+    Stats.evictions++;
+    if (victim->dirty)
+    {
+      *res = CACHEDISK_BackendWrite(pdrv, LineData[victim - Lines], victim->sector, 1);
+      if (*res != RES_OK)
+      {
+        return NULL;
+      }
+      Stats.writebacks++;
+    }
+  }
+
+  victim->sector = sector;
+  victim->valid = 0;
+  victim->dirty = 0;
+  return victim;
+}
+
+/**
+  * @brief  Write back dirty sectors in [first, last] in ascending order,
+  *         adjacent sectors are gathered into one backend write
+  * @retval DRESULT: Operation result
+  */
+static DRESULT CACHEDISK_FlushRange(BYTE pdrv, DWORD first, DWORD last)
+{
+  DWORD cursor = first;
+
+  for (;;)
+  {
+    /* Lowest dirty sector at or after the cursor, the cache is small enough to scan */
+    CacheLine_t *start = NULL;
+    for (UINT i = 0; i < CACHEDISK_LINES; i++)
+    {
+      if (Lines[i].dirty && Lines[i].sector >= cursor && Lines[i].sector <= last &&
+          (start == NULL || Lines[i].sector < start->sector))
+      {
+        start = &Lines[i];
+      }
+    }
+
+    if (start == NULL)
+    {
+      return RES_OK;
+    }
+
+    /* Extend the run while the next sector is also dirty */
+    UINT run = 1;
+    memcpy(CoalesceBuffer[0], LineData[start - Lines], CACHEDISK_SECTOR_SIZE);
+    start->dirty = 0;
+    while (run < CACHEDISK_COALESCE_SECTORS && start->sector + run <= last)
+    {
+      CacheLine_t *next = CACHEDISK_Lookup(start->sector + run);
+      if (next == NULL || !next->dirty)
+      {
+        break;
+      }
+      memcpy(CoalesceBuffer[run], LineData[next - Lines], CACHEDISK_SECTOR_SIZE);
+      next->dirty = 0;
+      run++;
+    }
+
+    DRESULT res = CACHEDISK_BackendWrite(pdrv, CoalesceBuffer[0], start->sector, run);
+    if (res != RES_OK)
+    {
+      /* Keep the data dirty so a later sync can retry */
+      for (UINT i = 0; i < run; i++)
+      {
+        CACHEDISK_Lookup(start->sector + i)->dirty = 1;
+      }
+      return res;
+    }
+
+    Stats.writebacks += run;
+    cursor = start->sector + run;
+    if (cursor == 0)
+    {
+      /* Wrapped past the last LBA */
+      return RES_OK;
+    }
+  }
+}
+
+/**
+  * @brief  Backend read with traffic counting
+  */
+static DRESULT CACHEDISK_BackendRead(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+  Stats.backendReadCalls++;
+  return Backend->disk_read(pdrv, buff, sector, count);
+}
+
+/**
+  * @brief  Backend write with traffic counting
+  */
+static DRESULT CACHEDISK_BackendWrite(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+#if _USE_WRITE == 1
+  Stats.backendWriteCalls++;
+  Stats.backendWriteSectors += count;
+  return Backend->disk_write(pdrv, buff, sector, count);
+#else
+  return RES_WRPRT;
+#endif /* _USE_WRITE == 1 */
+}
+
+/**
+  * @brief  Drop every line without writing it back
+  */
+static void CACHEDISK_Invalidate(void)
+{
+  memset(Lines, 0, sizeof(Lines));
+  AccessStamp = 0;
+}
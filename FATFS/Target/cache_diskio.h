@@ -0,0 +1,68 @@
+/**
+ ******************************************************************************
+  * @file    cache_diskio.h
+  * @brief   Set-associative write-back sector cache, stacked on another
+  *          diskio driver.
+  ******************************************************************************
+  * Single sector accesses (FAT, directory and partial data sectors) are held
+  * in a CACHEDISK_SETS x CACHEDISK_WAYS cache with LRU replacement per set.
+  * Dirty sectors reach the backend on eviction or CTRL_SYNC, where runs of
+  * adjacent dirty sectors go out as one multi-sector write. FatFS issues
+  * CTRL_SYNC from f_sync/f_close, so durability at those points is unchanged.
+  *
+  * Multi-sector transfers are streaming file data and go straight to the
+  * backend so they do not evict the FAT sectors worth keeping; any cached
+  * copy in the range is kept coherent.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CACHE_DISKIO_H
+#define __CACHE_DISKIO_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "ff_gen_drv.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Cache effectiveness and backend traffic, counted whether or not the cache is enabled */
+typedef struct
+{
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;           /* Valid lines replaced */
+  uint32_t writebacks;          /* Dirty sectors written to the backend */
+  uint32_t backendReadCalls;
+  uint32_t backendWriteCalls;
+  uint32_t backendWriteSectors;
+} CACHEDISK_Stats_t;
+
+/* Exported constants --------------------------------------------------------*/
+#define CACHEDISK_SECTOR_SIZE       512
+#ifndef CACHEDISK_SETS
+#define CACHEDISK_SETS              4     /* Power of two, sector N maps to set N % SETS */
+#endif
+#ifndef CACHEDISK_WAYS
+#define CACHEDISK_WAYS              2
+#endif
+#ifndef CACHEDISK_COALESCE_SECTORS
+#define CACHEDISK_COALESCE_SECTORS  4     /* Longest run written in one call on flush */
+#endif
+
+/* Exported functions ------------------------------------------------------- */
+extern Diskio_drvTypeDef  CACHEDISK_Driver;
+
+void CACHEDISK_Attach(const Diskio_drvTypeDef *backend);
+DRESULT CACHEDISK_SetEnabled(BYTE pdrv, uint8_t enabled);
+DRESULT CACHEDISK_Flush(BYTE pdrv);
+void CACHEDISK_GetStats(CACHEDISK_Stats_t *stats);
+void CACHEDISK_ResetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CACHE_DISKIO_H */
@@ -0,0 +1,271 @@
+/**
+ ******************************************************************************
+  * @file    fault_diskio.c
+  * @brief   Power loss injection stacked on another diskio driver, for crash
+  *          consistency tests on the host.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "fault_diskio.h"
+
+/* Private variables ---------------------------------------------------------*/
+static const Diskio_drvTypeDef *Backend = NULL;
+static uint8_t Armed = 0;
+static uint8_t PowerLost = 0;
+static uint32_t SectorsLeft = 0;    /* Written whole before the cut */
+static uint32_t RandomState = 1;
+static uint8_t TornSector[FAULTDISK_SECTOR_SIZE] __attribute__((aligned(4)));
+static FAULTDISK_Stats_t Stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static DSTATUS FAULTDISK_initialize (BYTE pdrv);
+static DSTATUS FAULTDISK_status (BYTE pdrv);
+static DRESULT FAULTDISK_read (BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+#if _USE_WRITE == 1
+static DRESULT FAULTDISK_write (BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+#endif /* _USE_WRITE == 1 */
+#if _USE_IOCTL == 1
+static DRESULT FAULTDISK_ioctl (BYTE pdrv, BYTE cmd, void *buff);
+#endif /* _USE_IOCTL == 1 */
+
+static uint32_t FAULTDISK_Random(void);
+
+Diskio_drvTypeDef  FAULTDISK_Driver =
+{
+  FAULTDISK_initialize,
+  FAULTDISK_status,
+  FAULTDISK_read,
+#if  _USE_WRITE == 1
+  FAULTDISK_write,
+#endif /* _USE_WRITE == 1 */
+#if  _USE_IOCTL == 1
+  FAULTDISK_ioctl,
+#endif /* _USE_IOCTL == 1 */
+};
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Select the driver power is cut in front of, call before disk_initialize
+  * @param  backend: Driver that performs the actual transfers
+  * @retval None
+  */
+void FAULTDISK_Attach(const Diskio_drvTypeDef *backend)
+{
+  Backend = backend;
+}
+
+/**
+  * @brief  Cut power while a later sector is being written
+  * @param  sectors: Sectors written whole from now on before the one that is torn, 0 tears the next one
+  * @param  seed: Seeds how much of the torn sector is written
+  * @retval None
+  */
+void FAULTDISK_Arm(uint32_t sectors, uint32_t seed)
+{
+  SectorsLeft = sectors;
+  RandomState = (seed != 0) ? seed : 1;
+  Armed = 1;
+}
+
+/**
+  * @brief  Restore power and stop counting, the next disk_initialize is the reboot
+  * @retval None
+  */
+void FAULTDISK_Disarm(void)
+{
+  Armed = 0;
+  PowerLost = 0;
+}
+
+/**
+  * @brief  Whether power was cut since the last FAULTDISK_Disarm
+  * @retval uint8_t Non zero once cut
+  */
+uint8_t FAULTDISK_PowerLost(void)
+{
+  return PowerLost;
+}
+
+/**
+  * @brief  Copy out the counters
+  * @param  stats: Destination of the counters
+  * @retval None
+  */
+void FAULTDISK_GetStats(FAULTDISK_Stats_t *stats)
+{
+  *stats = Stats;
+}
+
+/**
+  * @brief  Zero the counters
+  * @retval None
+  */
+void FAULTDISK_ResetStats(void)
+{
+  memset(&Stats, 0, sizeof(Stats));
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Initializes the backend, refused while power is cut
+  * @param  pdrv: Physical drive number (0..)
+  * @retval DSTATUS: Operation status
+  */
+static DSTATUS FAULTDISK_initialize(BYTE pdrv)
+{
+  if (Backend == NULL || PowerLost)
+  {
+    return STA_NOINIT;
+  }
+
+  return Backend->disk_initialize(pdrv);
+}
+
+/**
+  * @brief  Gets Disk Status
+  * @param  pdrv: Physical drive number (0..)
+  * @retval DSTATUS: Operation status
+  */
+static DSTATUS FAULTDISK_status(BYTE pdrv)
+{
+  if (Backend == NULL || PowerLost)
+  {
+    return STA_NOINIT;
+  }
+
+  return Backend->disk_status(pdrv);
+}
+
+/**
+  * @brief  Reads Sector(s)
+  * @param  pdrv: Physical drive number (0..)
+  * @param  *buff: Data buffer to store read data
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to read
+  * @retval DRESULT: Operation result
+  */
+static DRESULT FAULTDISK_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+  if (Backend == NULL)
+  {
+    return RES_NOTRDY;
+  }
+
+  if (PowerLost)
+  {
+    Stats.failedCalls++;
+    return RES_NOTRDY;
+  }
+
+  return Backend->disk_read(pdrv, buff, sector, count);
+}
+
+/**
+  * @brief  Writes Sector(s), tearing the one power is cut on
+  * @param  pdrv: Physical drive number (0..)
+  * @param  *buff: Data to be written
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to write
+  * @retval DRESULT: Operation result
+  */
+#if _USE_WRITE == 1
+static DRESULT FAULTDISK_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+  DRESULT res;
+
+  if (Backend == NULL)
+  {
+    return RES_NOTRDY;
+  }
+
+  if (PowerLost)
+  {
+    Stats.failedCalls++;
+    return RES_NOTRDY;
+  }
+
+  if (!Armed || count <= SectorsLeft)
+  {
+    res = Backend->disk_write(pdrv, buff, sector, count);
+    if (res == RES_OK)
+    {
+      Stats.sectorsWritten += count;
+      if (Armed)
+      {
+        SectorsLeft -= count;
+      }
+    }
+    return res;
+  }
+
+  /* The sectors ahead of the cut land whole */
+  if (SectorsLeft > 0)
+  {
+    res = Backend->disk_write(pdrv, buff, sector, SectorsLeft);
+    if (res != RES_OK)
+    {
+      return res;
+    }
+    Stats.sectorsWritten += SectorsLeft;
+    buff += (size_t)SectorsLeft * FAULTDISK_SECTOR_SIZE;
+    sector += SectorsLeft;
+  }
+
+  /* Then a prefix of the next one over its old content */
+  uint32_t torn = FAULTDISK_Random() % FAULTDISK_SECTOR_SIZE;
+  if (Backend->disk_read(pdrv, TornSector, sector, 1) == RES_OK)
+  {
+    memcpy(TornSector, buff, torn);
+    Backend->disk_write(pdrv, TornSector, sector, 1);
+  }
+
+  Armed = 0;
+  PowerLost = 1;
+  SectorsLeft = 0;
+  Stats.powerCuts++;
+  Stats.tornBytes = torn;
+  Stats.failedCalls++;
+  return RES_NOTRDY;
+}
+#endif /* _USE_WRITE == 1 */
+
+/**
+  * @brief  I/O control operation
+  * @param  pdrv: Physical drive number (0..)
+  * @param  cmd: Control code
+  * @param  *buff: Buffer to send/receive control data
+  * @retval DRESULT: Operation result
+  */
+#if _USE_IOCTL == 1
+static DRESULT FAULTDISK_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+  if (Backend == NULL)
+  {
+    return RES_NOTRDY;
+  }
+
+  if (PowerLost)
+  {
+    Stats.failedCalls++;
+    return RES_NOTRDY;
+  }
+
+  return Backend->disk_ioctl(pdrv, cmd, buff);
+}
+#endif /* _USE_IOCTL == 1 */
+
+/**
+  * @brief  xorshift32, the sequence only depends on the seed given to FAULTDISK_Arm
+  * @retval uint32_t Next value
+  */
+static uint32_t FAULTDISK_Random(void)
+{
+  RandomState ^= RandomState << 13;
+  RandomState ^= RandomState >> 17;
+  RandomState ^= RandomState << 5;
+  return RandomState;
+}
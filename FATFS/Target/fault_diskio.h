@@ -0,0 +1,54 @@
+/**
+ ******************************************************************************
+  * @file    fault_diskio.h
+  * @brief   Power loss injection stacked on another diskio driver, for crash
+  *          consistency tests on the host.
+  ******************************************************************************
+  * Once armed, the sectors written through FAULTDISK are counted and power is
+  * cut at a chosen one: only a random prefix of that sector reaches the
+  * backend, and every later transfer fails as if the drive were gone, until
+  * FAULTDISK_Disarm restores power. Whatever the layers above still held in
+  * RAM, e.g. the dirty lines of cache_diskio, is dropped by the next
+  * disk_initialize, as after a real reset. Stack it below the cache so the
+  * order sectors reach the media in is the one a real drive would see.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FAULT_DISKIO_H
+#define __FAULT_DISKIO_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "ff_gen_drv.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t sectorsWritten;  /* Reached the backend whole */
+  uint32_t powerCuts;
+  uint32_t tornBytes;       /* Of the sector being written at the last cut */
+  uint32_t failedCalls;     /* Transfers refused without power */
+} FAULTDISK_Stats_t;
+
+/* Exported constants --------------------------------------------------------*/
+#define FAULTDISK_SECTOR_SIZE       512
+
+/* Exported functions ------------------------------------------------------- */
+extern Diskio_drvTypeDef  FAULTDISK_Driver;
+
+void FAULTDISK_Attach(const Diskio_drvTypeDef *backend);
+void FAULTDISK_Arm(uint32_t sectors, uint32_t seed);
+void FAULTDISK_Disarm(void);
+uint8_t FAULTDISK_PowerLost(void);
+void FAULTDISK_GetStats(FAULTDISK_Stats_t *stats);
+void FAULTDISK_ResetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FAULT_DISKIO_H */
@@ -0,0 +1,224 @@
+/**
+ ******************************************************************************
+  * @file    image_diskio.c
+  * @brief   Host (Linux) diskio backend over a memory-mapped disk image file.
+  ******************************************************************************
+  */
+#if defined(__linux__)
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "image_diskio.h"
+
+/* Private variables ---------------------------------------------------------*/
+static int ImageFd = -1;
+static uint8_t *Image = NULL;
+static uint32_t ImageSectors = 0;
+static volatile DSTATUS Stat = STA_NOINIT;
+
+/* Private function prototypes -----------------------------------------------*/
+static DSTATUS IMAGEDISK_initialize (BYTE pdrv);
+static DSTATUS IMAGEDISK_status (BYTE pdrv);
+static DRESULT IMAGEDISK_read (BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+#if _USE_WRITE == 1
+static DRESULT IMAGEDISK_write (BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+#endif /* _USE_WRITE == 1 */
+#if _USE_IOCTL == 1
+static DRESULT IMAGEDISK_ioctl (BYTE pdrv, BYTE cmd, void *buff);
+#endif /* _USE_IOCTL == 1 */
+
+Diskio_drvTypeDef  IMAGEDISK_Driver =
+{
+  IMAGEDISK_initialize,
+  IMAGEDISK_status,
+  IMAGEDISK_read,
+#if  _USE_WRITE == 1
+  IMAGEDISK_write,
+#endif /* _USE_WRITE == 1 */
+#if  _USE_IOCTL == 1
+  IMAGEDISK_ioctl,
+#endif /* _USE_IOCTL == 1 */
+};
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Map an image file, creating or growing it to sectorCount sectors
+  */
+int IMAGEDISK_Open(const char *path, uint32_t sectorCount)
+{
+  IMAGEDISK_Close();
+
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+  {
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  off_t size = (off_t)sectorCount * IMAGEDISK_SECTOR_SIZE;
+  if (st.st_size > size)
+  {
+    size = st.st_size - (st.st_size % IMAGEDISK_SECTOR_SIZE);
+  }
+  else if (st.st_size < size && ftruncate(fd, size) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  void *map = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED)
+  {
+    close(fd);
+    return -1;
+  }
+
+  ImageFd = fd;
+  Image = (uint8_t *)map;
+  ImageSectors = (uint32_t)(size / IMAGEDISK_SECTOR_SIZE);
+  Stat = 0;
+  return 0;
+}
+
+/**
+  * @brief  Flush and unmap the image
+  */
+void IMAGEDISK_Close(void)
+{
+  if (Image != NULL)
+  {
+    msync(Image, (size_t)ImageSectors * IMAGEDISK_SECTOR_SIZE, MS_SYNC);
+    munmap(Image, (size_t)ImageSectors * IMAGEDISK_SECTOR_SIZE);
+    close(ImageFd);
+  }
+
+  ImageFd = -1;
+  Image = NULL;
+  ImageSectors = 0;
+  Stat = STA_NOINIT;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Initializes the drive, opening the default image if none is mapped
+  * @param  pdrv: Physical drive number (0..)
+  * @retval DSTATUS: Operation status
+  */
+static DSTATUS IMAGEDISK_initialize(BYTE pdrv)
+{
+  if (Image == NULL)
+  {
+    const char *path = getenv(IMAGEDISK_PATH_ENV);
+    IMAGEDISK_Open((path != NULL) ? path : IMAGEDISK_DEFAULT_PATH, IMAGEDISK_DEFAULT_SECTORS);
+  }
+  return Stat;
+}
+
+/**
+  * @brief  Gets Disk Status
+  * @param  pdrv: Physical drive number (0..)
+  * @retval DSTATUS: Operation status
+  */
+static DSTATUS IMAGEDISK_status(BYTE pdrv)
+{
+  return Stat;
+}
+
+/**
+  * @brief  Reads Sector(s)
+  * @param  pdrv: Physical drive number (0..)
+  * @param  *buff: Data buffer to store read data
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to read
+  * @retval DRESULT: Operation result
+  */
+static DRESULT IMAGEDISK_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+  if (Stat & STA_NOINIT)
+  {
+    return RES_NOTRDY;
+  }
+
+  if (count == 0 || sector >= ImageSectors || count > ImageSectors - sector)
+  {
+    return RES_PARERR;
+  }
+
+  memcpy(buff, Image + (size_t)sector * IMAGEDISK_SECTOR_SIZE, (size_t)count * IMAGEDISK_SECTOR_SIZE);
+  return RES_OK;
+}
+
+/**
+  * @brief  Writes Sector(s)
+  * @param  pdrv: Physical drive number (0..)
+  * @param  *buff: Data to be written
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to write
+  * @retval DRESULT: Operation result
+  */
+#if _USE_WRITE == 1
+static DRESULT IMAGEDISK_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+  if (Stat & STA_NOINIT)
+  {
+    return RES_NOTRDY;
+  }
+
+  if (count == 0 || sector >= ImageSectors || count > ImageSectors - sector)
+  {
+    return RES_PARERR;
+  }
+
+  memcpy(Image + (size_t)sector * IMAGEDISK_SECTOR_SIZE, buff, (size_t)count * IMAGEDISK_SECTOR_SIZE);
+  return RES_OK;
+}
+#endif /* _USE_WRITE == 1 */
+
+/**
+  * @brief  I/O control operation
+  * @param  pdrv: Physical drive number (0..)
+  * @param  cmd: Control code
+  * @param  *buff: Buffer to send/receive control data
+  * @retval DRESULT: Operation result
+  */
+#if _USE_IOCTL == 1
+static DRESULT IMAGEDISK_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+  if (Stat & STA_NOINIT)
+  {
+    return RES_NOTRDY;
+  }
+
+  switch (cmd)
+  {
+  case CTRL_SYNC:
+    return (msync(Image, (size_t)ImageSectors * IMAGEDISK_SECTOR_SIZE, MS_SYNC) == 0) ? RES_OK : RES_ERROR;
+  case GET_SECTOR_COUNT:
+    *(DWORD *)buff = ImageSectors;
+    return RES_OK;
+  case GET_SECTOR_SIZE:
+    *(WORD *)buff = IMAGEDISK_SECTOR_SIZE;
+    return RES_OK;
+  case GET_BLOCK_SIZE:
+    *(DWORD *)buff = 1;
+    return RES_OK;
+  default:
+    return RES_PARERR;
+  }
+}
+#endif /* _USE_IOCTL == 1 */
+
+#endif /* __linux__ */
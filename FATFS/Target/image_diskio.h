@@ -0,0 +1,53 @@
+/**
+ ******************************************************************************
+  * @file    image_diskio.h
+  * @brief   Host (Linux) diskio backend over a memory-mapped disk image file.
+  ******************************************************************************
+  * The image is created or grown to the requested size on open and can be
+  * inspected afterwards with standard tools, e.g. mtools or a loop mount.
+  * Only compiled on Linux, the target build sees an empty translation unit.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __IMAGE_DISKIO_H
+#define __IMAGE_DISKIO_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "ff_gen_drv.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define IMAGEDISK_SECTOR_SIZE       512
+#ifndef IMAGEDISK_DEFAULT_PATH
+#define IMAGEDISK_DEFAULT_PATH      "soarfs.img"
+#endif
+#ifndef IMAGEDISK_DEFAULT_SECTORS
+#define IMAGEDISK_DEFAULT_SECTORS   131072  /* 64 MB */
+#endif
+#define IMAGEDISK_PATH_ENV          "SOARFS_DISK_IMAGE" /* Overrides the default path when set */
+
+/* Exported functions ------------------------------------------------------- */
+extern Diskio_drvTypeDef  IMAGEDISK_Driver;
+
+/**
+  * @brief  Map an image file, creating or growing it to sectorCount sectors
+  * @param  path: Image file path
+  * @param  sectorCount: Size of the volume, an existing larger image keeps its size
+  * @retval 0 on success, -1 on failure
+  */
+int IMAGEDISK_Open(const char *path, uint32_t sectorCount);
+
+/**
+  * @brief  Flush and unmap the image, the next disk_initialize reopens the default image
+  */
+void IMAGEDISK_Close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IMAGE_DISKIO_H */
@@ -0,0 +1,164 @@
+/**
+ ******************************************************************************
+  * @file    ram_diskio.c
+  * @brief   Static RAM disk diskio backend, sized at compile time.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "ram_diskio.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t RamDisk[RAMDISK_SECTOR_COUNT][RAMDISK_SECTOR_SIZE] __attribute__((aligned(4)));
+static volatile DSTATUS Stat = STA_NOINIT;
+static volatile uint8_t Present = 1;
+
+/* Private function prototypes -----------------------------------------------*/
+static DSTATUS RAMDISK_initialize (BYTE pdrv);
+static DSTATUS RAMDISK_status (BYTE pdrv);
+static DRESULT RAMDISK_read (BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+#if _USE_WRITE == 1
+static DRESULT RAMDISK_write (BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+#endif /* _USE_WRITE == 1 */
+#if _USE_IOCTL == 1
+static DRESULT RAMDISK_ioctl (BYTE pdrv, BYTE cmd, void *buff);
+#endif /* _USE_IOCTL == 1 */
+
+Diskio_drvTypeDef  RAMDISK_Driver =
+{
+  RAMDISK_initialize,
+  RAMDISK_status,
+  RAMDISK_read,
+#if  _USE_WRITE == 1
+  RAMDISK_write,
+#endif /* _USE_WRITE == 1 */
+#if  _USE_IOCTL == 1
+  RAMDISK_ioctl,
+#endif /* _USE_IOCTL == 1 */
+};
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Simulate pulling or reinserting the media, contents are kept
+  * @param  present: 0 to remove, 1 to insert
+  * @retval None
+  */
+void RAMDISK_SetPresent(uint8_t present)
+{
+  Present = present;
+  if (!present)
+  {
+    Stat = STA_NOINIT | STA_NODISK;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Initializes the RAM disk, contents are kept across calls
+  * @param  pdrv: Physical drive number (0..)
+  * @retval DSTATUS: Operation status
+  */
+static DSTATUS RAMDISK_initialize(BYTE pdrv)
+{
+  Stat = Present ? 0 : (STA_NOINIT | STA_NODISK);
+  return Stat;
+}
+
+/**
+  * @brief  Gets Disk Status
+  * @param  pdrv: Physical drive number (0..)
+  * @retval DSTATUS: Operation status
+  */
+static DSTATUS RAMDISK_status(BYTE pdrv)
+{
+  return Stat;
+}
+
+/**
+  * @brief  Reads Sector(s)
+  * @param  pdrv: Physical drive number (0..)
+  * @param  *buff: Data buffer to store read data
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to read
+  * @retval DRESULT: Operation result
+  */
+static DRESULT RAMDISK_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+  if (Stat & STA_NOINIT)
+  {
+    return RES_NOTRDY;
+  }
+
+  if (count == 0 || sector >= RAMDISK_SECTOR_COUNT || count > RAMDISK_SECTOR_COUNT - sector)
+  {
+    return RES_PARERR;
+  }
+
+  memcpy(buff, RamDisk[sector], (size_t)count * RAMDISK_SECTOR_SIZE);
+  return RES_OK;
+}
+
+/**
+  * @brief  Writes Sector(s)
+  * @param  pdrv: Physical drive number (0..)
+  * @param  *buff: Data to be written
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to write
+  * @retval DRESULT: Operation result
+  */
+#if _USE_WRITE == 1
+static DRESULT RAMDISK_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+  if (Stat & STA_NOINIT)
+  {
+    return RES_NOTRDY;
+  }
+
+  if (count == 0 || sector >= RAMDISK_SECTOR_COUNT || count > RAMDISK_SECTOR_COUNT - sector)
+  {
+    return RES_PARERR;
+  }
+
+  memcpy(RamDisk[sector], buff, (size_t)count * RAMDISK_SECTOR_SIZE);
+  return RES_OK;
+}
+#endif /* _USE_WRITE == 1 */
+
+/**
+  * @brief  I/O control operation
+  * @param  pdrv: Physical drive number (0..)
+  * @param  cmd: Control code
+  * @param  *buff: Buffer to send/receive control data
+  * @retval DRESULT: Operation result
+  */
+#if _USE_IOCTL == 1
+static DRESULT RAMDISK_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+  if (Stat & STA_NOINIT)
+  {
+    return RES_NOTRDY;
+  }
+
+  switch (cmd)
+  {
+  case CTRL_SYNC:
+    /* Writes land in RAM immediately */
+    return RES_OK;
+  case GET_SECTOR_COUNT:
+    *(DWORD *)buff = RAMDISK_SECTOR_COUNT;
+    return RES_OK;
+  case GET_SECTOR_SIZE:
+    *(WORD *)buff = RAMDISK_SECTOR_SIZE;
+    return RES_OK;
+  case GET_BLOCK_SIZE:
+    /* No erase block, report a single sector */
+    *(DWORD *)buff = 1;
+    return RES_OK;
+  default:
+    return RES_PARERR;
+  }
+}
+#endif /* _USE_IOCTL == 1 */
@@ -0,0 +1,38 @@
+/**
+ ******************************************************************************
+  * @file    ram_diskio.h
+  * @brief   Static RAM disk diskio backend, sized at compile time.
+  ******************************************************************************
+  * The whole volume lives in .bss and is lost on reset, it exists to exercise
+  * and benchmark the FatFS/SoarFS stack without media. f_mkfs needs at least
+  * 128 sectors, so budget 64 KB of RAM (reduce configTOTAL_HEAP_SIZE) before
+  * selecting it on target.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RAM_DISKIO_H
+#define __RAM_DISKIO_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "ff_gen_drv.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define RAMDISK_SECTOR_SIZE         512
+#ifndef RAMDISK_SECTOR_COUNT
+#define RAMDISK_SECTOR_COUNT        128   /* Minimum f_mkfs accepts */
+#endif
+
+/* Exported functions ------------------------------------------------------- */
+extern Diskio_drvTypeDef  RAMDISK_Driver;
+void RAMDISK_SetPresent(uint8_t present);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RAM_DISKIO_H */
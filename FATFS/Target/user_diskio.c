@@ -35,13 +35,65 @@
 /* Includes ------------------------------------------------------------------*/
 #include <string.h>
 #include "ff_gen_drv.h"
+#include "user_diskio.h"
+#if USER_DISKIO_BACKEND == USER_DISKIO_BACKEND_RAMDISK
+#include "ram_diskio.h"
+#elif USER_DISKIO_BACKEND == USER_DISKIO_BACKEND_IMAGE
+#include "image_diskio.h"
+#endif
+#if USER_DISKIO_CACHE
+#include "cache_diskio.h"
+#endif
+#if USER_DISKIO_FAULT
+#include "fault_diskio.h"
+#endif
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+#if USER_DISKIO_BACKEND == USER_DISKIO_BACKEND_RAMDISK
+#define USER_MEDIA (&RAMDISK_Driver)
+#elif USER_DISKIO_BACKEND == USER_DISKIO_BACKEND_IMAGE
+#define USER_MEDIA (&IMAGEDISK_Driver)
+#endif
+
+/* Driver in front of the media, the power loss injector when enabled */
+#if defined(USER_MEDIA) && USER_DISKIO_FAULT
+#define USER_STORAGE (&FAULTDISK_Driver)
+#elif defined(USER_MEDIA)
+#define USER_STORAGE USER_MEDIA
+#endif
+
+/* Driver USER_Driver forwards to, the cache when enabled, which then forwards to the storage */
+#if defined(USER_MEDIA) && USER_DISKIO_CACHE
+#define USER_BACKEND (&CACHEDISK_Driver)
+#elif defined(USER_MEDIA)
+#define USER_BACKEND USER_STORAGE
+#endif
 
 /* Private variables ---------------------------------------------------------*/
 /* Disk status */
 static volatile DSTATUS Stat = STA_NOINIT;
+/* Transfer counters */
+static USER_DiskStats_t DiskStats;
+
+/**
+  * @brief  Copy out the transfer counters
+  * @param  stats: Destination of the counters
+  * @retval None
+  */
+void USER_GetDiskStats(USER_DiskStats_t *stats)
+{
+  *stats = DiskStats;
+}
+
+/**
+  * @brief  Zero the transfer counters
+  * @retval None
+  */
+void USER_ResetDiskStats(void)
+{
+  memset(&DiskStats, 0, sizeof(DiskStats));
+}
 
 /* USER CODE END DECL */
 
@@ -81,7 +133,17 @@ DSTATUS USER_initialize (
 )
 {
   /* USER CODE BEGIN INIT */
+#if defined(USER_MEDIA) && USER_DISKIO_FAULT
+    FAULTDISK_Attach(USER_MEDIA);
+#endif
+#if defined(USER_MEDIA) && USER_DISKIO_CACHE
+    CACHEDISK_Attach(USER_STORAGE);
+#endif
+#ifdef USER_BACKEND
+    Stat = USER_BACKEND->disk_initialize(pdrv);
+#else
     Stat = STA_NOINIT;
+#endif
     return Stat;
   /* USER CODE END INIT */
 }
@@ -96,7 +158,11 @@ DSTATUS USER_status (
 )
 {
   /* USER CODE BEGIN STATUS */
+#ifdef USER_BACKEND
+    Stat = USER_BACKEND->disk_status(pdrv);
+#else
     Stat = STA_NOINIT;
+#endif
     return Stat;
   /* USER CODE END STATUS */
 }
@@ -117,7 +183,13 @@ DRESULT USER_read (
 )
 {
   /* USER CODE BEGIN READ */
-    return RES_OK;
+    DiskStats.readCalls++;
+    DiskStats.readSectors += count;
+#ifdef USER_BACKEND
+    return USER_BACKEND->disk_read(pdrv, buff, sector, count);
+#else
+    return RES_NOTRDY;
+#endif
   /* USER CODE END READ */
 }
 
@@ -139,7 +211,13 @@ DRESULT USER_write (
 {
   /* USER CODE BEGIN WRITE */
   /* USER CODE HERE */
-    return RES_OK;
+    DiskStats.writeCalls++;
+    DiskStats.writeSectors += count;
+#ifdef USER_BACKEND
+    return USER_BACKEND->disk_write(pdrv, buff, sector, count);
+#else
+    return RES_NOTRDY;
+#endif
   /* USER CODE END WRITE */
 }
 #endif /* _USE_WRITE == 1 */
@@ -160,6 +238,13 @@ DRESULT USER_ioctl (
 {
   /* USER CODE BEGIN IOCTL */
     DRESULT res = RES_ERROR;
+    if (cmd == CTRL_SYNC)
+    {
+      DiskStats.syncCalls++;
+    }
+#ifdef USER_BACKEND
+    res = USER_BACKEND->disk_ioctl(pdrv, cmd, buff);
+#endif
     return res;
   /* USER CODE END IOCTL */
 }
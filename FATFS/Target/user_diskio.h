@@ -30,10 +30,51 @@
 
 /* Includes ------------------------------------------------------------------*/
 /* Exported types ------------------------------------------------------------*/
+/* Transfer counters, every FatFS access to the drive passes through USER_Driver */
+typedef struct
+{
+  uint32_t readCalls;
+  uint32_t readSectors;
+  uint32_t writeCalls;
+  uint32_t writeSectors;
+  uint32_t syncCalls;
+} USER_DiskStats_t;
+
 /* Exported constants --------------------------------------------------------*/
+/* Backend USER_Driver forwards to, override with -DUSER_DISKIO_BACKEND=... */
+#define USER_DISKIO_BACKEND_MEDIA     0   /* Physical media driver, not implemented yet */
+#define USER_DISKIO_BACKEND_RAMDISK   1   /* Static RAM disk, see ram_diskio.h */
+#define USER_DISKIO_BACKEND_IMAGE     2   /* Host disk image file, see image_diskio.h */
+
+#ifndef USER_DISKIO_BACKEND
+#if defined(__linux__)
+#define USER_DISKIO_BACKEND           USER_DISKIO_BACKEND_IMAGE
+#else
+#define USER_DISKIO_BACKEND           USER_DISKIO_BACKEND_MEDIA
+#endif
+#endif
+
+/* Stack the write-back sector cache (cache_diskio.h) on the backend, override with -DUSER_DISKIO_CACHE=0.
+   Off for the media backend, which has no driver for the cache to sit on yet */
+#ifndef USER_DISKIO_CACHE
+#if USER_DISKIO_BACKEND == USER_DISKIO_BACKEND_MEDIA
+#define USER_DISKIO_CACHE             0
+#else
+#define USER_DISKIO_CACHE             1
+#endif
+#endif
+
+/* Stack the power loss injector (fault_diskio.h) under the cache, host tests only, enable with -DUSER_DISKIO_FAULT=1 */
+#ifndef USER_DISKIO_FAULT
+#define USER_DISKIO_FAULT             0
+#endif
+
 /* Exported functions ------------------------------------------------------- */
 extern Diskio_drvTypeDef  USER_Driver;
 
+void USER_GetDiskStats(USER_DiskStats_t *stats);
+void USER_ResetDiskStats(void);
+
 /* USER CODE END 0 */
 
 #ifdef __cplusplus
@@ -0,0 +1,71 @@
+/*
+ * FreeRTOS Kernel V10.3.1
+ *
+ * Host (Linux) configuration for the FreeRTOS POSIX port.
+ *
+ * Mirrors Core/Inc/FreeRTOSConfig.h wherever the application can observe the
+ * difference (tick rate, priorities, heap size, task name length) so task
+ * timing and heap pressure match the target. Interrupt priority and
+ * Cortex-M handler mappings have no meaning on the POSIX port and are left out.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <stdint.h>
+
+#define configUSE_PREEMPTION                     1
+#define configSUPPORT_STATIC_ALLOCATION          1
+#define configSUPPORT_DYNAMIC_ALLOCATION         1
+#define configUSE_IDLE_HOOK                      0
+#define configUSE_TICK_HOOK                      0
+#define configGENERATE_RUN_TIME_STATS            1
+#define configUSE_TRACE_FACILITY                 1
+#define configTICK_RATE_HZ                       ((TickType_t)1000)
+#define configMAX_PRIORITIES                     ( 7 )
+#define configMINIMAL_STACK_SIZE                 ((uint16_t)192)
+#define configTOTAL_HEAP_SIZE                    ((size_t)30000)
+#define configMAX_TASK_NAME_LEN                  ( 16 )
+#define configUSE_16_BIT_TICKS                   0
+#define configUSE_MUTEXES                        1
+#define configUSE_RECURSIVE_MUTEXES              1
+#define configUSE_COUNTING_SEMAPHORES            1
+#define configQUEUE_REGISTRY_SIZE                8
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION  0
+#define configMESSAGE_BUFFER_LENGTH_TYPE         size_t
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES                    0
+#define configMAX_CO_ROUTINE_PRIORITIES          ( 2 )
+
+/* Software timer definitions. */
+#define configUSE_TIMERS                         1
+#define configTIMER_TASK_PRIORITY                ( 2 )
+#define configTIMER_QUEUE_LENGTH                 10
+#define configTIMER_TASK_STACK_DEPTH             384
+
+/* Set the following definitions to 1 to include the API function, or zero
+to exclude the API function. */
+#define INCLUDE_vTaskPrioritySet             1
+#define INCLUDE_uxTaskPriorityGet            1
+#define INCLUDE_vTaskDelete                  1
+#define INCLUDE_vTaskCleanUpResources        0
+#define INCLUDE_vTaskSuspend                 1
+#define INCLUDE_vTaskDelayUntil              0
+#define INCLUDE_vTaskDelay                   1
+#define INCLUDE_xTaskGetSchedulerState       1
+#define INCLUDE_xTaskGetCurrentTaskHandle    1
+
+/* Run time stats on the CycleCounter monotonic clock and switch counts for top, see RunTimeStats.hpp. */
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
+void RunTimeStats_TaskSwitchedIn(unsigned long taskNumber);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS configureTimerForRunTimeStats
+#define portGET_RUN_TIME_COUNTER_VALUE getRunTimeCounterValue
+#define traceTASK_SWITCHED_IN() RunTimeStats_TaskSwitchedIn(pxCurrentTCB->uxTCBNumber)
+
+/* The POSIX port has no interrupts to mask, an assert is fatal to the process. */
+void vAssertCalled(const char *file, unsigned long line);
+#define configASSERT( x ) if ((x) == 0) { vAssertCalled(__FILE__, __LINE__); }
+
+#endif /* FREERTOS_CONFIG_H */
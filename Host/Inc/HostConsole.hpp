@@ -0,0 +1,59 @@
+/**
+ ******************************************************************************
+ * File Name          : HostConsole.hpp
+ * Description        : Simulated debug UART over stdin for the host build
+ ******************************************************************************
+ *
+ * A low priority task polls stdin and hands each byte to the registered
+ * receiver exactly like the UART RX interrupt does on target. Reading from a
+ * FreeRTOS task, rather than a raw pthread, keeps every FreeRTOS call inside
+ * the POSIX port's scheduler. Output needs no equivalent, SOAR_PRINT already
+ * ends up on stdout.
+ *
+ ******************************************************************************
+ */
+#ifndef CUBE_HOST_CONSOLE_HPP_
+#define CUBE_HOST_CONSOLE_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include "Task.hpp"
+#include "UARTDriver.hpp"
+
+/* Macros ------------------------------------------------------------------*/
+constexpr uint8_t HOST_CONSOLE_TASK_PRIORITY = 1;          // Below every application task
+constexpr uint16_t HOST_CONSOLE_STACK_DEPTH_WORDS = 256;   // Size of the console task stack
+constexpr uint32_t HOST_CONSOLE_POLL_PERIOD_MS = 10;       // stdin poll period
+
+/* Class ------------------------------------------------------------------*/
+class HostConsole
+{
+public:
+    static HostConsole &Inst()
+    {
+        static HostConsole inst;
+        return inst;
+    }
+
+    void InitTask();
+
+    // Same contract as UARTDriver::ReceiveIT, one byte per arm
+    bool ReceiveIT(uint8_t *charBuf, UARTReceiverBase *receiver);
+
+private:
+    static void RunTask(void *pvParams)
+    {
+        HostConsole::Inst().Run(pvParams);
+    }
+
+    void Run(void *pvParams);
+
+    HostConsole();                               // Private constructor
+    HostConsole(const HostConsole &);            // Prevent copy-construction
+    HostConsole &operator=(const HostConsole &); // Prevent assignment
+
+    TaskHandle_t rtTaskHandle;
+    uint8_t *volatile rxCharBuf;
+    UARTReceiverBase *volatile rxReceiver;
+};
+
+#endif // CUBE_HOST_CONSOLE_HPP_
@@ -0,0 +1,20 @@
+/**
+ ******************************************************************************
+ * File Name          : cmsis_gcc.h
+ * Description        : Host (Linux) stand-in for the CMSIS GCC core intrinsics
+ ******************************************************************************
+ *
+ * Shadows Drivers/CMSIS/Include/cmsis_gcc.h, whose intrinsics are Cortex-M
+ * instructions. cmsis_os.c includes it directly and only reads IPSR.
+ *
+ ******************************************************************************
+ */
+#ifndef __CMSIS_GCC_H
+#define __CMSIS_GCC_H
+
+#include <stdint.h>
+
+/* Not in an interrupt, ever, cmsis_os.c uses this to pick the FromISR API */
+static inline uint32_t __get_IPSR(void) { return 0; }
+
+#endif /* __CMSIS_GCC_H */
@@ -0,0 +1,29 @@
+/**
+ ******************************************************************************
+ * File Name          : main.h
+ * Description        : Host (Linux) stand-in for the CubeMX generated main.h
+ ******************************************************************************
+ *
+ * Shadows Core/Inc/main.h when building against the FreeRTOS POSIX port so
+ * generated code that includes it (ffconf.h, app_fatfs.c) compiles unchanged.
+ *
+ ******************************************************************************
+ */
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g4xx_hal.h"
+
+/* Exported functions prototypes ---------------------------------------------*/
+void Error_Handler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MAIN_H */
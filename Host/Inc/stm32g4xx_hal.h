@@ -0,0 +1,58 @@
+/**
+ ******************************************************************************
+ * File Name          : stm32g4xx_hal.h
+ * Description        : Host (Linux) stand-in for the subset of the STM32 HAL
+ *                      used outside of Core/
+ ******************************************************************************
+ *
+ * Peripherals that have no host equivalent are reduced to placeholder types so
+ * code referencing them still compiles. Anything needing real behaviour (CRC,
+ * cycle counter) has its own COMPUTER_ENVIRONMENT fallback at the call site.
+ *
+ ******************************************************************************
+ */
+#ifndef __STM32G4xx_HAL_H
+#define __STM32G4xx_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+#include "cmsis_gcc.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+typedef struct
+{
+  uint32_t placeholder;
+} USART_TypeDef;
+
+typedef struct
+{
+  uint32_t placeholder;
+} CRC_HandleTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+extern USART_TypeDef HostUsart2;
+#define USART2 (&HostUsart2)
+
+/* Exported functions ------------------------------------------------------- */
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+void HAL_NVIC_SystemReset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32G4xx_HAL_H */
@@ -0,0 +1,83 @@
+/**
+ ******************************************************************************
+ * File Name          : HostConsole.cpp
+ * Description        : Simulated debug UART over stdin for the host build
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "HostConsole.hpp"
+#include "SystemDefines.hpp"
+#include "StaticAllocation.hpp"
+#include <poll.h>
+#include <unistd.h>
+
+/**
+ * @brief Constructor
+ */
+HostConsole::HostConsole() : rtTaskHandle(nullptr), rxCharBuf(nullptr), rxReceiver(nullptr)
+{
+}
+
+/**
+ * @brief Start the stdin polling task
+ */
+void HostConsole::InitTask()
+{
+    SOAR_ASSERT(rtTaskHandle == nullptr, "Cannot initialize HostConsole twice");
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    static StaticTaskStorage<HOST_CONSOLE_STACK_DEPTH_WORDS> taskStorage;
+    rtTaskHandle = taskStorage.Create((TaskFunction_t)HostConsole::RunTask,
+                                      (const char *)"HostConsole",
+                                      (void *)this,
+                                      (UBaseType_t)HOST_CONSOLE_TASK_PRIORITY);
+
+    SOAR_ASSERT(rtTaskHandle != nullptr, "HostConsole::InitTask() - xTaskCreateStatic() failed");
+#else
+    BaseType_t rtValue =
+        xTaskCreate((TaskFunction_t)HostConsole::RunTask,
+                    (const char *)"HostConsole",
+                    (uint16_t)HOST_CONSOLE_STACK_DEPTH_WORDS,
+                    (void *)this,
+                    (UBaseType_t)HOST_CONSOLE_TASK_PRIORITY,
+                    (TaskHandle_t *)&rtTaskHandle);
+
+    SOAR_ASSERT(rtValue == pdPASS, "HostConsole::InitTask() - xTaskCreate() failed");
+#endif
+}
+
+/**
+ * @brief Arm reception of the next byte
+ */
+bool HostConsole::ReceiveIT(uint8_t *charBuf, UARTReceiverBase *receiver)
+{
+    rxCharBuf = charBuf;
+    rxReceiver = receiver;
+    return true;
+}
+
+/**
+ * @brief Poll stdin and deliver bytes to the armed receiver
+ */
+void HostConsole::Run(void *pvParams)
+{
+    while (1)
+    {
+        struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+        uint8_t c;
+
+        // Only consume input once a receiver is armed, like a UART with RX disabled
+        while (rxReceiver != nullptr && poll(&pfd, 1, 0) > 0 && read(STDIN_FILENO, &c, 1) == 1)
+        {
+            // Terminals send LF, DebugTask terminates messages on CR
+            *rxCharBuf = (c == '\n') ? '\r' : c;
+
+            UARTReceiverBase *receiver = rxReceiver;
+            rxReceiver = nullptr;
+            receiver->InterruptRxData(0);
+        }
+
+        osDelay(HOST_CONSOLE_POLL_PERIOD_MS);
+    }
+}
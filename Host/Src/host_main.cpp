@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * File Name          : host_main.cpp
+ * Description        : Process entry point for the host (Linux) build
+ ******************************************************************************
+ *
+ * Stands in for Core/Src/main.c: there is no clock tree or peripheral setup
+ * to do, so this goes straight to run_main() which creates the application
+ * tasks and starts the POSIX port scheduler. The SD card is replaced by the
+ * disk image backend selected in user_diskio.h (SOARFS_DISK_IMAGE).
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "main_avionics.hpp"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Variables -----------------------------------------------------------------*/
+CRC_HandleTypeDef hcrc;
+USART_TypeDef HostUsart2;
+uint32_t SystemCoreClock = 1000000000u; // Matches the CycleCounter host frequency
+
+/* HAL stand-ins ------------------------------------------------------------*/
+extern "C" uint32_t HAL_GetTick(void)
+{
+    // The scheduler tick when running, wall clock before the scheduler starts
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+    {
+        return (uint32_t)xTaskGetTickCount();
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000u + ts.tv_nsec / 1000000u);
+}
+
+extern "C" void HAL_Delay(uint32_t Delay)
+{
+    vTaskDelay(pdMS_TO_TICKS(Delay));
+}
+
+extern "C" void HAL_NVIC_SystemReset(void)
+{
+    fprintf(stderr, "System reset requested, exiting\n");
+    exit(EXIT_FAILURE);
+}
+
+extern "C" void Error_Handler(void)
+{
+    fprintf(stderr, "Error_Handler called\n");
+    abort();
+}
+
+// osSystickHandler in cmsis_os.c calls it on target, the POSIX port ticks from its own timer signal
+extern "C" void xPortSysTickHandler(void)
+{
+}
+
+extern "C" void vAssertCalled(const char *file, unsigned long line)
+{
+    fprintf(stderr, "configASSERT failed %s:%lu\n", file, line);
+    abort();
+}
+
+/* Kernel task memory, Core/Src/app_freertos.c provides these on target ------*/
+static StaticTask_t xIdleTaskTCBBuffer;
+static StackType_t xIdleStack[configMINIMAL_STACK_SIZE];
+static StaticTask_t xTimerTaskTCBBuffer;
+static StackType_t xTimerStack[configTIMER_TASK_STACK_DEPTH];
+
+extern "C" void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                              uint32_t *pulIdleTaskStackSize)
+{
+    *ppxIdleTaskTCBBuffer = &xIdleTaskTCBBuffer;
+    *ppxIdleTaskStackBuffer = &xIdleStack[0];
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+extern "C" void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+                                               uint32_t *pulTimerTaskStackSize)
+{
+    *ppxTimerTaskTCBBuffer = &xTimerTaskTCBBuffer;
+    *ppxTimerTaskStackBuffer = &xTimerStack[0];
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+/**
+ * @brief Host entry point
+ */
+int main(void)
+{
+    // SOAR_PRINT output should appear as soon as it is printed, like the UART
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    run_main();
+
+    return EXIT_FAILURE;
+}
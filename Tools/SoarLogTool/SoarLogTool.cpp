@@ -0,0 +1,1306 @@
+/**
+ * File Name          : SoarLogTool.cpp
+ * Description        : Host decoder and converter for on-board SOAR logs
+ * Author             : SOAR Team
+ *
+ * Streams a log in fixed size chunks, never holding more than
+ * (threads x chunk size) of it in memory. Each chunk is decoded on its own
+ * thread and the results are written out in file order.
+ *
+ * Framed logs (.slg, SoarLogFormat.hpp) are verified block by block. A block
+ * with a bad magic or CRC is skipped and decoding resumes at the next offset
+ * holding a valid block, aligned or not. A chunk owns every block that starts
+ * inside it and reads up to one block past its end to finish the last one.
+ *
+ * Compressed files (.slz, SoarLZFormat.hpp) use the same framing and are
+ * expanded first, then decoded as whatever they contain.
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SoarLogFormat.hpp"
+#include "SoarLogColumnFormat.hpp"
+#include "SoarLZFormat.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Constants -----------------------------------------------------------------*/
+static const uint32_t COLUMNAR_MAGIC = 0x4C4F4353u; // "SCOL"
+static const uint32_t COLUMNAR_VERSION = 1;
+static const size_t DEFAULT_CHUNK_BYTES = 16u << 20;
+static const size_t RAW_READ_BYTES = 1u << 20;
+static const uint32_t BENCH_CORRUPT_EVERY_BLOCKS = 10000;
+
+/* Types ---------------------------------------------------------------------*/
+enum class OutputFormat
+{
+    CSV,
+    COLUMNAR,
+    NONE, // Decode and discard, for benchmarks and verification
+};
+
+struct Field
+{
+    std::string name;
+    char code;
+    uint32_t size; // 0 for SOAR_LOG_FIELD_TEXT
+};
+
+struct RecordType
+{
+    uint8_t type = 0;
+    std::string name;
+    std::vector<Field> fields;
+    std::vector<SoarLog_ColumnField_t> columns; // Empty if the type cannot be column encoded
+};
+
+// Decoded output of one record type from one chunk
+struct TypeOutput
+{
+    uint64_t rows = 0;
+    std::string csv;
+    std::vector<std::string> columns; // Column major, one buffer per field plus the timestamp
+};
+
+struct ChunkResult
+{
+    std::map<uint8_t, TypeOutput> outputs;
+    uint64_t blocks = 0;
+    uint64_t records = 0;
+    uint64_t corruptBlocks = 0; // Magic found but CRC or length invalid
+    uint64_t skippedBytes = 0;  // Bytes not covered by a valid block
+    uint64_t sequenceGaps = 0;
+    uint64_t leadingSkip = 0; // Skipped bytes before the first valid block, may be the tail of the previous chunk's block
+    uint64_t spill = 0;       // Bytes the last block extends past the end of the chunk
+    int64_t firstSequence = -1;
+    int64_t lastSequence = -1;
+};
+
+struct Options
+{
+    std::string input;
+    std::string outputPrefix;
+    std::string inputKind; // "slg", "slz", "raw" or "csv", detected when empty
+    OutputFormat format = OutputFormat::CSV;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t chunkBytes = DEFAULT_CHUNK_BYTES;
+    uint64_t benchMegabytes = 1024;
+    std::string benchFile = "soarlog_bench.slg";
+};
+
+/* CRC -----------------------------------------------------------------------*/
+
+// Slice-by-8 tables for the same CRC-32/MPEG-2 as SoarLog_Crc32Software
+static uint32_t g_crcTable[8][256];
+
+/**
+ * @brief Build the slice-by-8 tables and check them against the firmware implementation
+ */
+static void CrcInit()
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t c = i << 24;
+        for (int k = 0; k < 8; k++)
+        {
+            c = (c & 0x80000000u) ? (c << 1) ^ 0x04C11DB7u : (c << 1);
+        }
+        g_crcTable[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        for (int t = 1; t < 8; t++)
+        {
+            uint32_t prev = g_crcTable[t - 1][i];
+            g_crcTable[t][i] = (prev << 8) ^ g_crcTable[0][prev >> 24];
+        }
+    }
+}
+
+/**
+ * @brief CRC-32/MPEG-2, eight bytes per step
+ */
+static uint32_t Crc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = SOAR_LOG_CRC_INIT;
+    while (length >= 8)
+    {
+        uint32_t hi = crc ^ ((uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3]);
+        crc = g_crcTable[7][hi >> 24] ^ g_crcTable[6][(hi >> 16) & 0xFF] ^ g_crcTable[5][(hi >> 8) & 0xFF] ^
+              g_crcTable[4][hi & 0xFF] ^ g_crcTable[3][data[4]] ^ g_crcTable[2][data[5]] ^ g_crcTable[1][data[6]] ^
+              g_crcTable[0][data[7]];
+        data += 8;
+        length -= 8;
+    }
+    while (length--)
+    {
+        crc = (crc << 8) ^ g_crcTable[0][(crc >> 24) ^ *data++];
+    }
+    return crc;
+}
+
+/* Schema --------------------------------------------------------------------*/
+
+/**
+ * @brief Parse a "name:code,name:code" field list
+ */
+static std::vector<Field> ParseFields(const std::string &list)
+{
+    std::vector<Field> fields;
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+        size_t comma = list.find(',', pos);
+        std::string item = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        size_t colon = item.find(':');
+        if (colon != std::string::npos && colon + 1 < item.size())
+        {
+            char code = item[colon + 1];
+            fields.push_back({item.substr(0, colon), code, SoarLog_FieldSize(code)});
+        }
+        if (comma == std::string::npos)
+        {
+            break;
+        }
+        pos = comma + 1;
+    }
+    return fields;
+}
+
+/**
+ * @brief Build a record type from its schema entry
+ */
+static RecordType MakeRecordType(uint8_t type, const std::string &name, const std::string &list)
+{
+    RecordType record{type, name, ParseFields(list), {}};
+    SoarLog_ColumnField_t columns[SOAR_LOG_COLUMN_MAX_FIELDS];
+    int32_t count = SoarLog_ParseColumnFields(list.c_str(), columns);
+    if (count > 0)
+    {
+        record.columns.assign(columns, columns + count);
+    }
+    return record;
+}
+
+/**
+ * @brief Record types compiled into this tool, used when a log has no readable schema block
+ */
+static std::map<uint8_t, RecordType> BuiltinSchema()
+{
+    std::map<uint8_t, RecordType> schema;
+    for (const SoarLog_SchemaEntry_t &entry : SOAR_LOG_SCHEMA)
+    {
+        schema[entry.type] = MakeRecordType(entry.type, entry.name, entry.fields);
+    }
+    return schema;
+}
+
+/**
+ * @brief Parse the payload of a schema block
+ */
+static std::map<uint8_t, RecordType> ParseSchema(const uint8_t *payload, uint32_t length)
+{
+    std::map<uint8_t, RecordType> schema;
+    uint32_t pos = 0;
+    while (pos + 2 < length)
+    {
+        uint8_t type = payload[pos];
+        pos += 2; // Type and fixed length, the field list already implies the length
+        const char *name = (const char *)payload + pos;
+        size_t nameLen = strnlen(name, length - pos);
+        pos += nameLen + 1;
+        if (pos >= length)
+        {
+            break;
+        }
+        const char *fields = (const char *)payload + pos;
+        size_t fieldsLen = strnlen(fields, length - pos);
+        pos += fieldsLen + 1;
+        schema[type] = MakeRecordType(type, std::string(name, nameLen), std::string(fields, fieldsLen));
+    }
+    return schema;
+}
+
+/* Record output -------------------------------------------------------------*/
+
+/**
+ * @brief Append a number to a CSV line
+ */
+template <typename T>
+static void AppendNumber(std::string &out, T value)
+{
+    char buf[32];
+    std::to_chars_result res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr);
+}
+
+/**
+ * @brief Decode one record into the output of its type
+ */
+static void EmitRecord(const RecordType &type, uint32_t timestamp, const uint8_t *payload, uint32_t length,
+                       OutputFormat format, TypeOutput &out)
+{
+    out.rows++;
+    if (format == OutputFormat::NONE)
+    {
+        return;
+    }
+
+    if (format == OutputFormat::COLUMNAR && out.columns.empty())
+    {
+        out.columns.resize(type.fields.size() + 1);
+    }
+
+    if (format == OutputFormat::CSV)
+    {
+        AppendNumber(out.csv, timestamp);
+    }
+    else
+    {
+        out.columns[0].append((const char *)&timestamp, sizeof(timestamp));
+    }
+
+    uint32_t pos = 0;
+    for (size_t f = 0; f < type.fields.size(); f++)
+    {
+        const Field &field = type.fields[f];
+        uint32_t size = field.size ? field.size : length - std::min(pos, length);
+        if (pos + size > length)
+        {
+            size = 0; // Short record, emit an empty field
+        }
+        const uint8_t *p = payload + pos;
+        pos += size;
+
+        if (format == OutputFormat::COLUMNAR)
+        {
+            if (field.size == 0)
+            {
+                uint32_t len = size;
+                out.columns[f + 1].append((const char *)&len, sizeof(len));
+            }
+            std::string &col = out.columns[f + 1];
+            if (size == field.size || field.size == 0)
+            {
+                col.append((const char *)p, size);
+            }
+            else
+            {
+                col.append(field.size, '\0');
+            }
+            continue;
+        }
+
+        out.csv.push_back(',');
+        if (size == 0 && field.size != 0)
+        {
+            continue;
+        }
+        switch (field.code)
+        {
+        case SOAR_LOG_FIELD_U8:
+            AppendNumber(out.csv, (unsigned)p[0]);
+            break;
+        case SOAR_LOG_FIELD_I8:
+            AppendNumber(out.csv, (int)(int8_t)p[0]);
+            break;
+        case SOAR_LOG_FIELD_U16:
+        {
+            uint16_t v;
+            memcpy(&v, p, 2);
+            AppendNumber(out.csv, v);
+            break;
+        }
+        case SOAR_LOG_FIELD_I16:
+        {
+            int16_t v;
+            memcpy(&v, p, 2);
+            AppendNumber(out.csv, v);
+            break;
+        }
+        case SOAR_LOG_FIELD_U32:
+        {
+            uint32_t v;
+            memcpy(&v, p, 4);
+            AppendNumber(out.csv, v);
+            break;
+        }
+        case SOAR_LOG_FIELD_I32:
+        {
+            int32_t v;
+            memcpy(&v, p, 4);
+            AppendNumber(out.csv, v);
+            break;
+        }
+        case SOAR_LOG_FIELD_F32:
+        {
+            float v;
+            memcpy(&v, p, 4);
+            AppendNumber(out.csv, v);
+            break;
+        }
+        case SOAR_LOG_FIELD_TEXT:
+            out.csv.push_back('"');
+            for (uint32_t i = 0; i < size; i++)
+            {
+                if (p[i] == '"')
+                {
+                    out.csv.push_back('"');
+                }
+                out.csv.push_back((char)p[i]);
+            }
+            out.csv.push_back('"');
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (format == OutputFormat::CSV)
+    {
+        out.csv.push_back('\n');
+    }
+}
+
+/**
+ * @brief Output files of every record type, opened on first use
+ */
+class OutputSet
+{
+public:
+    OutputSet(const std::string &prefix, OutputFormat format) : prefix_(prefix), format_(format) {}
+
+    ~OutputSet()
+    {
+        for (auto &entry : files_)
+        {
+            if (format_ == OutputFormat::COLUMNAR)
+            {
+                const uint32_t terminator = 0;
+                fwrite(&terminator, sizeof(terminator), 1, entry.second);
+            }
+            fclose(entry.second);
+        }
+    }
+
+    /**
+     * @brief Append one chunk's output of a record type
+     */
+    bool Write(const RecordType &type, const TypeOutput &out)
+    {
+        if (format_ == OutputFormat::NONE || out.rows == 0)
+        {
+            return true;
+        }
+
+        FILE *fp = Open(type);
+        if (fp == nullptr)
+        {
+            return false;
+        }
+
+        if (format_ == OutputFormat::CSV)
+        {
+            return fwrite(out.csv.data(), 1, out.csv.size(), fp) == out.csv.size();
+        }
+
+        // One row group per chunk: row count, then each column as length + bytes
+        const uint32_t rows = (uint32_t)out.rows;
+        fwrite(&rows, sizeof(rows), 1, fp);
+        for (const std::string &col : out.columns)
+        {
+            const uint32_t len = (uint32_t)col.size();
+            fwrite(&len, sizeof(len), 1, fp);
+            fwrite(col.data(), 1, col.size(), fp);
+        }
+        return !ferror(fp);
+    }
+
+private:
+    FILE *Open(const RecordType &type)
+    {
+        auto it = files_.find(type.type);
+        if (it != files_.end())
+        {
+            return it->second;
+        }
+
+        std::string path = prefix_ + "_" + type.name + (format_ == OutputFormat::CSV ? ".csv" : ".scol");
+        FILE *fp = fopen(path.c_str(), "wb");
+        if (fp == nullptr)
+        {
+            fprintf(stderr, "Cannot create %s\n", path.c_str());
+            return nullptr;
+        }
+        setvbuf(fp, nullptr, _IOFBF, 1 << 20);
+
+        if (format_ == OutputFormat::CSV)
+        {
+            fputs("timestamp_ms", fp);
+            for (const Field &field : type.fields)
+            {
+                fprintf(fp, ",%s", field.name.c_str());
+            }
+            fputc('\n', fp);
+        }
+        else
+        {
+            // Header: magic, version, column count, then (type code, name length, name) per column
+            const uint32_t header[3] = {COLUMNAR_MAGIC, COLUMNAR_VERSION, (uint32_t)type.fields.size() + 1};
+            fwrite(header, sizeof(header), 1, fp);
+            WriteColumnHeader(fp, SOAR_LOG_FIELD_U32, "timestamp_ms");
+            for (const Field &field : type.fields)
+            {
+                WriteColumnHeader(fp, field.code, field.name);
+            }
+        }
+
+        files_[type.type] = fp;
+        return fp;
+    }
+
+    static void WriteColumnHeader(FILE *fp, char code, const std::string &name)
+    {
+        const uint8_t meta[2] = {(uint8_t)code, (uint8_t)std::min<size_t>(name.size(), 255)};
+        fwrite(meta, sizeof(meta), 1, fp);
+        fwrite(name.data(), 1, meta[1], fp);
+    }
+
+    std::string prefix_;
+    OutputFormat format_;
+    std::map<uint8_t, FILE *> files_;
+};
+
+/* Framed log decoding -------------------------------------------------------*/
+
+/**
+ * @brief Check that a full block at p is intact
+ */
+static bool ValidBlock(const uint8_t *p, SoarLog_BlockHeader_t &header, uint32_t magic = SOAR_LOG_MAGIC)
+{
+    memcpy(&header, p, sizeof(header));
+    if (header.magic != magic || header.payloadLength > SOAR_LOG_BLOCK_PAYLOAD_SIZE)
+    {
+        return false;
+    }
+
+    uint32_t crc;
+    memcpy(&crc, p + SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE, sizeof(crc));
+    return crc == Crc32(p, SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE);
+}
+
+/**
+ * @brief Decode the records of one data block
+ */
+static void DecodeBlock(const uint8_t *payload, uint32_t length, const std::map<uint8_t, RecordType> &schema,
+                        OutputFormat format, ChunkResult &result)
+{
+    uint32_t pos = 0;
+    while (pos + SOAR_LOG_RECORD_HEADER_SIZE <= length)
+    {
+        SoarLog_RecordHeader_t header;
+        memcpy(&header, payload + pos, sizeof(header));
+        pos += SOAR_LOG_RECORD_HEADER_SIZE;
+        if (pos + header.length > length)
+        {
+            break;
+        }
+
+        auto it = schema.find(header.type);
+        if (it != schema.end())
+        {
+            EmitRecord(it->second, header.timestamp, payload + pos, header.length, format,
+                       result.outputs[header.type]);
+        }
+        result.records++;
+        pos += header.length;
+    }
+}
+
+/**
+ * @brief Decode the records of one column block
+ */
+static void DecodeColumnBlock(const uint8_t *payload, uint32_t length, const std::map<uint8_t, RecordType> &schema,
+                              OutputFormat format, ChunkResult &result)
+{
+    auto it = length > 0 ? schema.find(payload[0]) : schema.end();
+    if (it == schema.end() || it->second.columns.empty())
+    {
+        return;
+    }
+
+    const std::vector<SoarLog_ColumnField_t> &columns = it->second.columns;
+    const uint32_t recordLength = columns.back().offset + columns.back().size;
+    uint32_t timestamps[SOAR_LOG_COLUMN_MAX_RECORDS];
+    uint8_t records[SOAR_LOG_COLUMN_MAX_RECORDS * SOAR_LOG_MAX_RECORD_PAYLOAD];
+    int32_t count = SoarLog_DecodeColumns(payload, length, columns.data(), columns.size(), timestamps, records,
+                                          recordLength, SOAR_LOG_COLUMN_MAX_RECORDS);
+
+    // A malformed payload behind a good CRC means an incompatible writer, not a torn block
+    for (int32_t i = 0; i < count; i++)
+    {
+        EmitRecord(it->second, timestamps[i], records + i * recordLength, recordLength, format,
+                   result.outputs[it->first]);
+        result.records++;
+    }
+}
+
+/**
+ * @brief Decode the blocks starting in [0, ownedBytes) of a buffer holding
+ * ownedBytes plus up to one block of lookahead
+ */
+static void DecodeChunk(const uint8_t *buf, size_t ownedBytes, size_t bufBytes,
+                        const std::map<uint8_t, RecordType> &schema, OutputFormat format, ChunkResult &result)
+{
+    static const uint8_t magic[4] = {'S', 'L', 'O', 'G'};
+    size_t off = 0;
+
+    while (off < ownedBytes)
+    {
+        SoarLog_BlockHeader_t header;
+        if (off + SOAR_LOG_BLOCK_SIZE <= bufBytes && ValidBlock(buf + off, header))
+        {
+            if (result.lastSequence >= 0 && header.sequence != (uint32_t)(result.lastSequence + 1))
+            {
+                result.sequenceGaps++;
+            }
+            if (result.firstSequence < 0)
+            {
+                result.firstSequence = header.sequence;
+                result.leadingSkip = off;
+            }
+            result.lastSequence = header.sequence;
+            result.blocks++;
+
+            if (header.blockType == SOAR_LOG_BLOCK_DATA)
+            {
+                DecodeBlock(buf + off + SOAR_LOG_BLOCK_HEADER_SIZE, header.payloadLength, schema, format, result);
+            }
+            else if (header.blockType == SOAR_LOG_BLOCK_COLUMNS)
+            {
+                DecodeColumnBlock(buf + off + SOAR_LOG_BLOCK_HEADER_SIZE, header.payloadLength, schema, format,
+                                  result);
+            }
+            // Index and commit blocks hold no records, a full decode has no use for them
+            off += SOAR_LOG_BLOCK_SIZE;
+            continue;
+        }
+
+        if (off + 4 <= bufBytes && memcmp(buf + off, magic, 4) == 0)
+        {
+            result.corruptBlocks++;
+        }
+
+        // Resynchronize on the next magic that starts a valid block
+        size_t next = off + 1;
+        while (next < ownedBytes)
+        {
+            const void *hit = memmem(buf + next, bufBytes - next, magic, sizeof(magic));
+            if (hit == nullptr)
+            {
+                next = ownedBytes;
+                break;
+            }
+            next = (const uint8_t *)hit - buf;
+            if (next >= ownedBytes || (next + SOAR_LOG_BLOCK_SIZE <= bufBytes && ValidBlock(buf + next, header)))
+            {
+                break;
+            }
+            if (next + SOAR_LOG_BLOCK_SIZE <= bufBytes)
+            {
+                result.corruptBlocks++;
+            }
+            next++;
+        }
+        next = std::min(next, ownedBytes);
+        result.skippedBytes += next - off;
+        off = next;
+    }
+
+    if (result.firstSequence < 0)
+    {
+        result.leadingSkip = ownedBytes;
+    }
+    result.spill = off - ownedBytes;
+}
+
+/**
+ * @brief Read exactly length bytes at offset, short only at end of file
+ */
+static size_t ReadAt(int fd, uint8_t *buf, size_t length, uint64_t offset)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t n = pread(fd, buf + done, length - done, (off_t)(offset + done));
+        if (n <= 0)
+        {
+            break;
+        }
+        done += (size_t)n;
+    }
+    return done;
+}
+
+/**
+ * @brief Find the schema in the first valid schema block, falling back to the built-in one
+ */
+static std::map<uint8_t, RecordType> LoadSchema(int fd)
+{
+    std::vector<uint8_t> head(64 * SOAR_LOG_BLOCK_SIZE);
+    size_t n = ReadAt(fd, head.data(), head.size(), 0);
+
+    for (size_t off = 0; off + SOAR_LOG_BLOCK_SIZE <= n; off += SOAR_LOG_BLOCK_SIZE)
+    {
+        SoarLog_BlockHeader_t header;
+        if (ValidBlock(head.data() + off, header) && header.blockType == SOAR_LOG_BLOCK_SCHEMA)
+        {
+            // From version 2 the log id comes first
+            const uint32_t skip = (header.version >= 2) ? SOAR_LOG_SCHEMA_ID_SIZE : 0;
+            if (header.payloadLength >= skip)
+            {
+                return ParseSchema(head.data() + off + SOAR_LOG_BLOCK_HEADER_SIZE + skip, header.payloadLength - skip);
+            }
+        }
+    }
+
+    fprintf(stderr, "No schema block found, using the built-in schema\n");
+    return BuiltinSchema();
+}
+
+/**
+ * @brief Decode a framed log with opts.threads workers, chunks are written in file order
+ * @return Process exit code
+ */
+static int DecodeFramed(const Options &opts, bool quiet = false)
+{
+    int fd = open(opts.input.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Cannot open %s\n", opts.input.c_str());
+        return 1;
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    const uint64_t fileSize = (uint64_t)st.st_size;
+    const size_t chunkBytes = std::max<size_t>(opts.chunkBytes - opts.chunkBytes % SOAR_LOG_BLOCK_SIZE, SOAR_LOG_BLOCK_SIZE);
+
+    std::map<uint8_t, RecordType> schema = LoadSchema(fd);
+    OutputSet outputs(opts.outputPrefix, opts.format);
+    ChunkResult total;
+    uint64_t prevSpill = 0;
+
+    std::vector<std::vector<uint8_t>> buffers(opts.threads, std::vector<uint8_t>(chunkBytes + SOAR_LOG_BLOCK_SIZE));
+    std::vector<ChunkResult> results(opts.threads);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t windowStart = 0; windowStart < fileSize; windowStart += (uint64_t)chunkBytes * opts.threads)
+    {
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < opts.threads; t++)
+        {
+            uint64_t chunkStart = windowStart + (uint64_t)t * chunkBytes;
+            results[t] = ChunkResult();
+            if (chunkStart >= fileSize)
+            {
+                break;
+            }
+            workers.emplace_back([&, t, chunkStart]() {
+                size_t owned = (size_t)std::min<uint64_t>(chunkBytes, fileSize - chunkStart);
+                size_t got = ReadAt(fd, buffers[t].data(), owned + SOAR_LOG_BLOCK_SIZE, chunkStart);
+                DecodeChunk(buffers[t].data(), std::min(owned, got), got, schema, opts.format, results[t]);
+            });
+        }
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+
+        for (size_t t = 0; t < workers.size(); t++)
+        {
+            ChunkResult &r = results[t];
+            for (auto &entry : r.outputs)
+            {
+                auto it = schema.find(entry.first);
+                if (!outputs.Write(it->second, entry.second))
+                {
+                    close(fd);
+                    return 1;
+                }
+            }
+
+            if (total.lastSequence >= 0 && r.firstSequence >= 0 && r.firstSequence != total.lastSequence + 1)
+            {
+                total.sequenceGaps++;
+            }
+            if (r.lastSequence >= 0)
+            {
+                total.lastSequence = r.lastSequence;
+            }
+            total.blocks += r.blocks;
+            total.records += r.records;
+            total.corruptBlocks += r.corruptBlocks;
+            // Bytes the previous chunk's last block already covered are not lost
+            total.skippedBytes += r.skippedBytes - std::min(r.leadingSkip, prevSpill);
+            prevSpill = r.firstSequence < 0 ? prevSpill - std::min(prevSpill, r.leadingSkip) : r.spill;
+            total.sequenceGaps += r.sequenceGaps;
+            for (auto &entry : r.outputs)
+            {
+                total.outputs[entry.first].rows += entry.second.rows;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    close(fd);
+
+    if (!quiet)
+    {
+        printf("%s: %llu bytes, %llu blocks, %llu records\n", opts.input.c_str(), (unsigned long long)fileSize,
+               (unsigned long long)total.blocks, (unsigned long long)total.records);
+        for (auto &entry : total.outputs)
+        {
+            printf("  %-8s %llu\n", schema[entry.first].name.c_str(), (unsigned long long)entry.second.rows);
+        }
+        printf("  corrupt blocks %llu, skipped bytes %llu, sequence gaps %llu\n",
+               (unsigned long long)total.corruptBlocks, (unsigned long long)total.skippedBytes,
+               (unsigned long long)total.sequenceGaps);
+    }
+    printf("  %.2f s, %.1f MB/s with %u thread(s)\n", seconds, fileSize / 1e6 / std::max(seconds, 1e-9), opts.threads);
+
+    return (total.corruptBlocks || total.skippedBytes) ? 2 : 0;
+}
+
+/* Compressed inputs ---------------------------------------------------------*/
+
+/**
+ * @brief Expand a compressed file back to the bytes written into it
+ *
+ * Blocks decode on their own, so a corrupt block loses only its bytes and
+ * expansion resumes at the next valid block, aligned or not.
+ * @return Process exit code
+ */
+static int UnpackCompressed(const std::string &input, const std::string &output)
+{
+    static const uint8_t magic[4] = {'S', 'L', 'Z', '0'};
+
+    int fd = open(input.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Cannot open %s\n", input.c_str());
+        return 1;
+    }
+    FILE *out = fopen(output.c_str(), "wb");
+    if (out == nullptr)
+    {
+        fprintf(stderr, "Cannot create %s\n", output.c_str());
+        close(fd);
+        return 1;
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    const uint64_t fileSize = (uint64_t)st.st_size;
+
+    std::vector<uint8_t> buf(RAW_READ_BYTES + SOAR_LOG_BLOCK_SIZE);
+    std::vector<uint8_t> raw(SOAR_LZ_WINDOW);
+    uint64_t blocks = 0, corruptBlocks = 0, skippedBytes = 0, sequenceGaps = 0, rawBytes = 0;
+    int64_t lastSequence = -1;
+    bool writeFailed = false;
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t offset = 0;
+    while (offset < fileSize && !writeFailed)
+    {
+        // Only blocks starting in the first RAW_READ_BYTES are taken, the rest is lookahead
+        size_t got = ReadAt(fd, buf.data(), buf.size(), offset);
+        size_t owned = std::min(got, RAW_READ_BYTES);
+        size_t off = 0;
+
+        while (off < owned)
+        {
+            SoarLog_BlockHeader_t header;
+            if (off + SOAR_LOG_BLOCK_SIZE <= got && ValidBlock(buf.data() + off, header, SOAR_LZ_MAGIC))
+            {
+                int32_t n = -1;
+                if (header.blockType == SOAR_LZ_BLOCK_PACKED)
+                {
+                    n = SoarLZ_Unpack(buf.data() + off + SOAR_LOG_BLOCK_HEADER_SIZE, header.payloadLength, raw.data(),
+                                      raw.size());
+                }
+                if (n >= 0)
+                {
+                    if (lastSequence >= 0 && header.sequence != (uint32_t)(lastSequence + 1))
+                    {
+                        sequenceGaps++;
+                    }
+                    lastSequence = header.sequence;
+                    if (fwrite(raw.data(), 1, (size_t)n, out) != (size_t)n)
+                    {
+                        writeFailed = true;
+                        break;
+                    }
+                    blocks++;
+                    rawBytes += (uint64_t)n;
+                    off += SOAR_LOG_BLOCK_SIZE;
+                    continue;
+                }
+            }
+
+            if (off + 4 <= got && memcmp(buf.data() + off, magic, 4) == 0)
+            {
+                corruptBlocks++;
+            }
+
+            // Resynchronize on the next magic, the loop checks whether it starts a valid block
+            const void *hit = memmem(buf.data() + off + 1, owned - off - 1, magic, sizeof(magic));
+            size_t next = (hit == nullptr) ? owned : (size_t)((const uint8_t *)hit - buf.data());
+            skippedBytes += next - off;
+            off = next;
+        }
+        offset += off;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    close(fd);
+    if (fclose(out) != 0 || writeFailed)
+    {
+        fprintf(stderr, "Cannot write %s\n", output.c_str());
+        return 1;
+    }
+
+    printf("%s: %llu bytes, %llu blocks -> %s: %llu bytes, ratio %.2f\n", input.c_str(), (unsigned long long)fileSize,
+           (unsigned long long)blocks, output.c_str(), (unsigned long long)rawBytes,
+           fileSize ? (double)rawBytes / fileSize : 0.0);
+    printf("  corrupt blocks %llu, skipped bytes %llu, sequence gaps %llu\n", (unsigned long long)corruptBlocks,
+           (unsigned long long)skippedBytes, (unsigned long long)sequenceGaps);
+    printf("  %.2f s, %.1f MB/s expanded\n", seconds, rawBytes / 1e6 / std::max(seconds, 1e-9));
+
+    return (corruptBlocks || skippedBytes) ? 2 : 0;
+}
+
+/* Legacy inputs -------------------------------------------------------------*/
+
+// Layout written by SoarFS_Example_StoreBinaryData before framed logs, natural alignment
+struct LegacyFlightData
+{
+    uint32_t timestamp;
+    float altitude;
+    float velocity;
+    float acceleration[3];
+    uint16_t battery_voltage;
+};
+static_assert(sizeof(LegacyFlightData) == 28, "Legacy FlightData_t layout");
+
+/**
+ * @brief Convert a file of back to back legacy FlightData_t structs
+ */
+static int DecodeRawFlight(const Options &opts)
+{
+    FILE *in = fopen(opts.input.c_str(), "rb");
+    if (in == nullptr)
+    {
+        fprintf(stderr, "Cannot open %s\n", opts.input.c_str());
+        return 1;
+    }
+
+    RecordType type;
+    for (const SoarLog_SchemaEntry_t &entry : SOAR_LOG_SCHEMA)
+    {
+        if (entry.type == SOAR_LOG_RECORD_FLIGHT)
+        {
+            type = MakeRecordType(entry.type, entry.name, entry.fields);
+        }
+    }
+
+    OutputSet outputs(opts.outputPrefix, opts.format);
+    std::vector<LegacyFlightData> records(RAW_READ_BYTES / sizeof(LegacyFlightData));
+    uint64_t total = 0;
+    size_t n;
+    while ((n = fread(records.data(), sizeof(LegacyFlightData), records.size(), in)) > 0)
+    {
+        TypeOutput out;
+        for (size_t i = 0; i < n; i++)
+        {
+            // Repack into the current FlightData_t payload so the schema decoder applies
+            FlightData_t payload;
+            payload.altitude = records[i].altitude;
+            payload.velocity = records[i].velocity;
+            memcpy(payload.acceleration, records[i].acceleration, sizeof(payload.acceleration));
+            payload.battery_voltage = records[i].battery_voltage;
+            EmitRecord(type, records[i].timestamp, (const uint8_t *)&payload, sizeof(payload), opts.format, out);
+        }
+        outputs.Write(type, out);
+        total += n;
+    }
+    fclose(in);
+
+    printf("%s: %llu legacy flight records\n", opts.input.c_str(), (unsigned long long)total);
+    return 0;
+}
+
+/**
+ * @brief Convert a CSV log (first column integer timestamp, the rest numeric) to the chosen format
+ */
+static int DecodeCsv(const Options &opts)
+{
+    FILE *in = fopen(opts.input.c_str(), "r");
+    if (in == nullptr)
+    {
+        fprintf(stderr, "Cannot open %s\n", opts.input.c_str());
+        return 1;
+    }
+
+    char line[1024];
+    if (fgets(line, sizeof(line), in) == nullptr)
+    {
+        fclose(in);
+        return 1;
+    }
+
+    // Header names the columns, the first is the timestamp
+    RecordType type;
+    type.type = SOAR_LOG_RECORD_ENVIRONMENT;
+    type.name = "csv";
+    std::string header(line);
+    header.erase(header.find_last_not_of("\r\n") + 1);
+    size_t comma = header.find(',');
+    std::string list;
+    while (comma != std::string::npos)
+    {
+        size_t next = header.find(',', comma + 1);
+        list += (list.empty() ? "" : ",") + header.substr(comma + 1, next - comma - 1) + ":f";
+        comma = next;
+    }
+    type.fields = ParseFields(list);
+
+    OutputSet outputs(opts.outputPrefix, opts.format);
+    TypeOutput out;
+    uint64_t rows = 0, bad = 0;
+    std::vector<float> values(type.fields.size());
+    while (fgets(line, sizeof(line), in) != nullptr)
+    {
+        char *p = line;
+        char *end;
+        unsigned long timestamp = strtoul(p, &end, 10);
+        bool ok = end != p;
+        for (size_t f = 0; ok && f < values.size(); f++)
+        {
+            p = end;
+            ok = *p == ',';
+            values[f] = strtof(p + 1, &end);
+            ok = ok && end != p + 1;
+        }
+        if (!ok)
+        {
+            bad++;
+            continue;
+        }
+
+        EmitRecord(type, (uint32_t)timestamp, (const uint8_t *)values.data(), values.size() * sizeof(float),
+                   opts.format, out);
+        rows++;
+        if (out.csv.size() + out.rows * 16 > RAW_READ_BYTES)
+        {
+            outputs.Write(type, out);
+            out = TypeOutput();
+        }
+    }
+    outputs.Write(type, out);
+    fclose(in);
+
+    printf("%s: %llu rows, %llu malformed\n", opts.input.c_str(), (unsigned long long)rows, (unsigned long long)bad);
+    return 0;
+}
+
+/* Benchmark -----------------------------------------------------------------*/
+
+/**
+ * @brief Write a synthetic framed log of the requested size, with periodic
+ * corrupt blocks and one unaligned gap to exercise resynchronization
+ */
+static bool GenerateSyntheticLog(const std::string &path, uint64_t megabytes)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr)
+    {
+        fprintf(stderr, "Cannot create %s\n", path.c_str());
+        return false;
+    }
+    setvbuf(fp, nullptr, _IOFBF, 1 << 20);
+
+    const uint64_t blocks = megabytes * 1000000 / SOAR_LOG_BLOCK_SIZE;
+    uint8_t block[SOAR_LOG_BLOCK_SIZE];
+    uint32_t timestamp = 0;
+
+    for (uint64_t b = 0; b < blocks; b++)
+    {
+        memset(block, 0, sizeof(block));
+        SoarLog_BlockHeader_t header = {SOAR_LOG_MAGIC, SOAR_LOG_VERSION, SOAR_LOG_BLOCK_DATA, 0, (uint32_t)b};
+        uint16_t used = 0;
+        uint8_t *payload = block + SOAR_LOG_BLOCK_HEADER_SIZE;
+
+        if (b == 0)
+        {
+            header.blockType = SOAR_LOG_BLOCK_SCHEMA;
+            const uint32_t logId = 0x53594E54; // "SYNT", the log has no commit points to check it against
+            memcpy(payload, &logId, SOAR_LOG_SCHEMA_ID_SIZE);
+            used = SOAR_LOG_SCHEMA_ID_SIZE;
+            for (const SoarLog_SchemaEntry_t &entry : SOAR_LOG_SCHEMA)
+            {
+                payload[used++] = entry.type;
+                payload[used++] = entry.length;
+                memcpy(payload + used, entry.name, strlen(entry.name) + 1);
+                used += strlen(entry.name) + 1;
+                memcpy(payload + used, entry.fields, strlen(entry.fields) + 1);
+                used += strlen(entry.fields) + 1;
+            }
+        }
+        else
+        {
+            // Alternate flight and environment samples like a 100 Hz / 1 Hz log would
+            for (;;)
+            {
+                bool flight = (timestamp % 100) != 0;
+                uint8_t length = flight ? sizeof(FlightData_t) : sizeof(SoarLog_Environment_t);
+                if (used + SOAR_LOG_RECORD_HEADER_SIZE + length > SOAR_LOG_BLOCK_PAYLOAD_SIZE)
+                {
+                    break;
+                }
+                SoarLog_RecordHeader_t rh = {(uint8_t)(flight ? SOAR_LOG_RECORD_FLIGHT : SOAR_LOG_RECORD_ENVIRONMENT),
+                                             length, timestamp * 10};
+                memcpy(payload + used, &rh, sizeof(rh));
+                used += sizeof(rh);
+                if (flight)
+                {
+                    FlightData_t fd = {timestamp * 0.5f, 30.0f, {0.1f, 0.2f, 9.81f}, 3700};
+                    memcpy(payload + used, &fd, sizeof(fd));
+                }
+                else
+                {
+                    SoarLog_Environment_t env = {21.5f, 40.25f};
+                    memcpy(payload + used, &env, sizeof(env));
+                }
+                used += length;
+                timestamp++;
+            }
+        }
+
+        header.payloadLength = used;
+        memcpy(block, &header, sizeof(header));
+        uint32_t crc = Crc32(block, SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE);
+        memcpy(block + SOAR_LOG_BLOCK_SIZE - SOAR_LOG_BLOCK_CRC_SIZE, &crc, sizeof(crc));
+
+        if (b > 0 && b % BENCH_CORRUPT_EVERY_BLOCKS == 0)
+        {
+            block[100] ^= 0x40; // Bit flip, caught by the CRC
+        }
+        if (b == blocks / 2)
+        {
+            fwrite("torn", 1, 4, fp); // Everything after this is off the 512 byte grid
+        }
+        fwrite(block, 1, sizeof(block), fp);
+    }
+
+    return fclose(fp) == 0;
+}
+
+/**
+ * @brief Generate a synthetic log and report decode throughput single and multi threaded
+ */
+static int RunBenchmark(Options opts)
+{
+    printf("Generating %llu MB synthetic log at %s\n", (unsigned long long)opts.benchMegabytes, opts.benchFile.c_str());
+    if (!GenerateSyntheticLog(opts.benchFile, opts.benchMegabytes))
+    {
+        return 1;
+    }
+
+    opts.input = opts.benchFile;
+    const unsigned threads = opts.threads;
+    const OutputFormat formats[] = {OutputFormat::NONE, OutputFormat::CSV, OutputFormat::COLUMNAR};
+    const char *names[] = {"verify only", "csv", "columnar"};
+
+    for (size_t f = 0; f < 3; f++)
+    {
+        opts.format = formats[f];
+        opts.outputPrefix = opts.benchFile + ".out";
+        for (unsigned t : {1u, threads})
+        {
+            opts.threads = t;
+            printf("%s:\n", names[f]);
+            DecodeFramed(opts, true);
+            if (threads == 1)
+            {
+                break;
+            }
+        }
+    }
+
+    unlink(opts.benchFile.c_str());
+    unlink((opts.benchFile + ".out_env.csv").c_str());
+    unlink((opts.benchFile + ".out_flight.csv").c_str());
+    unlink((opts.benchFile + ".out_env.scol").c_str());
+    unlink((opts.benchFile + ".out_flight.scol").c_str());
+    return 0;
+}
+
+/* Entry point ---------------------------------------------------------------*/
+
+/**
+ * @brief Pick the input type from the first four bytes and the file name
+ */
+static std::string DetectInputKind(const std::string &path)
+{
+    uint32_t magic = 0;
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp != nullptr)
+    {
+        if (fread(&magic, sizeof(magic), 1, fp) != 1)
+        {
+            magic = 0;
+        }
+        fclose(fp);
+    }
+    bool csvName = path.size() > 4 && strcasecmp(path.c_str() + path.size() - 4, ".csv") == 0;
+    return magic == SOAR_LOG_MAGIC ? "slg" : magic == SOAR_LZ_MAGIC ? "slz" : csvName ? "csv" : "raw";
+}
+
+static void Usage()
+{
+    fprintf(stderr,
+            "usage: soarlogtool decode <log> [-o prefix] [-f csv|col|none] [-j threads] [-c chunk_mb] [-t slg|raw|csv]\n"
+            "       soarlogtool unpack <file> [-o output]\n"
+            "       soarlogtool generate <log> [-s size_mb]\n"
+            "       soarlogtool bench [-s size_mb] [-j threads] [-c chunk_mb] [-b bench_file]\n"
+            "\n"
+            "decode writes <prefix>_<record>.csv or .scol per record type, prefix defaults to the log name.\n"
+            "Input type is detected from the content: SoarLog magic -> slg, SoarLZ magic -> slz, .csv name\n"
+            "-> csv, else raw legacy FlightData_t structs. slz is expanded to <prefix>_unpacked and that is\n"
+            "decoded. unpack writes the expanded bytes to output, default <file>.raw.\n"
+            "Exit code 2 means corrupt data was skipped.\n");
+}
+
+int main(int argc, char **argv)
+{
+    CrcInit();
+    if (Crc32((const uint8_t *)"123456789", 9) != SoarLog_Crc32Software(SOAR_LOG_CRC_INIT, (const uint8_t *)"123456789", 9))
+    {
+        fprintf(stderr, "CRC self test failed\n");
+        return 1;
+    }
+
+    if (argc < 2)
+    {
+        Usage();
+        return 1;
+    }
+
+    Options opts;
+    std::string command = argv[1];
+    int arg = 2;
+    if (command == "decode" || command == "generate" || command == "unpack")
+    {
+        if (argc < 3)
+        {
+            Usage();
+            return 1;
+        }
+        opts.input = argv[arg++];
+        opts.outputPrefix = opts.input;
+    }
+    else if (command != "bench")
+    {
+        Usage();
+        return 1;
+    }
+
+    for (; arg + 1 < argc; arg += 2)
+    {
+        std::string flag = argv[arg];
+        std::string value = argv[arg + 1];
+        if (flag == "-o")
+            opts.outputPrefix = value;
+        else if (flag == "-f")
+            opts.format = value == "col" ? OutputFormat::COLUMNAR : value == "none" ? OutputFormat::NONE : OutputFormat::CSV;
+        else if (flag == "-j")
+            opts.threads = std::max(1, atoi(value.c_str()));
+        else if (flag == "-c")
+            opts.chunkBytes = (size_t)std::max(1, atoi(value.c_str())) << 20;
+        else if (flag == "-t")
+            opts.inputKind = value;
+        else if (flag == "-s")
+            opts.benchMegabytes = std::max(1, atoi(value.c_str()));
+        else if (flag == "-b")
+            opts.benchFile = value;
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+    if (arg != argc)
+    {
+        Usage();
+        return 1;
+    }
+
+    if (command == "bench")
+    {
+        return RunBenchmark(opts);
+    }
+    if (command == "generate")
+    {
+        return GenerateSyntheticLog(opts.input, opts.benchMegabytes) ? 0 : 1;
+    }
+    if (command == "unpack")
+    {
+        return UnpackCompressed(opts.input, opts.outputPrefix == opts.input ? opts.input + ".raw" : opts.outputPrefix);
+    }
+
+    if (opts.inputKind.empty())
+    {
+        opts.inputKind = DetectInputKind(opts.input);
+    }
+
+    int unpackResult = 0;
+    if (opts.inputKind == "slz")
+    {
+        // Compressed text has no magic of its own, anything that is not a framed log is taken as CSV
+        std::string unpacked = opts.outputPrefix + "_unpacked";
+        unpackResult = UnpackCompressed(opts.input, unpacked);
+        if (unpackResult == 1)
+        {
+            return 1;
+        }
+        opts.input = unpacked;
+        opts.inputKind = DetectInputKind(unpacked) == "slg" ? "slg" : "csv";
+    }
+
+    int result;
+    if (opts.inputKind == "slg")
+    {
+        result = DecodeFramed(opts);
+    }
+    else if (opts.inputKind == "csv")
+    {
+        result = DecodeCsv(opts);
+    }
+    else
+    {
+        result = DecodeRawFlight(opts);
+    }
+    return std::max(result, unpackResult);
+}
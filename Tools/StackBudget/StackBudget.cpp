@@ -0,0 +1,590 @@
+/**
+ * File Name          : StackBudget.cpp
+ * Description        : Worst case stack depth of each task from the firmware build outputs
+ * Author             : SOAR Team
+ *
+ * Builds the call graph from the disassembly listing (.list, objdump -d of
+ * the .elf) and weighs every function with the frame size GCC reports in its
+ * object's .su file (-fstack-usage). The worst case of a task is its entry
+ * point's frame plus the deepest chain of callees below it.
+ *
+ * Direct calls and tail calls (bl, b.w to the start of another function) are
+ * followed. Calls through registers, recursion and functions without a .su
+ * entry (precompiled newlib, assembly) cannot be bounded from these inputs,
+ * so they are counted as 0 bytes and reported, and known indirect edges can
+ * be added with -e.
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <cxxabi.h>
+#include <dirent.h>
+
+/* Constants -----------------------------------------------------------------*/
+// Cortex-M4F exception frame with FPU state (104 B) plus the context FreeRTOS
+// saves on a switch (r4-r11, lr, s16-s31: 100 B), rounded up, pushed on top of
+// whatever the task itself has in use
+static const uint32_t DEFAULT_MARGIN_BYTES = 256;
+
+/* Types ---------------------------------------------------------------------*/
+struct Function
+{
+    std::string name;             // Demangled, or the plain symbol for C
+    std::set<std::string> calls;  // Mangled callee symbols
+    std::vector<std::string> indirect; // Call or jump instructions through a register
+    uint32_t frame = 0;
+    bool hasFrame = false;
+    bool dynamic = false; // The .su reports a variable sized frame (alloca, VLA)
+};
+
+struct Result
+{
+    uint32_t depth = 0;
+    std::string next; // Callee on the deepest path, empty at a leaf
+};
+
+struct Task
+{
+    std::string prefix; // Constant prefix, e.g. TASK_DEBUG
+    std::string entry;  // Demangled name prefix or symbol of the entry point
+    std::string symbol;
+};
+
+struct Options
+{
+    std::string list;
+    std::vector<std::string> suDirs;
+    std::vector<std::string> suFiles;
+    std::vector<std::pair<std::string, std::string>> edges; // Extra caller -> callee, by name prefix
+    std::vector<Task> tasks;
+    uint32_t margin = DEFAULT_MARGIN_BYTES;
+    std::string header;
+};
+
+/* Variables -----------------------------------------------------------------*/
+static std::map<std::string, Function> g_functions; // By mangled symbol
+static std::map<std::string, Result> g_results;
+static std::set<std::string> g_active;    // On the current DFS path, to catch recursion
+static std::set<std::string> g_recursive; // Functions found calling back into their own path
+
+/* Functions -----------------------------------------------------------------*/
+static std::string Demangle(const std::string &symbol)
+{
+    int status = 0;
+    char *name = abi::__cxa_demangle(symbol.c_str(), nullptr, nullptr, &status);
+    if (status != 0 || name == nullptr)
+    {
+        return symbol;
+    }
+    std::string result = name;
+    free(name);
+    return result;
+}
+
+/**
+ * @brief Drop compiler clone suffixes, "f(int) [clone .isra.0]" and "f.part.0" both become their origin
+ */
+static std::string StripClone(std::string name)
+{
+    size_t clone = name.find(" [clone ");
+    if (clone != std::string::npos)
+    {
+        name.erase(clone);
+    }
+    for (const char *suffix : {".isra.", ".part.", ".constprop.", ".cold"})
+    {
+        size_t at = name.find(suffix);
+        if (at != std::string::npos)
+        {
+            name.erase(at);
+        }
+    }
+    return name;
+}
+
+/**
+ * @brief The qualified name and parameters of a .su signature, without the return type in front
+ *
+ * GCC writes "static DebugTask& DebugTask::Inst()" where the demangler gives
+ * "DebugTask::Inst()", so the name starts after the last space outside any
+ * template brackets before the parameter list.
+ */
+static std::string SignatureKey(const std::string &signature)
+{
+    int depth = 0;
+    size_t open = std::string::npos;
+    for (size_t i = 0; i < signature.size(); i++)
+    {
+        char c = signature[i];
+        if (c == '<')
+            depth++;
+        else if (c == '>')
+            depth--;
+        else if (c == '(' && depth == 0)
+        {
+            // "operator()" names its own parentheses first
+            open = (signature.compare(i, 3, "()(") == 0) ? i + 2 : i;
+            break;
+        }
+    }
+    if (open == std::string::npos)
+    {
+        return signature;
+    }
+
+    size_t start = open;
+    depth = 0;
+    while (start > 0)
+    {
+        char c = signature[start - 1];
+        if (c == '>')
+            depth++;
+        else if (c == '<')
+            depth--;
+        else if (c == ' ' && depth == 0 && signature.compare(start, 8, "operator") != 0)
+            break;
+        start--;
+    }
+    return signature.substr(start);
+}
+
+static std::string BaseName(const std::string &key)
+{
+    return key.substr(0, key.find('('));
+}
+
+/**
+ * @brief Read one .su file into frame sizes by signature key, keeping the largest of duplicates
+ */
+static void LoadStackUsage(const std::string &path, std::map<std::string, std::pair<uint32_t, bool>> &frames)
+{
+    std::ifstream in(path);
+    std::string line;
+    static const std::regex suLine("^(.*):([0-9]+):([0-9]+):(.*)\t([0-9]+)\t(.*)$");
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+
+        std::smatch match;
+        if (!std::regex_match(line, match, suLine))
+        {
+            continue;
+        }
+
+        std::string key = StripClone(SignatureKey(match[4].str()));
+        uint32_t bytes = (uint32_t)strtoul(match[5].str().c_str(), nullptr, 10);
+        bool dynamic = match[6].str().find("dynamic") != std::string::npos;
+        auto &entry = frames[key];
+        entry.first = std::max(entry.first, bytes);
+        entry.second = entry.second || dynamic;
+    }
+}
+
+static void FindStackUsageFiles(const std::string &dir, std::vector<std::string> &files)
+{
+    DIR *handle = opendir(dir.c_str());
+    if (handle == nullptr)
+    {
+        return;
+    }
+    while (struct dirent *entry = readdir(handle))
+    {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..")
+        {
+            continue;
+        }
+        std::string path = dir + "/" + name;
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, ".su") == 0)
+        {
+            files.push_back(path);
+        }
+        else if (entry->d_type == DT_DIR)
+        {
+            FindStackUsageFiles(path, files);
+        }
+    }
+    closedir(handle);
+}
+
+/**
+ * @brief Split the listing into functions and collect the calls out of each
+ */
+static bool LoadListing(const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        fprintf(stderr, "cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    static const std::regex header("^[0-9a-f]{8} <([^>]+)>:$");
+    static const std::regex branch("^ *[0-9a-f]+:\t[0-9a-f ]+\t(bl|blx|b|b\\.w|b\\.n|b[a-z]{2}|b[a-z]{2}\\.w|b[a-z]{2}\\.n)\t[0-9a-f]+ <([^>+]+)>");
+    static const std::regex viaRegister("^ *[0-9a-f]+:\t[0-9a-f ]+\t(blx|bx)\t(r[0-9]+|ip|sl|fp)\\b");
+
+    Function *current = nullptr;
+    std::string currentSymbol;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::smatch match;
+        if (std::regex_match(line, match, header))
+        {
+            currentSymbol = match[1].str();
+            current = &g_functions[currentSymbol];
+            current->name = Demangle(currentSymbol);
+        }
+        else if (current == nullptr)
+        {
+            continue;
+        }
+        else if (std::regex_search(line, match, branch))
+        {
+            // Targets inside the function print as <sym+0x..> and are not matched
+            if (match[2].str() != currentSymbol)
+            {
+                current->calls.insert(match[2].str());
+            }
+        }
+        else if (std::regex_search(line, match, viaRegister) && match[2].str() != "lr")
+        {
+            current->indirect.push_back(match[1].str() + " " + match[2].str());
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Mangled symbols whose demangled name or symbol starts with the given text
+ */
+static std::vector<std::string> FindSymbols(const std::string &name)
+{
+    std::vector<std::string> found;
+    for (const auto &entry : g_functions)
+    {
+        if (entry.first == name || entry.second.name.compare(0, name.size(), name) == 0)
+        {
+            found.push_back(entry.first);
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Deepest stack below and including a function, memoised
+ */
+static uint32_t Depth(const std::string &symbol)
+{
+    auto done = g_results.find(symbol);
+    if (done != g_results.end())
+    {
+        return done->second.depth;
+    }
+    if (g_active.count(symbol))
+    {
+        g_recursive.insert(symbol);
+        return 0;
+    }
+
+    Result result;
+    auto function = g_functions.find(symbol);
+    if (function != g_functions.end())
+    {
+        g_active.insert(symbol);
+        for (const std::string &callee : function->second.calls)
+        {
+            uint32_t depth = Depth(callee);
+            if (depth > result.depth)
+            {
+                result.depth = depth;
+                result.next = callee;
+            }
+        }
+        g_active.erase(symbol);
+        result.depth += function->second.frame;
+    }
+    g_results[symbol] = result;
+    return result.depth;
+}
+
+/**
+ * @brief Every function reachable from an entry point, for the warnings
+ */
+static void Reachable(const std::string &symbol, std::set<std::string> &seen)
+{
+    if (!seen.insert(symbol).second)
+    {
+        return;
+    }
+    auto function = g_functions.find(symbol);
+    if (function != g_functions.end())
+    {
+        for (const std::string &callee : function->second.calls)
+        {
+            Reachable(callee, seen);
+        }
+    }
+}
+
+static std::string DisplayName(const std::string &symbol)
+{
+    auto function = g_functions.find(symbol);
+    return function == g_functions.end() ? symbol : function->second.name;
+}
+
+static void PrintList(const char *label, const std::vector<std::string> &names)
+{
+    if (names.empty())
+    {
+        return;
+    }
+    printf("  %s (%zu):", label, names.size());
+    for (size_t i = 0; i < names.size() && i < 8; i++)
+    {
+        printf("%s %s", i ? "," : "", names[i].c_str());
+    }
+    printf("%s\n", names.size() > 8 ? ", ..." : "");
+}
+
+static bool WriteHeader(const Options &opts, const std::vector<std::pair<const Task *, uint32_t>> &budgets)
+{
+    FILE *out = fopen(opts.header.c_str(), "w");
+    if (out == nullptr)
+    {
+        fprintf(stderr, "cannot write %s\n", opts.header.c_str());
+        return false;
+    }
+
+    fprintf(out,
+            "/**\n"
+            " ******************************************************************************\n"
+            " * File Name          : StackBudgets.hpp\n"
+            " * Description        : Worst case task stack use, generated by Tools/StackBudget\n"
+            " ******************************************************************************\n"
+            " *\n"
+            " * Do not edit, rerun `make budgets` in Tools/StackBudget after a Debug build.\n"
+            " * The budgets leave out calls through pointers and functions without a .su\n"
+            " * file, so RunTimeStats checks them against the stack watermarks at run time.\n"
+            " *\n"
+            " ******************************************************************************\n"
+            " */\n"
+            "#ifndef CUBE_SYSCORE_STACK_BUDGETS_HPP_\n"
+            "#define CUBE_SYSCORE_STACK_BUDGETS_HPP_\n"
+            "\n"
+            "/* Includes ------------------------------------------------------------------*/\n"
+            "#include <stdint.h>\n"
+            "\n"
+            "/* Macros --------------------------------------------------------------------*/\n"
+            "constexpr uint32_t STACK_BUDGET_MARGIN_BYTES = %u; // Exception frame and switch context on top of the budget\n"
+            "\n",
+            opts.margin);
+    for (const auto &budget : budgets)
+    {
+        fprintf(out, "constexpr uint32_t %s_STACK_BUDGET_BYTES = %u; // %s\n", budget.first->prefix.c_str(),
+                budget.second, DisplayName(budget.first->symbol).c_str());
+    }
+    fprintf(out,
+            "\n"
+            "/* Functions -----------------------------------------------------------------*/\n"
+            "/**\n"
+            " * @brief Stack depth in words for a task with the given budget\n"
+            " */\n"
+            "constexpr uint16_t StackBudgetWords(uint32_t budgetBytes)\n"
+            "{\n"
+            "    return (uint16_t)((budgetBytes + STACK_BUDGET_MARGIN_BYTES + 3) / 4);\n"
+            "}\n"
+            "\n"
+            "#endif // CUBE_SYSCORE_STACK_BUDGETS_HPP_\n");
+    fclose(out);
+    return true;
+}
+
+static void Usage()
+{
+    fprintf(stderr,
+            "usage: stackbudget -l <firmware.list> -s <build dir> [-s dir] [-x file.su] [-e caller=callee]\n"
+            "                   [-m margin_bytes] [-o StackBudgets.hpp] PREFIX=entry [PREFIX=entry ...]\n"
+            "\n"
+            "Prints the worst case stack of each task entry point and the call chain behind it.\n"
+            "entry is the start of a demangled name (DebugTask::RunTask) or a symbol. -s is searched\n"
+            "for .su files recursively, -x adds one, e.g. hand measured library functions. -e adds a\n"
+            "call the listing cannot show, such as a function pointer. -o writes PREFIX_STACK_BUDGET_BYTES\n"
+            "constants. Exit code 2 means a task reaches recursion, indirect calls or unknown frames.\n");
+}
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    for (int arg = 1; arg < argc; arg++)
+    {
+        std::string flag = argv[arg];
+        if (flag.size() == 2 && flag[0] == '-' && arg + 1 < argc)
+        {
+            std::string value = argv[++arg];
+            if (flag == "-l")
+                opts.list = value;
+            else if (flag == "-s")
+                opts.suDirs.push_back(value);
+            else if (flag == "-x")
+                opts.suFiles.push_back(value);
+            else if (flag == "-m")
+                opts.margin = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+            else if (flag == "-o")
+                opts.header = value;
+            else if (flag == "-e" && value.find('=') != std::string::npos)
+                opts.edges.push_back({value.substr(0, value.find('=')), value.substr(value.find('=') + 1)});
+            else
+            {
+                Usage();
+                return 1;
+            }
+        }
+        else if (flag.find('=') != std::string::npos && flag[0] != '-')
+        {
+            opts.tasks.push_back({flag.substr(0, flag.find('=')), flag.substr(flag.find('=') + 1), ""});
+        }
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+    if (opts.list.empty() || opts.tasks.empty())
+    {
+        Usage();
+        return 1;
+    }
+
+    if (!LoadListing(opts.list))
+    {
+        return 1;
+    }
+
+    std::vector<std::string> suFiles = opts.suFiles;
+    for (const std::string &dir : opts.suDirs)
+    {
+        FindStackUsageFiles(dir, suFiles);
+    }
+    std::map<std::string, std::pair<uint32_t, bool>> frames;
+    for (const std::string &file : suFiles)
+    {
+        LoadStackUsage(file, frames);
+    }
+
+    // Same name in several .su files (static helpers, header inlines) keeps the largest frame
+    std::map<std::string, std::pair<uint32_t, bool>> byBase;
+    for (const auto &frame : frames)
+    {
+        auto &entry = byBase[BaseName(frame.first)];
+        entry.first = std::max(entry.first, frame.second.first);
+        entry.second = entry.second || frame.second.second;
+    }
+
+    uint32_t matched = 0;
+    for (auto &entry : g_functions)
+    {
+        std::string key = StripClone(entry.second.name);
+        auto frame = frames.find(key);
+        if (frame == frames.end())
+        {
+            frame = byBase.find(BaseName(key));
+            if (frame == byBase.end())
+            {
+                continue;
+            }
+        }
+        entry.second.frame = frame->second.first;
+        entry.second.dynamic = frame->second.second;
+        entry.second.hasFrame = true;
+        matched++;
+    }
+    printf("%zu functions in %s, %u with a frame from %zu .su files\n\n", g_functions.size(), opts.list.c_str(), matched,
+           suFiles.size());
+
+    for (const auto &edge : opts.edges)
+    {
+        std::vector<std::string> callers = FindSymbols(edge.first);
+        std::vector<std::string> callees = FindSymbols(edge.second);
+        if (callers.empty() || callees.empty())
+        {
+            fprintf(stderr, "-e %s=%s matches no function\n", edge.first.c_str(), edge.second.c_str());
+            return 1;
+        }
+        for (const std::string &caller : callers)
+        {
+            g_functions[caller].calls.insert(callees.begin(), callees.end());
+        }
+    }
+
+    int exitCode = 0;
+    std::vector<std::pair<const Task *, uint32_t>> budgets;
+    for (Task &task : opts.tasks)
+    {
+        std::vector<std::string> symbols = FindSymbols(task.entry);
+        if (symbols.size() != 1)
+        {
+            fprintf(stderr, "%s: %s matches %zu functions\n", task.prefix.c_str(), task.entry.c_str(), symbols.size());
+            return 1;
+        }
+        task.symbol = symbols[0];
+
+        g_recursive.clear();
+        uint32_t depth = Depth(task.symbol);
+        printf("%s  %s  worst %u B, %u words with the %u B margin\n", task.prefix.c_str(), DisplayName(task.symbol).c_str(),
+               depth, (depth + opts.margin + 3) / 4, opts.margin);
+
+        for (std::string symbol = task.symbol; !symbol.empty(); symbol = g_results[symbol].next)
+        {
+            const Function &function = g_functions[symbol];
+            printf("  %6u %s%s\n", function.frame, DisplayName(symbol).c_str(), function.hasFrame ? "" : "  (no .su)");
+        }
+
+        std::set<std::string> reachable;
+        Reachable(task.symbol, reachable);
+        std::vector<std::string> unknown, indirect, dynamic, recursive;
+        for (const std::string &symbol : reachable)
+        {
+            const Function &function = g_functions[symbol];
+            if (!function.hasFrame)
+                unknown.push_back(DisplayName(symbol));
+            if (!function.indirect.empty())
+                indirect.push_back(DisplayName(symbol));
+            if (function.dynamic)
+                dynamic.push_back(DisplayName(symbol));
+            if (g_recursive.count(symbol))
+                recursive.push_back(DisplayName(symbol));
+        }
+        PrintList("no .su, counted as 0", unknown);
+        PrintList("calls through a register", indirect);
+        PrintList("variable sized frames", dynamic);
+        PrintList("recursive", recursive);
+        printf("\n");
+
+        if (!unknown.empty() || !indirect.empty() || !dynamic.empty() || !recursive.empty())
+        {
+            exitCode = 2;
+        }
+        budgets.push_back({&task, depth});
+    }
+
+    if (!opts.header.empty() && !WriteHeader(opts, budgets))
+    {
+        return 1;
+    }
+    return exitCode;
+}